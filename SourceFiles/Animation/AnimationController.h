@@ -40,16 +40,26 @@ public:
      */
     using AnimationCallback = std::function<void(const AnimationController&, const std::string&)>;
 
+    /**
+     * @brief Fills a clip's bone tracks with the keyframes of a sequence on demand.
+     *
+     * Called with SIZE_MAX when the clip has no sequences (whole clip).
+     * See Parsers::BB9AnimationIndex::CreateSequenceLoader().
+     */
+    using SequenceLoader = std::function<void(AnimationClip&, size_t)>;
+
     AnimationController() = default;
 
     /**
      * @brief Initializes the controller with a clip.
      *
      * @param clip Animation clip to play.
+     * @param sequenceLoader Optional loader for clips whose keyframes are decoded lazily.
      */
-    void Initialize(std::shared_ptr<AnimationClip> clip)
+    void Initialize(std::shared_ptr<AnimationClip> clip, SequenceLoader sequenceLoader = nullptr)
     {
         m_clip = clip;
+        m_sequenceLoader = std::move(sequenceLoader);
         m_currentSequenceIndex = 0;
         m_currentTime = clip ? clip->minTime : 0.0f;
         m_state = PlaybackState::Stopped;
@@ -60,6 +70,8 @@ public:
             m_boneWorldPositions.resize(clip->boneTracks.size());
             m_boneWorldRotations.resize(clip->boneTracks.size());
 
+            LoadSequenceKeys(clip->sequences.empty() ? SIZE_MAX : 0);
+
             // Set initial time range
             if (!clip->sequences.empty())
             {
@@ -141,6 +153,8 @@ public:
         }
 
         m_currentSequenceIndex = index;
+        LoadSequenceKeys(index);
+
         const auto& seq = m_clip->sequences[index];
         m_sequenceStartTime = seq.startTime;
         m_sequenceEndTime = seq.endTime;
@@ -361,6 +375,14 @@ public:
     }
 
 private:
+    void LoadSequenceKeys(size_t index)
+    {
+        if (m_clip && m_sequenceLoader)
+        {
+            m_sequenceLoader(*m_clip, index);
+        }
+    }
+
     void EvaluateBoneMatrices()
     {
         if (!m_clip)
@@ -388,6 +410,7 @@ private:
 private:
     std::shared_ptr<AnimationClip> m_clip;
     AnimationEvaluator m_evaluator;
+    SequenceLoader m_sequenceLoader;
 
     PlaybackState m_state = PlaybackState::Stopped;
     float m_currentTime = 0.0f;
@@ -0,0 +1,41 @@
+#pragma once
+#include <span>
+#include <variant>
+#include <vector>
+#include "FFNA_ModelFile.h"
+#include "FFNA_ModelFile_Other.h"
+
+// A parsed FFNA_Type2 model file, either in the standard format (0xFA* chunks) or the "other" one (0xBB* chunks).
+using AnyModelFile = std::variant<FFNA_ModelFile, FFNA_ModelFile_Other>;
+
+// Parses decompressed model file data. The format is detected on the same buffer, see IsOtherModelFormat.
+inline AnyModelFile ParseModelFile(std::span<unsigned char> data)
+{
+    if (IsOtherModelFormat(data))
+    {
+        return AnyModelFile(std::in_place_type<FFNA_ModelFile_Other>, 0, data);
+    }
+    return AnyModelFile(std::in_place_type<FFNA_ModelFile>, 0, data);
+}
+
+inline bool IsOtherModelFormat(const AnyModelFile& model_file)
+{
+    return std::holds_alternative<FFNA_ModelFile_Other>(model_file);
+}
+
+inline bool IsParsedCorrectly(const AnyModelFile& model_file)
+{
+    return std::visit([](const auto& model) { return model.parsed_correctly; }, model_file);
+}
+
+/**
+ * @brief A model file read and decompressed once.
+ *
+ * data holds the decompressed file, for parsers that work on the raw chunks such as the animation parsers,
+ * so they don't have to read the file again.
+ */
+struct OpenedModelFile
+{
+    std::vector<uint8_t> data;
+    AnyModelFile model;
+};
@@ -1,5 +1,28 @@
 #include "pch.h"
 #include "DATManager.h"
+#include <chrono>
+
+namespace
+{
+    constexpr int reserved_mft_entries = 15; // Header, hash table and other DAT internals, not files
+
+    bool is_diffable(const MFTEntry& entry)
+    {
+        return entry.b && entry.Size > 0;
+    }
+
+    // Identifies the stored (compressed) file, known without reading it.
+    uint64_t stored_signature(const MFTEntry& entry)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(entry.CRC)) << 32) | static_cast<uint32_t>(entry.Size);
+    }
+
+    // Identifies the decompressed content, known once the file was read.
+    uint64_t content_signature(const MFTEntry& entry)
+    {
+        return (static_cast<uint64_t>(entry.murmurhash3) << 32) | static_cast<uint32_t>(entry.uncompressedSize);
+    }
+}
 
 FFNA_MapFile DATManager::parse_ffna_map_file(int index)
 {
@@ -37,40 +60,17 @@ FFNA_ModelFile DATManager::parse_ffna_model_file(int index)
     return ffna_model_file;
 }
 
-FFNA_ModelFile_Other DATManager::parse_ffna_model_file_other(int index)
-{
-    MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
-    if (!mft_entry)
-        throw "mft_entry not found.";
-
-    // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
-
-    FFNA_ModelFile_Other ffna_model_file_other(0, file_data);
-    delete[] data;
-
-    return ffna_model_file_other;
-}
-
-bool DATManager::is_other_model_format(int index)
+OpenedModelFile DATManager::open_model_file(int index)
 {
-    MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
-    if (!mft_entry || mft_entry->uncompressedSize < 13)
-        return false;
-
-    // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
-
-    bool is_other = IsOtherModelFormat(file_data);
-    delete[] data;
+    OpenedModelFile model_file{ read_file_data(index), {} };
+    if (model_file.data.empty())
+    {
+        model_file.model.emplace<FFNA_ModelFile>().parsed_correctly = false;
+        return model_file;
+    }
 
-    return is_other;
+    model_file.model = ParseModelFile(std::span<unsigned char>(model_file.data.data(), model_file.data.size()));
+    return model_file;
 }
 
 AMAT_file DATManager::parse_amat_file(int index)
@@ -128,6 +128,21 @@ std::vector<uint8_t> DATManager::parse_dds_file(int index)
     return file_data;
 }
 
+std::vector<uint8_t> DATManager::read_file_data(int index)
+{
+    MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
+    if (!mft_entry)
+        return {};
+
+    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
+    std::unique_ptr<unsigned char[]> data(m_dat.readFile(file_handle, index, true));
+    CloseHandle(file_handle);
+    if (!data)
+        return {};
+
+    return std::vector<uint8_t>(data.get(), data.get() + mft_entry->uncompressedSize);
+}
+
 bool DATManager::save_raw_decompressed_data_to_file(int index, std::wstring filepath)
 {
     MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
@@ -225,3 +240,212 @@ void DATManager::read_files_thread(Concurrency::concurrent_queue<int>& file_indi
 
     auto remaining_threads = m_num_running_dat_reader_threads.fetch_sub(1, std::memory_order_relaxed);
 }
+
+DatDiff DATManager::diff_against(DATManager& older, DatDiffProgress* progress)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    auto& new_mft = get_MFT();
+    auto& old_mft = older.get_MFT();
+
+    // Files with an id are matched by id, the others by their stored content.
+    std::unordered_map<int, int> old_by_id;
+    std::unordered_multimap<uint64_t, int> old_without_id;
+    for (int i = reserved_mft_entries; i < static_cast<int>(old_mft.size()); i++) {
+        if (!is_diffable(old_mft[i])) continue;
+
+        if (old_mft[i].Hash != 0) {
+            old_by_id.try_emplace(old_mft[i].Hash, i);
+        }
+        else {
+            old_without_id.emplace(stored_signature(old_mft[i]), i);
+        }
+    }
+
+    DatDiff diff;
+    std::vector<std::pair<int, int>> changed; // (old, new) with the same id but a different CRC or size
+    std::vector<int> added;
+    std::unordered_set<int> new_ids;
+    for (int i = reserved_mft_entries; i < static_cast<int>(new_mft.size()); i++) {
+        if (!is_diffable(new_mft[i])) continue;
+
+        if (new_mft[i].Hash != 0) {
+            if (!new_ids.insert(new_mft[i].Hash).second) continue;
+
+            const auto it = old_by_id.find(new_mft[i].Hash);
+            if (it == old_by_id.end()) {
+                added.push_back(i);
+                continue;
+            }
+
+            if (stored_signature(old_mft[it->second]) == stored_signature(new_mft[i])) {
+                diff.unchanged++;
+            }
+            else {
+                changed.emplace_back(it->second, i);
+            }
+            old_by_id.erase(it);
+        }
+        else {
+            const auto it = old_without_id.find(stored_signature(new_mft[i]));
+            if (it == old_without_id.end()) {
+                added.push_back(i);
+                continue;
+            }
+
+            diff.unchanged++;
+            old_without_id.erase(it);
+        }
+    }
+
+    std::vector<int> removed;
+    for (const auto& [id, i] : old_by_id) {
+        removed.push_back(i);
+    }
+    for (const auto& [signature, i] : old_without_id) {
+        removed.push_back(i);
+    }
+    std::ranges::sort(removed);
+
+    // Only the files that differ get decompressed. A fully loaded DAT already knows its murmurhash3s.
+    std::vector<int> old_to_read = removed;
+    std::vector<int> new_to_read = added;
+    for (const auto& [old_index, new_index] : changed) {
+        old_to_read.push_back(old_index);
+        new_to_read.push_back(new_index);
+    }
+    diff.files_read += older.read_files_for_diff(old_to_read, progress);
+    if (m_initialization_state != InitializationState::Completed) {
+        diff.files_read += read_files_for_diff(new_to_read, progress);
+    }
+    if (progress && progress->stop_requested) {
+        return diff;
+    }
+
+    const auto make_change = [&](DatChangeType type, int old_index, int new_index) {
+        DatChange change{ type };
+        change.old_mft_index = old_index;
+        change.new_mft_index = new_index;
+        if (old_index >= 0) {
+            const auto& entry = old_mft[old_index];
+            change.file_id = entry.Hash;
+            change.file_type = entry.type;
+            change.old_murmurhash3 = entry.murmurhash3;
+            change.old_size = entry.uncompressedSize;
+        }
+        if (new_index >= 0) {
+            const auto& entry = new_mft[new_index];
+            if (old_index >= 0 && entry.Hash != change.file_id) {
+                change.old_file_id = change.file_id;
+            }
+            change.file_id = entry.Hash;
+            change.file_type = entry.type;
+            change.new_murmurhash3 = entry.murmurhash3;
+            change.new_size = entry.uncompressedSize;
+        }
+        return change;
+    };
+
+    for (const auto& [old_index, new_index] : changed) {
+        if (content_signature(old_mft[old_index]) == content_signature(new_mft[new_index])) {
+            diff.unchanged++;
+            diff.recompressed++;
+        }
+        else {
+            diff.changes.push_back(make_change(DatChangeType::Modified, old_index, new_index));
+        }
+    }
+
+    // A removed file whose content shows up as an added one was moved to another id.
+    std::unordered_multimap<uint64_t, int> removed_by_content;
+    for (int i : removed) {
+        if (old_mft[i].uncompressedSize >= 0) {
+            removed_by_content.emplace(content_signature(old_mft[i]), i);
+        }
+    }
+    for (int i : added) {
+        const auto it = new_mft[i].uncompressedSize >= 0 ? removed_by_content.find(content_signature(new_mft[i])) : removed_by_content.end();
+        if (it != removed_by_content.end()) {
+            diff.changes.push_back(make_change(DatChangeType::Moved, it->second, i));
+            removed_by_content.erase(it);
+        }
+        else {
+            diff.changes.push_back(make_change(DatChangeType::Added, -1, i));
+        }
+    }
+    for (const auto& [content, i] : removed_by_content) {
+        diff.changes.push_back(make_change(DatChangeType::Removed, i, -1));
+    }
+    for (int i : removed) {
+        if (old_mft[i].uncompressedSize < 0) {
+            diff.changes.push_back(make_change(DatChangeType::Removed, i, -1));
+        }
+    }
+
+    std::ranges::sort(diff.changes, {}, [](const DatChange& change) {
+        return std::make_tuple(change.new_mft_index < 0, change.new_mft_index, change.old_mft_index);
+    });
+    diff.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    return diff;
+}
+
+int DATManager::read_files_for_diff(const std::vector<int>& indices, DatDiffProgress* progress)
+{
+    auto& mft = get_MFT();
+
+    // File ids that share a stored file share its MFT entry data, decompress it once.
+    std::unordered_map<__int64, int> first_by_offset;
+    std::vector<int> unique_indices;
+    std::vector<std::pair<int, int>> shared_indices; // (index, index that gets read)
+    for (int i : indices) {
+        const auto [it, inserted] = first_by_offset.try_emplace(mft[i].Offset, i);
+        if (inserted) {
+            unique_indices.push_back(i);
+        }
+        else {
+            shared_indices.emplace_back(i, it->second);
+        }
+    }
+    // Sweep the DAT front to back.
+    std::ranges::sort(unique_indices, {}, [&](int i) { return mft[i].Offset; });
+    if (progress) {
+        progress->files_to_read += static_cast<int>(unique_indices.size());
+    }
+
+    std::atomic<size_t> next_index{0};
+    const unsigned num_threads = std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned>(unique_indices.size())));
+    {
+        std::vector<std::jthread> threads;
+        for (unsigned t = 0; t < num_threads; t++) {
+            threads.emplace_back([&] {
+                HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
+                while (!(progress && progress->stop_requested)) {
+                    const size_t k = next_index.fetch_add(1);
+                    if (k >= unique_indices.size()) break;
+
+                    auto& entry = mft[unique_indices[k]];
+                    if (entry.type == NOTREAD) {
+                        entry.murmurhash3 = 0; // Not initialized by an MFT only read
+                    }
+                    try
+                    {
+                        delete[] m_dat.readFile(file_handle, unique_indices[k], false);
+                    }
+                    catch (...)
+                    {
+                    }
+                    if (progress) {
+                        progress->files_read++;
+                    }
+                }
+                CloseHandle(file_handle);
+            });
+        }
+    } // jthread joins
+
+    for (const auto& [i, read_index] : shared_indices) {
+        mft[i].type = mft[read_index].type;
+        mft[i].uncompressedSize = mft[read_index].uncompressedSize;
+        mft[i].murmurhash3 = mft[read_index].murmurhash3;
+    }
+    return static_cast<int>(unique_indices.size());
+}
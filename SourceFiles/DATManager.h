@@ -3,6 +3,8 @@
 #include "FFNA_MapFile.h"
 #include "FFNA_ModelFile.h"
 #include "FFNA_ModelFile_Other.h"
+#include "AnyModelFile.h"
+#include "DatDiff.h"
 #include <ppl.h>
 #include <concurrent_queue.h>
 
@@ -34,6 +36,14 @@ public:
         return true;
     }
 
+    // Reads only the header and the MFT. Types, decompressed sizes and murmurhash3s stay unknown until a
+    // file is read, which is all diff_against needs from an older DAT.
+    bool InitMFTOnly(std::wstring dat_filepath)
+    {
+        m_dat_filepath = dat_filepath;
+        return m_dat.readDat(m_dat_filepath.c_str()) != 0;
+    }
+
     std::atomic<InitializationState> m_initialization_state{NotStarted};
 
     int get_num_files_type_read() { return m_num_types_read; }
@@ -47,8 +57,8 @@ public:
 
     FFNA_MapFile parse_ffna_map_file(int index);
     FFNA_ModelFile parse_ffna_model_file(int index);
-    FFNA_ModelFile_Other parse_ffna_model_file_other(int index);
-    bool is_other_model_format(int index);
+    // Reads and decompresses a model file once and parses it in whichever format it is in.
+    OpenedModelFile open_model_file(int index);
     AMAT_file parse_amat_file(int index);
     DatTexture parse_ffna_texture_file(int index);
     std::vector<uint8_t> parse_dds_file(int index);
@@ -63,6 +73,14 @@ public:
         return data;
     }
 
+    // Decompressed contents of a file, empty if it couldn't be read.
+    std::vector<uint8_t> read_file_data(int index);
+
+    // Compares this DAT with an older snapshot of it. Files are matched by file id, files without one by
+    // content. Only entries whose CRC or compressed size differ are decompressed, on every hardware thread,
+    // to tell real changes from recompressed files and to find content that moved to another file id.
+    DatDiff diff_against(DATManager& older, DatDiffProgress* progress = nullptr);
+
     int get_num_files_for_type(FileType type) {
         return num_files_per_type[type];
     }
@@ -79,4 +97,8 @@ private:
     void read_all_files();
 
     void read_files_thread(Concurrency::concurrent_queue<int>& file_indices_queue);
+
+    // Decompresses the given entries once per stored file to fill in their type, size and murmurhash3.
+    // Returns the number of files decompressed.
+    int read_files_for_diff(const std::vector<int>& indices, DatDiffProgress* progress);
 };
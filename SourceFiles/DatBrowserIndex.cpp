@@ -0,0 +1,486 @@
+#include "pch.h"
+#include "DatBrowserIndex.h"
+#include "draw_dat_browser.h"
+#include <bit>
+#include <emmintrin.h>
+
+namespace
+{
+    // A value gets a bitmap once its row list would be larger than a bitmap of all rows.
+    constexpr size_t DENSE_POSTINGS_RATIO = 32;
+
+    // Name matches rank 0-3, see TrigramIndex::GetMatchRank.
+    constexpr int TEXT_CONTENTS_MATCH_RANK = 4;
+    constexpr int NO_MATCH_RANK = 5;
+
+    // Splits the ^ prefix marker off a name filter.
+    std::string_view parse_name_filter(const std::string& name_filter, bool& prefix_only)
+    {
+        prefix_only = name_filter.starts_with('^');
+        return std::string_view(name_filter).substr(prefix_only ? 1 : 0);
+    }
+
+    bool is_placeholder_name(std::string_view name) { return name == "" || name == "-"; }
+}
+
+void RowBitmap::Reset(size_t row_count, bool value)
+{
+    m_row_count = row_count;
+    m_words.assign((row_count + 63) / 64, value ? ~uint64_t(0) : 0);
+    if (value && (row_count & 63)) {
+        m_words.back() = (uint64_t(1) << (row_count & 63)) - 1;
+    }
+}
+
+void RowBitmap::SetRows(std::span<const uint32_t> rows)
+{
+    for (const auto row : rows) {
+        Set(row);
+    }
+}
+
+void RowBitmap::And(const RowBitmap& other)
+{
+    const size_t word_count = std::min(m_words.size(), other.m_words.size());
+    size_t i = 0;
+    for (; i + 2 <= word_count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_words[i]));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&other.m_words[i]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_words[i]), _mm_and_si128(a, b));
+    }
+    for (; i < word_count; i++) {
+        m_words[i] &= other.m_words[i];
+    }
+}
+
+void RowBitmap::Or(const RowBitmap& other)
+{
+    const size_t word_count = std::min(m_words.size(), other.m_words.size());
+    size_t i = 0;
+    for (; i + 2 <= word_count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_words[i]));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&other.m_words[i]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_words[i]), _mm_or_si128(a, b));
+    }
+    for (; i < word_count; i++) {
+        m_words[i] |= other.m_words[i];
+    }
+}
+
+void RowBitmap::AppendRows(std::vector<uint32_t>& rows) const
+{
+    for (size_t i = 0; i < m_words.size(); i++) {
+        uint64_t word = m_words[i];
+        while (word) {
+            rows.push_back(static_cast<uint32_t>(i * 64 + std::countr_zero(word)));
+            word &= word - 1;
+        }
+    }
+}
+
+void PostingIndex::Build(std::vector<std::pair<uint32_t, uint32_t>>& value_rows, size_t row_count)
+{
+    Clear();
+    std::sort(value_rows.begin(), value_rows.end());
+    value_rows.erase(std::unique(value_rows.begin(), value_rows.end()), value_rows.end());
+
+    m_offsets.push_back(0);
+    for (size_t begin = 0; begin < value_rows.size();) {
+        const uint32_t value = value_rows[begin].first;
+        size_t end = begin;
+        while (end < value_rows.size() && value_rows[end].first == value) end++;
+
+        const size_t count = end - begin;
+        if (count * DENSE_POSTINGS_RATIO > row_count) {
+            auto& bitmap = m_bitmaps.emplace_back();
+            bitmap.Reset(row_count, false);
+            for (size_t i = begin; i < end; i++) bitmap.Set(value_rows[i].second);
+            m_dense_values.push_back(value);
+            m_dense_counts.push_back(static_cast<uint32_t>(count));
+        }
+        else {
+            for (size_t i = begin; i < end; i++) m_rows.push_back(value_rows[i].second);
+            m_values.push_back(value);
+            m_offsets.push_back(static_cast<uint32_t>(m_rows.size()));
+        }
+        begin = end;
+    }
+
+    m_values.shrink_to_fit();
+    m_offsets.shrink_to_fit();
+    m_rows.shrink_to_fit();
+}
+
+void PostingIndex::Clear()
+{
+    m_values.clear();
+    m_offsets.clear();
+    m_rows.clear();
+    m_dense_values.clear();
+    m_dense_counts.clear();
+    m_bitmaps.clear();
+}
+
+PostingIndex::Postings PostingIndex::Find(uint32_t value) const
+{
+    Postings postings;
+
+    const auto dense_it = std::lower_bound(m_dense_values.begin(), m_dense_values.end(), value);
+    if (dense_it != m_dense_values.end() && *dense_it == value) {
+        const size_t i = dense_it - m_dense_values.begin();
+        postings.bitmap = &m_bitmaps[i];
+        postings.count = m_dense_counts[i];
+        return postings;
+    }
+
+    const auto it = std::lower_bound(m_values.begin(), m_values.end(), value);
+    if (it != m_values.end() && *it == value) {
+        const size_t i = it - m_values.begin();
+        postings.rows = std::span<const uint32_t>(m_rows.data() + m_offsets[i], m_offsets[i + 1] - m_offsets[i]);
+        postings.count = static_cast<uint32_t>(postings.rows.size());
+    }
+    return postings;
+}
+
+size_t PostingIndex::GetMemoryUsage() const
+{
+    size_t size = (m_values.capacity() + m_offsets.capacity() + m_rows.capacity() + m_dense_values.capacity() + m_dense_counts.capacity()) *
+        sizeof(uint32_t);
+    for (const auto& bitmap : m_bitmaps) {
+        size += bitmap.GetMemoryUsage();
+    }
+    return size;
+}
+
+void DatBrowserIndex::Clear()
+{
+    *this = DatBrowserIndex();
+}
+
+uint32_t DatBrowserIndex::AddName(const std::string& name)
+{
+    const auto [it, inserted] = m_name_lookup.try_emplace(name, static_cast<uint32_t>(GetNameCount()));
+    if (inserted) {
+        m_names += name;
+        m_name_offsets.push_back(static_cast<uint32_t>(m_names.size()));
+        m_name_search.Add(name);
+    }
+    return it->second;
+}
+
+void DatBrowserIndex::Add(const DatBrowserItem& item)
+{
+    m_ids.push_back(item.id);
+    m_hashes.push_back(item.hash);
+    m_types.push_back(static_cast<uint8_t>(item.type));
+    m_sizes.push_back(item.size);
+    m_decompressed_sizes.push_back(item.decompressed_size);
+    m_file_ids_0.push_back(item.file_id_0);
+    m_file_ids_1.push_back(item.file_id_1);
+    m_murmurhash3s.push_back(item.murmurhash3);
+
+    m_map_ids.insert(m_map_ids.end(), item.map_ids.begin(), item.map_ids.end());
+    m_map_id_offsets.push_back(static_cast<uint32_t>(m_map_ids.size()));
+
+    for (const auto is_pvp : item.is_pvp) {
+        m_is_pvp.push_back(static_cast<uint8_t>(is_pvp));
+    }
+    m_is_pvp_offsets.push_back(static_cast<uint32_t>(m_is_pvp.size()));
+
+    for (const auto& name : item.names) {
+        m_row_names.push_back(AddName(name));
+    }
+    m_row_name_offsets.push_back(static_cast<uint32_t>(m_row_names.size()));
+}
+
+void DatBrowserIndex::Finalize()
+{
+    const size_t row_count = Size();
+    std::vector<std::pair<uint32_t, uint32_t>> value_rows;
+    value_rows.reserve(row_count);
+
+    const auto build_column = [&](PostingIndex& index, auto get_value) {
+        value_rows.clear();
+        for (uint32_t row = 0; row < row_count; row++) {
+            value_rows.emplace_back(get_value(row), row);
+        }
+        index.Build(value_rows, row_count);
+    };
+
+    build_column(m_id_index, [&](uint32_t row) { return m_ids[row]; });
+    build_column(m_hash_index, [&](uint32_t row) { return m_hashes[row]; });
+    build_column(m_file_id_0_index, [&](uint32_t row) { return m_file_ids_0[row]; });
+    build_column(m_file_id_1_index, [&](uint32_t row) { return m_file_ids_1[row]; });
+    build_column(m_type_index, [&](uint32_t row) { return m_types[row]; });
+    build_column(m_murmurhash3_index, [&](uint32_t row) { return m_murmurhash3s[row]; });
+
+    BuildMultiValuedPostings();
+}
+
+void DatBrowserIndex::BuildMultiValuedPostings()
+{
+    const size_t row_count = Size();
+    std::vector<std::pair<uint32_t, uint32_t>> value_rows;
+
+    for (uint32_t row = 0; row < row_count; row++) {
+        for (const auto map_id : GetMapIds(row)) value_rows.emplace_back(map_id, row);
+    }
+    m_map_id_index.Build(value_rows, row_count);
+
+    value_rows.clear();
+    for (uint32_t row = 0; row < row_count; row++) {
+        for (const auto is_pvp : GetIsPvp(row)) value_rows.emplace_back(is_pvp != 0, row);
+    }
+    m_pvp_index.Build(value_rows, row_count);
+
+    value_rows.clear();
+    for (uint32_t row = 0; row < row_count; row++) {
+        for (const auto name_id : GetNameIds(row)) {
+            if (!is_placeholder_name(GetName(name_id))) value_rows.emplace_back(name_id, row);
+        }
+    }
+    m_name_index.Build(value_rows, row_count);
+}
+
+void DatBrowserIndex::UpdateRows(std::span<const DatBrowserItem> items)
+{
+    if (items.empty()) return;
+
+    std::vector<const DatBrowserItem*> updates(Size(), nullptr);
+    for (const auto& item : items) {
+        updates[item.id] = &item;
+    }
+
+    std::vector<uint32_t> map_ids;
+    std::vector<uint32_t> map_id_offsets{ 0 };
+    std::vector<uint8_t> is_pvp;
+    std::vector<uint32_t> is_pvp_offsets{ 0 };
+    std::vector<uint32_t> row_names;
+    std::vector<uint32_t> row_name_offsets{ 0 };
+    map_ids.reserve(m_map_ids.size());
+    is_pvp.reserve(m_is_pvp.size());
+    row_names.reserve(m_row_names.size());
+
+    for (uint32_t row = 0; row < Size(); row++) {
+        if (const auto* item = updates[row]) {
+            map_ids.insert(map_ids.end(), item->map_ids.begin(), item->map_ids.end());
+            for (const auto value : item->is_pvp) is_pvp.push_back(static_cast<uint8_t>(value));
+            for (const auto& name : item->names) row_names.push_back(AddName(name));
+        }
+        else {
+            const auto row_map_ids = GetMapIds(row);
+            const auto row_is_pvp = GetIsPvp(row);
+            const auto row_name_ids = GetNameIds(row);
+            map_ids.insert(map_ids.end(), row_map_ids.begin(), row_map_ids.end());
+            is_pvp.insert(is_pvp.end(), row_is_pvp.begin(), row_is_pvp.end());
+            row_names.insert(row_names.end(), row_name_ids.begin(), row_name_ids.end());
+        }
+        map_id_offsets.push_back(static_cast<uint32_t>(map_ids.size()));
+        is_pvp_offsets.push_back(static_cast<uint32_t>(is_pvp.size()));
+        row_name_offsets.push_back(static_cast<uint32_t>(row_names.size()));
+    }
+
+    m_map_ids = std::move(map_ids);
+    m_map_id_offsets = std::move(map_id_offsets);
+    m_is_pvp = std::move(is_pvp);
+    m_is_pvp_offsets = std::move(is_pvp_offsets);
+    m_row_names = std::move(row_names);
+    m_row_name_offsets = std::move(row_name_offsets);
+
+    BuildMultiValuedPostings();
+}
+
+void DatBrowserIndex::AddText(uint32_t row, std::string_view text)
+{
+    if (m_text_documents.contains(row)) return;
+
+    m_text_documents.emplace(row, m_text_search.Add(text));
+    m_text_rows.push_back(row);
+}
+
+std::string_view DatBrowserIndex::GetName(uint32_t name_id) const
+{
+    return std::string_view(m_names).substr(m_name_offsets[name_id], m_name_offsets[name_id + 1] - m_name_offsets[name_id]);
+}
+
+DatBrowserItem DatBrowserIndex::GetItem(uint32_t row) const
+{
+    DatBrowserItem item{ GetId(row), GetHash(row), GetType(row), GetSize(row), GetDecompressedSize(row), GetFileId0(row), GetFileId1(row), {}, {}, {}, GetMurmurhash3(row) };
+
+    const auto map_ids = GetMapIds(row);
+    item.map_ids.assign(map_ids.begin(), map_ids.end());
+    for (const auto name_id : GetNameIds(row)) {
+        item.names.emplace_back(GetName(name_id));
+    }
+    const auto is_pvp = GetIsPvp(row);
+    item.is_pvp.assign(is_pvp.begin(), is_pvp.end());
+    return item;
+}
+
+void DatBrowserIndex::Filter(const DatBrowserFilter& filter, std::vector<uint32_t>& rows) const
+{
+    rows.clear();
+    const size_t row_count = Size();
+    if (filter.IsEmpty()) {
+        rows.resize(row_count);
+        std::iota(rows.begin(), rows.end(), 0u);
+        return;
+    }
+
+    std::vector<PostingIndex::Postings> terms;
+    if (filter.id) terms.push_back(m_id_index.Find(*filter.id));
+    if (filter.hash) terms.push_back(m_hash_index.Find(*filter.hash));
+
+    if (filter.filename) {
+        const uint16_t id0 = *filter.filename & 0xFFFF;
+        const uint16_t id1 = (*filter.filename >> 16) & 0xFFFF;
+
+        // A partial filename only filters on the halves that exist. Full filenames are also matched with the
+        // halves swapped, they are often written in the other order.
+        const bool is_full_filename_hash = id0 > 0xFF && id1 > 0xFF;
+        if (!is_full_filename_hash) {
+            if (m_file_id_0_index.Contains(id0)) terms.push_back(m_file_id_0_index.Find(id0));
+            if (m_file_id_1_index.Contains(id1)) terms.push_back(m_file_id_1_index.Find(id1));
+        }
+        else if (m_file_id_0_index.Contains(id0) && m_file_id_1_index.Contains(id1)) {
+            terms.push_back(m_file_id_0_index.Find(id0));
+            terms.push_back(m_file_id_1_index.Find(id1));
+        }
+        else if (m_file_id_0_index.Contains(id1) && m_file_id_1_index.Contains(id0)) {
+            terms.push_back(m_file_id_0_index.Find(id1));
+            terms.push_back(m_file_id_1_index.Find(id0));
+        }
+        else {
+            return;
+        }
+    }
+
+    if (filter.type != NONE) terms.push_back(m_type_index.Find(filter.type));
+    if (filter.map_id) terms.push_back(m_map_id_index.Find(*filter.map_id));
+    if (filter.pvp != -1) terms.push_back(m_pvp_index.Find(filter.pvp == 1));
+    if (filter.murmurhash3) terms.push_back(m_murmurhash3_index.Find(*filter.murmurhash3));
+
+    RowBitmap name_rows;
+    if (!filter.name.empty()) {
+        PostingIndex::Postings name_postings;
+        name_postings.bitmap = &name_rows;
+        FindNameRows(filter.name, name_rows, name_postings.count);
+        terms.push_back(name_postings);
+    }
+
+    for (const auto& term : terms) {
+        if (term.count == 0) return;
+    }
+
+    std::sort(terms.begin(), terms.end(), [](const auto& a, const auto& b) { return a.count < b.count; });
+
+    // Bitmaps of the other sparse terms, so every term can be tested per row.
+    std::vector<RowBitmap> sparse_bitmaps;
+    std::vector<const RowBitmap*> other_bitmaps;
+    sparse_bitmaps.reserve(terms.size());
+    for (size_t i = 1; i < terms.size(); i++) {
+        if (terms[i].bitmap) {
+            other_bitmaps.push_back(terms[i].bitmap);
+        }
+        else {
+            auto& bitmap = sparse_bitmaps.emplace_back();
+            bitmap.Reset(row_count, false);
+            bitmap.SetRows(terms[i].rows);
+            other_bitmaps.push_back(&bitmap);
+        }
+    }
+
+    const auto& shortest = terms.front();
+    if (shortest.bitmap) {
+        RowBitmap result = *shortest.bitmap;
+        for (const auto* bitmap : other_bitmaps) {
+            result.And(*bitmap);
+        }
+        result.AppendRows(rows);
+    }
+    else {
+        for (const auto row : shortest.rows) {
+            if (std::all_of(other_bitmaps.begin(), other_bitmaps.end(), [row](const RowBitmap* bitmap) { return bitmap->Test(row); })) {
+                rows.push_back(row);
+            }
+        }
+    }
+}
+
+void DatBrowserIndex::FindNameRows(const std::string& name_filter, RowBitmap& rows, uint32_t& count) const
+{
+    rows.Reset(Size(), false);
+    count = 0;
+
+    bool prefix_only = false;
+    const auto query = parse_name_filter(name_filter, prefix_only);
+
+    std::vector<uint32_t> documents;
+    m_name_search.Search(query, prefix_only, documents);
+    for (const auto name_id : documents) {
+        const auto postings = m_name_index.Find(name_id);
+        if (postings.bitmap) rows.Or(*postings.bitmap);
+        else rows.SetRows(postings.rows);
+        count += postings.count;
+    }
+
+    m_text_search.Search(query, prefix_only, documents);
+    for (const auto document : documents) {
+        rows.Set(m_text_rows[document]);
+        count++;
+    }
+}
+
+void DatBrowserIndex::SortByRelevance(const std::string& name_filter, std::vector<uint32_t>& rows) const
+{
+    bool prefix_only = false;
+    const std::string query = TrigramIndex::ToLowerCase(parse_name_filter(name_filter, prefix_only));
+
+    struct RankedRow
+    {
+        int rank;
+        size_t length;
+        uint32_t row;
+    };
+    std::vector<RankedRow> ranked_rows;
+    ranked_rows.reserve(rows.size());
+
+    for (const auto row : rows) {
+        RankedRow ranked_row{ NO_MATCH_RANK, std::numeric_limits<size_t>::max(), row };
+        for (const auto name_id : GetNameIds(row)) {
+            const auto name = m_name_search.GetText(name_id);
+            const int rank = TrigramIndex::GetMatchRank(name, query);
+            if (rank >= 0 && (rank < ranked_row.rank || (rank == ranked_row.rank && name.size() < ranked_row.length))) {
+                ranked_row.rank = rank;
+                ranked_row.length = name.size();
+            }
+        }
+        if (ranked_row.rank == NO_MATCH_RANK && m_text_documents.contains(row)) {
+            ranked_row.rank = TEXT_CONTENTS_MATCH_RANK;
+        }
+        ranked_rows.push_back(ranked_row);
+    }
+
+    std::stable_sort(ranked_rows.begin(), ranked_rows.end(), [](const RankedRow& a, const RankedRow& b) {
+        return a.rank != b.rank ? a.rank < b.rank : a.length < b.length;
+    });
+    for (size_t i = 0; i < rows.size(); i++) {
+        rows[i] = ranked_rows[i].row;
+    }
+}
+
+size_t DatBrowserIndex::GetMemoryUsage() const
+{
+    size_t size = (m_ids.capacity() + m_hashes.capacity() + m_sizes.capacity() + m_decompressed_sizes.capacity() + m_murmurhash3s.capacity()) * sizeof(uint32_t) +
+        m_types.capacity() + (m_file_ids_0.capacity() + m_file_ids_1.capacity()) * sizeof(uint16_t);
+    size += (m_map_ids.capacity() + m_map_id_offsets.capacity() + m_is_pvp_offsets.capacity() + m_row_names.capacity() + m_row_name_offsets.capacity()) * sizeof(uint32_t) +
+        m_is_pvp.capacity();
+    size += m_names.capacity() + m_name_offsets.capacity() * sizeof(uint32_t) + m_name_search.GetMemoryUsage();
+    size += m_text_search.GetMemoryUsage() + m_text_rows.capacity() * sizeof(uint32_t);
+
+    for (const auto* index : { &m_id_index, &m_hash_index, &m_file_id_0_index, &m_file_id_1_index, &m_type_index, &m_map_id_index,
+        &m_pvp_index, &m_murmurhash3_index, &m_name_index }) {
+        size += index->GetMemoryUsage();
+    }
+    return size;
+}
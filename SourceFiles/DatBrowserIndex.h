@@ -0,0 +1,196 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "GWUnpacker.h"
+#include "TrigramIndex.h"
+
+struct DatBrowserItem;
+
+// One bit per row, rows are MFT indices.
+class RowBitmap
+{
+public:
+    void Reset(size_t row_count, bool value);
+    void Set(uint32_t row) { m_words[row >> 6] |= uint64_t(1) << (row & 63); }
+    bool Test(uint32_t row) const { return (m_words[row >> 6] >> (row & 63)) & 1; }
+
+    void SetRows(std::span<const uint32_t> rows);
+    void And(const RowBitmap& other);
+    void Or(const RowBitmap& other);
+
+    // Appends the set rows in ascending order.
+    void AppendRows(std::vector<uint32_t>& rows) const;
+
+    size_t GetMemoryUsage() const { return m_words.capacity() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> m_words;
+    size_t m_row_count = 0;
+};
+
+/**
+ * @brief Rows per value of one attribute.
+ *
+ * Each value keeps either a sorted row list or, when it matches more than 1/32 of the rows and a bitmap is
+ * smaller than the list, a RowBitmap. Low cardinality attributes like the file type end up as bitmaps, ids and
+ * hashes as short lists.
+ */
+class PostingIndex
+{
+public:
+    struct Postings
+    {
+        std::span<const uint32_t> rows;
+        const RowBitmap* bitmap = nullptr; // Set instead of rows for dense values.
+        uint32_t count = 0;
+    };
+
+    void Build(std::vector<std::pair<uint32_t, uint32_t>>& value_rows, size_t row_count);
+    void Clear();
+
+    // Empty postings if no row has the value.
+    Postings Find(uint32_t value) const;
+    bool Contains(uint32_t value) const { return Find(value).count > 0; }
+
+    size_t GetMemoryUsage() const;
+
+private:
+    // Sparse values, rows of m_values[i] are [m_offsets[i], m_offsets[i + 1]) of m_rows.
+    std::vector<uint32_t> m_values; // Sorted
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_rows;
+
+    // Dense values
+    std::vector<uint32_t> m_dense_values; // Sorted
+    std::vector<uint32_t> m_dense_counts;
+    std::vector<RowBitmap> m_bitmaps;
+};
+
+// What the DAT browser filters on. Unset fields don't constrain the result.
+struct DatBrowserFilter
+{
+    std::optional<uint32_t> id;
+    std::optional<uint32_t> hash;
+    std::optional<uint32_t> filename; // file_id_0 in the low and file_id_1 in the high 16 bits
+    std::optional<uint32_t> map_id;
+    std::optional<uint32_t> murmurhash3;
+    FileType type = NONE;
+    int pvp = -1; // -1 means no filter, 0 means false, 1 means true
+    // Case insensitive substring of a name or of the contents of a text file. A leading ^ only matches prefixes.
+    std::string name;
+
+    bool IsEmpty() const
+    {
+        return !id && !hash && !filename && !map_id && !murmurhash3 && type == NONE && pvp == -1 && name.empty();
+    }
+};
+
+/**
+ * @brief Struct of arrays store of the DAT browser rows with posting lists for filtering.
+ *
+ * Rows are added in MFT order so a row is its MFT index. Names are deduplicated into a string pool, map names
+ * are shared by all files of the map. A filter intersects the postings of each set field, starting from the
+ * shortest list and testing its rows against the others, or ANDing bitmaps when every field is dense.
+ * Names and the text file contents added with AddText are searched through trigram indices.
+ */
+class DatBrowserIndex
+{
+public:
+    void Clear();
+    void Add(const DatBrowserItem& item);
+    // Builds the postings, call once after the last Add.
+    void Finalize();
+
+    // Replaces the names, map ids and pvp flags of the rows of items, e.g. after the custom file info changed.
+    // Only the postings of those multi valued columns are rebuilt.
+    void UpdateRows(std::span<const DatBrowserItem> items);
+
+    // Makes the contents of a text file searchable by the name filter.
+    void AddText(uint32_t row, std::string_view text);
+
+    size_t Size() const { return m_ids.size(); }
+
+    uint32_t GetId(uint32_t row) const { return m_ids[row]; }
+    uint32_t GetHash(uint32_t row) const { return m_hashes[row]; }
+    FileType GetType(uint32_t row) const { return static_cast<FileType>(m_types[row]); }
+    uint32_t GetSize(uint32_t row) const { return m_sizes[row]; }
+    uint32_t GetDecompressedSize(uint32_t row) const { return m_decompressed_sizes[row]; }
+    uint16_t GetFileId0(uint32_t row) const { return m_file_ids_0[row]; }
+    uint16_t GetFileId1(uint32_t row) const { return m_file_ids_1[row]; }
+    uint32_t GetMurmurhash3(uint32_t row) const { return m_murmurhash3s[row]; }
+
+    std::span<const uint32_t> GetMapIds(uint32_t row) const { return Range(m_map_ids, m_map_id_offsets, row); }
+    std::span<const uint8_t> GetIsPvp(uint32_t row) const { return Range(m_is_pvp, m_is_pvp_offsets, row); }
+    // Indices into the name pool, see GetName.
+    std::span<const uint32_t> GetNameIds(uint32_t row) const { return Range(m_row_names, m_row_name_offsets, row); }
+
+    size_t GetNameCount() const { return m_name_offsets.empty() ? 0 : m_name_offsets.size() - 1; }
+    std::string_view GetName(uint32_t name_id) const;
+
+    // Materializes a row for the code that works on whole items, e.g. the export functions.
+    DatBrowserItem GetItem(uint32_t row) const;
+
+    // Rows matching all set fields of filter in ascending order.
+    void Filter(const DatBrowserFilter& filter, std::vector<uint32_t>& rows) const;
+
+    // Orders rows matching a name filter by how well they match: exact names first, then name prefixes, word
+    // prefixes, other name matches and finally text contents. Ties keep their order.
+    void SortByRelevance(const std::string& name_filter, std::vector<uint32_t>& rows) const;
+
+    size_t GetMemoryUsage() const;
+
+private:
+    template <typename T>
+    static std::span<const T> Range(const std::vector<T>& values, const std::vector<uint32_t>& offsets, uint32_t row)
+    {
+        return std::span<const T>(values.data() + offsets[row], offsets[row + 1] - offsets[row]);
+    }
+
+    uint32_t AddName(const std::string& name);
+    void BuildMultiValuedPostings();
+    // Rows whose names or text contain the query of a name filter.
+    void FindNameRows(const std::string& name_filter, RowBitmap& rows, uint32_t& count) const;
+
+    // Columns
+    std::vector<uint32_t> m_ids;
+    std::vector<uint32_t> m_hashes;
+    std::vector<uint8_t> m_types;
+    std::vector<uint32_t> m_sizes;
+    std::vector<uint32_t> m_decompressed_sizes;
+    std::vector<uint16_t> m_file_ids_0;
+    std::vector<uint16_t> m_file_ids_1;
+    std::vector<uint32_t> m_murmurhash3s;
+
+    // Multi valued columns, values of row i are in [offsets[i], offsets[i + 1]).
+    std::vector<uint32_t> m_map_ids;
+    std::vector<uint32_t> m_map_id_offsets{ 0 };
+    std::vector<uint8_t> m_is_pvp;
+    std::vector<uint32_t> m_is_pvp_offsets{ 0 };
+    std::vector<uint32_t> m_row_names;
+    std::vector<uint32_t> m_row_name_offsets{ 0 };
+
+    // String pool, name i is [m_name_offsets[i], m_name_offsets[i + 1]) of m_names.
+    std::string m_names;
+    std::vector<uint32_t> m_name_offsets{ 0 };
+    std::unordered_map<std::string, uint32_t> m_name_lookup;
+    TrigramIndex m_name_search; // Document ids are name ids.
+
+    TrigramIndex m_text_search;
+    std::vector<uint32_t> m_text_rows; // Row of each text document
+    std::unordered_map<uint32_t, uint32_t> m_text_documents; // Text document of each row that has one
+
+    PostingIndex m_id_index;
+    PostingIndex m_hash_index;
+    PostingIndex m_file_id_0_index;
+    PostingIndex m_file_id_1_index;
+    PostingIndex m_type_index;
+    PostingIndex m_map_id_index;
+    PostingIndex m_pvp_index;
+    PostingIndex m_murmurhash3_index;
+    PostingIndex m_name_index; // Keyed by name id, leaves out the "" and "-" placeholders.
+};
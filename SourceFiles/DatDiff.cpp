@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "DatDiff.h"
+#include "DATManager.h"
+#include <json.hpp>
+
+namespace
+{
+    const char* change_type_name(DatChangeType type)
+    {
+        switch (type) {
+        case DatChangeType::Added:
+            return "added";
+        case DatChangeType::Removed:
+            return "removed";
+        case DatChangeType::Modified:
+            return "modified";
+        case DatChangeType::Moved:
+            return "moved";
+        }
+        return "";
+    }
+
+    std::string to_utf8(const std::wstring& s)
+    {
+        const auto utf8 = std::filesystem::path(s).u8string();
+        return std::string(utf8.begin(), utf8.end());
+    }
+}
+
+int DatDiff::Count(DatChangeType type) const
+{
+    return static_cast<int>(std::ranges::count(changes, type, &DatChange::change));
+}
+
+std::vector<int> DatDiff::GetIndicesToExtract() const
+{
+    std::vector<int> indices;
+    for (const auto& change : changes) {
+        if (change.change == DatChangeType::Added || change.change == DatChangeType::Modified) {
+            indices.push_back(change.new_mft_index);
+        }
+    }
+    return indices;
+}
+
+// {
+//   "format": "gwmb_dat_changelog", "version": 1, "old_dat": ..., "new_dat": ...,
+//   "summary": { "added", "removed", "modified", "moved", "unchanged", "recompressed", "files_read", "seconds" },
+//   "changes": [ { "change": "added" | "removed" | "modified" | "moved", "file_id", "old_file_id" (moved only), "type",
+//                  "old": { "mft_index", "murmurhash3", "size" } (not for added), "new": { ... } (not for removed) } ]
+// }
+bool DatDiff::SaveChangelog(const std::filesystem::path& file_path, const std::wstring& old_dat_filepath,
+    const std::wstring& new_dat_filepath) const
+{
+    nlohmann::json changes_json = nlohmann::json::array();
+    for (const auto& change : changes) {
+        nlohmann::json change_json{
+            { "change", change_type_name(change.change) },
+            { "file_id", change.file_id },
+            { "type", typeToString(change.file_type) },
+        };
+        if (change.change == DatChangeType::Moved) {
+            change_json["old_file_id"] = change.old_file_id;
+        }
+        if (change.old_mft_index >= 0) {
+            change_json["old"] = { { "mft_index", change.old_mft_index }, { "murmurhash3", change.old_murmurhash3 }, { "size", change.old_size } };
+        }
+        if (change.new_mft_index >= 0) {
+            change_json["new"] = { { "mft_index", change.new_mft_index }, { "murmurhash3", change.new_murmurhash3 }, { "size", change.new_size } };
+        }
+        changes_json.push_back(std::move(change_json));
+    }
+
+    const nlohmann::json changelog{
+        { "format", "gwmb_dat_changelog" },
+        { "version", 1 },
+        { "old_dat", to_utf8(old_dat_filepath) },
+        { "new_dat", to_utf8(new_dat_filepath) },
+        { "summary", {
+            { "added", Count(DatChangeType::Added) },
+            { "removed", Count(DatChangeType::Removed) },
+            { "modified", Count(DatChangeType::Modified) },
+            { "moved", Count(DatChangeType::Moved) },
+            { "unchanged", unchanged },
+            { "recompressed", recompressed },
+            { "files_read", files_read },
+            { "seconds", seconds },
+        } },
+        { "changes", std::move(changes_json) },
+    };
+
+    std::ofstream file(file_path);
+    if (!file) {
+        return false;
+    }
+    file << changelog.dump(1, '\t');
+    return file.good();
+}
+
+DatDiffJob::~DatDiffJob()
+{
+    Stop();
+}
+
+void DatDiffJob::Start(DATManager* new_dat, std::wstring old_dat_filepath, std::filesystem::path save_directory)
+{
+    Stop();
+
+    m_new_dat = new_dat;
+    m_old_dat.reset();
+    m_old_dat_filepath = std::move(old_dat_filepath);
+    m_changelog_path = save_directory / "dat_changelog.json";
+    m_result = {};
+    m_error.clear();
+    m_progress.files_to_read = 0;
+    m_progress.files_read = 0;
+    m_progress.stop_requested = false;
+    m_done = false;
+
+    m_thread = std::jthread([this] { Run(); });
+}
+
+void DatDiffJob::Stop()
+{
+    m_progress.stop_requested = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_old_dat.reset();
+}
+
+void DatDiffJob::Run()
+{
+    m_old_dat = std::make_unique<DATManager>();
+    if (!m_old_dat->InitMFTOnly(m_old_dat_filepath)) {
+        m_error = L"Failed to read the MFT of the older DAT.";
+    }
+    else {
+        m_result = m_new_dat->diff_against(*m_old_dat, &m_progress);
+        if (!m_progress.stop_requested &&
+            !m_result.SaveChangelog(m_changelog_path, m_old_dat_filepath, m_new_dat->get_filepath())) {
+            m_error = std::format(L"Failed to write {}.", m_changelog_path.wstring());
+        }
+    }
+    m_done = true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class DATManager;
+
+enum class DatChangeType
+{
+    Added,
+    Removed,
+    Modified,
+    Moved // Same content under another file id
+};
+
+struct DatChange
+{
+    DatChangeType change;
+    int file_id = 0; // 0 for files without an id, they are matched by content
+    int old_file_id = 0; // Moved only
+    int old_mft_index = -1;
+    int new_mft_index = -1;
+    int file_type = 0;
+    uint32_t old_murmurhash3 = 0;
+    uint32_t new_murmurhash3 = 0;
+    int old_size = -1; // Decompressed sizes
+    int new_size = -1;
+};
+
+/**
+ * @brief Differences between two snapshots of a DAT, see DATManager::diff_against.
+ */
+struct DatDiff
+{
+    std::vector<DatChange> changes; // Ordered by new MFT index, removed files last
+    int unchanged = 0;
+    int recompressed = 0; // CRC or size differed but the decompressed content is the same
+    int files_read = 0; // Files decompressed to tell the above apart
+    double seconds = 0;
+
+    int Count(DatChangeType type) const;
+
+    // New MFT indices of the added and modified files, the ones worth extracting.
+    std::vector<int> GetIndicesToExtract() const;
+
+    // Writes the changes as JSON, see the implementation for the layout.
+    bool SaveChangelog(const std::filesystem::path& file_path, const std::wstring& old_dat_filepath,
+        const std::wstring& new_dat_filepath) const;
+};
+
+struct DatDiffProgress
+{
+    std::atomic<int> files_to_read{0};
+    std::atomic<int> files_read{0};
+    std::atomic<bool> stop_requested{false};
+};
+
+/**
+ * @brief Diffs a loaded DAT against an older one on a background thread and writes the changelog.
+ *
+ * The older DAT only gets its MFT read, its files are decompressed only where the MFT shows a change.
+ */
+class DatDiffJob
+{
+public:
+    ~DatDiffJob();
+
+    void Start(DATManager* new_dat, std::wstring old_dat_filepath, std::filesystem::path save_directory);
+    void Stop();
+
+    bool IsActive() const { return m_thread.joinable(); }
+    bool IsDone() const { return m_done.load(); }
+
+    int GetFilesToRead() const { return m_progress.files_to_read.load(); }
+    int GetFilesRead() const { return m_progress.files_read.load(); }
+
+    // Valid once done.
+    const DatDiff& GetResult() const { return m_result; }
+    const std::wstring& GetError() const { return m_error; }
+    const std::filesystem::path& GetChangelogPath() const { return m_changelog_path; }
+
+private:
+    void Run();
+
+    DATManager* m_new_dat = nullptr;
+    std::unique_ptr<DATManager> m_old_dat;
+    std::wstring m_old_dat_filepath;
+    std::filesystem::path m_changelog_path;
+
+    DatDiff m_result;
+    std::wstring m_error;
+
+    DatDiffProgress m_progress;
+    std::atomic<bool> m_done{false};
+    std::jthread m_thread;
+};
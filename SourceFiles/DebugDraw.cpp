@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "DebugDraw.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr UINT MIN_VERTEX_CAPACITY = 4096;
+    // Batches left over from earlier frames are dropped once there are more than this many,
+    // e.g. after colors that change every frame.
+    constexpr size_t MAX_CACHED_BATCHES = 64;
+
+    uint32_t quantize_channel(float value)
+    {
+        return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    uint64_t batch_key(D3D11_PRIMITIVE_TOPOLOGY topology, const XMFLOAT4& color)
+    {
+        const uint32_t packed_color = quantize_channel(color.x) | (quantize_channel(color.y) << 8) |
+            (quantize_channel(color.z) << 16) | (quantize_channel(color.w) << 24);
+        return (static_cast<uint64_t>(topology) << 32) | packed_color;
+    }
+}
+
+void DebugDraw::BeginFrame()
+{
+    if (m_batches.size() > MAX_CACHED_BATCHES) {
+        m_batches.clear();
+        m_batch_lookup.clear();
+    }
+
+    for (auto& batch : m_batches) {
+        batch.positions.clear();
+    }
+    m_needs_upload = true;
+}
+
+std::vector<XMFLOAT3>& DebugDraw::GetBatchPositions(D3D11_PRIMITIVE_TOPOLOGY topology, const XMFLOAT4& color)
+{
+    m_needs_upload = true;
+
+    const uint64_t key = batch_key(topology, color);
+    const auto it = m_batch_lookup.find(key);
+    if (it != m_batch_lookup.end()) {
+        return m_batches[it->second].positions;
+    }
+
+    m_batch_lookup.emplace(key, static_cast<uint32_t>(m_batches.size()));
+    auto& batch = m_batches.emplace_back();
+    batch.topology = topology;
+    batch.color = color;
+    return batch.positions;
+}
+
+void DebugDraw::AddLine(const XMFLOAT3& start, const XMFLOAT3& end, const XMFLOAT4& color)
+{
+    auto& positions = GetBatchPositions(D3D11_PRIMITIVE_TOPOLOGY_LINELIST, color);
+    positions.push_back(start);
+    positions.push_back(end);
+}
+
+void DebugDraw::AddLines(std::span<const XMFLOAT3> segment_points, const XMFLOAT4& color)
+{
+    if (segment_points.size() < 2) return;
+    auto& positions = GetBatchPositions(D3D11_PRIMITIVE_TOPOLOGY_LINELIST, color);
+    positions.insert(positions.end(), segment_points.begin(), segment_points.begin() + (segment_points.size() & ~size_t(1)));
+}
+
+void DebugDraw::AddLineStrip(std::span<const XMFLOAT3> points, const XMFLOAT4& color)
+{
+    if (points.size() < 2) return;
+    // Strips are expanded to line lists so they can share a batch with other lines of the same color.
+    auto& positions = GetBatchPositions(D3D11_PRIMITIVE_TOPOLOGY_LINELIST, color);
+    positions.reserve(positions.size() + (points.size() - 1) * 2);
+    for (size_t i = 1; i < points.size(); i++) {
+        positions.push_back(points[i - 1]);
+        positions.push_back(points[i]);
+    }
+}
+
+void DebugDraw::AddTriangle(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c, const XMFLOAT4& color)
+{
+    auto& positions = GetBatchPositions(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, color);
+    positions.push_back(a);
+    positions.push_back(b);
+    positions.push_back(c);
+}
+
+void DebugDraw::AddTriangles(std::span<const XMFLOAT3> triangle_points, const XMFLOAT4& color)
+{
+    if (triangle_points.size() < 3) return;
+    auto& positions = GetBatchPositions(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, color);
+    positions.insert(positions.end(), triangle_points.begin(), triangle_points.begin() + triangle_points.size() / 3 * 3);
+}
+
+size_t DebugDraw::GetVertexCount() const
+{
+    size_t count = 0;
+    for (const auto& batch : m_batches) {
+        count += batch.positions.size();
+    }
+    return count;
+}
+
+size_t DebugDraw::GetBatchCount() const
+{
+    return std::count_if(m_batches.begin(), m_batches.end(), [](const Batch& batch) { return !batch.positions.empty(); });
+}
+
+bool DebugDraw::Upload()
+{
+    m_needs_upload = false;
+    m_uploaded_vertex_count = 0;
+
+    const size_t vertex_count = GetVertexCount();
+    if (vertex_count == 0) {
+        return true;
+    }
+
+    if (vertex_count > m_vertex_capacity) {
+        const UINT new_capacity = std::max({ static_cast<UINT>(vertex_count), m_vertex_capacity * 2, MIN_VERTEX_CAPACITY });
+
+        D3D11_BUFFER_DESC vbDesc = {};
+        vbDesc.Usage = D3D11_USAGE_DYNAMIC;
+        vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        vbDesc.ByteWidth = sizeof(GWVertex) * new_capacity;
+        vbDesc.StructureByteStride = sizeof(GWVertex);
+
+        m_vertex_buffer.Reset();
+        m_vertex_capacity = 0;
+        if (FAILED(m_device->CreateBuffer(&vbDesc, nullptr, m_vertex_buffer.GetAddressOf()))) {
+            return false;
+        }
+        m_vertex_capacity = new_capacity;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    if (FAILED(m_deviceContext->Map(m_vertex_buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) {
+        return false;
+    }
+
+    auto* vertices = static_cast<GWVertex*>(mappedResource.pData);
+    const XMFLOAT3 normal(0.0f, 1.0f, 0.0f);
+    const XMFLOAT2 tex_coord(0.0f, 0.0f);
+    UINT next_vertex = 0;
+    for (auto& batch : m_batches) {
+        batch.first_vertex = next_vertex;
+        for (const auto& position : batch.positions) {
+            vertices[next_vertex++] = GWVertex(position, normal, tex_coord);
+        }
+    }
+    m_deviceContext->Unmap(m_vertex_buffer.Get(), 0);
+
+    m_uploaded_vertex_count = next_vertex;
+    return true;
+}
+
+void DebugDraw::Render(std::unordered_map<PixelShaderType, std::unique_ptr<PixelShader>>& pixel_shaders,
+    BlendStateManager* blend_state_manager, RasterizerStateManager* rasterizer_state_manager,
+    MeshManager* mesh_manager)
+{
+    if (m_needs_upload && !Upload()) {
+        return;
+    }
+    if (m_uploaded_vertex_count == 0) {
+        return;
+    }
+
+    UINT stride = sizeof(GWVertex);
+    UINT offset = 0;
+    m_deviceContext->IASetVertexBuffers(0, 1, m_vertex_buffer.GetAddressOf(), &stride, &offset);
+
+    const auto& pixel_shader = pixel_shaders[PixelShaderType::OldModel];
+    m_deviceContext->PSSetShader(pixel_shader->GetShader(), nullptr, 0);
+    m_deviceContext->PSSetSamplers(0, 1, pixel_shader->GetSamplerState());
+    m_deviceContext->PSSetSamplers(1, 1, pixel_shader->GetSamplerStateShadow());
+
+    blend_state_manager->SetBlendState(BlendState::AlphaBlend);
+    rasterizer_state_manager->SetRasterizerState(RasterizerStateType::Solid_NoCull);
+
+    // Identity world and no textures, so the pixel shader outputs object_color.
+    PerObjectCB per_object_data;
+    for (const auto& batch : m_batches) {
+        if (batch.positions.empty()) continue;
+
+        per_object_data.object_color = batch.color;
+        mesh_manager->SetPerObjectCB(per_object_data);
+
+        m_deviceContext->IASetPrimitiveTopology(batch.topology);
+        m_deviceContext->Draw(static_cast<UINT>(batch.positions.size()), batch.first_vertex);
+    }
+
+    m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "MeshManager.h"
+
+/**
+ * @brief Immediate mode line and triangle drawing for overlays.
+ *
+ * Primitives are submitted every frame between BeginFrame calls and grouped into
+ * batches by topology and color. All batches share one growable dynamic vertex
+ * buffer that is uploaded once per frame, so each batch costs a single draw call
+ * no matter how many primitives it holds. Colors go through PerObjectCB::object_color
+ * of the OldModel pixel shader, the same way as the MeshManager debug primitives.
+ */
+class DebugDraw
+{
+public:
+    DebugDraw(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+        : m_device(device)
+        , m_deviceContext(deviceContext)
+    {
+    }
+
+    // Drops the primitives submitted for the previous frame.
+    void BeginFrame();
+
+    void AddLine(const DirectX::XMFLOAT3& start, const DirectX::XMFLOAT3& end, const DirectX::XMFLOAT4& color);
+    // Points are consumed in pairs, one segment per pair.
+    void AddLines(std::span<const DirectX::XMFLOAT3> segment_points, const DirectX::XMFLOAT4& color);
+    void AddLineStrip(std::span<const DirectX::XMFLOAT3> points, const DirectX::XMFLOAT4& color);
+    void AddTriangle(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b, const DirectX::XMFLOAT3& c,
+        const DirectX::XMFLOAT4& color);
+    // Points are consumed in triples, one triangle per triple.
+    void AddTriangles(std::span<const DirectX::XMFLOAT3> triangle_points, const DirectX::XMFLOAT4& color);
+
+    // Draws everything submitted since BeginFrame. Can be called several times per frame (e.g. offscreen renders),
+    // the vertex buffer is only uploaded again when primitives were added in between.
+    void Render(std::unordered_map<PixelShaderType, std::unique_ptr<PixelShader>>& pixel_shaders,
+        BlendStateManager* blend_state_manager, RasterizerStateManager* rasterizer_state_manager,
+        MeshManager* mesh_manager);
+
+    size_t GetVertexCount() const;
+    size_t GetBatchCount() const;
+
+private:
+    struct Batch
+    {
+        D3D11_PRIMITIVE_TOPOLOGY topology;
+        DirectX::XMFLOAT4 color;
+        std::vector<DirectX::XMFLOAT3> positions;
+        UINT first_vertex = 0;
+    };
+
+    std::vector<DirectX::XMFLOAT3>& GetBatchPositions(D3D11_PRIMITIVE_TOPOLOGY topology, const DirectX::XMFLOAT4& color);
+    bool Upload();
+
+    ID3D11Device* m_device;
+    ID3D11DeviceContext* m_deviceContext;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertex_buffer;
+    UINT m_vertex_capacity = 0;
+    UINT m_uploaded_vertex_count = 0;
+    bool m_needs_upload = false;
+
+    // Batches persist across frames so their position vectors keep their capacity.
+    std::vector<Batch> m_batches;
+    std::unordered_map<uint64_t, uint32_t> m_batch_lookup;
+};
@@ -368,7 +368,6 @@ void DeviceResources::CreateWindowSizeDependentResources()
     m_d3dDepthStencilView.Reset();
     m_renderTarget.Reset();
     m_pickingRenderTarget.Reset();
-    m_pickingStagingTexture.Reset();
     m_depthStencil.Reset();
     m_d3dContext->Flush();
 
@@ -470,17 +469,9 @@ void DeviceResources::CreateWindowSizeDependentResources()
     ThrowIfFailed(m_d3dDevice->CreateRenderTargetView(m_pickingRenderTarget.Get(), &pickingTargetViewDesc,
         m_d3dPickingRenderTargetView.ReleaseAndGetAddressOf()));
 
-    // Staging texture to copy data from pickingRenderTarget to the staging texture on the GPU.
-    // Then I can access the data on the CPU through the staging texture. I must do this because the CPU cannot access a render targets data.
-    CD3D11_TEXTURE2D_DESC stagingTextureDesc(
-    DXGI_FORMAT_R8G8B8A8_UNORM, backBufferWidth, backBufferHeight, 1, 1, 0,
-    D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
-
-	  // Use Microsoft::WRL::ComPtr or your own ComPtr implementation
-	ThrowIfFailed(m_d3dDevice->CreateTexture2D(&stagingTextureDesc, nullptr, &m_pickingStagingTexture));
-
-    // When using multisampling (MSAA > 1x) we need to resolve the multisampled texture before we can copy it to the staging texture
-    // So we create this texture for that purpose.
+    // The CPU can't read render targets, PickingReadback copies the region around the cursor to staging textures.
+    // When using multisampling (MSAA > 1x) the picking target is resolved into this texture first, multisampled
+    // resources can only be copied as a whole.
     CD3D11_TEXTURE2D_DESC resolvedTextureDesc(
         DXGI_FORMAT_R8G8B8A8_UNORM,
         backBufferWidth,
@@ -567,7 +558,6 @@ void DeviceResources::HandleDeviceLost()
     m_d3dOffscreenRenderTargetView.Reset();
     m_renderTarget.Reset();
     m_pickingRenderTarget.Reset();
-    m_pickingStagingTexture.Reset();
     m_depthStencil.Reset();
     m_offscreenDepthStencil.Reset();
     m_offscreenNonMsaaTexture.Reset();
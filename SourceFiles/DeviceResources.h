@@ -59,7 +59,6 @@ namespace DX
         D3D_FEATURE_LEVEL       GetDeviceFeatureLevel() const noexcept  { return m_d3dFeatureLevel; }
         ID3D11Texture2D*        GetRenderTarget() const noexcept        { return m_renderTarget.Get(); }
         ID3D11Texture2D*        GetPickingRenderTarget() const noexcept        { return m_pickingRenderTarget.Get(); }
-        ID3D11Texture2D*        GetPickingStagingTexture() const noexcept { return m_pickingStagingTexture.Get(); }
         ID3D11Texture2D*        GetPickingNonMsaaTexture() const noexcept { return m_pickingNonMsaaTexture.Get(); }
         ID3D11Texture2D*        GetOffscreenRenderTarget() const noexcept { return m_offscreenRenderTarget.Get(); }
         ID3D11Texture2D*        GetOffscreenNonMsaaRenderTarget() const noexcept { return m_offscreenNonMsaaTexture.Get(); }
@@ -146,7 +145,6 @@ namespace DX
         D3D11_VIEWPORT                                  m_screenViewport;
 
         Microsoft::WRL::ComPtr<ID3D11Texture2D>         m_pickingRenderTarget;
-        Microsoft::WRL::ComPtr<ID3D11Texture2D>         m_pickingStagingTexture;
         Microsoft::WRL::ComPtr<ID3D11Texture2D>         m_pickingNonMsaaTexture;
         Microsoft::WRL::ComPtr<ID3D11RenderTargetView>  m_d3dPickingRenderTargetView;
 
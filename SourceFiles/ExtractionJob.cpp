@@ -0,0 +1,460 @@
+#include "pch.h"
+#include "ExtractionJob.h"
+#include "DATManager.h"
+#include <array>
+#include <charconv>
+#include <set>
+#include <unordered_map>
+
+namespace
+{
+    constexpr const char* manifest_filename = "extraction_manifest.tsv";
+    constexpr size_t tar_block_size = 512;
+
+    uint64_t content_key(uint32_t murmurhash3, uint32_t size)
+    {
+        return (static_cast<uint64_t>(murmurhash3) << 32) | size;
+    }
+
+    std::wstring to_wstring(const std::string& s)
+    {
+        return std::wstring(s.begin(), s.end());
+    }
+
+    template <typename T>
+    bool parse_number(std::string_view text, T& value)
+    {
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    struct ManifestRecord
+    {
+        uint32_t murmurhash3;
+        uint32_t size;
+        std::string storage;
+        std::string target;
+    };
+
+    // Later lines for the same path replace earlier ones.
+    std::unordered_map<std::string, ManifestRecord> load_manifest(const std::filesystem::path& file_path)
+    {
+        std::unordered_map<std::string, ManifestRecord> records;
+        std::ifstream file(file_path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            std::vector<std::string_view> fields;
+            std::string_view rest = line;
+            while (true) {
+                const size_t tab = rest.find('\t');
+                fields.push_back(rest.substr(0, tab));
+                if (tab == std::string_view::npos) break;
+                rest.remove_prefix(tab + 1);
+            }
+            if (fields.size() != 5) continue; // Cut off by an interrupted run
+
+            ManifestRecord record;
+            if (!parse_number(fields[1], record.murmurhash3) || !parse_number(fields[2], record.size)) continue;
+            record.storage = fields[3];
+            record.target = fields[4];
+            records[std::string(fields[0])] = std::move(record);
+        }
+        return records;
+    }
+
+    // ustar header, numbers are zero padded octal.
+    void write_octal(char* field, size_t field_size, uint64_t value)
+    {
+        std::snprintf(field, field_size, "%0*llo", static_cast<int>(field_size - 1), static_cast<unsigned long long>(value));
+    }
+
+    bool fill_tar_header(std::array<char, tar_block_size>& header, const std::string& name, uint64_t size, uint32_t mtime,
+        const std::string& link_target)
+    {
+        header.fill(0);
+
+        std::string prefix;
+        std::string short_name = name;
+        if (short_name.size() > 100) {
+            const size_t slash = name.rfind('/', 155);
+            if (slash == std::string::npos || name.size() - slash - 1 > 100) return false;
+            prefix = name.substr(0, slash);
+            short_name = name.substr(slash + 1);
+        }
+        if (link_target.size() > 100) return false;
+
+        std::memcpy(&header[0], short_name.data(), short_name.size());
+        write_octal(&header[100], 8, 0644);
+        write_octal(&header[108], 8, 0);
+        write_octal(&header[116], 8, 0);
+        write_octal(&header[124], 12, link_target.empty() ? size : 0);
+        write_octal(&header[136], 12, mtime);
+        header[156] = link_target.empty() ? '0' : '1';
+        std::memcpy(&header[157], link_target.data(), link_target.size());
+        std::memcpy(&header[257], "ustar", 6);
+        std::memcpy(&header[263], "00", 2);
+        std::memcpy(&header[345], prefix.data(), prefix.size());
+
+        // The checksum is computed with its own field set to spaces.
+        std::memset(&header[148], ' ', 8);
+        uint32_t checksum = 0;
+        for (char c : header) {
+            checksum += static_cast<uint8_t>(c);
+        }
+        std::snprintf(&header[148], 8, "%06o", checksum);
+        header[155] = ' ';
+        return true;
+    }
+}
+
+void ExtractionJob::Start(DATManager* dat_manager, ExtractionOptions options, unsigned num_threads)
+{
+    Stop();
+
+    m_dat_manager = dat_manager;
+    m_options = std::move(options);
+    m_write_tasks.clear();
+    m_link_tasks.clear();
+    m_write_succeeded.clear();
+    m_last_error.clear();
+    m_next_task = 0;
+    m_stop_requested = false;
+    m_total = 0;
+    m_skipped = 0;
+    m_written = 0;
+    m_deduplicated = 0;
+    m_failed = 0;
+    m_bytes_written = 0;
+    m_bytes_deduplicated = 0;
+    m_start_time = std::chrono::steady_clock::now();
+    m_end_time = std::chrono::steady_clock::time_point{};
+    m_phase = Phase::Planning;
+
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_coordinator = std::jthread([this, num_threads] { Run(num_threads); });
+}
+
+void ExtractionJob::Stop()
+{
+    m_stop_requested = true;
+    if (m_coordinator.joinable()) {
+        m_coordinator.join();
+    }
+}
+
+double ExtractionJob::GetElapsedSeconds() const
+{
+    const auto start = m_start_time.load();
+    auto end = m_end_time.load();
+    if (end == std::chrono::steady_clock::time_point{}) {
+        end = std::chrono::steady_clock::now();
+    }
+    return std::max(0.0, std::chrono::duration<double>(end - start).count());
+}
+
+double ExtractionJob::GetBytesPerSecond() const
+{
+    const double seconds = GetElapsedSeconds();
+    return seconds > 0 ? GetBytesWritten() / seconds : 0;
+}
+
+double ExtractionJob::GetFilesPerSecond() const
+{
+    const double seconds = GetElapsedSeconds();
+    return seconds > 0 ? (GetWrittenCount() + GetDeduplicatedCount()) / seconds : 0;
+}
+
+std::wstring ExtractionJob::GetLastError() const
+{
+    std::scoped_lock lock(m_error_mutex);
+    return m_last_error;
+}
+
+void ExtractionJob::Run(unsigned num_threads)
+{
+    Plan();
+    if (m_stop_requested) {
+        m_end_time = std::chrono::steady_clock::now();
+        m_phase = Phase::Done;
+        return;
+    }
+
+    const auto manifest_path = m_options.save_directory / manifest_filename;
+    std::error_code error;
+    const bool new_manifest = std::filesystem::file_size(manifest_path, error) == 0 || error;
+    m_manifest.open(manifest_path, std::ios::app);
+    if (!m_manifest) {
+        ReportError(L"Failed to open the extraction manifest.");
+    }
+    else if (new_manifest) {
+        m_manifest << "# path\tmurmurhash3\tsize\tstorage\ttarget\n";
+    }
+
+    const bool has_work = !m_write_tasks.empty() || !m_link_tasks.empty();
+    if (has_work && m_options.write_tar_archive && !OpenArchive()) {
+        ReportError(L"Failed to create the tar archive.");
+        m_failed += static_cast<int>(m_write_tasks.size() + m_link_tasks.size());
+        m_write_tasks.clear();
+        m_link_tasks.clear();
+    }
+
+    m_start_time = std::chrono::steady_clock::now(); // Throughput covers the extraction only
+    m_phase = Phase::Extracting;
+
+    num_threads = std::min(num_threads, static_cast<unsigned>(std::max<size_t>(m_write_tasks.size(), 1)));
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned i = 0; i < num_threads; i++) {
+            workers.emplace_back([this] { RunWorker(); });
+        }
+    } // jthread joins
+
+    // Duplicates point at content the workers wrote, so they go last. They are cheap, one thread is enough.
+    m_phase = Phase::Linking;
+    for (const Task& task : m_link_tasks) {
+        if (m_stop_requested) break;
+
+        if (LinkTask(task)) {
+            m_deduplicated++;
+            m_bytes_deduplicated += task.size;
+        }
+        else {
+            m_failed++;
+        }
+    }
+
+    CloseArchive();
+    m_manifest.close();
+    m_end_time = std::chrono::steady_clock::now();
+    m_phase = Phase::Done;
+}
+
+void ExtractionJob::Plan()
+{
+    const auto manifest = load_manifest(m_options.save_directory / manifest_filename);
+
+    struct ContentSource
+    {
+        std::string path;
+        bool in_tar;
+        int task;
+    };
+    std::unordered_map<uint64_t, ContentSource> content_sources;
+    for (const auto& [path, record] : manifest) {
+        if (record.storage == "file" || record.storage == "tar") {
+            content_sources.try_emplace(content_key(record.murmurhash3, record.size), ContentSource{ path, record.storage == "tar", -1 });
+        }
+    }
+
+    const auto& mft = m_dat_manager->get_MFT();
+    std::vector<int> indices;
+    if (m_options.mft_indices) {
+        indices = *m_options.mft_indices;
+    }
+    else {
+        for (int i = 0; i < static_cast<int>(mft.size()); i++) {
+            if (m_options.file_types.contains(mft[i].type)) {
+                indices.push_back(i);
+            }
+        }
+    }
+    std::ranges::stable_sort(indices, {}, [&](int i) { return mft[i].Offset; });
+    m_total = static_cast<int>(indices.size());
+
+    std::set<std::string> subfolders;
+    for (int i : indices) {
+        if (m_stop_requested) return;
+
+        const auto& entry = mft[i];
+        std::string extension = ".gwraw";
+        if (m_options.use_mp3_extension && (entry.type == AMP || entry.type == SOUND)) {
+            extension = ".mp3";
+        }
+        else if (m_options.use_txt_extension && entry.type == TEXT) {
+            extension = ".txt";
+        }
+        else if (m_options.use_dds_extension && entry.type == DDS) {
+            extension = ".dds";
+        }
+
+        Task task{ i, std::format("{}_{}_{}_{}{}", i, entry.Hash, entry.murmurhash3, typeToString(entry.type), extension),
+            entry.murmurhash3, static_cast<uint32_t>(entry.uncompressedSize) };
+        if (m_options.save_to_subfolders) {
+            const std::string subfolder = typeToString(entry.type);
+            subfolders.insert(subfolder);
+            task.relative_path = subfolder + "/" + task.relative_path;
+        }
+
+        const uint64_t key = content_key(task.murmurhash3, task.size);
+        if (const auto it = manifest.find(task.relative_path); it != manifest.end()) {
+            if (content_key(it->second.murmurhash3, it->second.size) == key) {
+                m_skipped++;
+                continue;
+            }
+            task.replaces_existing = true;
+        }
+
+        if (const auto it = content_sources.find(key); it != content_sources.end()) {
+            task.source_task = it->second.task;
+            task.source_path = it->second.path;
+            task.source_in_tar = it->second.in_tar;
+            m_link_tasks.push_back(std::move(task));
+        }
+        else {
+            content_sources.emplace(key, ContentSource{ task.relative_path, m_options.write_tar_archive, static_cast<int>(m_write_tasks.size()) });
+            m_write_tasks.push_back(std::move(task));
+        }
+    }
+    m_write_succeeded.assign(m_write_tasks.size(), 0);
+
+    // Create the output folders once instead of per file.
+    std::error_code error;
+    std::filesystem::create_directories(m_options.save_directory, error);
+    if (!m_options.write_tar_archive) {
+        for (const auto& subfolder : subfolders) {
+            std::filesystem::create_directories(m_options.save_directory / subfolder, error);
+        }
+    }
+}
+
+void ExtractionJob::RunWorker()
+{
+    while (!m_stop_requested) {
+        const size_t i = m_next_task.fetch_add(1);
+        if (i >= m_write_tasks.size()) break;
+
+        const Task& task = m_write_tasks[i];
+        if (WriteTask(task)) {
+            m_write_succeeded[i] = 1;
+            m_written++;
+            m_bytes_written += task.size;
+        }
+        else {
+            m_failed++;
+        }
+    }
+}
+
+bool ExtractionJob::WriteTask(const Task& task)
+{
+    const std::vector<uint8_t> data = m_dat_manager->read_file_data(task.mft_index);
+    if (data.empty() && task.size != 0) {
+        ReportError(std::format(L"Failed to read file at index {}.", task.mft_index));
+        return false;
+    }
+
+    if (m_options.write_tar_archive) {
+        if (!WriteArchiveEntry(task.relative_path, data.data(), data.size())) {
+            ReportError(std::format(L"Failed to add {} to the tar archive.", to_wstring(task.relative_path)));
+            return false;
+        }
+        AppendToManifest(task, "tar", m_archive_name);
+        return true;
+    }
+
+    const auto file_path = m_options.save_directory / task.relative_path;
+    if (task.replaces_existing) {
+        // The old file may be a hard link, writing through it would change the files it is linked with.
+        std::error_code error;
+        std::filesystem::remove(file_path, error);
+    }
+
+    std::ofstream file(file_path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!file.good()) {
+        ReportError(std::format(L"Failed to write {}.", to_wstring(task.relative_path)));
+        return false;
+    }
+    file.close();
+    AppendToManifest(task, "file", "");
+    return true;
+}
+
+bool ExtractionJob::LinkTask(const Task& task)
+{
+    if (task.source_task >= 0 && !m_write_succeeded[task.source_task]) {
+        ReportError(std::format(L"Skipped {}, its content failed to extract as {}.", to_wstring(task.relative_path),
+            to_wstring(task.source_path)));
+        return false;
+    }
+
+    if (m_options.write_tar_archive) {
+        // Only entries of the same archive can be linked to, older archives are referenced from the manifest.
+        if (task.source_task >= 0) {
+            if (!WriteArchiveEntry(task.relative_path, nullptr, 0, task.source_path)) {
+                ReportError(std::format(L"Failed to add {} to the tar archive.", to_wstring(task.relative_path)));
+                return false;
+            }
+            AppendToManifest(task, "tar", m_archive_name);
+            return true;
+        }
+    }
+    else if (m_options.hard_link_duplicates && !task.source_in_tar) {
+        const auto file_path = m_options.save_directory / task.relative_path;
+        std::error_code error;
+        std::filesystem::remove(file_path, error);
+        std::filesystem::create_hard_link(m_options.save_directory / task.source_path, file_path, error);
+        if (!error) {
+            AppendToManifest(task, "hardlink", task.source_path);
+            return true;
+        }
+        // E.g. FAT volumes or too many links to one file, fall back to a reference.
+    }
+
+    AppendToManifest(task, "ref", task.source_path);
+    return true;
+}
+
+void ExtractionJob::AppendToManifest(const Task& task, const char* storage, const std::string& target)
+{
+    std::scoped_lock lock(m_manifest_mutex);
+    if (!m_manifest) return;
+
+    // Flushed per line so an interrupted run loses at most the files that were being written.
+    m_manifest << task.relative_path << '\t' << task.murmurhash3 << '\t' << task.size << '\t' << storage << '\t' << target << '\n';
+    m_manifest.flush();
+}
+
+void ExtractionJob::ReportError(std::wstring error)
+{
+    std::scoped_lock lock(m_error_mutex);
+    m_last_error = std::move(error);
+}
+
+bool ExtractionJob::OpenArchive()
+{
+    const auto now = std::chrono::system_clock::now();
+    m_archive_mtime = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count());
+    m_archive_name = std::format("extraction_{:%Y%m%d_%H%M%S}.tar", std::chrono::floor<std::chrono::seconds>(now));
+    m_archive.open(m_options.save_directory / m_archive_name, std::ios::binary);
+    return m_archive.good();
+}
+
+void ExtractionJob::CloseArchive()
+{
+    if (!m_archive.is_open()) return;
+
+    // Two zero blocks end the archive. Written on Stop as well, so a cancelled run leaves a valid archive.
+    const std::array<char, tar_block_size * 2> end_blocks{};
+    m_archive.write(end_blocks.data(), end_blocks.size());
+    m_archive.close();
+}
+
+bool ExtractionJob::WriteArchiveEntry(const std::string& name, const uint8_t* data, size_t size, const std::string& link_target)
+{
+    std::array<char, tar_block_size> header;
+    if (!fill_tar_header(header, name, size, m_archive_mtime, link_target)) return false;
+
+    const std::array<char, tar_block_size> padding{};
+    std::scoped_lock lock(m_archive_mutex);
+    m_archive.write(header.data(), header.size());
+    if (size > 0) {
+        m_archive.write(reinterpret_cast<const char*>(data), size);
+        m_archive.write(padding.data(), (tar_block_size - size % tar_block_size) % tar_block_size);
+    }
+    return m_archive.good();
+}
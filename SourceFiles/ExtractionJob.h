@@ -0,0 +1,146 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+class DATManager;
+
+struct ExtractionOptions
+{
+    std::filesystem::path save_directory;
+    std::unordered_set<int> file_types; // FileType values to extract
+    std::optional<std::vector<int>> mft_indices; // If set, only these files are extracted and file_types is ignored
+
+    bool save_to_subfolders = false;
+    bool use_mp3_extension = false;
+    bool use_txt_extension = false;
+    bool use_dds_extension = false;
+
+    // Duplicates are hard linked to the first copy. Off, or when linking fails, they are only listed in the manifest.
+    bool hard_link_duplicates = true;
+
+    // Writes every file into one new .tar in save_directory instead of one file each.
+    bool write_tar_archive = false;
+};
+
+/**
+ * @brief Extracts the decompressed files of a DAT to disk on a pool of worker threads.
+ *
+ * Files are read in the order they are stored in the DAT, so the reads sweep the DAT front to back.
+ * Files with the same content (murmurhash3 and size) are written once, the others become hard links or
+ * references in the manifest. The manifest (extraction_manifest.tsv in the save directory) gets a line per
+ * finished file:
+ *
+ *   <relative path> \t <murmurhash3> \t <size> \t <storage> \t <target>
+ *
+ * storage is "file", "hardlink" or "ref" (target is the relative path holding the content) or "tar" (target
+ * is the archive). A later run into the same directory skips every path the manifest already lists with the
+ * same content, so an interrupted run continues where it stopped and a run after a game update only writes
+ * new and changed files. The manifest is trusted, delete it to extract everything again.
+ */
+class ExtractionJob
+{
+public:
+    enum class Phase
+    {
+        Planning,
+        Extracting,
+        Linking,
+        Done
+    };
+
+    ~ExtractionJob() { Stop(); }
+
+    // Returns immediately, planning and extraction run on a background thread. num_threads 0 uses every hardware thread.
+    void Start(DATManager* dat_manager, ExtractionOptions options, unsigned num_threads = 0);
+
+    // Cancels the remaining files and joins all threads. Files and tar entries already written stay valid.
+    void Stop();
+
+    // Started and not stopped yet, also while the finished job waits to be joined by Stop.
+    bool IsActive() const { return m_coordinator.joinable(); }
+    Phase GetPhase() const { return m_phase.load(); }
+
+    int GetTotalCount() const { return m_total.load(); } // Selected files, known after planning
+    int GetSkippedCount() const { return m_skipped.load(); } // Already in the manifest
+    int GetWrittenCount() const { return m_written.load(); }
+    int GetDeduplicatedCount() const { return m_deduplicated.load(); }
+    int GetFailedCount() const { return m_failed.load(); }
+    int GetCompletedCount() const { return GetSkippedCount() + GetWrittenCount() + GetDeduplicatedCount() + GetFailedCount(); }
+    uint64_t GetBytesWritten() const { return m_bytes_written.load(); }
+    uint64_t GetBytesDeduplicated() const { return m_bytes_deduplicated.load(); }
+
+    // Since planning finished, up to now or until the job is done.
+    double GetElapsedSeconds() const;
+    double GetBytesPerSecond() const;
+    double GetFilesPerSecond() const;
+
+    std::wstring GetLastError() const;
+
+private:
+    struct Task
+    {
+        int mft_index;
+        std::string relative_path; // Generic format, also the tar entry name
+        uint32_t murmurhash3;
+        uint32_t size;
+        int source_task = -1; // Duplicates: the task in this run that writes the content, -1 if an earlier run did
+        std::string source_path; // Duplicates: path holding the content
+        bool source_in_tar = false; // Duplicates: the content was written to a tar
+        bool replaces_existing = false; // The manifest lists the path with other content
+    };
+
+    void Run(unsigned num_threads);
+    void Plan();
+    void RunWorker();
+    bool WriteTask(const Task& task);
+    bool LinkTask(const Task& task);
+    void AppendToManifest(const Task& task, const char* storage, const std::string& target);
+    void ReportError(std::wstring error);
+
+    bool OpenArchive();
+    void CloseArchive();
+    bool WriteArchiveEntry(const std::string& name, const uint8_t* data, size_t size, const std::string& link_target = {});
+
+    DATManager* m_dat_manager = nullptr;
+    ExtractionOptions m_options;
+
+    std::vector<Task> m_write_tasks; // In DAT offset order
+    std::vector<Task> m_link_tasks;
+    std::vector<uint8_t> m_write_succeeded; // Per write task, each set by the one worker that writes it
+
+    std::ofstream m_manifest;
+    std::mutex m_manifest_mutex;
+
+    std::ofstream m_archive;
+    std::string m_archive_name;
+    std::mutex m_archive_mutex;
+    uint32_t m_archive_mtime = 0;
+
+    mutable std::mutex m_error_mutex;
+    std::wstring m_last_error;
+
+    std::jthread m_coordinator;
+    std::atomic<size_t> m_next_task{0};
+    std::atomic<bool> m_stop_requested{false};
+    std::atomic<Phase> m_phase{Phase::Done};
+
+    std::atomic<int> m_total{0};
+    std::atomic<int> m_skipped{0};
+    std::atomic<int> m_written{0};
+    std::atomic<int> m_deduplicated{0};
+    std::atomic<int> m_failed{0};
+    std::atomic<uint64_t> m_bytes_written{0};
+    std::atomic<uint64_t> m_bytes_deduplicated{0};
+
+    std::atomic<std::chrono::steady_clock::time_point> m_start_time{};
+    std::atomic<std::chrono::steady_clock::time_point> m_end_time{};
+};
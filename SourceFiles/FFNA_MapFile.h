@@ -1360,8 +1360,16 @@ struct BigChunkSub0 {
     }
 };
 
+// Marks an unused neighbor slot in PathfindingTrapezoid::neighbors.
+constexpr uint32_t PATHFINDING_NO_NEIGHBOR = 0xFFFFFFFF;
+// Marks an unused portal slot in PathfindingTrapezoid::portal_left/portal_right.
+constexpr uint16_t PATHFINDING_NO_PORTAL = 0xFFFF;
+
 // Pathfinding trapezoid structure (navigation mesh element)
 struct PathfindingTrapezoid {
+    std::array<uint32_t, 4> neighbors;  // Adjacent trapezoid indices within the same plane
+    uint16_t portal_left;   // Portal on the left edge, connects to another plane
+    uint16_t portal_right;  // Portal on the right edge, connects to another plane
     float yt;   // Top Y
     float yb;   // Bottom Y
     float xtl;  // Top-left X
@@ -1371,8 +1379,12 @@ struct PathfindingTrapezoid {
 
     PathfindingTrapezoid() = default;
     PathfindingTrapezoid(int& offset, const unsigned char* data) {
-        // Skip neighbor indices (16 bytes) and portal indices (4 bytes)
-        offset += 20;
+        std::memcpy(neighbors.data(), &data[offset], sizeof(neighbors));
+        offset += sizeof(neighbors);
+        std::memcpy(&portal_left, &data[offset], sizeof(portal_left));
+        offset += sizeof(portal_left);
+        std::memcpy(&portal_right, &data[offset], sizeof(portal_right));
+        offset += sizeof(portal_right);
 
         std::memcpy(&yt, &data[offset], sizeof(yt));
         offset += sizeof(yt);
@@ -1392,8 +1404,14 @@ struct PathfindingTrapezoid {
 // Pathfinding plane (contains multiple trapezoids)
 struct PathfindingPlane {
     uint32_t traps_count = 0;
+    uint32_t portals_count = 0;
+    uint32_t portal_traps_count = 0;
     std::vector<PathfindingTrapezoid> trapezoids;
 
+    // Raw tag 9 (portals) and tag 10 (portal trapezoid lists) payloads, kept for tools that decode them.
+    std::vector<uint8_t> portal_data;
+    std::vector<uint8_t> portal_trap_data;
+
     PathfindingPlane() = default;
 };
 
@@ -1500,6 +1518,8 @@ private:
         offset += 32;
 
         plane.traps_count = traps_count;
+        plane.portals_count = portals_count;
+        plane.portal_traps_count = portal_traps_count;
 
         // Tag 11: Special - only read h000C * 8 bytes
         tag = data[offset];
@@ -1528,27 +1548,24 @@ private:
                 int trap_offset = offset + i * 44;
                 if (trap_offset + 44 > (int)data_size) break;
 
-                PathfindingTrapezoid trap;
-                // Skip neighbor indices (16 bytes) and portal indices (4 bytes) = 20 bytes
-                int coord_offset = trap_offset + 20;
-                std::memcpy(&trap.yt, &data[coord_offset], sizeof(trap.yt));
-                std::memcpy(&trap.yb, &data[coord_offset + 4], sizeof(trap.yb));
-                std::memcpy(&trap.xtl, &data[coord_offset + 8], sizeof(trap.xtl));
-                std::memcpy(&trap.xtr, &data[coord_offset + 12], sizeof(trap.xtr));
-                std::memcpy(&trap.xbl, &data[coord_offset + 16], sizeof(trap.xbl));
-                std::memcpy(&trap.xbr, &data[coord_offset + 20], sizeof(trap.xbr));
-                plane.trapezoids.push_back(trap);
+                plane.trapezoids.emplace_back(trap_offset, data);
             }
             offset += traps_count * 44;
         }
 
-        // Skip remaining tags: 3, 4, 5, 6, 10, 9
+        // Remaining tags: 3, 4, 5, 6 (search tree nodes, skipped), 10 and 9 (portals, kept raw)
         int remaining_tags[] = {3, 4, 5, 6, 10, 9};
         for (int expected_tag : remaining_tags) {
             if (offset >= (int)data_size - 5) break;
             tag = data[offset];
             std::memcpy(&tag_size, &data[offset + 1], sizeof(tag_size));
-            offset += 5 + tag_size;
+            offset += 5;
+
+            if ((tag == 9 || tag == 10) && offset + (size_t)tag_size <= data_size) {
+                auto& raw = tag == 9 ? plane.portal_data : plane.portal_trap_data;
+                raw.assign(&data[offset], &data[offset] + tag_size);
+            }
+            offset += tag_size;
         }
     }
 };
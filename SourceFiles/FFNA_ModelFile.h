@@ -1233,6 +1233,7 @@ struct FFNA_ModelFile
         }
 
 
+        VertexAttributes vertex_attributes;
         for (int i = 0; i < sub_model.vertices.size(); i++)
         {
             ModelVertex model_vertex = sub_model.vertices[i];
@@ -1240,6 +1241,14 @@ struct FFNA_ModelFile
             if (! model_vertex.has_position)
                 return Mesh();
 
+            vertex_attributes.has_normal |= model_vertex.has_normal;
+            vertex_attributes.has_tangents |= model_vertex.has_tangent || model_vertex.has_bitangent;
+            for (int j = 0; j < 8; j++)
+            {
+                if (model_vertex.has_tex_coord[j])
+                    vertex_attributes.uv_set_mask |= 1 << j;
+            }
+
             if (max_num_tex_coords < model_vertex.num_texcoords)
             {
                 max_num_tex_coords = model_vertex.num_texcoords;
@@ -1571,7 +1580,9 @@ struct FFNA_ModelFile
             }
         }
 
-        return Mesh(vertices, indices, indices1, indices2, uv_coords_indices, tex_indices, blend_flags, texture_types, should_cull, blend_state,
-                    tex_indices.size());
+        Mesh mesh(vertices, indices, indices1, indices2, uv_coords_indices, tex_indices, blend_flags, texture_types, should_cull, blend_state,
+                  tex_indices.size());
+        mesh.vertex_attributes = vertex_attributes;
+        return mesh;
     }
 };
@@ -0,0 +1,198 @@
+#include "pch.h"
+#include "FrustumCulling.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr uint32_t MAX_LEAF_ITEMS = 4;
+
+    CullingAABB merge(const CullingAABB& a, const CullingAABB& b)
+    {
+        CullingAABB result;
+        XMStoreFloat3(&result.min, XMVectorMin(XMLoadFloat3(&a.min), XMLoadFloat3(&b.min)));
+        XMStoreFloat3(&result.max, XMVectorMax(XMLoadFloat3(&a.max), XMLoadFloat3(&b.max)));
+        return result;
+    }
+
+    float get_axis(const XMFLOAT3& v, int axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+}
+
+CullingFrustum::CullingFrustum(FXMMATRIX view, CXMMATRIX proj)
+{
+    // Rows of the transposed matrix are the columns of view * proj: clip = (x, y, z, w).
+    const XMMATRIX m = XMMatrixTranspose(XMMatrixMultiply(view, proj));
+    const XMVECTOR planes[6] = {
+        XMVectorAdd(m.r[3], m.r[0]),      // left:   w + x >= 0
+        XMVectorSubtract(m.r[3], m.r[0]), // right:  w - x >= 0
+        XMVectorAdd(m.r[3], m.r[1]),      // bottom: w + y >= 0
+        XMVectorSubtract(m.r[3], m.r[1]), // top:    w - y >= 0
+        m.r[2],                           // near:   z >= 0 (D3D clip space)
+        XMVectorSubtract(m.r[3], m.r[2]), // far:    w - z >= 0
+    };
+
+    for (int i = 0; i < 6; i++) {
+        XMStoreFloat4A(&m_planes[i], XMPlaneNormalize(planes[i]));
+    }
+}
+
+CullingFrustum::Result CullingFrustum::Classify(const CullingAABB& box) const
+{
+    const XMVECTOR box_min = XMLoadFloat3(&box.min);
+    const XMVECTOR box_max = XMLoadFloat3(&box.max);
+    const XMVECTOR zero = XMVectorZero();
+
+    Result result = Result::Inside;
+    for (const auto& stored_plane : m_planes) {
+        const XMVECTOR plane = XMLoadFloat4A(&stored_plane);
+        // The corner furthest along the plane normal decides if the box is outside,
+        // the opposite corner if it straddles the plane.
+        const XMVECTOR positive_mask = XMVectorGreater(plane, zero);
+        const XMVECTOR far_corner = XMVectorSelect(box_min, box_max, positive_mask);
+        if (XMVectorGetX(XMPlaneDotCoord(plane, far_corner)) < 0.0f) {
+            return Result::Outside;
+        }
+
+        const XMVECTOR near_corner = XMVectorSelect(box_max, box_min, positive_mask);
+        if (XMVectorGetX(XMPlaneDotCoord(plane, near_corner)) < 0.0f) {
+            result = Result::Intersecting;
+        }
+    }
+    return result;
+}
+
+CullingAABB TransformAABB(const CullingAABB& local_box, const XMFLOAT4X4& world)
+{
+    // Arvo's method: the extent along each world axis is the sum of the absolute projected local extents.
+    const XMMATRIX m = XMLoadFloat4x4(&world);
+    const XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&local_box.min), XMLoadFloat3(&local_box.max)), 0.5f);
+    const XMVECTOR extent = XMVectorScale(XMVectorSubtract(XMLoadFloat3(&local_box.max), XMLoadFloat3(&local_box.min)), 0.5f);
+
+    const XMVECTOR world_center = XMVector3Transform(center, m);
+    XMVECTOR world_extent = XMVectorMultiply(XMVectorSplatX(extent), XMVectorAbs(m.r[0]));
+    world_extent = XMVectorMultiplyAdd(XMVectorSplatY(extent), XMVectorAbs(m.r[1]), world_extent);
+    world_extent = XMVectorMultiplyAdd(XMVectorSplatZ(extent), XMVectorAbs(m.r[2]), world_extent);
+
+    CullingAABB result;
+    XMStoreFloat3(&result.min, XMVectorSubtract(world_center, world_extent));
+    XMStoreFloat3(&result.max, XMVectorAdd(world_center, world_extent));
+    return result;
+}
+
+void BoundsBVH::Clear()
+{
+    m_nodes.clear();
+    m_item_ids.clear();
+    m_item_bounds.clear();
+}
+
+void BoundsBVH::Build(std::span<const CullingAABB> boxes, std::span<const uint32_t> ids)
+{
+    Clear();
+    if (boxes.empty() || boxes.size() != ids.size()) return;
+
+    std::vector<XMFLOAT3> centers(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        XMStoreFloat3(&centers[i], XMVectorScale(XMVectorAdd(XMLoadFloat3(&boxes[i].min), XMLoadFloat3(&boxes[i].max)), 0.5f));
+    }
+
+    std::vector<uint32_t> order(boxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    m_nodes.reserve(boxes.size());
+    BuildNode(order, boxes, centers, 0, static_cast<uint32_t>(order.size()));
+
+    m_item_ids.resize(order.size());
+    m_item_bounds.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        m_item_ids[i] = ids[order[i]];
+        m_item_bounds[i] = boxes[order[i]];
+    }
+}
+
+uint32_t BoundsBVH::BuildNode(std::vector<uint32_t>& order, std::span<const CullingAABB> boxes,
+    std::span<const XMFLOAT3> centers, uint32_t begin, uint32_t end)
+{
+    const uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({});
+
+    CullingAABB bounds = boxes[order[begin]];
+    CullingAABB center_bounds{ centers[order[begin]], centers[order[begin]] };
+    for (uint32_t i = begin + 1; i < end; i++) {
+        bounds = merge(bounds, boxes[order[i]]);
+        center_bounds = merge(center_bounds, { centers[order[i]], centers[order[i]] });
+    }
+    m_nodes[node_index].bounds = bounds;
+
+    if (end - begin <= MAX_LEAF_ITEMS) {
+        m_nodes[node_index].first = begin;
+        m_nodes[node_index].count = end - begin;
+        return node_index;
+    }
+
+    const XMFLOAT3 center_extent(center_bounds.max.x - center_bounds.min.x, center_bounds.max.y - center_bounds.min.y,
+        center_bounds.max.z - center_bounds.min.z);
+    int axis = 0;
+    if (center_extent.y > center_extent.x) axis = 1;
+    if (center_extent.z > get_axis(center_extent, axis)) axis = 2;
+
+    const uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+        [&](uint32_t a, uint32_t b) { return get_axis(centers[a], axis) < get_axis(centers[b], axis); });
+
+    BuildNode(order, boxes, centers, begin, middle);
+    const uint32_t right = BuildNode(order, boxes, centers, middle, end);
+    m_nodes[node_index].first = right;
+    m_nodes[node_index].count = 0;
+    return node_index;
+}
+
+void BoundsBVH::AppendAll(uint32_t node_index, std::vector<uint32_t>& visible_ids) const
+{
+    // Nodes are stored depth first, so a subtree covers a contiguous item range from its leftmost to its rightmost leaf.
+    uint32_t leftmost = node_index;
+    while (m_nodes[leftmost].count == 0) leftmost++;
+    uint32_t rightmost = node_index;
+    while (m_nodes[rightmost].count == 0) rightmost = m_nodes[rightmost].first;
+
+    const auto first = m_item_ids.begin() + m_nodes[leftmost].first;
+    const auto last = m_item_ids.begin() + m_nodes[rightmost].first + m_nodes[rightmost].count;
+    visible_ids.insert(visible_ids.end(), first, last);
+}
+
+void BoundsBVH::Query(const CullingFrustum& frustum, std::vector<uint32_t>& visible_ids) const
+{
+    if (m_nodes.empty()) return;
+
+    uint32_t stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const uint32_t node_index = stack[--stack_size];
+        const Node& node = m_nodes[node_index];
+
+        const auto result = frustum.Classify(node.bounds);
+        if (result == CullingFrustum::Result::Outside) continue;
+        if (result == CullingFrustum::Result::Inside) {
+            AppendAll(node_index, visible_ids);
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                if (frustum.Intersects(m_item_bounds[i])) {
+                    visible_ids.push_back(m_item_ids[i]);
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = node_index + 1;
+    }
+}
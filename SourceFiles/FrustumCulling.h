@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <DirectXMath.h>
+
+struct CullingAABB
+{
+    DirectX::XMFLOAT3 min;
+    DirectX::XMFLOAT3 max;
+};
+
+/**
+ * @brief The six planes of a view frustum, pointing inwards.
+ *
+ * Planes are extracted from the combined view projection matrix (Gribb/Hartmann), so
+ * the same code handles the perspective user camera, the orthographic light camera of
+ * the shadow pass and the mirrored reflection camera.
+ */
+class CullingFrustum
+{
+public:
+    CullingFrustum() = default;
+    CullingFrustum(DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj);
+
+    enum class Result
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    Result Classify(const CullingAABB& box) const;
+    bool Intersects(const CullingAABB& box) const { return Classify(box) != Result::Outside; }
+
+private:
+    std::array<DirectX::XMFLOAT4A, 6> m_planes{};
+};
+
+// World-space bounds of a local box transformed by a (row-vector) world matrix.
+CullingAABB TransformAABB(const CullingAABB& local_box, const DirectX::XMFLOAT4X4& world);
+
+// Bounds of the given positions, used for mesh vertices. Empty input gives a zero sized box at the origin.
+template <typename Vertex>
+CullingAABB ComputeAABB(std::span<const Vertex> vertices)
+{
+    if (vertices.empty()) return {};
+    DirectX::XMVECTOR min = DirectX::XMLoadFloat3(&vertices[0].position);
+    DirectX::XMVECTOR max = min;
+    for (const auto& vertex : vertices) {
+        const DirectX::XMVECTOR position = DirectX::XMLoadFloat3(&vertex.position);
+        min = DirectX::XMVectorMin(min, position);
+        max = DirectX::XMVectorMax(max, position);
+    }
+    CullingAABB box;
+    DirectX::XMStoreFloat3(&box.min, min);
+    DirectX::XMStoreFloat3(&box.max, max);
+    return box;
+}
+
+/**
+ * @brief Bounding volume hierarchy over world-space boxes with user supplied ids.
+ *
+ * Built top-down by splitting at the median of the longest axis of the box centers.
+ * Queries skip the plane tests for subtrees that are completely inside the frustum.
+ */
+class BoundsBVH
+{
+public:
+    void Build(std::span<const CullingAABB> boxes, std::span<const uint32_t> ids);
+    void Clear();
+
+    // Appends the ids of all boxes intersecting the frustum to visible_ids.
+    void Query(const CullingFrustum& frustum, std::vector<uint32_t>& visible_ids) const;
+
+    size_t GetItemCount() const { return m_item_ids.size(); }
+    size_t GetNodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Node
+    {
+        CullingAABB bounds;
+        // Leaves: range in m_item_ids. Inner nodes: first is the index of the right child, the left one follows the node.
+        uint32_t first;
+        uint32_t count; // 0 for inner nodes
+    };
+
+    uint32_t BuildNode(std::vector<uint32_t>& order, std::span<const CullingAABB> boxes,
+        std::span<const DirectX::XMFLOAT3> centers, uint32_t begin, uint32_t end);
+    void AppendAll(uint32_t node_index, std::vector<uint32_t>& visible_ids) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_item_ids;
+    std::vector<CullingAABB> m_item_bounds;
+};
@@ -7,9 +7,11 @@
 #include "InputManager.h"
 #include "ModelViewer/ModelViewer.h"
 #include "Extract_BASS_DLL_resource.h"
+#include "MapExportJob.h"
 #include "imgui.h"
 #include <filesystem>
 #include <DbgHelp.h>
+#include <shellapi.h>
 
 LONG WINAPI UnhandledExceptionHandler(EXCEPTION_POINTERS* pExceptionPointers) {
     // Create mini dump file
@@ -158,6 +160,81 @@ extern "C"
     __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 }
 
+// GuildWarsMapBrowser.exe --export-all-maps <Gw.dat> <output folder> [--json] [--memory-budget-mb <MB>]
+// Exports every map like the extract panel does (see MapExportJob), without a window or a D3D device.
+// Binary .gwmb by default like the panel, --json writes the JSON files instead.
+// Returns the exit code, or nothing if the command line doesn't ask for it.
+static std::optional<int> RunHeadlessMapExport()
+{
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) {
+        return std::nullopt;
+    }
+    const std::vector<std::wstring> args(argv + 1, argv + argc); // Without the executable
+    LocalFree(argv);
+    if (args.empty() || args[0] != L"--export-all-maps") {
+        return std::nullopt;
+    }
+
+    // The executable is a GUI app, print to the console it was started from, if any.
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+        freopen_s(&stream, "CONOUT$", "w", stderr);
+    }
+
+    bool binary = true;
+    uint64_t memory_budget_bytes = MapExportJob::default_memory_budget_bytes;
+    std::vector<std::wstring> paths;
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == L"--json") {
+            binary = false;
+        }
+        else if (args[i] == L"--memory-budget-mb" && i + 1 < args.size()) {
+            memory_budget_bytes = std::max<uint64_t>(256, wcstoull(args[++i].c_str(), nullptr, 10)) << 20;
+        }
+        else {
+            paths.push_back(args[i]);
+        }
+    }
+    if (paths.size() != 2) {
+        fwprintf(stderr, L"Usage: GuildWarsMapBrowser.exe --export-all-maps <Gw.dat> <output folder> [--json] [--memory-budget-mb <MB>]\n");
+        return 2;
+    }
+
+    const auto dat_manager = std::make_unique<DATManager>();
+    if (!dat_manager->Init(paths[0])) {
+        fwprintf(stderr, L"Failed to read %s.\n", paths[0].c_str());
+        return 1;
+    }
+
+    // The file types are only known once every file was read.
+    while (dat_manager->m_initialization_state != InitializationState::Completed) {
+        wprintf(L"\rReading DAT: %d / %d files", dat_manager->get_num_files_type_read(), dat_manager->get_num_files());
+        fflush(stdout);
+        Sleep(250);
+    }
+    wprintf(L"\n");
+
+    MapExportJob map_export_job;
+    map_export_job.Start(dat_manager.get(), paths[1], binary, memory_budget_bytes);
+    while (!map_export_job.IsDone()) {
+        wprintf(L"\rExporting maps: %d / %d", map_export_job.GetCompletedCount(), map_export_job.GetTotalCount());
+        fflush(stdout);
+        Sleep(250);
+    }
+    map_export_job.Stop();
+
+    wprintf(L"\rExported %d of %d maps in %.1f s.\n", map_export_job.GetExportedCount(), map_export_job.GetTotalCount(),
+        map_export_job.GetElapsedSeconds());
+    if (map_export_job.GetFailedCount() > 0) {
+        fwprintf(stderr, L"%d maps failed, see %s.\n", map_export_job.GetFailedCount(), map_export_job.GetErrorLogPath().c_str());
+        return 1;
+    }
+    return 0;
+}
+
 // Entry point
 int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine,
     _In_ int nCmdShow)
@@ -174,6 +251,10 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     if (FAILED(hr))
         return 1;
 
+    if (const auto exit_code = RunHeadlessMapExport()) {
+        CoUninitialize();
+        return *exit_code;
+    }
 
     // Register class and create window
     {
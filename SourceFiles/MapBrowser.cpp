@@ -26,7 +26,6 @@ extern int selected_map_file_index;
 MapBrowser::MapBrowser(InputManager* input_manager) noexcept(false)
     : m_input_manager(input_manager),
     m_dat_manager_to_show_in_dat_browser(0),
-    m_total_textures_to_extract(0),
     m_hash_index_initialized(false),
     m_FPS_target(60),
     m_show_error_msg(false),
@@ -41,6 +40,10 @@ MapBrowser::MapBrowser(InputManager* input_manager) noexcept(false)
 MapBrowser::~MapBrowser()
 {
     GuiGlobalConstants::SaveSettings(); // Save window visibility settings on exit
+    m_texture_export_job.Stop();
+    m_extract_panel_info.dat_diff_job.Stop(); // These use the DAT managers, which are destroyed first
+    m_extract_panel_info.extraction_job.Stop();
+    m_extract_panel_info.map_export_job.Stop();
     CloseTextureErrorLog(); // Ensure log file is closed on exit
 }
 
@@ -97,7 +100,9 @@ void MapBrowser::Initialize(HWND window, int width, int height)
 void MapBrowser::Tick()
 {
     // Check if extraction is in progress; if so, don't skip frames
-    bool is_extracting = !m_mft_indices_to_extract.empty() || !m_mft_indices_to_extract_textures.empty();
+    bool is_extracting = !m_mft_indices_to_extract.empty() || m_texture_export_job.IsActive() ||
+        m_extract_panel_info.extraction_job.IsActive() || m_extract_panel_info.dat_diff_job.IsActive() ||
+        m_extract_panel_info.map_export_job.IsActive();
 
     if (!is_extracting) {
         if (IsIconic(m_deviceResources->GetWindow())) {
@@ -434,28 +439,38 @@ void MapBrowser::Render()
 
 
     // --- Process Picking ---
-    // Resolve multisampled picking texture if necessary
-    if (m_deviceResources->GetMsaaLevelIndex() > 0) {
-        m_deviceResources->GetD3DDeviceContext()->ResolveSubresource(
-            m_deviceResources->GetPickingNonMsaaTexture(),
-            0,
-            m_deviceResources->GetPickingRenderTarget(),
-            0,
-            m_deviceResources->GetBackBufferFormat());
-
-        // Copy picking texture to staging texture for CPU access
-        m_deviceResources->GetD3DDeviceContext()->CopyResource(
-            m_deviceResources->GetPickingStagingTexture(),
-            m_deviceResources->GetPickingNonMsaaTexture());
-    }
-    else {
-        m_deviceResources->GetD3DDeviceContext()->CopyResource(
-            m_deviceResources->GetPickingStagingTexture(),
-            m_deviceResources->GetPickingRenderTarget());
+    // The region around the cursor is copied for CPU access and read back a few frames later without waiting on
+    // the GPU. A new copy is only needed when what is under the cursor may have changed.
+    auto* picking_context = m_deviceResources->GetD3DDeviceContext();
+    auto mouse_client_coords = m_input_manager->GetClientCoords(m_deviceResources->GetWindow());
+
+    DirectX::XMFLOAT4X4 picking_view;
+    DirectX::XMStoreFloat4x4(&picking_view, m_map_renderer->GetCamera()->GetView());
+    const bool mouse_button_down = ImGui::GetIO().MouseDown[ImGuiMouseButton_Left] || ImGui::GetIO().MouseDown[ImGuiMouseButton_Right];
+    if (mouse_button_down || mouse_client_coords.x != m_last_picking_cursor.x || mouse_client_coords.y != m_last_picking_cursor.y ||
+        std::memcmp(&picking_view, &m_last_picking_view, sizeof(picking_view)) != 0)
+    {
+        ID3D11Texture2D* picking_texture = m_deviceResources->GetPickingRenderTarget();
+
+        // Resolve multisampled picking texture if necessary
+        if (m_deviceResources->GetMsaaLevelIndex() > 0) {
+            picking_context->ResolveSubresource(
+                m_deviceResources->GetPickingNonMsaaTexture(),
+                0,
+                m_deviceResources->GetPickingRenderTarget(),
+                0,
+                m_deviceResources->GetBackBufferFormat());
+            picking_texture = m_deviceResources->GetPickingNonMsaaTexture();
+        }
+
+        // A dropped request is retried next frame.
+        if (m_picking_readback.Request(picking_context, picking_texture, mouse_client_coords.x, mouse_client_coords.y)) {
+            m_last_picking_cursor = mouse_client_coords;
+            m_last_picking_view = picking_view;
+        }
     }
 
-    auto mouse_client_coords = m_input_manager->GetClientCoords(m_deviceResources->GetWindow());
-    int hovered_object_id = m_map_renderer->GetObjectId(m_deviceResources->GetPickingStagingTexture(), mouse_client_coords.x, mouse_client_coords.y);
+    int hovered_object_id = m_picking_readback.GetObjectId(picking_context, mouse_client_coords.x, mouse_client_coords.y);
 
     // Get prop_index id
     int prop_index = -1;
@@ -478,6 +493,23 @@ void MapBrowser::Render()
     picking_info.prop_submodel_index = submodel_index;
     picking_info.camera_pos = m_map_renderer->GetCamera()->GetPosition3f();
 
+    if (GuiGlobalConstants::is_picking_panel_open) {
+        // Unproject the cursor onto the near and far planes, hit distances are then in units of the view depth range.
+        const auto viewport = m_deviceResources->GetScreenViewport();
+        const XMMATRIX view = m_map_renderer->GetCamera()->GetView();
+        const XMMATRIX proj = m_map_renderer->GetCamera()->GetProj();
+        const auto unproject = [&](float depth) {
+            return XMVector3Unproject(XMVectorSet(static_cast<float>(mouse_client_coords.x), static_cast<float>(mouse_client_coords.y), depth, 0),
+                viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height, 0, 1, proj, view, XMMatrixIdentity());
+        };
+        const XMVECTOR near_point = unproject(0);
+        Ray cursor_ray;
+        XMStoreFloat3(&cursor_ray.origin, near_point);
+        XMStoreFloat3(&cursor_ray.direction, XMVectorSubtract(unproject(1), near_point));
+        cursor_ray.max_distance = 1;
+        m_map_renderer->CastRay(cursor_ray, picking_info.world_hit);
+    }
+
 
     // --- Start ImGui Frame ---
     ImGui_ImplDX11_NewFrame();
@@ -488,6 +520,10 @@ void MapBrowser::Render()
     int msaa_level_index = m_deviceResources->GetMsaaLevelIndex();
     const auto& msaa_levels = m_deviceResources->GetMsaaLevels();
 
+    // Debug draw primitives submitted from here on are drawn with the next scene render
+    m_map_renderer->BeginDebugDrawFrame();
+    m_map_renderer->GetMeshManager()->BeginRenderStatsFrame();
+
     // Draw the main UI
     if (m_show_error_msg) {
         ShowErrorMessage();
@@ -500,14 +536,14 @@ void MapBrowser::Render()
         // --- Draw extraction progress UI *inside* the ImGui frame ---
         // Check if either extraction queue is active
         bool is_map_extracting = !m_mft_indices_to_extract.empty();
-        bool is_texture_extracting = !m_mft_indices_to_extract_textures.empty();
+        bool is_texture_extracting = m_texture_export_job.IsActive();
         if (is_map_extracting || is_texture_extracting) {
             int total_items = is_map_extracting ?
                 m_dat_managers[m_dat_manager_to_show_in_dat_browser]->get_num_files_for_type(FFNA_Type3) :
-                m_total_textures_to_extract;
+                m_texture_export_job.GetTotalCount();
             int remaining_items = is_map_extracting ?
                 static_cast<int>(m_mft_indices_to_extract.size()) : // Cast size_t to int
-                static_cast<int>(m_mft_indices_to_extract_textures.size()); // Cast size_t to int
+                m_texture_export_job.GetTotalCount() - m_texture_export_job.GetCompletedCount();
 
             // Only draw if there are items to process
             if (total_items > 0) {
@@ -540,7 +576,7 @@ void MapBrowser::Render()
     if (m_extract_panel_info.pixels_per_tile_changed) {
         m_extract_panel_info.pixels_per_tile_changed = false;
         m_mft_indices_to_extract.clear();
-        m_mft_indices_to_extract_textures.clear();
+        m_texture_export_job.Stop();
         CloseTextureErrorLog();
 
         // Check if the current DAT manager is initialized
@@ -581,29 +617,36 @@ void MapBrowser::Render()
     // Trigger texture extraction if requested
     if (m_extract_panel_info.extract_all_textures_requested) {
         m_extract_panel_info.extract_all_textures_requested = false;
-        m_mft_indices_to_extract_textures.clear();
+        m_texture_export_job.Stop();
         m_mft_indices_to_extract.clear();
         CloseTextureErrorLog();
         OpenTextureErrorLog(m_extract_panel_info.save_directory);
-        m_total_textures_to_extract = 0;
 
         // Check if the current DAT manager is initialized
         if (m_dat_managers.count(m_dat_manager_to_show_in_dat_browser) > 0 &&
             m_dat_managers[m_dat_manager_to_show_in_dat_browser]->m_initialization_state == InitializationState::Completed) {
 
-            const auto& mft = m_dat_managers[m_dat_manager_to_show_in_dat_browser]->get_MFT();
+            DATManager* dat_manager = m_dat_managers[m_dat_manager_to_show_in_dat_browser].get();
+            const auto& mft = dat_manager->get_MFT();
+            std::vector<int> texture_indices;
             for (int i = 0; i < mft.size(); ++i) {
                 if (is_type_texture(static_cast<FileType>(mft[i].type))) {
-                    m_mft_indices_to_extract_textures.insert(i);
+                    texture_indices.push_back(i);
                 }
             }
-            m_total_textures_to_extract = static_cast<int>(m_mft_indices_to_extract_textures.size());
 
-            if (m_total_textures_to_extract == 0) {
+            if (texture_indices.empty()) {
                 m_error_msg = "No texture files found in the DAT to extract.";
                 m_show_error_msg = true;
                 CloseTextureErrorLog();
             }
+            else {
+                // Textures are decoded and encoded on worker threads, see TextureExportJob.
+                m_texture_export_job.Start(dat_manager, std::move(texture_indices), m_extract_panel_info.save_directory,
+                    [this](int mft_index, int file_hash, const std::wstring& error) {
+                        WriteToTextureErrorLog(mft_index, file_hash, error);
+                    });
+            }
         }
         else {
             m_error_msg = "Current DAT file is not fully loaded yet. Please wait.";
@@ -816,17 +859,11 @@ void MapBrowser::Render()
             }
         }
     }
-    // Process one texture extraction per frame if requested
-    if (!m_mft_indices_to_extract_textures.empty()) {
-        int index_to_process = *m_mft_indices_to_extract_textures.begin();
-        ProcessTextureExtraction(index_to_process, m_extract_panel_info.save_directory);
-        m_mft_indices_to_extract_textures.erase(index_to_process);
-
-
-        if (m_mft_indices_to_extract_textures.empty()) {
-            OutputDebugStringA("Texture extraction complete.\n");
-            CloseTextureErrorLog();
-        }
+    // Join the texture extraction workers once they ran out of files
+    if (m_texture_export_job.IsActive() && m_texture_export_job.IsDone()) {
+        m_texture_export_job.Stop();
+        OutputDebugStringA("Texture extraction complete.\n");
+        CloseTextureErrorLog();
     }
 }
 
@@ -1232,7 +1269,7 @@ void MapBrowser::CreateWindowSizeDependentResources()
 
 void MapBrowser::OnDeviceLost()
 {
-    // TODO: Add Direct3D resource cleanup here.
+    m_picking_readback.Reset();
 }
 
 void MapBrowser::OnDeviceRestored()
@@ -1243,7 +1280,7 @@ void MapBrowser::OnDeviceRestored()
 }
 
 void MapBrowser::DrawStopExtractionButton() {
-    bool is_extracting = !m_mft_indices_to_extract.empty() || !m_mft_indices_to_extract_textures.empty();
+    bool is_extracting = !m_mft_indices_to_extract.empty() || m_texture_export_job.IsActive();
     if (is_extracting) {
         // Set the window to be centered on the screen
         ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x * 0.5f,
@@ -1261,7 +1298,7 @@ void MapBrowser::DrawStopExtractionButton() {
 
         // Determine button label based on which extraction is running
         const char* buttonLabel = "Stop Extraction"; // Generic default
-        if (!m_mft_indices_to_extract_textures.empty()) {
+        if (m_texture_export_job.IsActive()) {
             buttonLabel = "Stop Texture Extraction";
         }
         else if (!m_mft_indices_to_extract.empty()) {
@@ -1271,8 +1308,7 @@ void MapBrowser::DrawStopExtractionButton() {
         // Render the button and handle its press
         if (ImGui::Button(buttonLabel)) {
             m_mft_indices_to_extract.clear(); // Clear map extraction queue
-            m_mft_indices_to_extract_textures.clear(); // Clear texture extraction queue
-            m_total_textures_to_extract = 0; // Reset texture count
+            m_texture_export_job.Stop(); // Cancel the remaining textures and join the workers
             CloseTextureErrorLog(); // Close log file if stopped manually
         }
 
@@ -1286,177 +1322,6 @@ void MapBrowser::DrawStopExtractionButton() {
 }
 
 
-void MapBrowser::ProcessTextureExtraction(int index, const std::wstring& save_directory)
-{
-    DATManager* dat_manager = m_dat_managers[m_dat_manager_to_show_in_dat_browser].get();
-    const auto& mft = dat_manager->get_MFT();
-    if (index < 0 || index >= mft.size()) {
-        std::wstring error_str = std::format(L"Invalid MFT index {} provided for texture extraction.", index);
-        OutputDebugStringW(error_str.c_str());
-        WriteToTextureErrorLog(index, -1, error_str);
-        return; // Continue to next item without stopping the whole process
-    }
-
-    const auto& entry = mft[index];
-    unsigned char* raw_data = nullptr;
-    ComPtr<ID3D11Texture2D> localTexture;
-    ComPtr<ID3D11ShaderResourceView> localSrv;
-    int texWidth = 0, texHeight = 0;
-    std::vector<RGBA> rgba_data; // Needed for DDS parsing result
-    DirectX::ScratchImage ddsImage; // To hold data from DDS
-
-    try {
-        // Always read raw file data for extraction
-        raw_data = dat_manager->read_file(index);
-        if (!raw_data) {
-            throw std::runtime_error(std::format("Failed to read file data for index {}.", index));
-        }
-
-        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-        const void* pixelDataPtr = nullptr;
-        UINT bytesPerPixel = 0;
-        ComPtr<ID3D11Device> device = m_deviceResources->GetD3DDevice();
-
-        if (entry.type == DDS) {
-            DirectX::TexMetadata metadata;
-            HRESULT hr = DirectX::LoadFromDDSMemory(raw_data, entry.uncompressedSize, DirectX::DDS_FLAGS_NONE, &metadata, ddsImage);
-            if (FAILED(hr)) {
-                throw std::runtime_error(std::format("LoadFromDDSMemory failed for index {}. HRESULT: 0x{:X}", index, hr));
-            }
-
-            DXGI_FORMAT targetFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
-            if (metadata.format != targetFormat)
-            {
-                DirectX::ScratchImage convertedImage;
-                hr = DirectX::Convert(*ddsImage.GetImage(0, 0, 0), targetFormat, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, convertedImage);
-                if (FAILED(hr)) {
-                    throw std::runtime_error(std::format("DDS Convert failed for index {}. HRESULT: 0x{:X}", index, hr));
-                }
-                // ddsImage is already a ScratchImage, no need to Release, just move assign
-                ddsImage = std::move(convertedImage); // Replace original with converted
-                metadata = ddsImage.GetMetadata(); // Get updated metadata
-            }
-
-            format = metadata.format;
-            texWidth = static_cast<int>(metadata.width);
-            texHeight = static_cast<int>(metadata.height);
-            pixelDataPtr = ddsImage.GetPixels();
-            bytesPerPixel = BytesPerPixel(format);
-
-        }
-        else if (is_type_texture(static_cast<FileType>(entry.type))) {
-            DatTexture dat_texture = dat_manager->parse_ffna_texture_file(index);
-            if (dat_texture.width > 0 && dat_texture.height > 0) {
-                texWidth = dat_texture.width;
-                texHeight = dat_texture.height;
-                format = DXGI_FORMAT_B8G8R8A8_UNORM;
-                rgba_data = std::move(dat_texture.rgba_data);
-                pixelDataPtr = rgba_data.data();
-                bytesPerPixel = sizeof(RGBA);
-            }
-            else {
-                throw std::runtime_error(std::format("ProcessImageFile failed or returned invalid dimensions for index {}.", index));
-            }
-        }
-        else {
-            throw std::runtime_error(std::format("Attempting to extract non-texture file at index {} as texture.", index));
-        }
-
-        if (!pixelDataPtr || texWidth <= 0 || texHeight <= 0 || bytesPerPixel == 0) {
-            throw std::runtime_error(std::format("Invalid texture data derived for index {}.", index));
-        }
-
-
-        // Create temporary D3D11Texture2D
-        D3D11_TEXTURE2D_DESC texDesc = {};
-        texDesc.Width = texWidth;
-        texDesc.Height = texHeight;
-        texDesc.MipLevels = 1; // Create only one mip level for saving
-        texDesc.ArraySize = 1;
-        texDesc.Format = format; // Use the determined format
-        texDesc.SampleDesc.Count = 1;
-        texDesc.Usage = D3D11_USAGE_DEFAULT;
-        texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-        texDesc.CPUAccessFlags = 0;
-        texDesc.MiscFlags = 0;
-
-        D3D11_SUBRESOURCE_DATA initData = {};
-        initData.pSysMem = pixelDataPtr;
-        initData.SysMemPitch = texWidth * bytesPerPixel;
-        initData.SysMemSlicePitch = initData.SysMemPitch * texHeight;
-
-        HRESULT hr = device->CreateTexture2D(&texDesc, &initData, localTexture.GetAddressOf());
-        if (FAILED(hr)) throw std::runtime_error(std::format("CreateTexture2D failed for index {}. HRESULT: 0x{:X}", index, hr));
-
-        // Create temporary ID3D11ShaderResourceView
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = texDesc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        srvDesc.Texture2D.MostDetailedMip = 0;
-
-        hr = device->CreateShaderResourceView(localTexture.Get(), &srvDesc, localSrv.GetAddressOf());
-        if (FAILED(hr)) throw std::runtime_error(std::format("CreateShaderResourceView failed for index {}. HRESULT: 0x{:X}", index, hr));
-
-        // --- Create Subfolder ---
-        FileType fileTypeEnum = static_cast<FileType>(entry.type);
-        std::wstring typeSubfolderName = typeToWString(fileTypeEnum);
-        if (typeSubfolderName == L" ") {
-            typeSubfolderName = L"UnknownType";
-        }
-        std::filesystem::path subFolderPath = std::filesystem::path(save_directory) / typeSubfolderName;
-
-        // Create directory if it doesn't exist
-        std::error_code ec;
-        if (!std::filesystem::exists(subFolderPath)) {
-            if (!std::filesystem::create_directories(subFolderPath, ec)) {
-                // Handle error - couldn't create directory
-                throw std::runtime_error(std::format("Failed to create directory: {}. Error code: {}", subFolderPath.string(), ec.value()));
-            }
-        }
-        // --- End Create Subfolder ---
-
-
-        // Construct filename and save
-        std::wstring filename = std::format(L"texture_0x{:X}.png", entry.Hash);
-        std::filesystem::path fullPath = subFolderPath / filename;
-
-        std::wstring fullPathStr = fullPath.wstring();
-        if (!m_map_renderer || !m_map_renderer->GetTextureManager()) {
-            throw std::runtime_error("TextureManager is not available for saving.");
-        }
-        if (!SaveTextureToPng(localSrv.Get(), fullPathStr, m_map_renderer->GetTextureManager())) {
-            throw std::runtime_error(std::format("Failed to save texture to PNG for index {}.", index));
-        }
-
-        // Cleanup raw data if allocated
-        if (raw_data) {
-            delete[] raw_data;
-            raw_data = nullptr;
-        }
-        // ComPtrs handle D3D resource release automatically
-    }
-    catch (const std::exception& e) {
-        // Log the error instead of showing a popup and stopping
-        std::string error_what = e.what();
-        std::wstring error_msg_w(error_what.begin(), error_what.end());
-        std::wstring log_entry = std::format(L"MFT Index: {}, File Hash: 0x{:X}, Error: {}", index, entry.Hash, error_msg_w);
-        OutputDebugStringW(log_entry.c_str());
-        OutputDebugStringA("\n"); // For VS Output Window clarity
-        WriteToTextureErrorLog(index, entry.Hash, error_msg_w);
-        if (raw_data) { delete[] raw_data; } // Ensure cleanup even on exception
-    }
-    catch (...) {
-        // Log the unknown error
-        std::wstring log_entry = std::format(L"MFT Index: {}, File Hash: 0x{:X}, Error: Unknown error.", index, entry.Hash);
-        OutputDebugStringW(log_entry.c_str());
-        OutputDebugStringA("\n"); // For VS Output Window clarity
-        WriteToTextureErrorLog(index, entry.Hash, L"Unknown error.");
-        if (raw_data) { delete[] raw_data; } // Ensure cleanup even on exception
-    }
-}
-
-
 void MapBrowser::OpenTextureErrorLog(const std::wstring& save_directory) {
     if (m_is_texture_error_log_open) {
         m_texture_error_log_file.close();
@@ -10,6 +10,8 @@
 #include "Camera.h"
 #include "DATManager.h"
 #include "MapRenderer.h"
+#include "PickingReadback.h"
+#include "TextureExport.h"
 #include "ModelViewer/ModelViewer.h"
 #include <draw_extract_panel.h>
 
@@ -71,7 +73,6 @@ private:
     void CreateWindowSizeDependentResources();
 
     void DrawStopExtractionButton();
-    void ProcessTextureExtraction(int index, const std::wstring& save_directory);
 
     // Texture Error Logging Helpers
     void OpenTextureErrorLog(const std::wstring& save_directory);
@@ -102,16 +103,20 @@ private:
     bool m_hash_index_initialized = false;
 
     //Texture extraction state
-    std::set<int> m_mft_indices_to_extract_textures;
-    int m_total_textures_to_extract = 0;
     std::wofstream m_texture_error_log_file; // Log file stream
     bool m_is_texture_error_log_open; // Flag for log file state
+    TextureExportJob m_texture_export_job; // Declared after the log so its workers are joined before it is destroyed
 
 
     std::vector<std::vector<std::string>> m_csv_data;
 
     std::unique_ptr<MapRenderer> m_map_renderer;
 
+    // Hovered object ids, copied only when the cursor, a mouse button or the camera changed since the last copy.
+    PickingReadback m_picking_readback;
+    POINT m_last_picking_cursor{};
+    DirectX::XMFLOAT4X4 m_last_picking_view{};
+
     std::string m_error_msg = "";
     bool m_show_error_msg = false;
 };
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "MapExportJob.h"
+#include "DATManager.h"
+#include "map_exporter.h"
+
+namespace
+{
+    // A map's working set (terrain mesh, parsed props and the models being exported) grows with the size of
+    // the map file. The factor is a rough upper bound from exporting the largest maps, not a measurement.
+    constexpr uint64_t map_memory_factor = 32;
+    constexpr uint64_t min_map_memory = 64ull << 20;
+
+    std::wstring exception_message(const std::exception_ptr& exception)
+    {
+        try {
+            std::rethrow_exception(exception);
+        }
+        catch (const std::exception& e) {
+            const std::string what = e.what();
+            return std::wstring(what.begin(), what.end());
+        }
+        catch (const char* message) { // The exporters throw string literals
+            const std::string what = message;
+            return std::wstring(what.begin(), what.end());
+        }
+        catch (...) {
+            return L"Unknown error.";
+        }
+    }
+}
+
+MapExportJob::~MapExportJob()
+{
+    Stop();
+}
+
+void MapExportJob::Start(DATManager* dat_manager, std::filesystem::path save_directory, bool binary,
+    uint64_t memory_budget_bytes, unsigned num_threads)
+{
+    Stop();
+
+    m_dat_manager = dat_manager;
+    m_save_directory = std::move(save_directory);
+    m_binary = binary;
+    m_error_log_path = m_save_directory / "map_export_errors.txt";
+    m_last_error.clear();
+    m_next_map = 0;
+    m_exported = 0;
+    m_failed = 0;
+    m_memory_in_use = 0;
+    m_stop_requested = false;
+    m_start_time = std::chrono::steady_clock::now();
+    m_end_time = std::chrono::steady_clock::time_point{};
+
+    // A quarter of the budget keeps decoded textures around for the next maps, the rest is for maps in flight.
+    const uint64_t texture_budget = memory_budget_bytes / 4;
+    m_memory_budget = memory_budget_bytes - texture_budget;
+    m_cache = std::make_unique<gwmb_export_cache>(static_cast<size_t>(texture_budget));
+
+    const auto& mft = m_dat_manager->get_MFT();
+    m_hash_index.clear();
+    m_maps.clear();
+    for (int i = 0; i < static_cast<int>(mft.size()); i++) {
+        m_hash_index[mft[i].Hash].push_back(i);
+        if (mft[i].type == FFNA_Type3 && mft[i].Hash != 0) {
+            const uint64_t estimate = std::max<uint64_t>(min_map_memory, static_cast<uint64_t>(mft[i].uncompressedSize) * map_memory_factor);
+            m_maps.push_back({ i, mft[i].Hash, std::min(estimate, m_memory_budget) });
+        }
+    }
+
+    // Maps share their hash with aliases, one export each is enough.
+    std::ranges::sort(m_maps, {}, &Map::file_hash);
+    const auto [first, last] = std::ranges::unique(m_maps, {}, &Map::file_hash);
+    m_maps.erase(first, last);
+
+    // The largest maps first, so the small ones fill the gaps at the end instead of one large map running alone.
+    std::ranges::stable_sort(m_maps, std::ranges::greater{}, &Map::memory_estimate);
+
+    std::error_code error;
+    std::filesystem::create_directories(m_save_directory, error);
+    std::filesystem::remove(m_error_log_path, error);
+
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, static_cast<unsigned>(std::max<size_t>(m_maps.size(), 1)));
+
+    m_running_workers = static_cast<int>(num_threads);
+    for (unsigned i = 0; i < num_threads; i++) {
+        m_workers.emplace_back([this] { RunWorker(); });
+    }
+}
+
+void MapExportJob::Stop()
+{
+    {
+        std::scoped_lock lock(m_memory_mutex);
+        m_stop_requested = true;
+    }
+    m_memory_released.notify_all();
+    m_workers.clear(); // jthread joins
+    m_cache.reset();
+}
+
+size_t MapExportJob::GetTextureCacheBytes() const
+{
+    return m_cache ? m_cache->get_texture_bytes() : 0;
+}
+
+double MapExportJob::GetElapsedSeconds() const
+{
+    auto end = m_end_time.load();
+    if (end == std::chrono::steady_clock::time_point{}) {
+        end = std::chrono::steady_clock::now();
+    }
+    return std::max(0.0, std::chrono::duration<double>(end - m_start_time).count());
+}
+
+std::wstring MapExportJob::GetLastError() const
+{
+    std::scoped_lock lock(m_error_mutex);
+    return m_last_error;
+}
+
+void MapExportJob::RunWorker()
+{
+    while (!m_stop_requested) {
+        const size_t i = m_next_map.fetch_add(1);
+        if (i >= m_maps.size()) break;
+
+        const auto& map = m_maps[i];
+        if (!AcquireMemory(map.memory_estimate)) break;
+        ExportMap(map);
+        ReleaseMemory(map.memory_estimate);
+    }
+
+    if (m_running_workers.fetch_sub(1) == 1) {
+        m_end_time = std::chrono::steady_clock::now();
+    }
+}
+
+// Each estimate is clamped to the budget, so a map always fits once nothing else is in flight.
+bool MapExportJob::AcquireMemory(uint64_t bytes)
+{
+    std::unique_lock lock(m_memory_mutex);
+    m_memory_released.wait(lock, [&] {
+        return m_stop_requested || m_memory_in_use + bytes <= m_memory_budget;
+    });
+    if (m_stop_requested) {
+        return false;
+    }
+    m_memory_in_use += bytes;
+    return true;
+}
+
+void MapExportJob::ReleaseMemory(uint64_t bytes)
+{
+    {
+        std::scoped_lock lock(m_memory_mutex);
+        m_memory_in_use -= bytes;
+    }
+    m_memory_released.notify_all();
+}
+
+void MapExportJob::ExportMap(const Map& map)
+{
+    bool success = false;
+    std::wstring error;
+    try {
+        const std::wstring map_directory = (m_save_directory / (L"gwmb_map_" + std::to_wstring(map.file_hash))).wstring();
+        std::filesystem::create_directories(map_directory);
+
+        success = m_binary
+            ? map_exporter::export_map_binary(map_directory, map.file_hash, map.mft_index, m_dat_manager, m_hash_index, m_cache.get())
+            : map_exporter::export_map(map_directory, map.file_hash, map.mft_index, m_dat_manager, m_hash_index, false, m_cache.get());
+        if (!success) {
+            error = L"The map has no terrain or couldn't be written.";
+        }
+    }
+    catch (...) {
+        error = exception_message(std::current_exception());
+    }
+
+    if (success) {
+        m_exported.fetch_add(1);
+    }
+    else {
+        m_failed.fetch_add(1);
+        ReportError(map, error);
+    }
+}
+
+void MapExportJob::ReportError(const Map& map, const std::wstring& error)
+{
+    std::scoped_lock lock(m_error_mutex);
+    m_last_error = std::format(L"Map 0x{:X}: {}", map.file_hash, error);
+
+    std::wofstream log(m_error_log_path, std::ios::app);
+    log << std::format(L"MFT Index: {}, File Hash: 0x{:X}, Error: {}\n", map.mft_index, map.file_hash, error);
+}
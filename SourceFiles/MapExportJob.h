@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "gwmb_export_cache.h"
+
+class DATManager;
+
+/**
+ * @brief Exports every map (FFNA_Type3) of a DAT to gwmb on a pool of worker threads, without D3D.
+ *
+ * Each map goes to <save_directory>/gwmb_map_<hash>, the same folder layout as exporting a single map from
+ * the DAT browser, so the Blender add-on imports them unchanged. The maps share a gwmb_export_cache: a model
+ * or texture used by many maps is decoded and written once, the other map folders get hard links to it.
+ *
+ * Maps are exported largest first. A map is only started while the estimated memory of the maps in flight
+ * stays within the budget, a quarter of which is given to the cache's decoded textures. Errors are collected
+ * in map_export_errors.txt in the save directory.
+ */
+class MapExportJob
+{
+public:
+    static constexpr uint64_t default_memory_budget_bytes = 4ull << 30;
+
+    ~MapExportJob();
+
+    // Returns immediately. dat_manager must have finished reading the types of its files. num_threads 0 uses
+    // every hardware thread.
+    void Start(DATManager* dat_manager, std::filesystem::path save_directory, bool binary,
+        uint64_t memory_budget_bytes = default_memory_budget_bytes, unsigned num_threads = 0);
+
+    // Cancels the maps that haven't started and joins the workers. Maps being exported are finished first.
+    void Stop();
+
+    // Started and not stopped yet, also while the finished workers wait to be joined by Stop.
+    bool IsActive() const { return !m_workers.empty(); }
+    bool IsDone() const { return m_running_workers.load() == 0; }
+
+    int GetTotalCount() const { return static_cast<int>(m_maps.size()); }
+    int GetExportedCount() const { return m_exported.load(); }
+    int GetFailedCount() const { return m_failed.load(); }
+    int GetCompletedCount() const { return GetExportedCount() + GetFailedCount(); }
+    uint64_t GetMemoryInUse() const { return m_memory_in_use.load(); } // Estimated, maps in flight only
+    size_t GetTextureCacheBytes() const;
+
+    // Up to now or until the job is done.
+    double GetElapsedSeconds() const;
+
+    std::wstring GetLastError() const;
+    const std::filesystem::path& GetErrorLogPath() const { return m_error_log_path; }
+
+private:
+    struct Map
+    {
+        int mft_index;
+        int file_hash;
+        uint64_t memory_estimate;
+    };
+
+    void RunWorker();
+    bool AcquireMemory(uint64_t bytes);
+    void ReleaseMemory(uint64_t bytes);
+    void ExportMap(const Map& map);
+    void ReportError(const Map& map, const std::wstring& error);
+
+    DATManager* m_dat_manager = nullptr;
+    std::filesystem::path m_save_directory;
+    bool m_binary = false;
+    std::vector<Map> m_maps; // Largest first
+    std::unordered_map<int, std::vector<int>> m_hash_index;
+    std::unique_ptr<gwmb_export_cache> m_cache;
+
+    uint64_t m_memory_budget = 0; // For the maps in flight, the cache's share is taken out
+    std::atomic<uint64_t> m_memory_in_use{0};
+    std::mutex m_memory_mutex;
+    std::condition_variable m_memory_released;
+
+    mutable std::mutex m_error_mutex;
+    std::wstring m_last_error;
+    std::filesystem::path m_error_log_path;
+
+    std::vector<std::jthread> m_workers;
+    std::atomic<size_t> m_next_map{0};
+    std::atomic<int> m_exported{0};
+    std::atomic<int> m_failed{0};
+    std::atomic<int> m_running_workers{0};
+    std::atomic<bool> m_stop_requested{false};
+
+    std::chrono::steady_clock::time_point m_start_time;
+    std::atomic<std::chrono::steady_clock::time_point> m_end_time{};
+};
@@ -1,7 +1,11 @@
 #pragma once
+#include <numeric>
 #include "InputManager.h"
 #include "Camera.h"
 #include "MeshManager.h"
+#include "DebugDraw.h"
+#include "FrustumCulling.h"
+#include "RayQuery.h"
 #include "TextureManager.h"
 #include "VertexShader.h"
 #include "SkinnedVertexShader.h"
@@ -32,6 +36,7 @@ public:
         m_blend_state_manager = std::make_unique<BlendStateManager>(m_device, m_deviceContext);
         m_rasterizer_state_manager = std::make_unique<RasterizerStateManager>(m_device, m_deviceContext);
         m_stencil_state_manager = std::make_unique<DepthStencilStateManager>(m_device, m_deviceContext);
+        m_debug_draw = std::make_unique<DebugDraw>(m_device, m_deviceContext);
         m_user_camera = std::make_unique<Camera>();
     }
 
@@ -40,6 +45,7 @@ public:
         // Initialize cameras
         float fov_degrees = 60.0f;
         float aspect_ratio = viewport_width / viewport_height;
+        m_viewport_height = viewport_height;
         m_user_camera->SetFrustumAsPerspective(static_cast<float>(fov_degrees * XM_PI / 180.0), aspect_ratio,
             10.0f, 200000);
         const auto pos = FXMVECTOR{ 0, 8500, 0, 0 };
@@ -59,6 +65,7 @@ public:
         // Create and initialize the VertexShader
         m_vertex_shader = std::make_unique<VertexShader>(m_device, m_deviceContext);
         m_vertex_shader->Initialize(L"VertexShader.hlsl");
+        m_mesh_manager->SetVertexShader(m_vertex_shader.get());
 
         // Create and initialize the Skinned VertexShader for animated models
         m_skinned_vertex_shader = std::make_unique<SkinnedVertexShader>(m_device, m_deviceContext);
@@ -325,6 +332,12 @@ public:
         mesh->num_textures = 1;
         m_terrain_mesh_id = m_mesh_manager->AddCustomMesh(mesh, m_terrain_current_pixel_shader_type);
         m_mesh_manager->SetMeshShouldRender(m_terrain_mesh_id, false); // We'll render it manually.
+
+        // Coarser chunk levels share the terrain mesh's textures and constants, so they ride along on the same instance.
+        if (const auto lod_mesh = terrain->get_lod_mesh())
+        {
+            m_mesh_manager->GetMesh(m_terrain_mesh_id)->SetAuxiliaryGeometry(m_device, lod_mesh->vertices, lod_mesh->indices);
+        }
         m_terrain_texture_atlas_id = texture_atlas_id;
 
         PerObjectCB terrainPerObjectData;
@@ -385,11 +398,9 @@ public:
         std::vector<uint8_t> terrain_shadow_map_data(texture_width * texture_height);
         for (int i = 0; i < texture_height; ++i)
         {
-            for (int j = 0; j < texture_width; ++j)
-            {
-                terain_texture_data[i * texture_width + j] = texture_index_grid[i][j];
-                terrain_shadow_map_data[i * texture_width + j] = terrain_shadow_map_grid[i][j];
-            }
+            // The grids carry one extra column, so copy texture_width bytes from each row
+            memcpy(&terain_texture_data[i * texture_width], texture_index_grid.row(i).data(), texture_width);
+            memcpy(&terrain_shadow_map_data[i * texture_width], terrain_shadow_map_grid.row(i).data(), texture_width);
         }
 
         // Create the texture and add it to the texture manager
@@ -405,6 +416,7 @@ public:
             m_terrain_mesh_id, { m_texture_manager->GetTexture(m_terrain_shadow_map_id) }, 2);
 
         m_terrain = terrain;
+        m_ray_scene.SetTerrain(terrain);
         m_is_terrain_mesh_set = true;
     }
 
@@ -430,6 +442,7 @@ public:
         }
 
         m_prop_mesh_ids.clear();
+        ClearPropCulling();
     }
 
     void SetTerrainMeshId(int terrain_mesh_id) { m_terrain_mesh_id = terrain_mesh_id; }
@@ -445,8 +458,10 @@ public:
     int GetWaterMeshId() { return m_water_mesh_id; }
 
     // A prop consists of 1+ sub models/meshes.
+    // geometry_source_mesh_ids optionally holds the mesh ids of an earlier prop with the same meshes,
+    // which are then drawn from that prop's GPU buffers and can be instanced with it.
     std::vector<int> AddProp(std::vector<Mesh> meshes, std::vector<PerObjectCB>& per_object_cbs,
-        uint32_t model_id, PixelShaderType pixel_shader_type)
+        uint32_t model_id, PixelShaderType pixel_shader_type, std::span<const int> geometry_source_mesh_ids = {})
     {
         m_should_rerender_shadows = true;
         std::vector<int> mesh_ids;
@@ -455,11 +470,30 @@ public:
             const auto& mesh = meshes[i];
             auto& per_object_cb = per_object_cbs[i];
 
-            int mesh_id = m_mesh_manager->AddCustomMesh(mesh, pixel_shader_type);
+            int mesh_id = static_cast<size_t>(i) < geometry_source_mesh_ids.size()
+                ? m_mesh_manager->AddCustomMesh(mesh, pixel_shader_type, geometry_source_mesh_ids[i])
+                : m_mesh_manager->AddCustomMesh(mesh, pixel_shader_type);
             per_object_cb.object_id = mesh_id;
             m_mesh_manager->UpdateMeshPerObjectData(mesh_id, per_object_cb);
             mesh_ids.push_back(mesh_id);
+
+            const auto local_bounds = ComputeAABB(std::span<const GWVertex>(mesh.vertices));
+            m_prop_culling_slots[mesh_id] = static_cast<uint32_t>(m_prop_culling_mesh_ids.size());
+            m_prop_culling_mesh_ids.push_back(mesh_id);
+            m_prop_local_bounds.push_back(local_bounds);
+            m_prop_world_bounds.push_back(TransformAABB(local_bounds, per_object_cb.world));
+
+            // Ray scene instances are added in slot order, so slots double as instance ids.
+            const int geometry_source_mesh_id = static_cast<size_t>(i) < geometry_source_mesh_ids.size() ? geometry_source_mesh_ids[i] : mesh_id;
+            auto ray_model_it = m_ray_models.find(geometry_source_mesh_id);
+            if (ray_model_it == m_ray_models.end()) {
+                std::vector<XMFLOAT3> positions(mesh.vertices.size());
+                std::transform(mesh.vertices.begin(), mesh.vertices.end(), positions.begin(), [](const GWVertex& vertex) { return vertex.position; });
+                ray_model_it = m_ray_models.emplace(geometry_source_mesh_id, m_ray_scene.AddModel(positions, mesh.indices)).first;
+            }
+            m_ray_scene.AddInstance(ray_model_it->second, per_object_cb.world, model_id, i);
         }
+        m_prop_bvh_dirty = true;
 
         const auto it = m_prop_mesh_ids.find(model_id);
         if (it != m_prop_mesh_ids.end()) {
@@ -481,6 +515,7 @@ public:
         }
 
         m_prop_mesh_ids.clear();
+        ClearPropCulling();
     }
 
     // Unbinds the shadow map SRV from slot 0 to avoid D3D11 validation errors
@@ -524,11 +559,6 @@ public:
         return false;
     }
 
-    int GetObjectId(ID3D11Texture2D* picking_target, const int x, const int y) const
-    {
-        return m_mesh_manager->GetPickedObjectId(m_deviceContext, picking_target, x, y);
-    }
-
     std::map<uint32_t, std::vector<int>>& GetPropsMeshIds() { return m_prop_mesh_ids; }
     std::vector<int>& GetShoreMeshIds() { return m_shore_mesh_ids; }
 
@@ -555,6 +585,7 @@ public:
     void OnViewPortChanged(const float viewport_width, const float viewport_height)
     {
         m_user_camera->OnViewPortChanged(viewport_width, viewport_height);
+        m_viewport_height = viewport_height;
     }
 
     RasterizerStateType GetCurrentRasterizerState()
@@ -585,6 +616,27 @@ public:
         return m_lod_quality;
     }
 
+    void SetTerrainLODEnabled(bool enabled) { m_terrain_lod_enabled = enabled; }
+    bool GetTerrainLODEnabled() const { return m_terrain_lod_enabled; }
+
+    void SetTerrainLODMaxScreenError(float max_screen_error) { m_terrain_lod_max_screen_error = max_screen_error; }
+    float GetTerrainLODMaxScreenError() const { return m_terrain_lod_max_screen_error; }
+
+    // Index counts from the last terrain LOD selection (full resolution vs. drawn).
+    const TerrainLODStats& GetTerrainLODStats() const { return m_terrain_lod_stats; }
+
+    void SetPropCullingEnabled(bool enabled) { m_prop_culling_enabled = enabled; }
+    bool GetPropCullingEnabled() const { return m_prop_culling_enabled; }
+
+    // Prop meshes inside the main camera frustum in the last frame, and the total number of prop meshes.
+    uint32_t GetVisiblePropMeshCount() const { return m_visible_prop_mesh_count; }
+    uint32_t GetPropMeshCount() const { return static_cast<uint32_t>(m_prop_culling_mesh_ids.size()); }
+
+    // Closest prop or terrain hit on the CPU, independent of the picking render target. Prop hits report the
+    // prop index passed to AddProp as model_id. Geometry is indexed on the first call after props change.
+    bool CastRay(const Ray& ray, RayHit& hit) { return m_ray_scene.Intersect(ray, hit); }
+    RayScene& GetRayScene() { return m_ray_scene; }
+
     void SetShouldRenderSky(bool should_render_sky) { m_should_render_sky = should_render_sky; }
     bool GetShouldRenderSky() { return m_should_render_sky; }
 
@@ -628,129 +680,128 @@ public:
     void SetWireframeMode(bool wireframe) { m_wireframe_mode = wireframe; }
     bool GetWireframeMode() const { return m_wireframe_mode; }
 
-    void SetPathfinding(std::vector<Mesh>& pathfinding_meshes, const std::vector<uint32_t>& plane_sizes, PixelShaderType pixel_shader_type)
+    // Stores the trapezoid corners of every plane. The overlay is drawn through the debug draw
+    // buffer with one triangle batch per plane color, no meshes or textures are created.
+    void SetPathfinding(const std::vector<PathfindingTrapezoid>& trapezoids, const std::vector<uint32_t>& plane_sizes,
+        Terrain* terrain)
     {
-        m_pathfinding_mesh_ids.clear();
-        m_pathfinding_plane_mesh_ids.clear();
-        should_render_pathfinding_mesh_id.clear();
+        ClearPathfinding();
+        if (!terrain) return;
 
         const float golden_ratio = 1.61803398875f;
-        const int texture_size = 4;  // Small solid color texture
 
-        // Initialize plane groupings
-        m_pathfinding_plane_mesh_ids.resize(plane_sizes.size());
-
-        size_t mesh_idx = 0;
+        m_pathfinding_plane_first.push_back(0);
         for (size_t plane_idx = 0; plane_idx < plane_sizes.size(); plane_idx++)
         {
-            for (uint32_t trap_idx = 0; trap_idx < plane_sizes[plane_idx]; trap_idx++)
-            {
-                if (mesh_idx >= pathfinding_meshes.size()) break;
-
-                const auto& mesh = pathfinding_meshes[mesh_idx];
-                int mesh_id = m_mesh_manager->AddCustomMesh(mesh, pixel_shader_type);
-
-                // Calculate hue using golden ratio for distinct colors (by plane for consistent plane colors)
-                float hue = fmodf(plane_idx * golden_ratio, 1.0f);
-
-                // HSV to RGB conversion (s=0.7, v=0.9)
-                float s = 0.7f, v = 0.9f;
-                float c = v * s;
-                float x = c * (1.0f - fabsf(fmodf(hue * 6.0f, 2.0f) - 1.0f));
-                float m = v - c;
-                float r, g, b;
-                int hi = (int)(hue * 6.0f);
-                switch (hi % 6) {
-                    case 0: r = c; g = x; b = 0; break;
-                    case 1: r = x; g = c; b = 0; break;
-                    case 2: r = 0; g = c; b = x; break;
-                    case 3: r = 0; g = x; b = c; break;
-                    case 4: r = x; g = 0; b = c; break;
-                    default: r = c; g = 0; b = x; break;
-                }
-                r += m; g += m; b += m;
-
-                // Create solid color texture data (RGBA format)
-                std::vector<uint8_t> texture_data(texture_size * texture_size * 4);
-                for (int p = 0; p < texture_size * texture_size; p++) {
-                    texture_data[p * 4 + 0] = static_cast<uint8_t>(r * 255);
-                    texture_data[p * 4 + 1] = static_cast<uint8_t>(g * 255);
-                    texture_data[p * 4 + 2] = static_cast<uint8_t>(b * 255);
-                    texture_data[p * 4 + 3] = 180;  // Semi-transparent
-                }
+            const uint32_t first = m_pathfinding_plane_first.back();
+            m_pathfinding_plane_first.push_back(std::min<uint32_t>(first + plane_sizes[plane_idx],
+                static_cast<uint32_t>(trapezoids.size())));
+
+            // Calculate hue using golden ratio for distinct colors (by plane for consistent plane colors)
+            float hue = fmodf(plane_idx * golden_ratio, 1.0f);
+
+            // HSV to RGB conversion (s=0.7, v=0.9)
+            float s = 0.7f, v = 0.9f;
+            float c = v * s;
+            float x = c * (1.0f - fabsf(fmodf(hue * 6.0f, 2.0f) - 1.0f));
+            float m = v - c;
+            float r, g, b;
+            int hi = (int)(hue * 6.0f);
+            switch (hi % 6) {
+                case 0: r = c; g = x; b = 0; break;
+                case 1: r = x; g = c; b = 0; break;
+                case 2: r = 0; g = c; b = x; break;
+                case 3: r = 0; g = x; b = c; break;
+                case 4: r = x; g = 0; b = c; break;
+                default: r = c; g = 0; b = x; break;
+            }
 
-                // Create texture and assign to mesh
-                int texture_id = m_texture_manager->AddTexture(
-                    texture_data.data(), texture_size, texture_size,
-                    DXGI_FORMAT_R8G8B8A8_UNORM, 9999000 + static_cast<int>(mesh_idx));
+            m_pathfinding_plane_colors.emplace_back(r + m, g + m, b + m, 180.0f / 255.0f);  // Semi-transparent
+        }
 
-                m_mesh_manager->SetTexturesForMesh(mesh_id, { m_texture_manager->GetTexture(texture_id) }, 3);
+        m_pathfinding_trapezoid_visible.assign(m_pathfinding_plane_first.back(), 1);
+        UpdatePathfindingHeights(m_pathfinding_height_offset, terrain, trapezoids);
+    }
 
-                PerObjectCB meshPerObjectData;
-                meshPerObjectData.num_uv_texture_pairs = 1;
-                meshPerObjectData.blend_flags[0][0] = 8;  // Alpha blend
-                m_mesh_manager->UpdateMeshPerObjectData(mesh_id, meshPerObjectData);
+    void ClearPathfinding()
+    {
+        m_pathfinding_corners.clear();
+        m_pathfinding_plane_first.clear();
+        m_pathfinding_plane_colors.clear();
+        m_pathfinding_trapezoid_visible.clear();
+        m_pathfinding_plane_triangles.clear();
+        m_pathfinding_triangles_dirty = true;
+    }
 
-                SetMeshShouldRender(mesh_id, false); // don't render with props
-                m_pathfinding_mesh_ids.push_back(mesh_id);
-                m_pathfinding_plane_mesh_ids[plane_idx].push_back(mesh_id);
-                should_render_pathfinding_mesh_id.insert({ mesh_id, true });
+    uint32_t GetPathfindingPlaneCount() const {
+        return m_pathfinding_plane_first.empty() ? 0 : static_cast<uint32_t>(m_pathfinding_plane_first.size() - 1);
+    }
+    uint32_t GetPathfindingTrapezoidCount() const { return static_cast<uint32_t>(m_pathfinding_trapezoid_visible.size()); }
+    uint32_t GetPathfindingPlaneFirstTrapezoid(uint32_t plane) const { return m_pathfinding_plane_first[plane]; }
+    uint32_t GetPathfindingPlaneTrapezoidCount(uint32_t plane) const {
+        return m_pathfinding_plane_first[plane + 1] - m_pathfinding_plane_first[plane];
+    }
 
-                mesh_idx++;
-            }
+    void SetPathfindingTrapezoidShouldRender(uint32_t trapezoid, bool should_render) {
+        if (trapezoid < m_pathfinding_trapezoid_visible.size() && m_pathfinding_trapezoid_visible[trapezoid] != should_render) {
+            m_pathfinding_trapezoid_visible[trapezoid] = should_render;
+            m_pathfinding_triangles_dirty = true;
         }
     }
 
-    void SetPathfindingMeshIdShouldRender(int mesh_id, bool should_render) {
-        auto it = should_render_pathfinding_mesh_id.find(mesh_id);
-        if (it != should_render_pathfinding_mesh_id.end()) {
-            it->second = should_render;
-        }
+    bool GetPathfindingTrapezoidShouldRender(uint32_t trapezoid) const {
+        return trapezoid < m_pathfinding_trapezoid_visible.size() && m_pathfinding_trapezoid_visible[trapezoid];
     }
 
-    bool GetPathfindingMeshIdShouldRender(int mesh_id) {
-        auto it = should_render_pathfinding_mesh_id.find(mesh_id);
-        if (it != should_render_pathfinding_mesh_id.end()) {
-            return it->second;
+    // Sets the visibility of count trapezoids starting at first, e.g. a whole plane.
+    void SetPathfindingTrapezoidsShouldRender(uint32_t first, uint32_t count, bool should_render) {
+        for (uint32_t i = first; i < first + count; i++) {
+            SetPathfindingTrapezoidShouldRender(i, should_render);
         }
-        return false;
     }
 
-    std::vector<int>& GetPathfindingMeshIds() { return m_pathfinding_mesh_ids; }
-    std::vector<std::vector<int>>& GetPathfindingPlaneMeshIds() { return m_pathfinding_plane_mesh_ids; }
-
     void SetPathfindingHeightOffset(float offset) { m_pathfinding_height_offset = offset; }
     float GetPathfindingHeightOffset() { return m_pathfinding_height_offset; }
 
-    void UpdatePathfindingMeshHeights(float height_offset, Terrain* terrain,
+    void UpdatePathfindingHeights(float height_offset, Terrain* terrain,
         const std::vector<PathfindingTrapezoid>& trapezoids)
     {
-        if (m_pathfinding_mesh_ids.size() != trapezoids.size()) return;
+        if (GetPathfindingTrapezoidCount() > trapezoids.size()) return;
 
         m_pathfinding_height_offset = height_offset;
 
-        for (size_t i = 0; i < m_pathfinding_mesh_ids.size(); i++)
+        std::vector<float> corner_heights = terrain->get_trapezoid_corner_heights(trapezoids);
+
+        m_pathfinding_corners.resize(GetPathfindingTrapezoidCount() * 4);
+        for (size_t i = 0; i < GetPathfindingTrapezoidCount(); i++)
         {
             const auto& trap = trapezoids[i];
-            int mesh_id = m_pathfinding_mesh_ids[i];
 
-            // Recalculate heights with new offset
-            float height_tl = terrain->get_height_at(trap.xtl, trap.yt) + height_offset;
-            float height_tr = terrain->get_height_at(trap.xtr, trap.yt) + height_offset;
-            float height_bl = terrain->get_height_at(trap.xbl, trap.yb) + height_offset;
-            float height_br = terrain->get_height_at(trap.xbr, trap.yb) + height_offset;
+            // trap.yt = top Y, trap.yb = bottom Y (world Z)
+            // trap.xtl/xtr = top X coords, trap.xbl/xbr = bottom X coords (world X)
+            m_pathfinding_corners[i * 4 + 0] = XMFLOAT3(trap.xtl, corner_heights[i * 4 + 0] + height_offset, trap.yt);
+            m_pathfinding_corners[i * 4 + 1] = XMFLOAT3(trap.xtr, corner_heights[i * 4 + 1] + height_offset, trap.yt);
+            m_pathfinding_corners[i * 4 + 2] = XMFLOAT3(trap.xbr, corner_heights[i * 4 + 3] + height_offset, trap.yb);
+            m_pathfinding_corners[i * 4 + 3] = XMFLOAT3(trap.xbl, corner_heights[i * 4 + 2] + height_offset, trap.yb);
+        }
+        m_pathfinding_triangles_dirty = true;
+    }
 
-            // Update mesh vertices
-            std::vector<GWVertex> vertices;
-            XMFLOAT3 normal(0.0f, 1.0f, 0.0f);
-            XMFLOAT2 tex00(0.0f, 0.0f), tex10(1.0f, 0.0f), tex01(0.0f, 1.0f), tex11(1.0f, 1.0f);
+    DebugDraw* GetDebugDraw() { return m_debug_draw.get(); }
 
-            vertices.push_back(GWVertex(XMFLOAT3(trap.xtl, height_tl, trap.yt), normal, tex00));
-            vertices.push_back(GWVertex(XMFLOAT3(trap.xtr, height_tr, trap.yt), normal, tex10));
-            vertices.push_back(GWVertex(XMFLOAT3(trap.xbr, height_br, trap.yb), normal, tex11));
-            vertices.push_back(GWVertex(XMFLOAT3(trap.xbl, height_bl, trap.yb), normal, tex01));
+    // Starts a new debug draw frame and submits the overlays owned by the renderer. Call once per frame
+    // before the UI submits its own primitives.
+    void BeginDebugDrawFrame()
+    {
+        m_debug_draw->BeginFrame();
 
-            m_mesh_manager->UpdateMeshVertices(mesh_id, vertices);
+        if (m_should_render_pathfinding && GetPathfindingTrapezoidCount() > 0) {
+            if (m_pathfinding_triangles_dirty) {
+                RebuildPathfindingTriangles();
+            }
+            for (uint32_t plane = 0; plane < m_pathfinding_plane_triangles.size(); plane++) {
+                m_debug_draw->AddTriangles(m_pathfinding_plane_triangles[plane], m_pathfinding_plane_colors[plane]);
+            }
         }
     }
 
@@ -857,6 +908,8 @@ public:
 
     void Render(ID3D11RenderTargetView* render_target_view, ID3D11RenderTargetView* picking_render_target, ID3D11DepthStencilView* depth_stencil_view)
     {
+        m_visible_prop_mesh_count = UpdatePropVisibility();
+
         m_deviceContext->OMSetRenderTargets(1, &render_target_view, depth_stencil_view);
 
         // Render sky before anything else
@@ -887,8 +940,7 @@ public:
         }
 
         if (m_terrain_mesh_id) {
-            m_mesh_manager->RenderMesh(m_pixel_shaders, m_blend_state_manager.get(), m_rasterizer_state_manager.get(),
-                m_stencil_state_manager.get(), m_user_camera->GetPosition3f(), m_lod_quality, m_terrain_mesh_id);
+            RenderTerrain();
         }
 
         if (m_should_use_picking_shader_for_models) {
@@ -921,17 +973,9 @@ public:
             }
         }
 
-        // Render pathfinding trapezoids
-        if (m_pathfinding_mesh_ids.size() > 0 && m_should_render_pathfinding) {
-            m_deviceContext->OMSetRenderTargets(1, &render_target_view, depth_stencil_view);
-            for (auto& mesh_id : m_pathfinding_mesh_ids) {
-                const auto it = should_render_pathfinding_mesh_id.find(mesh_id);
-                if (it != should_render_pathfinding_mesh_id.end() && it->second) {
-                    m_mesh_manager->RenderMesh(m_pixel_shaders, m_blend_state_manager.get(), m_rasterizer_state_manager.get(),
-                        m_stencil_state_manager.get(), m_user_camera->GetPosition3f(), m_lod_quality, mesh_id);
-                }
-            }
-        }
+        // Render debug draw primitives (pathfinding trapezoids, route overlays)
+        m_deviceContext->OMSetRenderTargets(1, &render_target_view, depth_stencil_view);
+        m_debug_draw->Render(m_pixel_shaders, m_blend_state_manager.get(), m_rasterizer_state_manager.get(), m_mesh_manager.get());
 
         if (m_should_use_picking_shader_for_models) {
             m_deviceContext->OMSetRenderTargets(1, &render_target_view, depth_stencil_view);
@@ -951,8 +995,40 @@ public:
         }
     }
 
+    // Draws the terrain with per-chunk LOD selected from the user camera, or at full resolution when LOD is off.
+    void RenderTerrain()
+    {
+        if (!m_terrain_lod_enabled || !m_terrain || m_terrain->get_chunk_lods().empty())
+        {
+            m_mesh_manager->RenderMesh(m_pixel_shaders, m_blend_state_manager.get(), m_rasterizer_state_manager.get(),
+                m_stencil_state_manager.get(), m_user_camera->GetPosition3f(), m_lod_quality, m_terrain_mesh_id);
+            return;
+        }
+
+        TerrainLODView view;
+        view.camera_position = m_user_camera->GetPosition3f();
+        view.max_screen_error = m_terrain_lod_max_screen_error;
+        if (m_user_camera->GetCameraType() == CameraType::Orthographic)
+        {
+            view.orthographic_scale = m_viewport_height / m_user_camera->GetViewHeight();
+        }
+        else
+        {
+            view.perspective_scale = m_viewport_height / (2.0f * std::tan(m_user_camera->GetFovY() * 0.5f));
+        }
+
+        const auto& chunks = m_terrain->get_chunk_lods();
+        m_terrain_lod_stats = SelectTerrainLODs(chunks, view, m_terrain_chunk_levels);
+        BuildTerrainDrawRanges(chunks, m_terrain_chunk_levels, m_terrain_full_res_ranges, m_terrain_lod_ranges);
+
+        m_mesh_manager->RenderMeshRanges(m_pixel_shaders, m_blend_state_manager.get(), m_rasterizer_state_manager.get(),
+            m_terrain_mesh_id, m_terrain_full_res_ranges, m_terrain_lod_ranges);
+    }
+
     void RenderForReflection(ID3D11RenderTargetView* render_target_view, ID3D11DepthStencilView* depth_stencil_view)
     {
+        UpdatePropVisibility();
+
         m_deviceContext->OMSetRenderTargets(1, &render_target_view, depth_stencil_view);
 
         // Render sky before anything else
@@ -987,6 +1063,8 @@ public:
 
     void RenderForShadowMap(ID3D11DepthStencilView* depth_stencil_view)
     {
+        UpdatePropVisibility();
+
         m_deviceContext->OMSetRenderTargets(0, nullptr, depth_stencil_view);
 
         if (m_terrain_mesh_id) {
@@ -1171,6 +1249,104 @@ public:
     }
 
 private:
+    void ClearPropCulling()
+    {
+        m_prop_culling_slots.clear();
+        m_prop_culling_mesh_ids.clear();
+        m_prop_local_bounds.clear();
+        m_prop_world_bounds.clear();
+        m_prop_bvh.Clear();
+        m_prop_bvh_dirty = true;
+
+        m_ray_scene.Clear();
+        m_ray_models.clear();
+        m_ray_scene.SetTerrain(m_terrain);
+    }
+
+    void UpdatePropWorldBounds(uint32_t slot)
+    {
+        const auto per_object_data = m_mesh_manager->GetMeshPerObjectData(m_prop_culling_mesh_ids[slot]);
+        if (per_object_data.has_value()) {
+            m_prop_world_bounds[slot] = TransformAABB(m_prop_local_bounds[slot], per_object_data->world);
+            m_ray_scene.SetInstanceTransform(slot, per_object_data->world);
+        }
+    }
+
+    // Culls prop meshes against the frustum of the current camera, which the main, reflection and shadow
+    // passes each set up before rendering. Returns the number of prop meshes left visible.
+    uint32_t UpdatePropVisibility()
+    {
+        // Props moved since the last pass (e.g. from the picking info panel) need new world bounds.
+        if (m_mesh_manager->TakeWorldChanges(m_moved_mesh_ids)) {
+            for (const int mesh_id : m_moved_mesh_ids) {
+                const auto it = m_prop_culling_slots.find(mesh_id);
+                if (it != m_prop_culling_slots.end()) {
+                    UpdatePropWorldBounds(it->second);
+                    m_prop_bvh_dirty = true;
+                }
+            }
+        }
+        else {
+            for (uint32_t slot = 0; slot < m_prop_culling_mesh_ids.size(); slot++) {
+                UpdatePropWorldBounds(slot);
+            }
+            m_prop_bvh_dirty = true;
+        }
+
+        if (!m_prop_culling_enabled || m_prop_culling_mesh_ids.empty()) {
+            m_mesh_manager->SetCulledMeshMask(nullptr);
+            return GetPropMeshCount();
+        }
+
+        if (m_prop_bvh_dirty) {
+            std::vector<uint32_t> slots(m_prop_culling_mesh_ids.size());
+            std::iota(slots.begin(), slots.end(), 0);
+            m_prop_bvh.Build(m_prop_world_bounds, slots);
+
+            const int max_mesh_id = *std::max_element(m_prop_culling_mesh_ids.begin(), m_prop_culling_mesh_ids.end());
+            m_culled_mesh_mask.assign(max_mesh_id + 1, 0);
+            m_prop_bvh_dirty = false;
+        }
+
+        XMMATRIX view, proj;
+        if (m_cameraOverrideActive) {
+            view = XMLoadFloat4x4(&m_cameraOverrideView);
+            proj = XMLoadFloat4x4(&m_cameraOverrideProj);
+        }
+        else {
+            view = m_user_camera->GetView();
+            proj = m_user_camera->GetProj();
+        }
+
+        m_visible_prop_slots.clear();
+        m_prop_bvh.Query(CullingFrustum(view, proj), m_visible_prop_slots);
+
+        for (const int mesh_id : m_prop_culling_mesh_ids) {
+            m_culled_mesh_mask[mesh_id] = 1;
+        }
+        for (const uint32_t slot : m_visible_prop_slots) {
+            m_culled_mesh_mask[m_prop_culling_mesh_ids[slot]] = 0;
+        }
+        m_mesh_manager->SetCulledMeshMask(&m_culled_mesh_mask);
+
+        return static_cast<uint32_t>(m_visible_prop_slots.size());
+    }
+
+    void RebuildPathfindingTriangles()
+    {
+        m_pathfinding_plane_triangles.resize(GetPathfindingPlaneCount());
+        for (uint32_t plane = 0; plane < GetPathfindingPlaneCount(); plane++) {
+            auto& triangles = m_pathfinding_plane_triangles[plane];
+            triangles.clear();
+            for (uint32_t i = m_pathfinding_plane_first[plane]; i < m_pathfinding_plane_first[plane + 1]; i++) {
+                if (!m_pathfinding_trapezoid_visible[i]) continue;
+                const XMFLOAT3* corners = &m_pathfinding_corners[i * 4];
+                triangles.insert(triangles.end(), { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] });
+            }
+        }
+        m_pathfinding_triangles_dirty = false;
+    }
+
     ID3D11Device* m_device;
     ID3D11DeviceContext* m_deviceContext;
     InputManager* m_input_manager;
@@ -1179,6 +1355,7 @@ private:
     std::unique_ptr<BlendStateManager> m_blend_state_manager;
     std::unique_ptr<RasterizerStateManager> m_rasterizer_state_manager;
     std::unique_ptr<DepthStencilStateManager> m_stencil_state_manager;
+    std::unique_ptr<DebugDraw> m_debug_draw;
     std::unique_ptr<Camera> m_user_camera;
 
     // Camera override for model viewer mode
@@ -1201,6 +1378,23 @@ private:
     std::map<uint32_t, std::vector<int>> m_prop_mesh_ids;
     std::vector<int> extra_mesh_ids; // For stuff like spheres and boxes.
 
+    // Prop frustum culling. Slots index the parallel arrays below and are the ids stored in the BVH.
+    bool m_prop_culling_enabled = true;
+    std::unordered_map<int, uint32_t> m_prop_culling_slots; // Mesh id -> slot
+    std::vector<int> m_prop_culling_mesh_ids;
+    std::vector<CullingAABB> m_prop_local_bounds;
+    std::vector<CullingAABB> m_prop_world_bounds;
+    BoundsBVH m_prop_bvh;
+    bool m_prop_bvh_dirty = true;
+    std::vector<uint8_t> m_culled_mesh_mask; // Indexed by mesh id, see MeshManager::SetCulledMeshMask
+    std::vector<uint32_t> m_visible_prop_slots;
+    std::vector<int> m_moved_mesh_ids;
+    uint32_t m_visible_prop_mesh_count = 0;
+
+    // CPU ray queries. Props sharing GPU geometry share a ray model, keyed by the mesh id owning the geometry.
+    RayScene m_ray_scene;
+    std::unordered_map<int, uint32_t> m_ray_models;
+
     bool m_is_terrain_mesh_set = false;
     int m_terrain_mesh_id = -1;
     int m_terrain_checkered_texture_id = -1;
@@ -1212,14 +1406,20 @@ private:
     int m_clouds_mesh_id = -1;
     int m_water_mesh_id = -1;
     std::vector<int> m_shore_mesh_ids;
-    std::vector<int> m_pathfinding_mesh_ids;
-    std::vector<std::vector<int>> m_pathfinding_plane_mesh_ids;  // Grouped by plane
 
     DirectionalLight m_directionalLight;
     bool m_per_frame_cb_changed = true;
 
     LODQuality m_lod_quality = LODQuality::High;
 
+    float m_viewport_height = 1.0f;
+    bool m_terrain_lod_enabled = true;
+    float m_terrain_lod_max_screen_error = 2.0f;
+    std::vector<uint8_t> m_terrain_chunk_levels;
+    std::vector<IndexRange> m_terrain_full_res_ranges;
+    std::vector<IndexRange> m_terrain_lod_ranges;
+    TerrainLODStats m_terrain_lod_stats;
+
     bool m_should_render_sky = true;
     float m_sky_height = 0;
 
@@ -1232,7 +1432,12 @@ private:
     std::map<int, bool> should_render_shore_mesh_id;
 
     bool m_should_render_pathfinding = false;
-    std::map<int, bool> should_render_pathfinding_mesh_id;
+    std::vector<XMFLOAT3> m_pathfinding_corners;                     // tl, tr, br, bl per trapezoid
+    std::vector<uint32_t> m_pathfinding_plane_first;                 // Plane count + 1 offsets into the trapezoids
+    std::vector<XMFLOAT4> m_pathfinding_plane_colors;
+    std::vector<uint8_t> m_pathfinding_trapezoid_visible;
+    std::vector<std::vector<XMFLOAT3>> m_pathfinding_plane_triangles; // Visible trapezoids as triangle lists
+    bool m_pathfinding_triangles_dirty = true;
     float m_pathfinding_height_offset = 50.0f;
 
     bool m_should_rerender_shadows = false;
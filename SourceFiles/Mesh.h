@@ -1,9 +1,17 @@
 #pragma once
 #include "Vertex.h"
+#include "VertexFormat.h"
 #include "BlendStateManager.h"
 
 constexpr int MAX_NUM_TEX_INDICES = 8;
 
+// A contiguous run of indices drawn with a single DrawIndexed call.
+struct IndexRange
+{
+	uint32_t start_index = 0;
+	uint32_t index_count = 0;
+};
+
 struct Mesh
 {
 	std::vector<GWVertex> vertices;
@@ -27,4 +35,7 @@ struct Mesh
 	int num_textures;
 
 	XMFLOAT3 center;
+
+	// The vertex attributes declared by the model file, if known. Picks the GPU vertex layout, see VertexFormat.
+	std::optional<VertexAttributes> vertex_attributes;
 };
@@ -1,7 +1,9 @@
 #pragma once
 #include "Mesh.h"
 #include "PerObjectCB.h"
+#include "PerObjectConstants.h"
 #include <array>
+#include <span>
 
 class MeshInstance
 {
@@ -12,14 +14,8 @@ public:
         m_mesh = mesh;
 
         // Create vertex buffer
-        D3D11_BUFFER_DESC vbDesc = {};
-        vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
-        vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        vbDesc.ByteWidth = sizeof(GWVertex) * m_mesh.vertices.size();
-        vbDesc.StructureByteStride = sizeof(GWVertex);
-        D3D11_SUBRESOURCE_DATA vbData = {};
-        vbData.pSysMem = m_mesh.vertices.data();
-        device->CreateBuffer(&vbDesc, &vbData, &m_vertexBuffer);
+        m_vertex_format = ChooseVertexFormat(m_mesh.vertices, m_mesh.vertex_attributes);
+        CreateVertexBuffer(device, m_mesh.vertices, m_vertex_format, m_vertexBuffer);
 
         // Create index buffer
         D3D11_BUFFER_DESC ibDesc = {};
@@ -48,12 +44,33 @@ public:
         }
     }
 
+    // Shares the GPU vertex and index buffers of geometry_source, e.g. for the instances of a prop model.
+    // mesh must be the geometry geometry_source was created from. Draws of instances that share
+    // geometry can be merged into one instanced draw.
+    MeshInstance(const MeshInstance& geometry_source, Mesh mesh, int mesh_id)
+        : m_mesh(std::move(mesh))
+        , m_mesh_id(mesh_id)
+        , m_vertexBuffer(geometry_source.m_vertexBuffer)
+        , m_indexBuffer_high(geometry_source.m_indexBuffer_high)
+        , m_indexBuffer_medium(geometry_source.m_indexBuffer_medium)
+        , m_indexBuffer_low(geometry_source.m_indexBuffer_low)
+        , m_vertex_format(geometry_source.m_vertex_format)
+    {
+    }
+
     ~MeshInstance() { }
 
     int GetMeshID() const { return m_mesh_id; }
 
     const PerObjectCB& GetPerObjectData() const { return m_per_object_data; }
-    void SetPerObjectData(const PerObjectCB& data) { m_per_object_data = data; }
+    void SetPerObjectData(const PerObjectCB& data)
+    {
+        m_per_object_data = data;
+        m_gpu_per_object_data.MarkDirty();
+    }
+
+    // Per object data with the world matrix transposed for the shaders, cached until the data changes.
+    const PerObjectCB& GetGpuPerObjectData() { return m_gpu_per_object_data.Get(m_per_object_data); }
 
     void SetTextures(const std::vector<ID3D11ShaderResourceView*>& textures, int slot)
     {
@@ -70,9 +87,53 @@ public:
             // Add the texture to the corresponding slot
             m_textures[slot].push_back(textures[i]);
         }
+
+        // FNV-1a over the bound views, only used to group draws with equal textures.
+        uint32_t hash = 2166136261u;
+        for (const auto& slot_textures : m_textures)
+        {
+            for (const auto& texture : slot_textures)
+            {
+                hash = (hash ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(texture.Get()) >> 4)) * 16777619u;
+            }
+            hash = (hash ^ 0xFF) * 16777619u;
+        }
+        m_texture_set_key = static_cast<uint16_t>(hash ^ (hash >> 16));
+    }
+
+    uint16_t GetTextureSetKey() const { return m_texture_set_key; }
+
+    // True if both instances bind the same views to every texture slot.
+    bool HasSameTextures(const MeshInstance& other) const { return m_textures == other.m_textures; }
+
+    const Mesh& GetMesh() const { return m_mesh; }
+
+    // True if both instances draw from the same vertex and index buffers.
+    bool SharesGeometry(const MeshInstance& other) const
+    {
+        return m_vertexBuffer == other.m_vertexBuffer && m_indexBuffer_high == other.m_indexBuffer_high;
+    }
+
+    // Hash of the vertex buffer, only used to keep draws of shared geometry next to each other in the render queue.
+    uint16_t GetGeometryKey() const
+    {
+        const auto address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(m_vertexBuffer.Get()) >> 4);
+        const uint32_t hash = address * 2654435761u;
+        return static_cast<uint16_t>(hash >> 16);
     }
 
-    const Mesh& GetMesh() { return m_mesh; }
+    // The layout the vertex buffers are stored in, the vertex shader variant must match it.
+    const VertexFormat& GetVertexFormat() const { return m_vertex_format; }
+
+    // Size of the vertex buffers in bytes, and what they would take as GWVertex.
+    size_t GetVertexBufferSize() const
+    {
+        return (m_mesh.vertices.size() + m_aux_vertex_count) * m_vertex_format.GetStride();
+    }
+    size_t GetFullVertexBufferSize() const { return (m_mesh.vertices.size() + m_aux_vertex_count) * sizeof(GWVertex); }
+
+    // Identifies the vertex buffer, instances that share geometry return the same buffer.
+    const ID3D11Buffer* GetVertexBuffer() const { return m_vertexBuffer.Get(); }
 
     void UpdateVertices(ID3D11Device* device, const std::vector<GWVertex>& vertices) {
         if (vertices.empty()) return;
@@ -80,29 +141,110 @@ public:
         m_mesh.vertices = vertices;
 
         // Recreate vertex buffer with new data
-        D3D11_BUFFER_DESC vbDesc = {};
-        vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
-        vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        vbDesc.ByteWidth = sizeof(GWVertex) * m_mesh.vertices.size();
-        vbDesc.StructureByteStride = sizeof(GWVertex);
-        D3D11_SUBRESOURCE_DATA vbData = {};
-        vbData.pSysMem = m_mesh.vertices.data();
+        m_vertex_format = ChooseVertexFormat(m_mesh.vertices, m_mesh.vertex_attributes);
+        CreateVertexBuffer(device, m_mesh.vertices, m_vertex_format, m_vertexBuffer);
+    }
 
-        m_vertexBuffer.Reset();
-        device->CreateBuffer(&vbDesc, &vbData, &m_vertexBuffer);
+    // Secondary vertex/index buffers drawn with this instance's textures and constants. Terrain uses it for coarser chunk levels.
+    // Both buffers are drawn with the same vertex shader variant, so the main vertices are reuploaded if they need a larger format.
+    void SetAuxiliaryGeometry(ID3D11Device* device, const std::vector<GWVertex>& vertices, const std::vector<uint32_t>& indices)
+    {
+        m_auxVertexBuffer.Reset();
+        m_auxIndexBuffer.Reset();
+        m_aux_vertex_count = 0;
+        if (vertices.empty() || indices.empty()) return;
+
+        const VertexFormat format = MergeVertexFormats(m_vertex_format, ChooseVertexFormat(vertices, std::nullopt));
+        if (!(format == m_vertex_format))
+        {
+            m_vertex_format = format;
+            CreateVertexBuffer(device, m_mesh.vertices, m_vertex_format, m_vertexBuffer);
+        }
+        CreateVertexBuffer(device, vertices, m_vertex_format, m_auxVertexBuffer);
+        m_aux_vertex_count = vertices.size();
+
+        D3D11_BUFFER_DESC ibDesc = {};
+        ibDesc.Usage = D3D11_USAGE_IMMUTABLE;
+        ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        ibDesc.StructureByteStride = sizeof(uint32_t);
+        ibDesc.ByteWidth = sizeof(uint32_t) * indices.size();
+        D3D11_SUBRESOURCE_DATA ibData = {};
+        ibData.pSysMem = indices.data();
+        device->CreateBuffer(&ibDesc, &ibData, &m_auxIndexBuffer);
     }
 
+    bool HasAuxiliaryGeometry() const { return m_auxVertexBuffer && m_auxIndexBuffer; }
+
     void SetShouldCull(const bool should_cull) {
         m_mesh.should_cull = should_cull;
     }
 
-    void Draw(ID3D11DeviceContext* context, LODQuality lod_quality)
+    // bind_textures can be false when the previous draw bound the same textures.
+    void Draw(ID3D11DeviceContext* context, LODQuality lod_quality, bool bind_textures = true)
     {
-        UINT stride = sizeof(GWVertex);
+        const UINT num_indices = BindGeometry(context, lod_quality);
+
+        if (bind_textures)
+        {
+            BindTextures(context);
+        }
+
+        context->DrawIndexed(num_indices, 0, 0);
+    }
+
+    // Draws instance_count instances of this geometry. The per instance buffer must already be bound.
+    void DrawInstanced(ID3D11DeviceContext* context, LODQuality lod_quality, bool bind_textures,
+        UINT instance_count, UINT first_instance)
+    {
+        const UINT num_indices = BindGeometry(context, lod_quality);
+
+        if (bind_textures)
+        {
+            BindTextures(context);
+        }
+
+        context->DrawIndexedInstanced(num_indices, instance_count, 0, 0, first_instance);
+    }
+
+    // Draws index ranges of the high LOD buffer, then index ranges of the auxiliary geometry.
+    void DrawRanges(ID3D11DeviceContext* context, std::span<const IndexRange> ranges,
+        std::span<const IndexRange> auxiliary_ranges)
+    {
+        UINT stride = m_vertex_format.GetStride();
+        UINT offset = 0;
+
+        BindTextures(context);
+
+        if (!ranges.empty())
+        {
+            context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+            context->IASetIndexBuffer(m_indexBuffer_high.Get(), DXGI_FORMAT_R32_UINT, 0);
+            for (const auto& range : ranges)
+            {
+                context->DrawIndexed(range.index_count, range.start_index, 0);
+            }
+        }
+
+        if (!auxiliary_ranges.empty() && HasAuxiliaryGeometry())
+        {
+            context->IASetVertexBuffers(0, 1, m_auxVertexBuffer.GetAddressOf(), &stride, &offset);
+            context->IASetIndexBuffer(m_auxIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+            for (const auto& range : auxiliary_ranges)
+            {
+                context->DrawIndexed(range.index_count, range.start_index, 0);
+            }
+        }
+    }
+
+private:
+    // Binds the vertex buffer and the index buffer of the LOD, returns its index count.
+    UINT BindGeometry(ID3D11DeviceContext* context, LODQuality lod_quality)
+    {
+        UINT stride = m_vertex_format.GetStride();
         UINT offset = 0;
         context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
 
-        int num_indices = 0;
+        UINT num_indices = 0;
 
         switch (lod_quality)
         {
@@ -130,6 +272,29 @@ public:
             break;
         }
 
+        return num_indices;
+    }
+
+    static void CreateVertexBuffer(ID3D11Device* device, std::span<const GWVertex> vertices, const VertexFormat& format,
+        Microsoft::WRL::ComPtr<ID3D11Buffer>& vertex_buffer)
+    {
+        std::vector<std::byte> packed_vertices;
+        PackVertices(vertices, format, packed_vertices);
+
+        D3D11_BUFFER_DESC vbDesc = {};
+        vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
+        vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        vbDesc.ByteWidth = static_cast<UINT>(packed_vertices.size());
+        vbDesc.StructureByteStride = format.GetStride();
+        D3D11_SUBRESOURCE_DATA vbData = {};
+        vbData.pSysMem = packed_vertices.data();
+
+        vertex_buffer.Reset();
+        device->CreateBuffer(&vbDesc, &vbData, &vertex_buffer);
+    }
+
+    void BindTextures(ID3D11DeviceContext* context)
+    {
         for (int slot = 0; slot < 4; ++slot)
         {
             if (m_textures[slot].size() > 0)
@@ -145,19 +310,24 @@ public:
                 context->PSSetShaderResources(slot, 1, &nullSRV);
             }
         }
-
-        context->DrawIndexed(num_indices, 0, 0);
     }
 
-private:
     Mesh m_mesh;
     int m_mesh_id;
     PerObjectCB m_per_object_data;
+    GpuPerObjectData m_gpu_per_object_data;
+    uint16_t m_texture_set_key = 0;
 
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexBuffer;
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer_high; // High LOD
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer_medium; // Medium LOD
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer_low; // Low LOD
 
+    VertexFormat m_vertex_format;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_auxVertexBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_auxIndexBuffer;
+    size_t m_aux_vertex_count = 0;
+
     std::array<std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>, 4> m_textures;
 };
@@ -12,6 +12,8 @@
 #include "BlendStateManager.h"
 #include "RasterizerStateManager.h"
 #include "DepthStencilStateManager.h"
+#include "PropInstancing.h"
+#include "VertexShader.h"
 #include <Dome.h>
 #include <Cylinder.h>
 #include <GWSkyCylinder.h>
@@ -25,6 +27,33 @@ enum class RenderSelectionState {
 	TransparentOnly,
 };
 
+// Per frame counters of MeshManager::Render. A skipped state set is a change avoided because the previous draw
+// already used the same state.
+struct RenderQueueStats
+{
+	uint32_t draw_calls = 0;
+	uint32_t queue_sorts = 0;
+	uint32_t pixel_shader_sets = 0;
+	uint32_t sampler_sets = 0;
+	uint32_t rasterizer_sets = 0;
+	uint32_t topology_sets = 0;
+	uint32_t texture_binds = 0;
+	uint32_t skipped_state_sets = 0;
+	uint32_t constant_buffer_maps = 0;
+	uint32_t instanced_draws = 0; // Draws of more than one instance, also counted in draw_calls.
+	uint32_t instances = 0; // Meshes drawn by instanced draws.
+	uint32_t vertex_shader_sets = 0; // Switches between vertex layouts and instanced variants.
+};
+
+// GPU memory of the mesh vertex buffers, buffers shared by several meshes are counted once.
+struct VertexMemoryStats
+{
+	size_t vertex_buffer_bytes = 0;
+	size_t full_vertex_bytes = 0; // What the same vertices would take as GWVertex.
+	uint32_t vertex_buffers = 0;
+	uint32_t packed_vertex_buffers = 0;
+};
+
 class MeshManager
 {
 public:
@@ -46,6 +75,26 @@ public:
 		ID3D11Buffer* constantBuffers[] = {m_perObjectCB.Get()};
 		m_deviceContext->VSSetConstantBuffers(PER_OBJECT_CB_SLOT, 1, constantBuffers);
 		m_deviceContext->PSSetConstantBuffers(PER_OBJECT_CB_SLOT, 1, constantBuffers);
+
+		// Render packs all per object constants of a pass into one buffer and binds slices of it,
+		// which needs constant buffer offsetting from D3D 11.1.
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+		if (SUCCEEDED(m_deviceContext->QueryInterface(IID_PPV_ARGS(m_deviceContext1.GetAddressOf()))) &&
+			SUCCEEDED(m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+			!options.ConstantBufferOffsetting)
+		{
+			m_deviceContext1.Reset();
+		}
+
+		// Attributes a packed vertex format doesn't store are read from this buffer, see VertexFormat.
+		const float vertex_defaults[VERTEX_DEFAULTS_BUFFER_SIZE / sizeof(float)] = {};
+		D3D11_BUFFER_DESC vbDesc = {};
+		vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		vbDesc.ByteWidth = VERTEX_DEFAULTS_BUFFER_SIZE;
+		D3D11_SUBRESOURCE_DATA vbData = {};
+		vbData.pSysMem = vertex_defaults;
+		m_device->CreateBuffer(&vbDesc, &vbData, m_vertexDefaultsBuffer.GetAddressOf());
 	}
 
 	int AddBox(const XMFLOAT3& size, PixelShaderType pixel_shader_type = PixelShaderType::OldModel)
@@ -156,6 +205,20 @@ public:
 		return meshID;
 	}
 
+	// Adds a mesh that draws from the GPU buffers of mesh geometry_source_id instead of uploading its own,
+	// mesh must be the geometry that mesh was created from. Uploads mesh if the source doesn't exist.
+	int AddCustomMesh(const Mesh& mesh, PixelShaderType pixel_shader_type, int geometry_source_id)
+	{
+		auto source_it = m_triangleMeshes.find(geometry_source_id);
+		if (source_it == m_triangleMeshes.end()) { return AddCustomMesh(mesh, pixel_shader_type); }
+
+		int meshID = m_nextMeshID++;
+		auto mesh_instance = std::make_shared<MeshInstance>(*source_it->second, mesh, meshID);
+		add_to_triangle_meshes(mesh_instance, pixel_shader_type);
+		m_needsUpdate = true;
+		return meshID;
+	}
+
 	bool ChangeMeshPixelShaderType(int mesh_id, PixelShaderType pixel_shader_type)
 	{
 		bool found = false;
@@ -216,7 +279,11 @@ public:
 	void SetTexturesForMesh(int meshID, const std::vector<ID3D11ShaderResourceView*>& textures, int slot)
 	{
 		auto it = m_triangleMeshes.find(meshID);
-		if (it != m_triangleMeshes.end()) { it->second->SetTextures(textures, slot); }
+		if (it != m_triangleMeshes.end())
+		{
+			it->second->SetTextures(textures, slot);
+			m_renderBatch.InvalidateOrder();
+		}
 	}
 
 	void UpdateMeshVertices(int meshID, const std::vector<GWVertex>& vertices)
@@ -231,16 +298,59 @@ public:
 	void UpdateMeshPerObjectData(int meshID, const PerObjectCB& data)
 	{
 		auto it = m_triangleMeshes.find(meshID);
-		if (it != m_triangleMeshes.end())
+		if (it == m_triangleMeshes.end())
 		{
-			it->second->SetPerObjectData(data);
-			return;
+			it = m_lineMeshes.find(meshID);
+			if (it == m_lineMeshes.end()) { return; }
 		}
 
-		it = m_lineMeshes.find(meshID);
-		if (it != m_lineMeshes.end()) { it->second->SetPerObjectData(data); }
+		if (memcmp(&it->second->GetPerObjectData().world, &data.world, sizeof(data.world)) != 0) {
+			RecordWorldChange(meshID);
+		}
+		it->second->SetPerObjectData(data);
+	}
+
+	// Moves the ids of meshes whose world matrix changed since the last call into mesh_ids.
+	// Returns false if too many changes piled up to be tracked, callers should then assume every mesh moved.
+	bool TakeWorldChanges(std::vector<int>& mesh_ids)
+	{
+		mesh_ids.clear();
+		std::swap(mesh_ids, m_world_changes);
+		const bool complete = !m_world_changes_overflowed;
+		m_world_changes_overflowed = false;
+		return complete;
 	}
 
+	// The vertex shader bound by the caller of Render. Each mesh is drawn with the variant that matches its vertex format,
+	// and runs of meshes that share geometry with the instanced variant. The regular variant is bound again afterwards.
+	void SetVertexShader(VertexShader* vertex_shader) { m_vertexShader = vertex_shader; }
+
+	void SetInstancingEnabled(bool enabled) { m_instancing_enabled = enabled; }
+	bool GetInstancingEnabled() const { return m_instancing_enabled; }
+	bool IsInstancingSupported() const { return m_vertexShader && m_vertexShader->GetInstancedShader(); }
+
+	VertexMemoryStats GetVertexMemoryStats() const
+	{
+		VertexMemoryStats stats;
+		std::unordered_set<const ID3D11Buffer*> counted_buffers;
+		for (const auto* meshes : { &m_triangleMeshes, &m_lineMeshes })
+		{
+			for (const auto& [mesh_id, mesh_instance] : *meshes)
+			{
+				if (!counted_buffers.insert(mesh_instance->GetVertexBuffer()).second) { continue; }
+				stats.vertex_buffer_bytes += mesh_instance->GetVertexBufferSize();
+				stats.full_vertex_bytes += mesh_instance->GetFullVertexBufferSize();
+				stats.vertex_buffers++;
+				if (mesh_instance->GetVertexFormat().packed) { stats.packed_vertex_buffers++; }
+			}
+		}
+		return stats;
+	}
+
+	// Meshes whose id indexes a non-zero entry are skipped by Render. Ids past the end are drawn.
+	// The mask is owned by the caller and must outlive its use here, pass nullptr to draw everything.
+	void SetCulledMeshMask(const std::vector<uint8_t>* culled_mesh_mask) { m_culled_mesh_mask = culled_mesh_mask; }
+
 	std::optional<PerObjectCB> GetMeshPerObjectData(int mesh_id) {
 		auto it = m_triangleMeshes.find(mesh_id);
 		if (it != m_triangleMeshes.end())
@@ -276,6 +386,7 @@ public:
 			DirectX::XMMATRIX translationMatrix = DirectX::XMMatrixTranslation(x, y, z);
 			DirectX::XMStoreFloat4x4(&data.world, translationMatrix);
 			mesh->SetPerObjectData(data);
+			RecordWorldChange(mesh_id);
 		}
 	}
 
@@ -368,53 +479,6 @@ public:
 		return false;
 	}
 
-	unsigned int DecodeObjectID(unsigned char* data, int x, int y, int rowPitch)
-	{
-		// Calculate the offset to the pixel at (x, y)
-		size_t offset = (y * rowPitch) + (x * 4); // Assume each pixel takes up 4 bytes (RGBA)
-
-		// Extract the color components
-		unsigned char r = data[offset];
-		unsigned char g = data[offset + 1];
-		unsigned char b = data[offset + 2];
-
-		// Reconstruct the object ID from the RGB channels
-		unsigned int objectID = (static_cast<unsigned int>(r) << 16) |
-		(static_cast<unsigned int>(g) << 8) |
-		static_cast<unsigned int>(b);
-
-		return objectID;
-	}
-
-	int GetPickedObjectId(ID3D11DeviceContext* context, ID3D11Texture2D* offscreenTexture, int x, int y)
-    {
-        // Validate coordinates
-        D3D11_TEXTURE2D_DESC desc;
-        offscreenTexture->GetDesc(&desc);
-
-        if (x < 0 || x >= static_cast<int>(desc.Width) || y < 0 || y >= static_cast<int>(desc.Height)) 
-        {
-            return -1; // Invalid coordinates
-        }
-
-        // Read back the texture data
-        D3D11_MAPPED_SUBRESOURCE mappedResource;
-        HRESULT hr = context->Map(offscreenTexture, 0, D3D11_MAP_READ, 0, &mappedResource);
-
-        if (FAILED(hr))
-        {
-            // Log or print HRESULT error
-            return -1; // Invalid object ID
-        }
-
-        auto data = static_cast<unsigned char*>(mappedResource.pData);
-        unsigned int objectID = DecodeObjectID(data, x, y, mappedResource.RowPitch);
-
-        context->Unmap(offscreenTexture, 0);
-
-        return objectID;
-	}
-
 	void Update(float dt)
 	{
 		if (m_needsUpdate) { m_needsUpdate = false; }
@@ -430,6 +494,7 @@ public:
 	 */
 	void SetPerObjectCB(const PerObjectCB& data)
 	{
+		m_frame_stats.constant_buffer_maps++;
 		D3D11_MAPPED_SUBRESOURCE mappedResource;
 		m_deviceContext->Map(m_perObjectCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 		memcpy(mappedResource.pData, &data, sizeof(PerObjectCB));
@@ -444,49 +509,25 @@ public:
 		bool should_overwrite_shader = false, PixelShaderType overwrite_shader = PixelShaderType::OldModel) {
 
 		auto command = m_renderBatch.GetCommand(mesh_id);
-		if (command.has_value()) {
-			if (render_select_state != RenderSelectionState::All) {
-				// Note that these blend_states are estimates. I don't know for sure which ones are transparent until after the models pixel shader has run.
-				if (command->blend_state == BlendState::Opaque && render_select_state != RenderSelectionState::OpaqueOnly) {
-					return;
-				}
-				if (command->blend_state == BlendState::AlphaBlend && render_select_state != RenderSelectionState::TransparentOnly) {
-					return;
-				}
-			}
-
-			m_deviceContext->IASetPrimitiveTopology(command->primitiveTopology);
-
-			if (should_overwrite_shader) {
-				m_deviceContext->PSSetShader(pixel_shaders[overwrite_shader]->GetShader(), nullptr, 0);
-			}
-			else if (should_set_ps) {
-				m_deviceContext->PSSetShader(pixel_shaders[command->pixelShaderType]->GetShader(), nullptr, 0);
-			}
-			m_deviceContext->PSSetSamplers(0, 1, pixel_shaders[command->pixelShaderType]->GetSamplerState());
-			m_deviceContext->PSSetSamplers(1, 1, pixel_shaders[command->pixelShaderType]->GetSamplerStateShadow());
-
-
-			if (command->should_cull) { rasterizer_state_manager->SetRasterizerState(RasterizerStateType::Solid); }
-			else { rasterizer_state_manager->SetRasterizerState(RasterizerStateType::Solid_NoCull); }
-
-
-			blend_state_manager->SetBlendState(BlendState::AlphaBlend);
-
-			PerObjectCB transposedData = command->meshInstance->GetPerObjectData();
-
-			// Load World matrix into an XMMATRIX, transpose it, and store it back into an XMFLOAT4X4
-			XMMATRIX worldMatrix = XMLoadFloat4x4(&transposedData.world);
-			worldMatrix = XMMatrixTranspose(worldMatrix);
-			XMStoreFloat4x4(&transposedData.world, worldMatrix);
+		if (command.has_value() && PrepareMeshDraw(*command, pixel_shaders, blend_state_manager, rasterizer_state_manager,
+			render_select_state, should_set_ps, should_overwrite_shader, overwrite_shader)) {
+			command->meshInstance->Draw(m_deviceContext, lod_quality);
+			RestoreVertexShader();
+		}
+	}
 
-			// Update the per object constant buffer
-			D3D11_MAPPED_SUBRESOURCE mappedResource;
-			m_deviceContext->Map(m_perObjectCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-			memcpy(mappedResource.pData, &transposedData, sizeof(PerObjectCB));
-			m_deviceContext->Unmap(m_perObjectCB.Get(), 0);
+	// Render index ranges of a specific mesh and of its auxiliary geometry. Ignores should_render.
+	void RenderMeshRanges(std::unordered_map<PixelShaderType, std::unique_ptr<PixelShader>>& pixel_shaders,
+		BlendStateManager* blend_state_manager, RasterizerStateManager* rasterizer_state_manager,
+		int mesh_id, std::span<const IndexRange> ranges, std::span<const IndexRange> auxiliary_ranges,
+		bool should_set_ps = true, bool should_overwrite_shader = false,
+		PixelShaderType overwrite_shader = PixelShaderType::OldModel) {
 
-			command->meshInstance->Draw(m_deviceContext, lod_quality);
+		auto command = m_renderBatch.GetCommand(mesh_id);
+		if (command.has_value() && PrepareMeshDraw(*command, pixel_shaders, blend_state_manager, rasterizer_state_manager,
+			RenderSelectionState::All, should_set_ps, should_overwrite_shader, overwrite_shader)) {
+			command->meshInstance->DrawRanges(m_deviceContext, ranges, auxiliary_ranges);
+			RestoreVertexShader();
 		}
 	}
 		
@@ -500,18 +541,32 @@ public:
 				bool wireframe = false
 		)
 	{
-		static D3D11_PRIMITIVE_TOPOLOGY currentTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
-		
-		static XMFLOAT3 prev_camera_position{ 0,0,0 };
-
+		// State set by the previous draw of this call. Other render paths change the same state in between calls,
+		// so the cache starts out empty every time.
+		D3D11_PRIMITIVE_TOPOLOGY current_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+		ID3D11PixelShader* current_pixel_shader = nullptr;
+		ID3D11SamplerState* current_sampler = nullptr;
+		ID3D11SamplerState* current_shadow_sampler = nullptr;
+		std::optional<RasterizerStateType> current_rasterizer_state;
+		const MeshInstance* previous_textured_mesh = nullptr;
+		ID3D11VertexShader* current_vertex_shader = nullptr;
+		ID3D11InputLayout* current_input_layout = nullptr;
+
+		const uint32_t sort_count = m_renderBatch.GetSortCount();
 		m_renderBatch.SortCommands(camera_position);
+		m_frame_stats.queue_sorts += m_renderBatch.GetSortCount() - sort_count;
 
 		blend_state_manager->SetBlendState(BlendState::AlphaBlend);
 
-		for (const RenderCommand& command : m_renderBatch.GetCommands())
+		m_drawList.clear();
+		for (const RenderCommand* command_ptr : m_renderBatch.GetCommands())
 		{
-			if (!command.should_render)
-				continue;
+			const RenderCommand& command = *command_ptr;
+			if (m_culled_mesh_mask) {
+				const int mesh_id = command.meshInstance->GetMeshID();
+				if (static_cast<size_t>(mesh_id) < m_culled_mesh_mask->size() && (*m_culled_mesh_mask)[mesh_id])
+					continue;
+			}
 			if (render_select_state != RenderSelectionState::All) {
 				if (command.blend_state == BlendState::Opaque && render_select_state != RenderSelectionState::OpaqueOnly) {
 					continue;
@@ -520,50 +575,319 @@ public:
 					continue;
 				}
 			}
+			m_drawList.push_back(&command);
+		}
+		if (m_drawList.empty()) { return; }
+
+		const bool use_constant_ring = UploadPerObjectConstants();
+
+		// Consecutive draws of shared geometry with equal state are merged into one instanced draw.
+		// Every draw is its own run if instancing is off or the instance data couldn't be uploaded.
+		const bool use_instancing = m_instancing_enabled && IsInstancingSupported();
+		FindInstanceRuns(m_drawList.size(), [&](size_t first, size_t next) {
+			return use_instancing && CanDrawInstanced(*m_drawList[first], *m_drawList[next]);
+		}, m_instanceRuns);
+		if (use_instancing && !UploadInstanceData())
+		{
+			FindInstanceRuns(m_drawList.size(), [](size_t, size_t) { return false; }, m_instanceRuns);
+		}
+		BindVertexDefaults();
+
+		for (const InstanceRun& run : m_instanceRuns)
+		{
+			// Runs share all state, so the first draw of a run provides it.
+			const size_t draw_index = run.first;
+			const RenderCommand& command = *m_drawList[draw_index];
 
-			if (command.primitiveTopology != currentTopology)
+			const bool draw_instanced = run.count > 1;
+			if (m_vertexShader)
+			{
+				const auto variant = m_vertexShader->GetVariant(command.meshInstance->GetVertexFormat(), draw_instanced);
+				if (!variant.shader) { continue; }
+				if (variant.shader != current_vertex_shader || variant.input_layout != current_input_layout)
+				{
+					m_deviceContext->VSSetShader(variant.shader, nullptr, 0);
+					m_deviceContext->IASetInputLayout(variant.input_layout);
+					current_vertex_shader = variant.shader;
+					current_input_layout = variant.input_layout;
+					m_frame_stats.vertex_shader_sets++;
+				}
+				else { m_frame_stats.skipped_state_sets++; }
+			}
+
+			if (command.primitiveTopology != current_topology)
 			{
 				m_deviceContext->IASetPrimitiveTopology(command.primitiveTopology);
-				currentTopology = command.primitiveTopology;
+				current_topology = command.primitiveTopology;
+				m_frame_stats.topology_sets++;
 			}
+			else { m_frame_stats.skipped_state_sets++; }
 
+			const auto& command_shader = pixel_shaders[command.pixelShaderType];
+			ID3D11PixelShader* pixel_shader = nullptr;
 			if (should_overwrite_old_model_shader && command.pixelShaderType == PixelShaderType::OldModel) {
-				m_deviceContext->PSSetShader(pixel_shaders[overwrite_old_model_shader]->GetShader(), nullptr, 0);
+				pixel_shader = pixel_shaders[overwrite_old_model_shader]->GetShader();
 			}
 			else if (should_overwrite_new_model_shader && command.pixelShaderType == PixelShaderType::NewModel) {
-				m_deviceContext->PSSetShader(pixel_shaders[overwrite_new_model_shader]->GetShader(), nullptr, 0);
+				pixel_shader = pixel_shaders[overwrite_new_model_shader]->GetShader();
 			}
 			else if (should_set_ps) {
-				m_deviceContext->PSSetShader(pixel_shaders[command.pixelShaderType]->GetShader(), nullptr, 0);
+				pixel_shader = command_shader->GetShader();
 			}
-			m_deviceContext->PSSetSamplers(0, 1, pixel_shaders[command.pixelShaderType]->GetSamplerState());
-			m_deviceContext->PSSetSamplers(1, 1, pixel_shaders[command.pixelShaderType]->GetSamplerStateShadow());
-
+			if (pixel_shader && pixel_shader != current_pixel_shader) {
+				m_deviceContext->PSSetShader(pixel_shader, nullptr, 0);
+				current_pixel_shader = pixel_shader;
+				m_frame_stats.pixel_shader_sets++;
+			}
+			else if (pixel_shader) { m_frame_stats.skipped_state_sets++; }
+
+			if (*command_shader->GetSamplerState() != current_sampler || *command_shader->GetSamplerStateShadow() != current_shadow_sampler) {
+				m_deviceContext->PSSetSamplers(0, 1, command_shader->GetSamplerState());
+				m_deviceContext->PSSetSamplers(1, 1, command_shader->GetSamplerStateShadow());
+				current_sampler = *command_shader->GetSamplerState();
+				current_shadow_sampler = *command_shader->GetSamplerStateShadow();
+				m_frame_stats.sampler_sets++;
+			}
+			else { m_frame_stats.skipped_state_sets++; }
 
+			RasterizerStateType rasterizer_state;
 			if (wireframe) {
-				rasterizer_state_manager->SetRasterizerState(command.should_cull ? RasterizerStateType::Wireframe : RasterizerStateType::Wireframe_NoCull);
+				rasterizer_state = command.should_cull ? RasterizerStateType::Wireframe : RasterizerStateType::Wireframe_NoCull;
 			} else {
-				rasterizer_state_manager->SetRasterizerState(command.should_cull ? RasterizerStateType::Solid : RasterizerStateType::Solid_NoCull);
+				rasterizer_state = command.should_cull ? RasterizerStateType::Solid : RasterizerStateType::Solid_NoCull;
+			}
+			if (rasterizer_state != current_rasterizer_state) {
+				rasterizer_state_manager->SetRasterizerState(rasterizer_state);
+				current_rasterizer_state = rasterizer_state;
+				m_frame_stats.rasterizer_sets++;
+			}
+			else { m_frame_stats.skipped_state_sets++; }
+
+			if (use_constant_ring) {
+				ID3D11Buffer* constant_buffers[] = { m_perObjectRingCB.Get() };
+				const UINT first_constant = static_cast<UINT>(draw_index) * PerObjectConstantPacker::SLOT_CONSTANTS;
+				const UINT num_constants = PerObjectConstantPacker::SLOT_CONSTANTS;
+				m_deviceContext1->VSSetConstantBuffers1(PER_OBJECT_CB_SLOT, 1, constant_buffers, &first_constant, &num_constants);
+				m_deviceContext1->PSSetConstantBuffers1(PER_OBJECT_CB_SLOT, 1, constant_buffers, &first_constant, &num_constants);
+			}
+			else {
+				SetPerObjectCB(command.meshInstance->GetGpuPerObjectData());
 			}
 
-			PerObjectCB transposedData = command.meshInstance->GetPerObjectData();
+			const bool bind_textures = !previous_textured_mesh || !command.meshInstance->HasSameTextures(*previous_textured_mesh);
+			if (bind_textures) { m_frame_stats.texture_binds++; }
+			else { m_frame_stats.skipped_state_sets++; }
+			previous_textured_mesh = command.meshInstance.get();
 
-			// Load World matrix into an XMMATRIX, transpose it, and store it back into an XMFLOAT4X4
-			XMMATRIX worldMatrix = XMLoadFloat4x4(&transposedData.world);
-			worldMatrix = XMMatrixTranspose(worldMatrix);
-			XMStoreFloat4x4(&transposedData.world, worldMatrix);
+			if (draw_instanced)
+			{
+				command.meshInstance->DrawInstanced(m_deviceContext, lod_quality, bind_textures, run.count, run.first_instance);
+				m_frame_stats.instanced_draws++;
+				m_frame_stats.instances += run.count;
+			}
+			else
+			{
+				command.meshInstance->Draw(m_deviceContext, lod_quality, bind_textures);
+			}
+			m_frame_stats.draw_calls++;
+		}
 
-			// Update the per object constant buffer
-			D3D11_MAPPED_SUBRESOURCE mappedResource;
-			m_deviceContext->Map(m_perObjectCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-			memcpy(mappedResource.pData, &transposedData, sizeof(PerObjectCB));
-			m_deviceContext->Unmap(m_perObjectCB.Get(), 0);
+		RestoreVertexShader();
 
-			command.meshInstance->Draw(m_deviceContext, lod_quality);
+		if (use_constant_ring) {
+			// The other draw paths map and bind the single object buffer.
+			ID3D11Buffer* constant_buffers[] = { m_perObjectCB.Get() };
+			m_deviceContext->VSSetConstantBuffers(PER_OBJECT_CB_SLOT, 1, constant_buffers);
+			m_deviceContext->PSSetConstantBuffers(PER_OBJECT_CB_SLOT, 1, constant_buffers);
 		}
 	}
 
+	// Moves the counters collected since the last call to GetRenderStats. Call once per frame.
+	void BeginRenderStatsFrame()
+	{
+		m_last_frame_stats = m_frame_stats;
+		m_frame_stats = {};
+	}
+
+	// Counters of the previous frame, summed over all Render calls (main, reflection, shadow and offscreen passes).
+	const RenderQueueStats& GetRenderStats() const { return m_last_frame_stats; }
+
 private:
+	// Packs the per object constants of m_drawList in draw order and uploads them with a single Map.
+	// Returns false if constant buffer offsets are unsupported or the upload failed.
+	bool UploadPerObjectConstants()
+	{
+		if (!m_deviceContext1) { return false; }
+
+		m_perObjectPacker.Reset();
+		for (const RenderCommand* command : m_drawList)
+		{
+			m_perObjectPacker.Append(command->meshInstance->GetGpuPerObjectData());
+		}
+
+		const uint32_t slot_count = m_perObjectPacker.GetSlotCount();
+		if (slot_count > m_perObjectRingSlots)
+		{
+			const uint32_t new_slots = std::max({ slot_count, m_perObjectRingSlots * 2, MIN_PER_OBJECT_RING_SLOTS });
+
+			D3D11_BUFFER_DESC cbDesc = {};
+			cbDesc.Usage = D3D11_USAGE_DYNAMIC;
+			cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			cbDesc.ByteWidth = new_slots * PerObjectConstantPacker::SLOT_SIZE;
+
+			m_perObjectRingCB.Reset();
+			m_perObjectRingSlots = 0;
+			if (FAILED(m_device->CreateBuffer(&cbDesc, nullptr, m_perObjectRingCB.GetAddressOf()))) { return false; }
+			m_perObjectRingSlots = new_slots;
+		}
+
+		// Discarding renames the buffer, so slices bound by earlier passes keep their contents.
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		if (FAILED(m_deviceContext->Map(m_perObjectRingCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) { return false; }
+		memcpy(mappedResource.pData, m_perObjectPacker.GetData(), m_perObjectPacker.GetSize());
+		m_deviceContext->Unmap(m_perObjectRingCB.Get(), 0);
+		m_frame_stats.constant_buffer_maps++;
+
+		return true;
+	}
+
+	// True if next can be drawn as another instance of first: same buffers, textures, shader and state,
+	// and per object constants that only differ in the per instance fields.
+	static bool CanDrawInstanced(const RenderCommand& first, const RenderCommand& next)
+	{
+		return next.primitiveTopology == first.primitiveTopology && next.pixelShaderType == first.pixelShaderType &&
+			next.should_cull == first.should_cull && next.blend_state == first.blend_state &&
+			next.meshInstance->SharesGeometry(*first.meshInstance) &&
+			next.meshInstance->HasSameTextures(*first.meshInstance) &&
+			HasSameMaterialConstants(next.meshInstance->GetPerObjectData(), first.meshInstance->GetPerObjectData());
+	}
+
+	// Writes the instances of every run of m_instanceRuns with more than one draw into the instance buffer
+	// with a single Map and binds it. Returns false if the buffer couldn't be created or mapped.
+	bool UploadInstanceData()
+	{
+		m_instanceData.clear();
+		for (InstanceRun& run : m_instanceRuns)
+		{
+			if (run.count < 2) { continue; }
+			run.first_instance = static_cast<uint32_t>(m_instanceData.size());
+			for (uint32_t i = run.first; i < run.first + run.count; i++)
+			{
+				m_instanceData.push_back(MakePropInstanceData(m_drawList[i]->meshInstance->GetPerObjectData()));
+			}
+		}
+		if (m_instanceData.empty()) { return true; }
+
+		const uint32_t instance_count = static_cast<uint32_t>(m_instanceData.size());
+		if (instance_count > m_instanceBufferCapacity)
+		{
+			const uint32_t new_capacity = std::max({ instance_count, m_instanceBufferCapacity * 2, MIN_INSTANCE_BUFFER_CAPACITY });
+
+			D3D11_BUFFER_DESC vbDesc = {};
+			vbDesc.Usage = D3D11_USAGE_DYNAMIC;
+			vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			vbDesc.ByteWidth = new_capacity * sizeof(PropInstanceData);
+			vbDesc.StructureByteStride = sizeof(PropInstanceData);
+
+			m_instanceBuffer.Reset();
+			m_instanceBufferCapacity = 0;
+			if (FAILED(m_device->CreateBuffer(&vbDesc, nullptr, m_instanceBuffer.GetAddressOf()))) { return false; }
+			m_instanceBufferCapacity = new_capacity;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		if (FAILED(m_deviceContext->Map(m_instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) { return false; }
+		memcpy(mappedResource.pData, m_instanceData.data(), m_instanceData.size() * sizeof(PropInstanceData));
+		m_deviceContext->Unmap(m_instanceBuffer.Get(), 0);
+
+		// The regular input layout doesn't read this slot, so the buffer can stay bound for the whole pass.
+		UINT stride = sizeof(PropInstanceData);
+		UINT offset = 0;
+		m_deviceContext->IASetVertexBuffers(PROP_INSTANCE_BUFFER_SLOT, 1, m_instanceBuffer.GetAddressOf(), &stride, &offset);
+		return true;
+	}
+
+	// Binds the buffer the packed input layouts read missing attributes from.
+	void BindVertexDefaults()
+	{
+		UINT stride = 0;
+		UINT offset = 0;
+		m_deviceContext->IASetVertexBuffers(VERTEX_DEFAULTS_BUFFER_SLOT, 1, m_vertexDefaultsBuffer.GetAddressOf(), &stride, &offset);
+	}
+
+	// Binds the regular vertex shader variant, which the other render paths expect.
+	void RestoreVertexShader()
+	{
+		if (!m_vertexShader) { return; }
+		m_deviceContext->VSSetShader(m_vertexShader->GetShader(), nullptr, 0);
+		m_deviceContext->IASetInputLayout(m_vertexShader->GetInputLayout());
+	}
+
+	void RecordWorldChange(int mesh_id)
+	{
+		m_renderBatch.InvalidateOrder();
+		if (m_world_changes.size() >= MAX_TRACKED_WORLD_CHANGES) {
+			m_world_changes.clear();
+			m_world_changes_overflowed = true;
+		}
+		if (!m_world_changes_overflowed) {
+			m_world_changes.push_back(mesh_id);
+		}
+	}
+
+	// Sets the shader, sampler, rasterizer, blend and per object state for a single mesh draw.
+	// Returns false if the mesh is filtered out by render_select_state or its vertex shader variant is unavailable.
+	bool PrepareMeshDraw(const RenderCommand& command,
+		std::unordered_map<PixelShaderType, std::unique_ptr<PixelShader>>& pixel_shaders,
+		BlendStateManager* blend_state_manager, RasterizerStateManager* rasterizer_state_manager,
+		RenderSelectionState render_select_state, bool should_set_ps, bool should_overwrite_shader,
+		PixelShaderType overwrite_shader)
+	{
+		if (render_select_state != RenderSelectionState::All) {
+			// Note that these blend_states are estimates. I don't know for sure which ones are transparent until after the models pixel shader has run.
+			if (command.blend_state == BlendState::Opaque && render_select_state != RenderSelectionState::OpaqueOnly) {
+				return false;
+			}
+			if (command.blend_state == BlendState::AlphaBlend && render_select_state != RenderSelectionState::TransparentOnly) {
+				return false;
+			}
+		}
+
+		if (m_vertexShader) {
+			const auto variant = m_vertexShader->GetVariant(command.meshInstance->GetVertexFormat(), false);
+			if (!variant.shader) {
+				return false;
+			}
+			m_deviceContext->VSSetShader(variant.shader, nullptr, 0);
+			m_deviceContext->IASetInputLayout(variant.input_layout);
+			BindVertexDefaults();
+		}
+
+		m_deviceContext->IASetPrimitiveTopology(command.primitiveTopology);
+
+		if (should_overwrite_shader) {
+			m_deviceContext->PSSetShader(pixel_shaders[overwrite_shader]->GetShader(), nullptr, 0);
+		}
+		else if (should_set_ps) {
+			m_deviceContext->PSSetShader(pixel_shaders[command.pixelShaderType]->GetShader(), nullptr, 0);
+		}
+		m_deviceContext->PSSetSamplers(0, 1, pixel_shaders[command.pixelShaderType]->GetSamplerState());
+		m_deviceContext->PSSetSamplers(1, 1, pixel_shaders[command.pixelShaderType]->GetSamplerStateShadow());
+
+
+		if (command.should_cull) { rasterizer_state_manager->SetRasterizerState(RasterizerStateType::Solid); }
+		else { rasterizer_state_manager->SetRasterizerState(RasterizerStateType::Solid_NoCull); }
+
+
+		blend_state_manager->SetBlendState(BlendState::AlphaBlend);
+
+		SetPerObjectCB(command.meshInstance->GetGpuPerObjectData());
+
+		return true;
+	}
+
 	ID3D11Device* m_device;
 	ID3D11DeviceContext* m_deviceContext;
 	int m_nextMeshID;
@@ -572,8 +896,36 @@ private:
 	std::unordered_map<int, std::shared_ptr<MeshInstance>> m_lineMeshes;
 	RenderBatch m_renderBatch;
 
+	static constexpr size_t MAX_TRACKED_WORLD_CHANGES = 4096;
+	std::vector<int> m_world_changes;
+	bool m_world_changes_overflowed = false;
+	const std::vector<uint8_t>* m_culled_mesh_mask = nullptr;
+
+	RenderQueueStats m_frame_stats;
+	RenderQueueStats m_last_frame_stats;
+
 	Microsoft::WRL::ComPtr<ID3D11Buffer> m_perObjectCB;
 
+	// Per pass constants, bound per draw with constant offsets. Null context when offsets are unsupported.
+	static constexpr uint32_t MIN_PER_OBJECT_RING_SLOTS = 1024;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> m_deviceContext1;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_perObjectRingCB;
+	uint32_t m_perObjectRingSlots = 0;
+	PerObjectConstantPacker m_perObjectPacker;
+	std::vector<const RenderCommand*> m_drawList;
+
+	// Owned by the caller. Null draws every mesh with the caller's vertex shader bindings.
+	VertexShader* m_vertexShader = nullptr;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexDefaultsBuffer;
+
+	// Instanced drawing of meshes that share geometry.
+	static constexpr uint32_t MIN_INSTANCE_BUFFER_CAPACITY = 1024;
+	bool m_instancing_enabled = true;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_instanceBuffer;
+	uint32_t m_instanceBufferCapacity = 0;
+	std::vector<InstanceRun> m_instanceRuns;
+	std::vector<PropInstanceData> m_instanceData;
+
 	void add_to_triangle_meshes(std::shared_ptr<MeshInstance> mesh_instance,
 	                            PixelShaderType pixel_shader_type)
 	{
@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "NavDistanceMatrix.h"
+#include <algorithm>
+#include <cstring>
+#include <execution>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <json.hpp>
+
+using namespace DirectX;
+
+namespace
+{
+    // Cost used for unreachable pairs when ordering, large enough to be avoided whenever possible.
+    constexpr float UNREACHABLE_COST = 1e9f;
+    constexpr int MAX_TWO_OPT_PASSES = 50;
+
+    uint64_t hash_points(uint64_t hash, std::span<const XMFLOAT2> points)
+    {
+        // FNV-1a over the raw coordinates
+        const auto* bytes = reinterpret_cast<const uint8_t*>(points.data());
+        for (size_t i = 0; i < points.size_bytes(); i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ull;
+        }
+        hash ^= points.size();
+        hash *= 0x100000001B3ull;
+        return hash;
+    }
+
+    bool same_points(const std::vector<XMFLOAT2>& stored, std::span<const XMFLOAT2> points)
+    {
+        return stored.size() == points.size() &&
+            std::memcmp(stored.data(), points.data(), points.size_bytes()) == 0;
+    }
+}
+
+NavDistanceMatrix ComputeNavDistanceMatrix(const NavMesh& nav_mesh, std::span<const XMFLOAT2> sources,
+    std::span<const XMFLOAT2> targets)
+{
+    NavDistanceMatrix matrix;
+    matrix.rows = static_cast<uint32_t>(sources.size());
+    matrix.cols = static_cast<uint32_t>(targets.size());
+    matrix.distances.assign(sources.size() * targets.size(), -1.0f);
+    if (nav_mesh.IsEmpty() || sources.empty() || targets.empty()) return matrix;
+
+    std::vector<uint32_t> source_traps(sources.size());
+    std::vector<XMFLOAT2> source_points(sources.size());
+    nav_mesh.FindNearestTrapezoids(sources, source_traps, source_points);
+
+    std::vector<uint32_t> target_traps(targets.size());
+    std::vector<XMFLOAT2> target_points(targets.size());
+    nav_mesh.FindNearestTrapezoids(targets, target_traps, target_points);
+
+    // Each worker owns a query (its scratch buffers are per mesh size) and handles every n-th source.
+    const uint32_t worker_count = std::clamp<uint32_t>(std::thread::hardware_concurrency(), 1, matrix.rows);
+    std::vector<uint32_t> workers(worker_count);
+    std::iota(workers.begin(), workers.end(), 0);
+
+    std::for_each(std::execution::par, workers.begin(), workers.end(), [&](uint32_t worker) {
+        NavMeshQuery query(nav_mesh);
+        for (uint32_t row = worker; row < matrix.rows; row += worker_count) {
+            if (source_traps[row] == NAVMESH_INVALID_ID) continue;
+
+            query.BuildDistanceTree(source_points[row], source_traps[row], target_traps);
+            float* out = &matrix.distances[static_cast<size_t>(row) * matrix.cols];
+            for (uint32_t col = 0; col < matrix.cols; col++) {
+                out[col] = query.GetTreeDistance(target_points[col], target_traps[col]);
+            }
+        }
+    });
+
+    return matrix;
+}
+
+bool WriteNavDistanceMatrixCsv(const std::filesystem::path& path, const NavDistanceMatrix& matrix)
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Header row holds the target indices, each following row starts with its source index.
+    file << "source";
+    for (uint32_t col = 0; col < matrix.cols; col++) {
+        file << "," << col;
+    }
+    file << "\n";
+
+    for (uint32_t row = 0; row < matrix.rows; row++) {
+        file << row;
+        for (uint32_t col = 0; col < matrix.cols; col++) {
+            const float distance = matrix.at(row, col);
+            file << ",";
+            if (distance >= 0) {
+                file << distance;
+            }
+        }
+        file << "\n";
+    }
+    return file.good();
+}
+
+bool WriteNavDistanceMatrixJson(const std::filesystem::path& path, const NavDistanceMatrix& matrix,
+    uint32_t map_file_hash, std::span<const XMFLOAT2> sources, std::span<const XMFLOAT2> targets)
+{
+    auto points_to_json = [](std::span<const XMFLOAT2> points) {
+        nlohmann::json array = nlohmann::json::array();
+        for (const auto& point : points) {
+            array.push_back({ {"x", point.x}, {"y", point.y} });
+        }
+        return array;
+    };
+
+    nlohmann::json rows = nlohmann::json::array();
+    for (uint32_t row = 0; row < matrix.rows; row++) {
+        nlohmann::json values = nlohmann::json::array();
+        for (uint32_t col = 0; col < matrix.cols; col++) {
+            const float distance = matrix.at(row, col);
+            values.push_back(distance >= 0 ? nlohmann::json(distance) : nlohmann::json(nullptr));
+        }
+        rows.push_back(std::move(values));
+    }
+
+    nlohmann::json j = {
+        {"map_file_hash", map_file_hash},
+        {"sources", points_to_json(sources)},
+        {"targets", points_to_json(targets)},
+        {"distances", std::move(rows)},
+    };
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << j.dump(2);
+    return file.good();
+}
+
+std::vector<uint32_t> OrderByNavDistance(const NavDistanceMatrix& matrix, uint32_t start_index)
+{
+    const uint32_t n = std::min(matrix.rows, matrix.cols);
+    std::vector<uint32_t> order;
+    if (n == 0) return order;
+    start_index = std::min(start_index, n - 1);
+
+    // Symmetric cost, walking a leg either way should cost the same.
+    auto cost = [&](uint32_t a, uint32_t b) {
+        const float ab = matrix.at(a, b);
+        const float ba = matrix.at(b, a);
+        if (ab < 0 && ba < 0) return UNREACHABLE_COST;
+        if (ab < 0) return ba;
+        if (ba < 0) return ab;
+        return (ab + ba) * 0.5f;
+    };
+
+    // Nearest neighbour tour
+    std::vector<bool> visited(n, false);
+    order.reserve(n);
+    order.push_back(start_index);
+    visited[start_index] = true;
+    for (uint32_t step = 1; step < n; step++) {
+        const uint32_t last = order.back();
+        uint32_t best = 0;
+        float best_cost = std::numeric_limits<float>::max();
+        for (uint32_t candidate = 0; candidate < n; candidate++) {
+            if (visited[candidate]) continue;
+            const float c = cost(last, candidate);
+            if (c < best_cost) {
+                best_cost = c;
+                best = candidate;
+            }
+        }
+        order.push_back(best);
+        visited[best] = true;
+    }
+
+    // 2-opt: reverse order[i..k] when that shortens the path. The start stays first and the path is open,
+    // so reversing a suffix has no closing edge to pay for.
+    for (int pass = 0; pass < MAX_TWO_OPT_PASSES; pass++) {
+        bool improved = false;
+        for (uint32_t i = 1; i + 1 < n; i++) {
+            for (uint32_t k = i + 1; k < n; k++) {
+                const float removed = cost(order[i - 1], order[i]) + (k + 1 < n ? cost(order[k], order[k + 1]) : 0.0f);
+                const float added = cost(order[i - 1], order[k]) + (k + 1 < n ? cost(order[i], order[k + 1]) : 0.0f);
+                if (added + 1e-3f < removed) {
+                    std::reverse(order.begin() + i, order.begin() + k + 1);
+                    improved = true;
+                }
+            }
+        }
+        if (!improved) break;
+    }
+
+    return order;
+}
+
+std::shared_ptr<const NavDistanceMatrix> NavDistanceCache::GetOrCompute(uint32_t map_file_hash,
+    const NavMesh& nav_mesh, std::span<const XMFLOAT2> sources, std::span<const XMFLOAT2> targets)
+{
+    uint64_t key = 0xCBF29CE484222325ull ^ map_file_hash;
+    key = hash_points(key, sources);
+    key = hash_points(key, targets);
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        auto& entry = it->second;
+        if (entry.map_file_hash == map_file_hash && same_points(entry.sources, sources) &&
+            same_points(entry.targets, targets)) {
+            m_lru.splice(m_lru.begin(), m_lru, entry.lru_position);
+            return entry.matrix;
+        }
+        // Hash collision, replace the old entry
+        m_lru.erase(entry.lru_position);
+        m_entries.erase(it);
+    }
+
+    auto matrix = std::make_shared<const NavDistanceMatrix>(ComputeNavDistanceMatrix(nav_mesh, sources, targets));
+
+    while (!m_lru.empty() && m_entries.size() >= m_max_entries) {
+        m_entries.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+
+    m_lru.push_front(key);
+    Entry entry;
+    entry.map_file_hash = map_file_hash;
+    entry.sources.assign(sources.begin(), sources.end());
+    entry.targets.assign(targets.begin(), targets.end());
+    entry.matrix = matrix;
+    entry.lru_position = m_lru.begin();
+    m_entries.emplace(key, std::move(entry));
+    return matrix;
+}
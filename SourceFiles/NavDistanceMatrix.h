@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+#include "NavMesh.h"
+
+/**
+ * @brief Many-to-many walk distances, row-major with one row per source.
+ *
+ * Unreachable pairs hold a negative distance.
+ */
+struct NavDistanceMatrix
+{
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    std::vector<float> distances;
+
+    float at(uint32_t row, uint32_t col) const { return distances[static_cast<size_t>(row) * cols + col]; }
+};
+
+/**
+ * @brief Computes walk distances from every source to every target.
+ *
+ * One shortest path tree is built per source and reused for all targets, and
+ * sources are spread across threads. Points off the walkable area are snapped
+ * to the nearest trapezoid first.
+ */
+NavDistanceMatrix ComputeNavDistanceMatrix(const NavMesh& nav_mesh, std::span<const DirectX::XMFLOAT2> sources,
+    std::span<const DirectX::XMFLOAT2> targets);
+
+bool WriteNavDistanceMatrixCsv(const std::filesystem::path& path, const NavDistanceMatrix& matrix);
+
+bool WriteNavDistanceMatrixJson(const std::filesystem::path& path, const NavDistanceMatrix& matrix,
+    uint32_t map_file_hash, std::span<const DirectX::XMFLOAT2> sources, std::span<const DirectX::XMFLOAT2> targets);
+
+/**
+ * @brief Visiting order for the points of a square distance matrix, starting at start_index.
+ *
+ * Nearest neighbour tour refined with 2-opt moves. The tour is an open path, so the
+ * last point doesn't return to the start. Unreachable pairs are treated as very long.
+ */
+std::vector<uint32_t> OrderByNavDistance(const NavDistanceMatrix& matrix, uint32_t start_index = 0);
+
+/**
+ * @brief Caches distance matrices per map file hash and point set.
+ *
+ * Holds a limited number of matrices and evicts the least recently used one.
+ * Not thread safe.
+ */
+class NavDistanceCache
+{
+public:
+    explicit NavDistanceCache(size_t max_entries = 16)
+        : m_max_entries(max_entries)
+    {
+    }
+
+    std::shared_ptr<const NavDistanceMatrix> GetOrCompute(uint32_t map_file_hash, const NavMesh& nav_mesh,
+        std::span<const DirectX::XMFLOAT2> sources, std::span<const DirectX::XMFLOAT2> targets);
+
+    void Clear()
+    {
+        m_entries.clear();
+        m_lru.clear();
+    }
+
+    size_t GetEntryCount() const { return m_entries.size(); }
+
+private:
+    struct Entry
+    {
+        uint32_t map_file_hash;
+        std::vector<DirectX::XMFLOAT2> sources;
+        std::vector<DirectX::XMFLOAT2> targets;
+        std::shared_ptr<const NavDistanceMatrix> matrix;
+        std::list<uint64_t>::iterator lru_position;
+    };
+
+    size_t m_max_entries;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::list<uint64_t> m_lru;   // Most recently used first
+};
@@ -0,0 +1,752 @@
+#include "pch.h"
+#include "NavMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+    // Tolerance for deciding that two trapezoid edges coincide, in world units.
+    constexpr float EDGE_EPSILON = 0.5f;
+    // Portals shorter than this only touch at a corner and can't be walked through.
+    constexpr float MIN_PORTAL_LENGTH = 1.0f;
+    // Lookup grids aim for about this many trapezoids per cell, capped per axis.
+    constexpr float GRID_TRAPEZOIDS_PER_CELL = 2.0f;
+    constexpr uint32_t GRID_MAX_CELLS_PER_AXIS = 1024;
+    // Batched lookups smaller than this run on the calling thread.
+    constexpr size_t PARALLEL_BATCH_SIZE = 1024;
+
+    struct NavEdge
+    {
+        uint32_t from;
+        uint32_t to;
+        NavPortal portal;
+    };
+
+    float distance(const XMFLOAT2& a, const XMFLOAT2& b)
+    {
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // Twice the signed area of triangle abc. Positive when c is right of a->b in an x-right, y-up frame.
+    float triangle_area2(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c)
+    {
+        return (c.x - a.x) * (b.y - a.y) - (b.x - a.x) * (c.y - a.y);
+    }
+
+    bool nearly_equal(const XMFLOAT2& a, const XMFLOAT2& b)
+    {
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        return dx * dx + dy * dy < 1e-6f;
+    }
+
+    float left_x_at(const PathfindingTrapezoid& trap, float y)
+    {
+        if (trap.yt == trap.yb) return std::min(trap.xtl, trap.xbl);
+        const float t = (y - trap.yb) / (trap.yt - trap.yb);
+        return trap.xbl + (trap.xtl - trap.xbl) * t;
+    }
+
+    float right_x_at(const PathfindingTrapezoid& trap, float y)
+    {
+        if (trap.yt == trap.yb) return std::max(trap.xtr, trap.xbr);
+        const float t = (y - trap.yb) / (trap.yt - trap.yb);
+        return trap.xbr + (trap.xtr - trap.xbr) * t;
+    }
+
+    float y_min(const PathfindingTrapezoid& trap) { return std::min(trap.yt, trap.yb); }
+    float y_max(const PathfindingTrapezoid& trap) { return std::max(trap.yt, trap.yb); }
+
+    // Overlap of two horizontal edges at the same y.
+    bool horizontal_overlap(float y_a, float a_x0, float a_x1, float y_b, float b_x0, float b_x1, NavPortal& portal)
+    {
+        if (std::abs(y_a - y_b) > EDGE_EPSILON) return false;
+        const float lo = std::max(std::min(a_x0, a_x1), std::min(b_x0, b_x1));
+        const float hi = std::min(std::max(a_x0, a_x1), std::max(b_x0, b_x1));
+        if (hi - lo < MIN_PORTAL_LENGTH) return false;
+        portal = { XMFLOAT2(lo, y_a), XMFLOAT2(hi, y_a) };
+        return true;
+    }
+
+    // Overlap of the left side of a with the right side of b.
+    bool side_overlap(const PathfindingTrapezoid& a, const PathfindingTrapezoid& b, NavPortal& portal)
+    {
+        const float lo = std::max(y_min(a), y_min(b));
+        const float hi = std::min(y_max(a), y_max(b));
+        if (hi - lo < EDGE_EPSILON) return false;
+
+        const float a_lo = left_x_at(a, lo);
+        const float a_hi = left_x_at(a, hi);
+        if (std::abs(a_lo - right_x_at(b, lo)) > EDGE_EPSILON || std::abs(a_hi - right_x_at(b, hi)) > EDGE_EPSILON) {
+            return false;
+        }
+
+        portal = { XMFLOAT2(a_lo, lo), XMFLOAT2(a_hi, hi) };
+        return distance(portal.a, portal.b) >= MIN_PORTAL_LENGTH;
+    }
+
+    // Finds the longest edge segment shared by two trapezoids.
+    bool shared_edge(const PathfindingTrapezoid& a, const PathfindingTrapezoid& b, NavPortal& portal)
+    {
+        NavPortal candidates[4];
+        bool found[4] = {
+            horizontal_overlap(a.yb, a.xbl, a.xbr, b.yt, b.xtl, b.xtr, candidates[0]),
+            horizontal_overlap(a.yt, a.xtl, a.xtr, b.yb, b.xbl, b.xbr, candidates[1]),
+            side_overlap(a, b, candidates[2]),
+            side_overlap(b, a, candidates[3]),
+        };
+
+        float best_length = 0;
+        for (int i = 0; i < 4; i++) {
+            if (!found[i]) continue;
+            const float length = distance(candidates[i].a, candidates[i].b);
+            if (length > best_length) {
+                best_length = length;
+                portal = candidates[i];
+            }
+        }
+        return best_length > 0;
+    }
+
+    // Point where the segment from -> goal crosses the portal, clamped to the portal's endpoints.
+    // Steering node positions toward the goal picks much straighter corridors than portal midpoints.
+    XMFLOAT2 portal_crossing_point(const NavPortal& portal, const XMFLOAT2& from, const XMFLOAT2& goal)
+    {
+        const float edge_x = portal.b.x - portal.a.x;
+        const float edge_y = portal.b.y - portal.a.y;
+        const float dir_x = goal.x - from.x;
+        const float dir_y = goal.y - from.y;
+        const float denominator = edge_x * dir_y - edge_y * dir_x;
+
+        float t;
+        if (std::abs(denominator) > 1e-6f) {
+            t = ((from.x - portal.a.x) * dir_y - (from.y - portal.a.y) * dir_x) / denominator;
+        }
+        else {
+            t = distance(from, portal.a) <= distance(from, portal.b) ? 0.0f : 1.0f;
+        }
+        t = std::clamp(t, 0.0f, 1.0f);
+        return XMFLOAT2(portal.a.x + edge_x * t, portal.a.y + edge_y * t);
+    }
+
+    XMFLOAT2 closest_point_on_segment(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& p)
+    {
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        const float length_sq = dx * dx + dy * dy;
+        float t = length_sq > 0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / length_sq : 0.0f;
+        t = std::clamp(t, 0.0f, 1.0f);
+        return XMFLOAT2(a.x + dx * t, a.y + dy * t);
+    }
+}
+
+NavMesh::NavMesh(const PathfindingChunk& pathfinding_chunk)
+{
+    if (!pathfinding_chunk.valid) return;
+
+    const auto& planes = pathfinding_chunk.planes;
+    m_plane_first.reserve(planes.size() + 1);
+    m_trapezoids.reserve(pathfinding_chunk.all_trapezoids.size());
+    for (uint32_t plane = 0; plane < planes.size(); plane++) {
+        m_plane_first.push_back(static_cast<uint32_t>(m_trapezoids.size()));
+        for (const auto& trap : planes[plane].trapezoids) {
+            m_trapezoids.push_back(trap);
+            m_trapezoid_planes.push_back(plane);
+            m_centroids.emplace_back((trap.xtl + trap.xtr + trap.xbl + trap.xbr) * 0.25f, (trap.yt + trap.yb) * 0.5f);
+        }
+    }
+    m_plane_first.push_back(static_cast<uint32_t>(m_trapezoids.size()));
+
+    m_plane_grids.resize(planes.size());
+    for (uint32_t plane = 0; plane < planes.size(); plane++) {
+        BuildPlaneGrid(plane);
+    }
+
+    std::vector<NavEdge> edges;
+    auto add_link = [&](uint32_t a, uint32_t b, const NavPortal& portal) {
+        edges.push_back({ a, b, portal });
+        edges.push_back({ b, a, portal });
+    };
+
+    // Links within a plane, from the stored neighbor indices. Indices that don't share an edge are ignored.
+    for (uint32_t plane = 0; plane + 1 < m_plane_first.size(); plane++) {
+        const uint32_t first = m_plane_first[plane];
+        const uint32_t count = m_plane_first[plane + 1] - first;
+        for (uint32_t i = 0; i < count; i++) {
+            const auto& trap = m_trapezoids[first + i];
+            for (uint32_t neighbor : trap.neighbors) {
+                if (neighbor == PATHFINDING_NO_NEIGHBOR || neighbor >= count || neighbor == i) continue;
+
+                NavPortal portal;
+                if (shared_edge(trap, m_trapezoids[first + neighbor], portal)) {
+                    add_link(first + i, first + neighbor, portal);
+                }
+            }
+        }
+    }
+
+    // Links between planes: a portal on the left side of one trapezoid meets a portal on the right side of a
+    // trapezoid in another plane. Portal trapezoids are rare, so a pairwise test is cheap.
+    std::vector<uint32_t> left_portals;
+    std::vector<uint32_t> right_portals;
+    for (uint32_t i = 0; i < m_trapezoids.size(); i++) {
+        if (m_trapezoids[i].portal_left != PATHFINDING_NO_PORTAL) left_portals.push_back(i);
+        if (m_trapezoids[i].portal_right != PATHFINDING_NO_PORTAL) right_portals.push_back(i);
+    }
+    for (uint32_t a : left_portals) {
+        for (uint32_t b : right_portals) {
+            if (m_trapezoid_planes[a] == m_trapezoid_planes[b]) continue;
+
+            NavPortal portal;
+            if (side_overlap(m_trapezoids[a], m_trapezoids[b], portal)) {
+                add_link(a, b, portal);
+            }
+        }
+    }
+
+    std::sort(edges.begin(), edges.end(), [](const NavEdge& lhs, const NavEdge& rhs) {
+        return lhs.from != rhs.from ? lhs.from < rhs.from : lhs.to < rhs.to;
+    });
+    edges.erase(std::unique(edges.begin(), edges.end(), [](const NavEdge& lhs, const NavEdge& rhs) {
+        return lhs.from == rhs.from && lhs.to == rhs.to;
+    }), edges.end());
+
+    // Sorted by source, so each plane's edges are one contiguous run.
+    m_plane_graphs.resize(planes.size());
+    auto edge = edges.begin();
+    for (uint32_t plane = 0; plane < planes.size(); plane++) {
+        const uint32_t first = m_plane_first[plane];
+        const uint32_t count = m_plane_first[plane + 1] - first;
+        const auto end = std::find_if(edge, edges.end(), [&](const NavEdge& e) { return e.from >= first + count; });
+
+        auto& graph = m_plane_graphs[plane];
+        graph.edge_offsets.assign(count + 1, 0);
+        graph.edge_targets.reserve(end - edge);
+        graph.edge_portals.reserve(end - edge);
+        for (; edge != end; ++edge) {
+            graph.edge_offsets[edge->from - first + 1]++;
+            graph.edge_targets.push_back(edge->to);
+            graph.edge_portals.push_back(edge->portal);
+        }
+        for (size_t i = 1; i < graph.edge_offsets.size(); i++) {
+            graph.edge_offsets[i] += graph.edge_offsets[i - 1];
+        }
+    }
+    m_edge_count = static_cast<uint32_t>(edges.size());
+}
+
+void NavMesh::BuildPlaneGrid(uint32_t plane)
+{
+    auto& grid = m_plane_grids[plane];
+    const uint32_t first = m_plane_first[plane];
+    const uint32_t last = m_plane_first[plane + 1];
+    if (first == last) return;
+
+    float min_x = std::numeric_limits<float>::max();
+    float min_y = std::numeric_limits<float>::max();
+    float max_x = std::numeric_limits<float>::lowest();
+    float max_y = std::numeric_limits<float>::lowest();
+    for (uint32_t i = first; i < last; i++) {
+        const auto& trap = m_trapezoids[i];
+        min_x = std::min({ min_x, trap.xtl, trap.xbl });
+        max_x = std::max({ max_x, trap.xtr, trap.xbr });
+        min_y = std::min(min_y, y_min(trap));
+        max_y = std::max(max_y, y_max(trap));
+    }
+
+    const float width = std::max(max_x - min_x, 1.0f);
+    const float height = std::max(max_y - min_y, 1.0f);
+    const float target_cells = std::max((last - first) / GRID_TRAPEZOIDS_PER_CELL, 1.0f);
+    grid.cell_size = std::max({ std::sqrt(width * height / target_cells),
+        width / GRID_MAX_CELLS_PER_AXIS, height / GRID_MAX_CELLS_PER_AXIS });
+    grid.min = XMFLOAT2(min_x, min_y);
+    grid.max = XMFLOAT2(max_x, max_y);
+    grid.cols = std::clamp(static_cast<uint32_t>(width / grid.cell_size) + 1, 1u, GRID_MAX_CELLS_PER_AXIS);
+    grid.rows = std::clamp(static_cast<uint32_t>(height / grid.cell_size) + 1, 1u, GRID_MAX_CELLS_PER_AXIS);
+
+    // Bounds grown by EDGE_EPSILON, the margin ContainsPoint accepts, so every point a trapezoid contains lies
+    // in one of its cells. FindTrapezoidInPlane maps points to cells with the same formula.
+    auto cell_range = [&](const PathfindingTrapezoid& trap, uint32_t& c0, uint32_t& c1, uint32_t& r0, uint32_t& r1) {
+        auto to_cell = [&](float v, float origin, uint32_t count) {
+            return std::min(static_cast<uint32_t>(std::max((v - origin) / grid.cell_size, 0.0f)), count - 1);
+        };
+        c0 = to_cell(std::min(trap.xtl, trap.xbl) - EDGE_EPSILON, grid.min.x, grid.cols);
+        c1 = to_cell(std::max(trap.xtr, trap.xbr) + EDGE_EPSILON, grid.min.x, grid.cols);
+        r0 = to_cell(y_min(trap) - EDGE_EPSILON, grid.min.y, grid.rows);
+        r1 = to_cell(y_max(trap) + EDGE_EPSILON, grid.min.y, grid.rows);
+    };
+
+    // Count, prefix sum, fill
+    grid.cell_offsets.assign(static_cast<size_t>(grid.cols) * grid.rows + 1, 0);
+    for (uint32_t i = first; i < last; i++) {
+        uint32_t c0, c1, r0, r1;
+        cell_range(m_trapezoids[i], c0, c1, r0, r1);
+        for (uint32_t r = r0; r <= r1; r++) {
+            for (uint32_t c = c0; c <= c1; c++) {
+                grid.cell_offsets[r * grid.cols + c + 1]++;
+            }
+        }
+    }
+    for (size_t i = 1; i < grid.cell_offsets.size(); i++) {
+        grid.cell_offsets[i] += grid.cell_offsets[i - 1];
+    }
+
+    grid.cell_items.resize(grid.cell_offsets.back());
+    std::vector<uint32_t> cursor(grid.cell_offsets.begin(), grid.cell_offsets.end() - 1);
+    for (uint32_t i = first; i < last; i++) {
+        uint32_t c0, c1, r0, r1;
+        cell_range(m_trapezoids[i], c0, c1, r0, r1);
+        for (uint32_t r = r0; r <= r1; r++) {
+            for (uint32_t c = c0; c <= c1; c++) {
+                grid.cell_items[cursor[r * grid.cols + c]++] = i;
+            }
+        }
+    }
+}
+
+bool NavMesh::ContainsPoint(const PathfindingTrapezoid& trap, const XMFLOAT2& point)
+{
+    if (point.y < y_min(trap) - EDGE_EPSILON || point.y > y_max(trap) + EDGE_EPSILON) return false;
+    const float y = std::clamp(point.y, y_min(trap), y_max(trap));
+    return point.x >= left_x_at(trap, y) - EDGE_EPSILON && point.x <= right_x_at(trap, y) + EDGE_EPSILON;
+}
+
+XMFLOAT2 NavMesh::ClosestPoint(const PathfindingTrapezoid& trap, const XMFLOAT2& point)
+{
+    if (ContainsPoint(trap, point)) return point;
+
+    const XMFLOAT2 corners[4] = {
+        XMFLOAT2(trap.xtl, trap.yt), XMFLOAT2(trap.xtr, trap.yt),
+        XMFLOAT2(trap.xbr, trap.yb), XMFLOAT2(trap.xbl, trap.yb),
+    };
+
+    XMFLOAT2 best = corners[0];
+    float best_distance = std::numeric_limits<float>::max();
+    for (int i = 0; i < 4; i++) {
+        const XMFLOAT2 candidate = closest_point_on_segment(corners[i], corners[(i + 1) % 4], point);
+        const float d = distance(candidate, point);
+        if (d < best_distance) {
+            best_distance = d;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+uint32_t NavMesh::FindTrapezoidInPlane(const XMFLOAT2& point, uint32_t plane) const
+{
+    const auto& grid = m_plane_grids[plane];
+    if (grid.cell_offsets.empty()) return NAVMESH_INVALID_ID;
+
+    if (point.x < grid.min.x - EDGE_EPSILON || point.y < grid.min.y - EDGE_EPSILON ||
+        point.x > grid.max.x + EDGE_EPSILON || point.y > grid.max.y + EDGE_EPSILON) {
+        return NAVMESH_INVALID_ID;
+    }
+
+    // Cells are clamped so points just outside the bounds still reach the edge trapezoids within EDGE_EPSILON.
+    // Trapezoids are listed in every cell their grown bounds touch, so the cell holds all that contain the point.
+    const float fx = (point.x - grid.min.x) / grid.cell_size;
+    const float fy = (point.y - grid.min.y) / grid.cell_size;
+    const uint32_t col = std::min(static_cast<uint32_t>(std::max(fx, 0.0f)), grid.cols - 1);
+    const uint32_t row = std::min(static_cast<uint32_t>(std::max(fy, 0.0f)), grid.rows - 1);
+
+    const uint32_t cell = row * grid.cols + col;
+    uint32_t best = NAVMESH_INVALID_ID;
+    for (uint32_t i = grid.cell_offsets[cell]; i < grid.cell_offsets[cell + 1]; i++) {
+        const uint32_t trap = grid.cell_items[i];
+        // Keep the lowest id so overlapping edges resolve the same way a linear scan would.
+        if (trap < best && ContainsPoint(m_trapezoids[trap], point)) {
+            best = trap;
+        }
+    }
+    return best;
+}
+
+uint32_t NavMesh::FindTrapezoid(const XMFLOAT2& point, int plane) const
+{
+    if (plane >= 0) {
+        if (plane >= static_cast<int>(GetPlaneCount())) return NAVMESH_INVALID_ID;
+        return FindTrapezoidInPlane(point, plane);
+    }
+
+    for (uint32_t p = 0; p < GetPlaneCount(); p++) {
+        const uint32_t trap = FindTrapezoidInPlane(point, p);
+        if (trap != NAVMESH_INVALID_ID) return trap;
+    }
+    return NAVMESH_INVALID_ID;
+}
+
+void NavMesh::FindNearestInPlane(const XMFLOAT2& point, uint32_t plane, uint32_t& best, float& best_distance,
+    XMFLOAT2& snapped_point) const
+{
+    const auto& grid = m_plane_grids[plane];
+    if (grid.cell_offsets.empty()) return;
+
+    // Rings of cells around the cell nearest to the point. Every cell in ring r is at least (r - 1) cells away
+    // from the point, so the search stops once that bound exceeds the best distance found.
+    const int center_col = std::clamp(static_cast<int>(std::floor((point.x - grid.min.x) / grid.cell_size)), 0,
+        static_cast<int>(grid.cols) - 1);
+    const int center_row = std::clamp(static_cast<int>(std::floor((point.y - grid.min.y) / grid.cell_size)), 0,
+        static_cast<int>(grid.rows) - 1);
+    const int max_ring = static_cast<int>(std::max(grid.cols, grid.rows));
+
+    auto visit_cell = [&](int col, int row) {
+        if (col < 0 || row < 0 || col >= static_cast<int>(grid.cols) || row >= static_cast<int>(grid.rows)) return;
+        const uint32_t cell = row * grid.cols + col;
+        for (uint32_t i = grid.cell_offsets[cell]; i < grid.cell_offsets[cell + 1]; i++) {
+            const uint32_t trap = grid.cell_items[i];
+            const XMFLOAT2 candidate = ClosestPoint(m_trapezoids[trap], point);
+            const float d = distance(candidate, point);
+            if (d < best_distance || (d == best_distance && trap < best)) {
+                best_distance = d;
+                best = trap;
+                snapped_point = candidate;
+            }
+        }
+    };
+
+    for (int ring = 0; ring <= max_ring; ring++) {
+        if ((ring - 1) * grid.cell_size > best_distance) break;
+
+        if (ring == 0) {
+            visit_cell(center_col, center_row);
+            continue;
+        }
+        for (int i = -ring; i <= ring; i++) {
+            visit_cell(center_col + i, center_row - ring);
+            visit_cell(center_col + i, center_row + ring);
+        }
+        for (int i = -ring + 1; i <= ring - 1; i++) {
+            visit_cell(center_col - ring, center_row + i);
+            visit_cell(center_col + ring, center_row + i);
+        }
+    }
+}
+
+uint32_t NavMesh::FindNearestTrapezoid(const XMFLOAT2& point, XMFLOAT2& snapped_point) const
+{
+    const uint32_t containing = FindTrapezoid(point);
+    if (containing != NAVMESH_INVALID_ID) {
+        snapped_point = point;
+        return containing;
+    }
+
+    uint32_t best = NAVMESH_INVALID_ID;
+    float best_distance = std::numeric_limits<float>::max();
+    for (uint32_t plane = 0; plane < GetPlaneCount(); plane++) {
+        FindNearestInPlane(point, plane, best, best_distance, snapped_point);
+    }
+    return best;
+}
+
+void NavMesh::FindTrapezoids(std::span<const XMFLOAT2> points, std::span<uint32_t> trapezoids, int plane) const
+{
+    const size_t count = std::min(points.size(), trapezoids.size());
+    auto lookup = [&](const XMFLOAT2& point) { return FindTrapezoid(point, plane); };
+    if (count < PARALLEL_BATCH_SIZE) {
+        std::transform(points.begin(), points.begin() + count, trapezoids.begin(), lookup);
+    }
+    else {
+        std::transform(std::execution::par, points.begin(), points.begin() + count, trapezoids.begin(), lookup);
+    }
+}
+
+void NavMesh::FindNearestTrapezoids(std::span<const XMFLOAT2> points, std::span<uint32_t> trapezoids,
+    std::span<XMFLOAT2> snapped_points) const
+{
+    const size_t count = std::min({ points.size(), trapezoids.size(), snapped_points.size() });
+    auto lookup = [&](size_t i) { trapezoids[i] = FindNearestTrapezoid(points[i], snapped_points[i]); };
+
+    std::vector<size_t> indices(count);
+    std::iota(indices.begin(), indices.end(), 0);
+    if (count < PARALLEL_BATCH_SIZE) {
+        std::for_each(indices.begin(), indices.end(), lookup);
+    }
+    else {
+        std::for_each(std::execution::par, indices.begin(), indices.end(), lookup);
+    }
+}
+
+NavMeshQuery::NavMeshQuery(const NavMesh& nav_mesh)
+    : m_nav_mesh(nav_mesh)
+{
+    const size_t count = nav_mesh.GetTrapezoidCount();
+    m_cost.resize(count);
+    m_entry_point.resize(count);
+    m_parent.resize(count);
+    m_parent_edge.resize(count);
+    m_visited.assign(count, 0);
+    m_closed.assign(count, 0);
+    m_target.assign(count, 0);
+}
+
+void NavMeshQuery::BeginSearch()
+{
+    // Search ids let the per trapezoid state be reused without clearing it between queries.
+    if (++m_search_id == 0) {
+        std::fill(m_visited.begin(), m_visited.end(), 0);
+        std::fill(m_closed.begin(), m_closed.end(), 0);
+        std::fill(m_target.begin(), m_target.end(), 0);
+        m_search_id = 1;
+    }
+    m_tree_source_trap = NAVMESH_INVALID_ID;
+}
+
+bool NavMeshQuery::FindPath(const XMFLOAT2& start, const XMFLOAT2& goal, NavPath& path)
+{
+    path.points.clear();
+    path.corridor.clear();
+    path.length = 0;
+
+    XMFLOAT2 start_point;
+    XMFLOAT2 goal_point;
+    const uint32_t start_trap = m_nav_mesh.FindNearestTrapezoid(start, start_point);
+    const uint32_t goal_trap = m_nav_mesh.FindNearestTrapezoid(goal, goal_point);
+    if (start_trap == NAVMESH_INVALID_ID || goal_trap == NAVMESH_INVALID_ID) return false;
+
+    if (!FindCorridor(start_trap, goal_trap, start_point, goal_point)) return false;
+
+    path.corridor.push_back(start_trap);
+    path.corridor.insert(path.corridor.end(), m_corridor.begin(), m_corridor.end());
+    path.length = StringPull(start_point, goal_point, &path.points);
+    return true;
+}
+
+float NavMeshQuery::FindDistance(const XMFLOAT2& start, const XMFLOAT2& goal)
+{
+    XMFLOAT2 start_point;
+    XMFLOAT2 goal_point;
+    const uint32_t start_trap = m_nav_mesh.FindNearestTrapezoid(start, start_point);
+    const uint32_t goal_trap = m_nav_mesh.FindNearestTrapezoid(goal, goal_point);
+    if (start_trap == NAVMESH_INVALID_ID || goal_trap == NAVMESH_INVALID_ID) return -1.0f;
+
+    if (!FindCorridor(start_trap, goal_trap, start_point, goal_point)) return -1.0f;
+    return StringPull(start_point, goal_point, nullptr);
+}
+
+bool NavMeshQuery::FindCorridor(uint32_t start_trap, uint32_t goal_trap, const XMFLOAT2& start, const XMFLOAT2& goal)
+{
+    m_corridor.clear();
+    m_portals.clear();
+    if (start_trap == goal_trap) return true;
+
+    BeginSearch();
+
+    auto heap_order = [](const OpenEntry& lhs, const OpenEntry& rhs) { return lhs.f > rhs.f; };
+
+    m_open.clear();
+    m_cost[start_trap] = 0;
+    m_entry_point[start_trap] = start;
+    m_parent[start_trap] = NAVMESH_INVALID_ID;
+    m_parent_edge[start_trap] = NAVMESH_INVALID_ID;
+    m_visited[start_trap] = m_search_id;
+    m_open.push_back({ distance(start, goal), start_trap });
+
+    bool found = false;
+    while (!m_open.empty()) {
+        std::pop_heap(m_open.begin(), m_open.end(), heap_order);
+        const uint32_t current = m_open.back().trap;
+        m_open.pop_back();
+
+        if (m_closed[current] == m_search_id) continue;
+        m_closed[current] = m_search_id;
+
+        if (current == goal_trap) {
+            found = true;
+            break;
+        }
+
+        const XMFLOAT2 current_point = m_entry_point[current];
+        const float current_cost = m_cost[current];
+        const auto targets = m_nav_mesh.GetEdgeTargets(current);
+        const auto portals = m_nav_mesh.GetEdgePortals(current);
+        for (uint32_t edge = 0; edge < targets.size(); edge++) {
+            const uint32_t next = targets[edge];
+            if (m_closed[next] == m_search_id) continue;
+
+            const XMFLOAT2 entry = portal_crossing_point(portals[edge], current_point, goal);
+            const float cost = current_cost + distance(current_point, entry);
+            if (m_visited[next] == m_search_id && cost >= m_cost[next]) continue;
+
+            m_visited[next] = m_search_id;
+            m_cost[next] = cost;
+            m_entry_point[next] = entry;
+            m_parent[next] = current;
+            m_parent_edge[next] = edge;
+            m_open.push_back({ cost + distance(entry, goal), next });
+            std::push_heap(m_open.begin(), m_open.end(), heap_order);
+        }
+    }
+
+    if (!found) return false;
+
+    for (uint32_t trap = goal_trap; m_parent[trap] != NAVMESH_INVALID_ID; trap = m_parent[trap]) {
+        m_corridor.push_back(trap);
+    }
+    std::reverse(m_corridor.begin(), m_corridor.end());
+    return true;
+}
+
+void NavMeshQuery::BuildDistanceTree(const XMFLOAT2& source, uint32_t source_trap,
+    std::span<const uint32_t> target_trapezoids)
+{
+    BeginSearch();
+    if (source_trap >= m_nav_mesh.GetTrapezoidCount()) return;
+
+    uint32_t remaining_targets = 0;
+    for (uint32_t target : target_trapezoids) {
+        if (target < m_target.size() && m_target[target] != m_search_id) {
+            m_target[target] = m_search_id;
+            remaining_targets++;
+        }
+    }
+
+    auto heap_order = [](const OpenEntry& lhs, const OpenEntry& rhs) { return lhs.f > rhs.f; };
+
+    m_open.clear();
+    m_cost[source_trap] = 0;
+    m_entry_point[source_trap] = source;
+    m_parent[source_trap] = NAVMESH_INVALID_ID;
+    m_parent_edge[source_trap] = NAVMESH_INVALID_ID;
+    m_visited[source_trap] = m_search_id;
+    m_open.push_back({ 0.0f, source_trap });
+
+    while (!m_open.empty()) {
+        std::pop_heap(m_open.begin(), m_open.end(), heap_order);
+        const uint32_t current = m_open.back().trap;
+        m_open.pop_back();
+
+        if (m_closed[current] == m_search_id) continue;
+        m_closed[current] = m_search_id;
+
+        if (m_target[current] == m_search_id && --remaining_targets == 0) break;
+
+        const XMFLOAT2 current_point = m_entry_point[current];
+        const float current_cost = m_cost[current];
+        const auto targets = m_nav_mesh.GetEdgeTargets(current);
+        const auto portals = m_nav_mesh.GetEdgePortals(current);
+        for (uint32_t edge = 0; edge < targets.size(); edge++) {
+            const uint32_t next = targets[edge];
+            if (m_closed[next] == m_search_id) continue;
+
+            // Without a goal to steer toward, enter through the portal midpoint. Nearest portal points tie on
+            // staircase corridors and string-pull noticeably longer.
+            const NavPortal& portal = portals[edge];
+            const XMFLOAT2 entry((portal.a.x + portal.b.x) * 0.5f, (portal.a.y + portal.b.y) * 0.5f);
+            const float cost = current_cost + distance(current_point, entry);
+            if (m_visited[next] == m_search_id && cost >= m_cost[next]) continue;
+
+            m_visited[next] = m_search_id;
+            m_cost[next] = cost;
+            m_entry_point[next] = entry;
+            m_parent[next] = current;
+            m_parent_edge[next] = edge;
+            m_open.push_back({ cost, next });
+            std::push_heap(m_open.begin(), m_open.end(), heap_order);
+        }
+    }
+
+    m_tree_source = source;
+    m_tree_source_trap = source_trap;
+}
+
+float NavMeshQuery::GetTreeDistance(const XMFLOAT2& goal, uint32_t goal_trap)
+{
+    if (m_tree_source_trap == NAVMESH_INVALID_ID || goal_trap >= m_nav_mesh.GetTrapezoidCount()) return -1.0f;
+    if (m_closed[goal_trap] != m_search_id) return -1.0f;
+
+    m_corridor.clear();
+    for (uint32_t trap = goal_trap; m_parent[trap] != NAVMESH_INVALID_ID; trap = m_parent[trap]) {
+        m_corridor.push_back(trap);
+    }
+    std::reverse(m_corridor.begin(), m_corridor.end());
+    return StringPull(m_tree_source, goal, nullptr);
+}
+
+float NavMeshQuery::StringPull(const XMFLOAT2& start, const XMFLOAT2& goal, std::vector<XMFLOAT2>* points)
+{
+    // Portal list for the funnel: the start point, every crossed portal oriented left/right, the goal point.
+    m_portals.clear();
+    m_portals.push_back({ start, start });
+    for (uint32_t trap : m_corridor) {
+        const NavPortal& portal = m_nav_mesh.GetEdgePortals(m_parent[trap])[m_parent_edge[trap]];
+        const XMFLOAT2& inside = m_nav_mesh.GetCentroid(trap);
+        const XMFLOAT2 midpoint((portal.a.x + portal.b.x) * 0.5f, (portal.a.y + portal.b.y) * 0.5f);
+        // Walking from the portal into the next trapezoid, the left endpoint has a negative area.
+        if (triangle_area2(midpoint, inside, portal.a) < 0) {
+            m_portals.push_back(portal);
+        }
+        else {
+            m_portals.push_back({ portal.b, portal.a });
+        }
+    }
+    m_portals.push_back({ goal, goal });
+
+    float length = 0;
+    XMFLOAT2 last_point = start;
+    auto emit = [&](const XMFLOAT2& point) {
+        if (nearly_equal(last_point, point)) return;
+        length += distance(last_point, point);
+        last_point = point;
+        if (points) points->push_back(point);
+    };
+    if (points) points->push_back(start);
+
+    XMFLOAT2 apex = start;
+    XMFLOAT2 left = m_portals[0].a;
+    XMFLOAT2 right = m_portals[0].b;
+    size_t apex_index = 0;
+    size_t left_index = 0;
+    size_t right_index = 0;
+
+    for (size_t i = 1; i < m_portals.size(); i++) {
+        const XMFLOAT2& portal_left = m_portals[i].a;
+        const XMFLOAT2& portal_right = m_portals[i].b;
+
+        // Tighten the right side of the funnel.
+        if (triangle_area2(apex, right, portal_right) <= 0) {
+            if (nearly_equal(apex, right) || triangle_area2(apex, left, portal_right) > 0) {
+                right = portal_right;
+                right_index = i;
+            }
+            else {
+                // Right crossed over left, the left point becomes a corner of the path.
+                emit(left);
+                apex = left;
+                apex_index = left_index;
+                right = apex;
+                right_index = apex_index;
+                i = apex_index;
+                continue;
+            }
+        }
+
+        // Tighten the left side of the funnel.
+        if (triangle_area2(apex, left, portal_left) >= 0) {
+            if (nearly_equal(apex, left) || triangle_area2(apex, right, portal_left) < 0) {
+                left = portal_left;
+                left_index = i;
+            }
+            else {
+                emit(right);
+                apex = right;
+                apex_index = right_index;
+                left = apex;
+                left_index = apex_index;
+                i = apex_index;
+                continue;
+            }
+        }
+    }
+
+    emit(goal);
+    if (points && points->size() == 1) points->push_back(goal);
+    return length;
+}
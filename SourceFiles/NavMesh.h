@@ -0,0 +1,207 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <DirectXMath.h>
+#include "FFNA_MapFile.h"
+
+constexpr uint32_t NAVMESH_INVALID_ID = 0xFFFFFFFF;
+
+// Segment shared by two adjacent trapezoids, in map XY (world XZ) coordinates.
+struct NavPortal
+{
+    DirectX::XMFLOAT2 a;
+    DirectX::XMFLOAT2 b;
+};
+
+struct NavPath
+{
+    std::vector<DirectX::XMFLOAT2> points;   // String-pulled waypoints from start to goal
+    std::vector<uint32_t> corridor;          // Trapezoids crossed, start to goal
+    float length = 0;
+};
+
+/**
+ * @brief Walkability graph built from the trapezoids of a PathfindingChunk.
+ *
+ * Trapezoids of all planes are flattened in plane order (the same order as
+ * PathfindingChunk::all_trapezoids). Each plane has its own CSR adjacency list
+ * of the directed edges leaving its trapezoids, and each edge stores the portal
+ * segment shared by the two trapezoids. Edges within a plane come from the
+ * parsed neighbor indices, edges between planes from trapezoids whose
+ * portal-flagged sides coincide; those lead to a trapezoid of another plane.
+ *
+ * Point lookups go through a uniform grid per plane, built at load, whose cells
+ * list the trapezoids overlapping them.
+ */
+class NavMesh
+{
+public:
+    NavMesh() = default;
+    explicit NavMesh(const PathfindingChunk& pathfinding_chunk);
+
+    bool IsEmpty() const { return m_trapezoids.empty(); }
+    uint32_t GetTrapezoidCount() const { return static_cast<uint32_t>(m_trapezoids.size()); }
+    uint32_t GetPlaneCount() const { return m_plane_first.empty() ? 0 : static_cast<uint32_t>(m_plane_first.size() - 1); }
+    uint32_t GetEdgeCount() const { return m_edge_count; }
+
+    const PathfindingTrapezoid& GetTrapezoid(uint32_t id) const { return m_trapezoids[id]; }
+    uint32_t GetTrapezoidPlane(uint32_t id) const { return m_trapezoid_planes[id]; }
+    const DirectX::XMFLOAT2& GetCentroid(uint32_t id) const { return m_centroids[id]; }
+
+    // Directed edges leaving a trapezoid, from its plane's adjacency list. Targets and portals
+    // line up, an edge is its index in both.
+    std::span<const uint32_t> GetEdgeTargets(uint32_t id) const
+    {
+        const uint32_t plane = m_trapezoid_planes[id];
+        const PlaneGraph& graph = m_plane_graphs[plane];
+        const uint32_t first = graph.edge_offsets[id - m_plane_first[plane]];
+        const uint32_t end = graph.edge_offsets[id - m_plane_first[plane] + 1];
+        return { graph.edge_targets.data() + first, end - first };
+    }
+    std::span<const NavPortal> GetEdgePortals(uint32_t id) const
+    {
+        const uint32_t plane = m_trapezoid_planes[id];
+        const PlaneGraph& graph = m_plane_graphs[plane];
+        const uint32_t first = graph.edge_offsets[id - m_plane_first[plane]];
+        const uint32_t end = graph.edge_offsets[id - m_plane_first[plane] + 1];
+        return { graph.edge_portals.data() + first, end - first };
+    }
+
+    /**
+     * @brief Returns the trapezoid containing the point, or NAVMESH_INVALID_ID.
+     * @param plane Restricts the search to one plane, -1 searches all planes in order.
+     */
+    uint32_t FindTrapezoid(const DirectX::XMFLOAT2& point, int plane = -1) const;
+
+    /**
+     * @brief Returns the trapezoid closest to the point and the closest point on it.
+     *
+     * Points inside the walkable area are returned unchanged.
+     */
+    uint32_t FindNearestTrapezoid(const DirectX::XMFLOAT2& point, DirectX::XMFLOAT2& snapped_point) const;
+
+    /**
+     * @brief Batched FindTrapezoid, large batches are split across threads.
+     */
+    void FindTrapezoids(std::span<const DirectX::XMFLOAT2> points, std::span<uint32_t> trapezoids,
+        int plane = -1) const;
+
+    /**
+     * @brief Batched FindNearestTrapezoid, large batches are split across threads.
+     */
+    void FindNearestTrapezoids(std::span<const DirectX::XMFLOAT2> points, std::span<uint32_t> trapezoids,
+        std::span<DirectX::XMFLOAT2> snapped_points) const;
+
+    static bool ContainsPoint(const PathfindingTrapezoid& trap, const DirectX::XMFLOAT2& point);
+    static DirectX::XMFLOAT2 ClosestPoint(const PathfindingTrapezoid& trap, const DirectX::XMFLOAT2& point);
+
+private:
+    struct PlaneGrid
+    {
+        DirectX::XMFLOAT2 min{};
+        DirectX::XMFLOAT2 max{};
+        float cell_size = 1;
+        uint32_t cols = 0;
+        uint32_t rows = 0;
+        std::vector<uint32_t> cell_offsets;   // CSR offsets into cell_items, cols * rows + 1 entries
+        std::vector<uint32_t> cell_items;     // Trapezoid ids overlapping each cell
+    };
+
+    struct PlaneGraph
+    {
+        std::vector<uint32_t> edge_offsets;   // CSR offsets by trapezoid index within the plane, count + 1 entries
+        std::vector<uint32_t> edge_targets;   // Trapezoid ids, of another plane for links between planes
+        std::vector<NavPortal> edge_portals;
+    };
+
+    void BuildPlaneGrid(uint32_t plane);
+    uint32_t FindTrapezoidInPlane(const DirectX::XMFLOAT2& point, uint32_t plane) const;
+    void FindNearestInPlane(const DirectX::XMFLOAT2& point, uint32_t plane, uint32_t& best, float& best_distance,
+        DirectX::XMFLOAT2& snapped_point) const;
+
+    std::vector<PathfindingTrapezoid> m_trapezoids;
+    std::vector<uint32_t> m_trapezoid_planes;
+    std::vector<uint32_t> m_plane_first;
+    std::vector<DirectX::XMFLOAT2> m_centroids;
+
+    std::vector<PlaneGraph> m_plane_graphs;
+    uint32_t m_edge_count = 0;
+
+    std::vector<PlaneGrid> m_plane_grids;
+};
+
+/**
+ * @brief Reusable shortest-path query over a NavMesh.
+ *
+ * Runs A* between trapezoids, using the point where the line toward the goal
+ * crosses each portal as node position, and then string-pulls the resulting
+ * corridor with the funnel algorithm. Scratch buffers
+ * are reused between queries, so batches of queries don't allocate. A query
+ * object isn't thread safe, use one per thread.
+ */
+class NavMeshQuery
+{
+public:
+    explicit NavMeshQuery(const NavMesh& nav_mesh);
+
+    /**
+     * @brief Finds the shortest walkable path between two points.
+     *
+     * Points outside the walkable area are snapped to the nearest trapezoid first.
+     * @return false if the mesh is empty or the points aren't connected.
+     */
+    bool FindPath(const DirectX::XMFLOAT2& start, const DirectX::XMFLOAT2& goal, NavPath& path);
+
+    /**
+     * @brief Walk distance between two points, or a negative value when unreachable.
+     */
+    float FindDistance(const DirectX::XMFLOAT2& start, const DirectX::XMFLOAT2& goal);
+
+    /**
+     * @brief Builds a shortest path tree (Dijkstra) from a source point on the mesh.
+     *
+     * The tree answers GetTreeDistance for any number of goals without searching again.
+     * When target trapezoids are given, the search stops once all of them are settled.
+     * @param source_trap Trapezoid containing the source, e.g. from NavMesh::FindNearestTrapezoids.
+     */
+    void BuildDistanceTree(const DirectX::XMFLOAT2& source, uint32_t source_trap,
+        std::span<const uint32_t> target_trapezoids = {});
+
+    /**
+     * @brief Walk distance from the last tree's source to a goal, or a negative value when unreachable.
+     */
+    float GetTreeDistance(const DirectX::XMFLOAT2& goal, uint32_t goal_trap);
+
+private:
+    void BeginSearch();
+    bool FindCorridor(uint32_t start_trap, uint32_t goal_trap, const DirectX::XMFLOAT2& start,
+        const DirectX::XMFLOAT2& goal);
+    float StringPull(const DirectX::XMFLOAT2& start, const DirectX::XMFLOAT2& goal,
+        std::vector<DirectX::XMFLOAT2>* points);
+
+    struct OpenEntry
+    {
+        float f;
+        uint32_t trap;
+    };
+
+    const NavMesh& m_nav_mesh;
+
+    // Per trapezoid search state, valid only where m_visited == m_search_id.
+    std::vector<float> m_cost;
+    std::vector<DirectX::XMFLOAT2> m_entry_point;
+    std::vector<uint32_t> m_parent;
+    std::vector<uint32_t> m_parent_edge;    // Index of the edge from the parent, into its GetEdgeTargets
+    std::vector<uint32_t> m_visited;
+    std::vector<uint32_t> m_closed;
+    std::vector<uint32_t> m_target;
+    uint32_t m_search_id = 0;
+
+    DirectX::XMFLOAT2 m_tree_source{};
+    uint32_t m_tree_source_trap = NAVMESH_INVALID_ID;
+
+    std::vector<OpenEntry> m_open;
+    std::vector<uint32_t> m_corridor;   // Trapezoids entered after the start, in order
+    std::vector<NavPortal> m_portals;   // Oriented (a = left, b = right) along the corridor
+};
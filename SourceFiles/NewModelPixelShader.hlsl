@@ -81,6 +81,8 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
 struct PSOutput
@@ -166,11 +168,11 @@ PSOutput main(PixelInputType input)
 
     float3 final_color = lighting_color * sampled_texture_color.rgb;
     
-    if (highlight_state == 1)
+    if (input.highlight_state == 1)
     {
         final_color.rgb = lerp(final_color.rgb, DARKGREEN, 0.7);
     }
-    else if (highlight_state == 2)
+    else if (input.highlight_state == 2)
     {
         final_color.rgb = lerp(final_color.rgb, LIGHTGREEN, 0.4);
     }
@@ -224,9 +226,9 @@ PSOutput main(PixelInputType input)
     output.rt_0_output = float4(final_color, sampled_texture_color.a);
 
 	float4 color_id = float4(0, 0, 0, 1);
-	color_id.r = (float) ((object_id & 0x00FF0000) >> 16) / 255.0f;
-	color_id.g = (float) ((object_id & 0x0000FF00) >> 8) / 255.0f;
-	color_id.b = (float) ((object_id & 0x000000FF)) / 255.0f;
+	color_id.r = (float) ((input.object_id & 0x00FF0000) >> 16) / 255.0f;
+	color_id.g = (float) ((input.object_id & 0x0000FF00) >> 8) / 255.0f;
+	color_id.b = (float) ((input.object_id & 0x000000FF)) / 255.0f;
 
     // Render target for picking
 	output.rt_1_output = color_id;
@@ -78,6 +78,8 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
 float3 compute_normalmap_lighting(const float3 normalmap_sample, const float3x3 TBN, const float3 pos)
@@ -162,11 +164,11 @@ float4 main(PixelInputType input) : SV_TARGET
 
     float3 final_color = lighting_color * sampled_texture_color.rgb;
     
-    if (highlight_state == 1)
+    if (input.highlight_state == 1)
     {
         final_color.rgb = lerp(final_color.rgb, DARKGREEN, 0.7);
     }
-    else if (highlight_state == 2)
+    else if (input.highlight_state == 2)
     {
         final_color.rgb = lerp(final_color.rgb, LIGHTGREEN, 0.4);
     }
@@ -87,6 +87,8 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
 struct PSOutput
@@ -102,15 +104,15 @@ PSOutput main(PixelInputType input)
     // Color by bone index mode (highlight_state == 3 or 4)
     // Vertex shader already computed the bone color in lightingColor
     // 3 = remapped skeleton bone, 4 = raw FA0 palette index
-    if (highlight_state == 3 || highlight_state == 4)
+    if (input.highlight_state == 3 || input.highlight_state == 4)
     {
         PSOutput output;
         output.rt_0_output = input.lightingColor;
 
         float4 colorId = float4(0, 0, 0, 1);
-        colorId.r = (float) ((object_id & 0x00FF0000) >> 16) / 255.0f;
-        colorId.g = (float) ((object_id & 0x0000FF00) >> 8) / 255.0f;
-        colorId.b = (float) ((object_id & 0x000000FF)) / 255.0f;
+        colorId.r = (float) ((input.object_id & 0x00FF0000) >> 16) / 255.0f;
+        colorId.g = (float) ((input.object_id & 0x0000FF00) >> 8) / 255.0f;
+        colorId.b = (float) ((input.object_id & 0x000000FF)) / 255.0f;
         output.rt_1_output = colorId;
 
         return output;
@@ -125,9 +127,9 @@ PSOutput main(PixelInputType input)
         output.rt_0_output = finalColor;
 
         float4 colorId = float4(0, 0, 0, 1);
-        colorId.r = (float) ((object_id & 0x00FF0000) >> 16) / 255.0f;
-        colorId.g = (float) ((object_id & 0x0000FF00) >> 8) / 255.0f;
-        colorId.b = (float) ((object_id & 0x000000FF)) / 255.0f;
+        colorId.r = (float) ((input.object_id & 0x00FF0000) >> 16) / 255.0f;
+        colorId.g = (float) ((input.object_id & 0x0000FF00) >> 8) / 255.0f;
+        colorId.b = (float) ((input.object_id & 0x000000FF)) / 255.0f;
         output.rt_1_output = colorId;
 
         return output;
@@ -219,11 +221,11 @@ PSOutput main(PixelInputType input)
 
     finalColor.a = a;
     
-    if (highlight_state == 1)
+    if (input.highlight_state == 1)
     {
         finalColor.rgb = lerp(finalColor.rgb, DARKGREEN, 0.7);
     }
-    else if (highlight_state == 2)
+    else if (input.highlight_state == 2)
     {
         finalColor.rgb = lerp(finalColor.rgb, LIGHTGREEN, 0.4);
     }
@@ -278,9 +280,9 @@ PSOutput main(PixelInputType input)
     output.rt_0_output = finalColor;
 
     float4 colorId = float4(0, 0, 0, 1);
-    colorId.r = (float) ((object_id & 0x00FF0000) >> 16) / 255.0f;
-    colorId.g = (float) ((object_id & 0x0000FF00) >> 8) / 255.0f;
-    colorId.b = (float) ((object_id & 0x000000FF)) / 255.0f;
+    colorId.r = (float) ((input.object_id & 0x00FF0000) >> 16) / 255.0f;
+    colorId.g = (float) ((input.object_id & 0x0000FF00) >> 8) / 255.0f;
+    colorId.b = (float) ((input.object_id & 0x000000FF)) / 255.0f;
 
     // Render target for picking
     output.rt_1_output = colorId;
@@ -80,6 +80,8 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
 float4 main(PixelInputType input) : SV_TARGET
@@ -174,11 +176,11 @@ float4 main(PixelInputType input) : SV_TARGET
 
     finalColor.a = a;
     
-    if (highlight_state == 1)
+    if (input.highlight_state == 1)
     {
         finalColor.rgb = lerp(finalColor.rgb, DARKGREEN, 0.7);
     }
-    else if (highlight_state == 2)
+    else if (input.highlight_state == 2)
     {
         finalColor.rgb = lerp(finalColor.rgb, LIGHTGREEN, 0.4);
     }
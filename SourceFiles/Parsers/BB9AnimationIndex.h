@@ -0,0 +1,804 @@
+#pragma once
+
+#include "BB9AnimationParser.h"
+#include "../Animation/AnimationController.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace GW::Parsers {
+
+/**
+ * @brief Byte ranges of one bone's keyframe streams inside a BB9/FA1 chunk.
+ *
+ * Recorded by the index pass so a bone (or a sequence of a bone) can later be
+ * decoded without walking the streams of the bones before it.
+ */
+struct BB9BoneStreamIndex
+{
+    size_t posTimesOffset = 0;
+    size_t posValuesOffset = 0;
+    size_t rotTimesOffset = 0;
+    size_t rotValuesOffset = 0;
+    size_t scaleTimesOffset = 0;
+    size_t scaleValuesOffset = 0;
+
+    uint16_t posKeyCount = 0;
+    uint16_t rotKeyCount = 0;
+    uint16_t scaleKeyCount = 0;
+
+    // False if the streams run past the end of the chunk (decoded as an empty track)
+    bool complete = false;
+
+    // Keyframe time range, same semantics as BoneTrack::GetTimeRange
+    float minTime = 0.0f;
+    float maxTime = 0.0f;
+};
+
+/**
+ * @brief Two-phase BB9/FA1 animation parser.
+ *
+ * Build() runs a cheap pass over the chunk that reads the header, sequences and
+ * skeleton (base positions, hierarchy, intermediate flags) and records the byte
+ * range of every bone's key streams. Only the keyframe times are decoded in this
+ * pass (they are needed for the sequence time ranges), the position, rotation and
+ * scale values are skipped.
+ *
+ * Keyframe values are decoded on first use, either for the whole clip or only for
+ * the keys covering a single sequence, so playing sequence 12 of 40 does not
+ * convert the keys of the other 39.
+ *
+ * The FA1 bit-stream keyframe format (see BB9AnimationParser::ParseFA1KeyframeFormat)
+ * is already indexed by the file's own bit offset table and is small, it is decoded
+ * eagerly during Build() and only sliced per sequence.
+ */
+class BB9AnimationIndex : public std::enable_shared_from_this<BB9AnimationIndex>
+{
+public:
+    /**
+     * @brief Indexes the BB9 or FA1 animation chunk of an FFNA file.
+     *
+     * The chunk bytes are copied, so fileData can be freed after this returns.
+     *
+     * @param fileData Complete FFNA file data.
+     * @param fileSize File size in bytes.
+     * @return The index, or nullptr if the file has no parsable animation chunk.
+     */
+    static std::shared_ptr<BB9AnimationIndex> Build(const uint8_t* fileData, size_t fileSize)
+    {
+        if (fileSize < 5 || fileData[0] != 'f' || fileData[1] != 'f' ||
+            fileData[2] != 'n' || fileData[3] != 'a')
+        {
+            return nullptr;
+        }
+
+        size_t chunkOffset, chunkSize;
+        bool isFA1 = false;
+        if (!FindChunk(fileData, fileSize, CHUNK_ID_BB9, chunkOffset, chunkSize))
+        {
+            if (!FindChunk(fileData, fileSize, CHUNK_ID_FA1, chunkOffset, chunkSize))
+            {
+                return nullptr;
+            }
+            isFA1 = true;
+        }
+
+        chunkSize = std::min(chunkSize, fileSize - std::min(chunkOffset, fileSize));
+
+        auto index = std::make_shared<BB9AnimationIndex>();
+        index->m_chunk.assign(fileData + chunkOffset, fileData + chunkOffset + chunkSize);
+
+        bool ok = isFA1 ? index->IndexFA1() : index->IndexBB9();
+        if (!ok)
+        {
+            return nullptr;
+        }
+
+        return index;
+    }
+
+    /**
+     * @brief Creates a clip with header, sequence and skeleton data but no keyframes.
+     *
+     * The clip's time ranges are already valid, so it can be passed to
+     * CreateSkeleton() and AnimationController::Initialize() directly.
+     */
+    std::shared_ptr<Animation::AnimationClip> CreateClip() const
+    {
+        return std::make_shared<Animation::AnimationClip>(m_shell);
+    }
+
+    /**
+     * @brief Gets the header/skeleton-only clip built by the index pass.
+     */
+    const Animation::AnimationClip& GetShell() const { return m_shell; }
+
+    size_t GetBoneCount() const { return m_shell.boneTracks.size(); }
+    size_t GetSequenceCount() const { return m_shell.sequences.size(); }
+
+    /**
+     * @brief Decodes the keyframes of one bone that cover [startTime, endTime].
+     *
+     * The returned track contains the last key at or before startTime through the
+     * first key at or after endTime, so evaluation inside the range is identical
+     * to evaluating the fully decoded track.
+     */
+    Animation::BoneTrack DecodeBoneTrack(size_t boneIndex, float startTime = -FLT_MAX, float endTime = FLT_MAX) const
+    {
+        Animation::BoneTrack track;
+        if (boneIndex >= m_shell.boneTracks.size())
+        {
+            return track;
+        }
+
+        track.boneIndex = m_shell.boneTracks[boneIndex].boneIndex;
+        track.basePosition = m_shell.boneTracks[boneIndex].basePosition;
+
+        if (!m_eagerTracks.empty())
+        {
+            const Animation::BoneTrack& src = m_eagerTracks[boneIndex];
+            track.positionKeys = SliceKeys(src.positionKeys, startTime, endTime);
+            track.rotationKeys = SliceKeys(src.rotationKeys, startTime, endTime);
+            track.scaleKeys = SliceKeys(src.scaleKeys, startTime, endTime);
+            return track;
+        }
+
+        if (boneIndex >= m_bones.size() || !m_bones[boneIndex].complete)
+        {
+            return track;
+        }
+
+        const BB9BoneStreamIndex& bone = m_bones[boneIndex];
+        const uint8_t* data = m_chunk.data();
+        const size_t dataSize = m_chunk.size();
+
+        try
+        {
+            if (bone.posKeyCount > 0)
+            {
+                VLEDecoder decoder(data, dataSize, bone.posTimesOffset);
+                auto times = decoder.ExpandUnsignedDeltaVLE(bone.posKeyCount);
+                auto [first, last] = FindKeyRange(times, startTime, endTime);
+
+                decoder.SetOffset(bone.posValuesOffset);
+                auto positions = decoder.ReadFloat3Range(bone.posKeyCount, first, last);
+
+                track.positionKeys.reserve(positions.size());
+                for (uint32_t i = first; i < last; i++)
+                {
+                    const XMFLOAT3& p = positions[i - first];
+                    // Apply coordinate transform: (x, y, z) -> (x, -z, y), as in BB9AnimationParser::Parse
+                    track.positionKeys.push_back({static_cast<float>(times[i]), {p.x, -p.z, p.y}});
+                }
+            }
+
+            if (bone.rotKeyCount > 0)
+            {
+                VLEDecoder decoder(data, dataSize, bone.rotTimesOffset);
+                auto times = decoder.ExpandUnsignedDeltaVLE(bone.rotKeyCount);
+                auto [first, last] = FindKeyRange(times, startTime, endTime);
+
+                decoder.SetOffset(bone.rotValuesOffset);
+                auto rotations = decoder.DecompressQuaternionKeyRange(bone.rotKeyCount, first, last);
+
+                track.rotationKeys.reserve(rotations.size());
+                for (uint32_t i = first; i < last; i++)
+                {
+                    track.rotationKeys.push_back({static_cast<float>(times[i]), rotations[i - first]});
+                }
+            }
+
+            if (bone.scaleKeyCount > 0)
+            {
+                VLEDecoder decoder(data, dataSize, bone.scaleTimesOffset);
+                auto times = decoder.ExpandUnsignedDeltaVLE(bone.scaleKeyCount);
+                auto [first, last] = FindKeyRange(times, startTime, endTime);
+
+                decoder.SetOffset(bone.scaleValuesOffset);
+                auto scales = decoder.ReadFloat3Range(bone.scaleKeyCount, first, last);
+
+                track.scaleKeys.reserve(scales.size());
+                for (uint32_t i = first; i < last; i++)
+                {
+                    track.scaleKeys.push_back({static_cast<float>(times[i]), scales[i - first]});
+                }
+            }
+        }
+        catch (const std::exception&)
+        {
+            // The index pass validated the ranges, so this only happens on corrupt data
+            track.positionKeys.clear();
+            track.rotationKeys.clear();
+            track.scaleKeys.clear();
+        }
+
+        return track;
+    }
+
+    /**
+     * @brief Adds the keyframes needed to play one sequence to clip's bone tracks.
+     *
+     * Keys of sequences loaded before are kept, so any loaded sequence still plays.
+     *
+     * @param clip Clip created by CreateClip().
+     * @param sequenceIndex Sequence to load, or SIZE_MAX (or an invalid index) for the whole clip.
+     */
+    void LoadSequence(Animation::AnimationClip& clip, size_t sequenceIndex) const
+    {
+        float startTime = -FLT_MAX;
+        float endTime = FLT_MAX;
+        if (sequenceIndex < m_shell.sequences.size())
+        {
+            startTime = m_shell.sequences[sequenceIndex].startTime;
+            endTime = m_shell.sequences[sequenceIndex].endTime;
+        }
+
+        if (clip.boneTracks.size() != m_shell.boneTracks.size())
+        {
+            clip.boneTracks = m_shell.boneTracks;
+        }
+
+        for (size_t boneIdx = 0; boneIdx < clip.boneTracks.size(); boneIdx++)
+        {
+            Animation::BoneTrack decoded = DecodeBoneTrack(boneIdx, startTime, endTime);
+            Animation::BoneTrack& track = clip.boneTracks[boneIdx];
+            MergeKeys(track.positionKeys, std::move(decoded.positionKeys));
+            MergeKeys(track.rotationKeys, std::move(decoded.rotationKeys));
+            MergeKeys(track.scaleKeys, std::move(decoded.scaleKeys));
+        }
+    }
+
+    /**
+     * @brief Decodes every keyframe, equivalent to BB9AnimationParser::Parse/ParseFA1.
+     */
+    Animation::AnimationClip DecodeAll() const
+    {
+        Animation::AnimationClip clip = m_shell;
+        LoadSequence(clip, SIZE_MAX);
+        return clip;
+    }
+
+    /**
+     * @brief Creates a loader for AnimationController that decodes sequences on demand.
+     *
+     * The loader keeps the index (and its copy of the chunk) alive. Sequences
+     * already loaded into the clip are not decoded again.
+     */
+    Animation::AnimationController::SequenceLoader CreateSequenceLoader()
+    {
+        std::shared_ptr<const BB9AnimationIndex> self = shared_from_this();
+        auto loadedSequences = std::make_shared<std::vector<bool>>(GetSequenceCount(), false);
+        auto loadedAll = std::make_shared<bool>(false);
+
+        return [self, loadedSequences, loadedAll](Animation::AnimationClip& clip, size_t sequenceIndex)
+        {
+            const bool isSequence = sequenceIndex < loadedSequences->size();
+            if (*loadedAll || (isSequence && (*loadedSequences)[sequenceIndex]))
+            {
+                return;
+            }
+
+            self->LoadSequence(clip, sequenceIndex);
+            if (isSequence)
+            {
+                (*loadedSequences)[sequenceIndex] = true;
+            }
+            else
+            {
+                *loadedAll = true;
+            }
+        };
+    }
+
+private:
+    /**
+     * @brief Finds the key range [first, last) covering [startTime, endTime].
+     */
+    static std::pair<uint32_t, uint32_t> FindKeyRange(const std::vector<uint32_t>& times, float startTime, float endTime)
+    {
+        const uint32_t count = static_cast<uint32_t>(times.size());
+        if (count == 0)
+        {
+            return {0, 0};
+        }
+
+        // Last key at or before startTime
+        uint32_t first = 0;
+        while (first + 1 < count && static_cast<float>(times[first + 1]) <= startTime)
+        {
+            first++;
+        }
+
+        // First key at or after endTime
+        uint32_t last = first;
+        while (last + 1 < count && static_cast<float>(times[last]) < endTime)
+        {
+            last++;
+        }
+
+        return {first, last + 1};
+    }
+
+    template<typename T>
+    static std::vector<Animation::Keyframe<T>> SliceKeys(const std::vector<Animation::Keyframe<T>>& keys,
+                                                         float startTime, float endTime)
+    {
+        if (keys.empty())
+        {
+            return {};
+        }
+
+        size_t first = 0;
+        while (first + 1 < keys.size() && keys[first + 1].time <= startTime)
+        {
+            first++;
+        }
+
+        size_t last = first;
+        while (last + 1 < keys.size() && keys[last].time < endTime)
+        {
+            last++;
+        }
+
+        return std::vector<Animation::Keyframe<T>>(keys.begin() + first, keys.begin() + last + 1);
+    }
+
+    /**
+     * @brief Merges a slice of a track's keys into the keys loaded so far.
+     *
+     * Both are slices of the same sorted keys, so the loaded keys inside the
+     * slice's time range are the slice's own and are replaced by it.
+     */
+    template<typename T>
+    static void MergeKeys(std::vector<Animation::Keyframe<T>>& keys, std::vector<Animation::Keyframe<T>>&& slice)
+    {
+        if (keys.empty())
+        {
+            keys = std::move(slice);
+            return;
+        }
+        if (slice.empty())
+        {
+            return;
+        }
+
+        const auto before = std::find_if(keys.begin(), keys.end(),
+            [&](const auto& key) { return key.time >= slice.front().time; });
+        const auto after = std::find_if(before, keys.end(),
+            [&](const auto& key) { return key.time > slice.back().time; });
+
+        std::vector<Animation::Keyframe<T>> merged;
+        merged.reserve((before - keys.begin()) + slice.size() + (keys.end() - after));
+        merged.insert(merged.end(), keys.begin(), before);
+        merged.insert(merged.end(), slice.begin(), slice.end());
+        merged.insert(merged.end(), after, keys.end());
+        keys = std::move(merged);
+    }
+
+    /**
+     * @brief Decodes a delta-of-delta time stream, keeping only the first and last time.
+     */
+    static bool ScanTimes(VLEDecoder& decoder, uint32_t count, float& outFirst, float& outLast)
+    {
+        int32_t last1 = 0;
+        int32_t last2 = 0;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t rawValue;
+            bool signPositive;
+            if (!decoder.TryReadVLEValue(rawValue, signPositive))
+            {
+                return false;
+            }
+
+            int32_t delta = signPositive ? static_cast<int32_t>(rawValue) : -static_cast<int32_t>(rawValue);
+            int32_t newValue = (last1 * 2 - last2) + delta;
+
+            if (i == 0)
+            {
+                outFirst = static_cast<float>(static_cast<uint32_t>(newValue));
+            }
+            last2 = last1;
+            last1 = newValue;
+        }
+
+        outLast = static_cast<float>(static_cast<uint32_t>(last1));
+        return true;
+    }
+
+    /**
+     * @brief Records the stream offsets of one bone, skipping all keyframe values.
+     *
+     * @return false if the streams run past the end of the chunk.
+     */
+    static bool IndexBoneStreams(VLEDecoder& decoder, const BB9BoneAnimHeader& boneHeader, BB9BoneStreamIndex& bone)
+    {
+        bone.posKeyCount = boneHeader.posKeyCount;
+        bone.rotKeyCount = boneHeader.rotKeyCount;
+        bone.scaleKeyCount = boneHeader.scaleKeyCount;
+
+        float minTime = FLT_MAX;
+        float maxTime = 0.0f;
+        float first = 0.0f, last = 0.0f;
+
+        bone.posTimesOffset = decoder.GetOffset();
+        if (bone.posKeyCount > 0)
+        {
+            if (!ScanTimes(decoder, bone.posKeyCount, first, last)) return false;
+            minTime = std::min(minTime, first);
+            maxTime = std::max(maxTime, last);
+        }
+        bone.posValuesOffset = decoder.GetOffset();
+        if (!decoder.TrySkipFloat3s(bone.posKeyCount)) return false;
+
+        bone.rotTimesOffset = decoder.GetOffset();
+        if (bone.rotKeyCount > 0)
+        {
+            if (!ScanTimes(decoder, bone.rotKeyCount, first, last)) return false;
+            minTime = std::min(minTime, first);
+            maxTime = std::max(maxTime, last);
+        }
+        bone.rotValuesOffset = decoder.GetOffset();
+        if (!decoder.TrySkipSignedDeltaVLEs(static_cast<uint32_t>(bone.rotKeyCount) * 3)) return false;
+
+        bone.scaleTimesOffset = decoder.GetOffset();
+        if (bone.scaleKeyCount > 0)
+        {
+            if (!ScanTimes(decoder, bone.scaleKeyCount, first, last)) return false;
+            minTime = std::min(minTime, first);
+            maxTime = std::max(maxTime, last);
+        }
+        bone.scaleValuesOffset = decoder.GetOffset();
+        if (!decoder.TrySkipFloat3s(bone.scaleKeyCount)) return false;
+
+        bone.minTime = (minTime == FLT_MAX) ? 0.0f : minTime;
+        bone.maxTime = maxTime;
+        bone.complete = true;
+        return true;
+    }
+
+    /**
+     * @brief Adds a bone to the shell clip (no keyframes).
+     */
+    void AddShellBone(uint32_t boneIdx, const XMFLOAT3& basePosition, bool isIntermediate)
+    {
+        Animation::BoneTrack track;
+        track.boneIndex = boneIdx;
+        track.basePosition = basePosition;
+        m_shell.boneTracks.push_back(std::move(track));
+        m_shell.boneIsIntermediate.push_back(isIntermediate);
+    }
+
+    /**
+     * @brief Computes the clip time ranges from the indexed per-bone ranges.
+     *
+     * Mirrors AnimationClip::ComputeTimeRange() on fully decoded tracks.
+     */
+    void ComputeTimeRanges()
+    {
+        if (!m_eagerTracks.empty())
+        {
+            Animation::AnimationClip timing;
+            timing.boneTracks = m_eagerTracks;
+            timing.ComputeTimeRange();
+            m_shell.minTime = timing.minTime;
+            m_shell.maxTime = timing.maxTime;
+            m_shell.duration = timing.duration;
+        }
+        else
+        {
+            float minTime = FLT_MAX;
+            float maxTime = 0.0f;
+            for (const auto& bone : m_bones)
+            {
+                minTime = std::min(minTime, bone.complete ? bone.minTime : 0.0f);
+                maxTime = std::max(maxTime, bone.complete ? bone.maxTime : 0.0f);
+            }
+            m_shell.minTime = (minTime == FLT_MAX) ? 0.0f : minTime;
+            m_shell.maxTime = maxTime;
+            m_shell.duration = m_shell.maxTime - m_shell.minTime;
+        }
+
+        m_shell.ComputeSequenceTimeRanges();
+    }
+
+    static Animation::AnimationSequence MakeSequence(const BB9SequenceEntry& entry, size_t index)
+    {
+        Animation::AnimationSequence seq;
+        seq.hash = entry.animationId;
+        seq.name = "seq_" + std::to_string(index);
+        seq.frameCount = entry.frameCount;
+        seq.sequenceIndex = entry.sequenceIndex;
+        seq.bounds = {entry.boundX, entry.boundY, entry.boundZ};
+        return seq;
+    }
+
+    /**
+     * @brief Index pass for BB9 chunks (see BB9AnimationParser::Parse).
+     */
+    bool IndexBB9()
+    {
+        const uint8_t* data = m_chunk.data();
+        const size_t dataSize = m_chunk.size();
+
+        if (dataSize < sizeof(BB9Header))
+        {
+            return false;
+        }
+
+        BB9Header header;
+        std::memcpy(&header, data, sizeof(BB9Header));
+
+        m_shell.modelHash0 = header.modelHash0;
+        m_shell.modelHash1 = header.modelHash1;
+
+        float headerScale;
+        std::memcpy(&headerScale, &header.reserved[2], sizeof(float));
+        bool needsAutoScale = !(headerScale > 0.001f && headerScale < 100.0f);
+        m_shell.geometryScale = needsAutoScale ? 1.0f : headerScale;
+
+        size_t offset = sizeof(BB9Header) + header.boundingCylinderCount * 16;
+
+        uint32_t cumulativeFrames = 0;
+        if (header.HasSequences())
+        {
+            if (offset + 4 > dataSize) return false;
+
+            uint32_t sequenceCount;
+            std::memcpy(&sequenceCount, &data[offset], sizeof(uint32_t));
+            offset += 4;
+
+            for (uint32_t i = 0; i < sequenceCount; i++)
+            {
+                if (offset + sizeof(BB9SequenceEntry) > dataSize) return false;
+
+                BB9SequenceEntry entry;
+                std::memcpy(&entry, &data[offset], sizeof(BB9SequenceEntry));
+                offset += sizeof(BB9SequenceEntry);
+
+                m_shell.sequences.push_back(MakeSequence(entry, i));
+                cumulativeFrames += entry.frameCount;
+            }
+        }
+        m_shell.totalFrames = cumulativeFrames > 0 ? cumulativeFrames : 100;
+
+        if (header.HasBoneTransforms())
+        {
+            if (offset + 8 > dataSize) return false;
+
+            uint32_t boneCount;
+            std::memcpy(&boneCount, &data[offset], sizeof(uint32_t));
+            offset += 8;
+
+            if (boneCount > 500)
+            {
+                return false;
+            }
+
+            VLEDecoder decoder(data, dataSize, offset);
+            std::vector<uint8_t> boneDepths;
+            int errorsInRow = 0;
+            m_bones.reserve(boneCount);
+
+            for (uint32_t boneIdx = 0; boneIdx < boneCount; boneIdx++)
+            {
+                if (decoder.RemainingBytes() < sizeof(BB9BoneAnimHeader))
+                {
+                    break;
+                }
+
+                BB9BoneAnimHeader boneHeader;
+                std::memcpy(&boneHeader, &data[decoder.GetOffset()], sizeof(BB9BoneAnimHeader));
+                decoder.SetOffset(decoder.GetOffset() + sizeof(BB9BoneAnimHeader));
+
+                if (boneHeader.posKeyCount > 10000 || boneHeader.rotKeyCount > 10000 ||
+                    boneHeader.scaleKeyCount > 10000)
+                {
+                    break;
+                }
+
+                constexpr uint32_t FLAG_INTERMEDIATE_BONE = 0x10000000;
+                bool isIntermediate = (boneHeader.boneFlags & FLAG_INTERMEDIATE_BONE) != 0;
+
+                BB9BoneStreamIndex bone;
+                if (IndexBoneStreams(decoder, boneHeader, bone))
+                {
+                    errorsInRow = 0;
+                }
+                else
+                {
+                    errorsInRow++;
+                    if (errorsInRow > 3)
+                    {
+                        break;  // Too many consecutive errors, as in BB9AnimationParser::Parse
+                    }
+
+                    // Truncated streams, decoded as an empty track
+                    bone.complete = false;
+                }
+
+                AddShellBone(boneIdx, {boneHeader.baseX, -boneHeader.baseZ, boneHeader.baseY}, isIntermediate);
+                boneDepths.push_back(boneHeader.GetHierarchyDepth());
+                m_bones.push_back(bone);
+            }
+
+            Animation::HierarchyMode hierarchyMode = Animation::HierarchyMode::TreeDepth;
+            BB9AnimationParser::ComputeBoneParents(m_shell.boneParents, boneDepths, nullptr, &hierarchyMode);
+            m_shell.hierarchyMode = hierarchyMode;
+            m_shell.BuildOutputMapping();
+        }
+
+        ComputeTimeRanges();
+        return true;
+    }
+
+    /**
+     * @brief Index pass for FA1 chunks (see BB9AnimationParser::ParseFA1).
+     */
+    bool IndexFA1()
+    {
+        const uint8_t* data = m_chunk.data();
+        const size_t dataSize = m_chunk.size();
+
+        if (dataSize < sizeof(FA1Header))
+        {
+            return false;
+        }
+
+        FA1Header header;
+        std::memcpy(&header, data, sizeof(FA1Header));
+
+        m_shell.modelHash0 = header.boundingBoxId;
+        m_shell.modelHash1 = header.collisionMeshId;
+
+        float headerScale = header.geometryScale;
+        bool needsAutoScale = !(headerScale > 0.001f && headerScale < 100.0f);
+        m_shell.geometryScale = needsAutoScale ? 1.0f : headerScale;
+
+        size_t offset = sizeof(FA1Header) + header.boundingCylinderCount * 16;
+
+        if (header.HasAnimationSequences() && header.sequenceCount0 > 0)
+        {
+            for (uint16_t i = 0; i < header.sequenceCount0; i++)
+            {
+                if (offset + sizeof(BB9SequenceEntry) > dataSize) break;
+
+                BB9SequenceEntry entry;
+                std::memcpy(&entry, &data[offset], sizeof(BB9SequenceEntry));
+                offset += sizeof(BB9SequenceEntry);
+
+                m_shell.sequences.push_back(MakeSequence(entry, i));
+            }
+        }
+
+        uint32_t cumulativeFrames = 0;
+        for (const auto& seq : m_shell.sequences)
+        {
+            cumulativeFrames += seq.frameCount;
+        }
+        m_shell.totalFrames = cumulativeFrames > 0 ? cumulativeFrames : 100;
+
+        bool hasBindPose = header.bindPoseBoneCount > 0 && header.bindPoseBoneCount < 256;
+        bool hasSkeletonData = header.HasSkeleton() || hasBindPose;
+        if (hasSkeletonData && offset < dataSize)
+        {
+            size_t bindPoseOffset = offset;
+            if (hasBindPose)
+            {
+                offset += header.bindPoseBoneCount * sizeof(FA1BindPoseEntry);
+            }
+
+            bool useFA1KeyframeFormat = false;
+            if (offset + sizeof(FA1KeyframeHeader) <= dataSize)
+            {
+                FA1KeyframeHeader testHeader;
+                std::memcpy(&testHeader, &data[offset], sizeof(FA1KeyframeHeader));
+                useFA1KeyframeFormat = testHeader.IsValid();
+            }
+
+            std::vector<uint8_t> boneDepths;
+
+            if (useFA1KeyframeFormat)
+            {
+                Animation::AnimationClip decoded;
+                if (BB9AnimationParser::ParseFA1KeyframeFormat(data, dataSize, bindPoseOffset, offset,
+                                                               header.bindPoseBoneCount, decoded, boneDepths))
+                {
+                    m_eagerTracks = std::move(decoded.boneTracks);
+                    for (const auto& track : m_eagerTracks)
+                    {
+                        AddShellBone(track.boneIndex, track.basePosition, false);
+                    }
+                }
+                else
+                {
+                    boneDepths.clear();
+                    useFA1KeyframeFormat = false;
+                }
+            }
+
+            if (!useFA1KeyframeFormat)
+            {
+                IndexBB9StyleBones(offset, boneDepths);
+            }
+
+            Animation::HierarchyMode hierarchyMode = Animation::HierarchyMode::TreeDepth;
+            BB9AnimationParser::ComputeBoneParents(m_shell.boneParents, boneDepths, nullptr, &hierarchyMode);
+            m_shell.hierarchyMode = hierarchyMode;
+            m_shell.BuildOutputMapping();
+        }
+
+        ComputeTimeRanges();
+        return true;
+    }
+
+    /**
+     * @brief Index pass for BB9-style bone headers in FA1 chunks
+     * (see BB9AnimationParser::ParseBB9StyleBoneAnimations).
+     */
+    void IndexBB9StyleBones(size_t offset, std::vector<uint8_t>& boneDepths)
+    {
+        const uint8_t* data = m_chunk.data();
+        const size_t dataSize = m_chunk.size();
+
+        VLEDecoder decoder(data, dataSize, offset);
+        int errorsInRow = 0;
+        uint32_t boneIdx = 0;
+        const uint32_t maxBones = 256;
+
+        while (decoder.RemainingBytes() >= sizeof(BB9BoneAnimHeader) &&
+               boneIdx < maxBones &&
+               errorsInRow < 3)
+        {
+            BB9BoneAnimHeader boneHeader;
+            std::memcpy(&boneHeader, &data[decoder.GetOffset()], sizeof(BB9BoneAnimHeader));
+
+            bool keyCountsValid = (boneHeader.posKeyCount <= 1000 &&
+                                   boneHeader.rotKeyCount <= 1000 &&
+                                   boneHeader.scaleKeyCount <= 1000);
+
+            bool posValid = std::isfinite(boneHeader.baseX) &&
+                            std::isfinite(boneHeader.baseY) &&
+                            std::isfinite(boneHeader.baseZ) &&
+                            std::abs(boneHeader.baseX) < 100000.0f &&
+                            std::abs(boneHeader.baseY) < 100000.0f &&
+                            std::abs(boneHeader.baseZ) < 100000.0f;
+
+            if (!keyCountsValid || (!posValid && boneIdx > 0))
+            {
+                break;
+            }
+
+            decoder.SetOffset(decoder.GetOffset() + sizeof(BB9BoneAnimHeader));
+
+            AddShellBone(boneIdx, {boneHeader.baseX, -boneHeader.baseZ, boneHeader.baseY}, false);
+            boneDepths.push_back(boneHeader.GetHierarchyDepth());
+
+            BB9BoneStreamIndex bone;
+            if (IndexBoneStreams(decoder, boneHeader, bone))
+            {
+                errorsInRow = 0;
+            }
+            else
+            {
+                bone.complete = false;
+                errorsInRow++;
+            }
+            m_bones.push_back(bone);
+            boneIdx++;
+        }
+    }
+
+private:
+    std::vector<uint8_t> m_chunk;                    // Copy of the BB9/FA1 chunk data
+    Animation::AnimationClip m_shell;                // Header/sequence/skeleton data, no keyframes
+    std::vector<BB9BoneStreamIndex> m_bones;         // Per-bone stream ranges (BB9-style layouts)
+    std::vector<Animation::BoneTrack> m_eagerTracks; // Decoded tracks (FA1 bit-stream layout)
+};
+
+} // namespace GW::Parsers
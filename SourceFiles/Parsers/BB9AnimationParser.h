@@ -242,6 +242,8 @@ struct FA1KeyframeHeader
 
 static_assert(sizeof(FA1KeyframeHeader) == 16, "FA1KeyframeHeader must be 16 bytes!");
 
+class BB9AnimationIndex;
+
 /**
  * @brief Parser for BB9/FA1 animation chunks.
  *
@@ -254,6 +256,9 @@ static_assert(sizeof(FA1KeyframeHeader) == 16, "FA1KeyframeHeader must be 16 byt
  */
 class BB9AnimationParser
 {
+    // The two-phase parser reuses the hierarchy and FA1 keyframe decoding
+    friend class BB9AnimationIndex;
+
 public:
     /**
      * @brief Parses FA1 bind pose entries and extracts parent array.
@@ -696,6 +701,25 @@ private:
 
             uint32_t ReadVLEValue(bool* outSign = nullptr)
             {
+                // Fast path: the value (5 bytes max) lies fully inside the range and the
+                // buffer, decode it from one unaligned 64-bit load shifted to the bit offset
+                size_t byteIndex = bitOffset / 8;
+                if (byteIndex + 8 <= dataSize && bitOffset + 40 <= bitEnd)
+                {
+                    uint64_t word;
+                    std::memcpy(&word, &data[byteIndex], sizeof(word));
+                    word >>= (bitOffset % 8);
+
+                    uint32_t value;
+                    bool sign;
+                    bitOffset += VLEDecoder::DecodeVLEWord(word, value, sign) * 8;
+                    if (outSign)
+                    {
+                        *outSign = sign;
+                    }
+                    return value;
+                }
+
                 uint8_t b = ReadByte();
                 uint32_t value = b & 0x3F;
 
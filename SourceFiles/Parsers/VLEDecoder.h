@@ -5,6 +5,10 @@
 #include <cstdint>
 #include <cmath>
 #include <stdexcept>
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <bit>
 
 using namespace DirectX;
 
@@ -22,6 +26,10 @@ namespace GW::Parsers {
  *
  * The continue bit (0x80) indicates more bytes follow.
  * For signed values, bit 0x40 indicates the sign.
+ *
+ * Values are decoded from 64-bit word loads (see DecodeVLEWord) and bounds are
+ * checked once per block of values where possible. The Try* methods report
+ * truncated data through their return value and HasError() instead of throwing.
  */
 class VLEDecoder
 {
@@ -53,6 +61,18 @@ public:
      */
     size_t RemainingBytes() const { return m_offset < m_dataSize ? m_dataSize - m_offset : 0; }
 
+    /**
+     * @brief Checks if a Try* read has failed (exception-free error channel).
+     *
+     * Once set, the flag stays set until ClearError() is called.
+     */
+    bool HasError() const { return m_error; }
+
+    /**
+     * @brief Clears the error flag.
+     */
+    void ClearError() { m_error = false; }
+
     /**
      * @brief Reads a single byte and advances the offset.
      */
@@ -65,6 +85,18 @@ public:
         return m_data[m_offset++];
     }
 
+    /**
+     * @brief Advances the offset by a number of bytes.
+     */
+    void Skip(size_t bytes)
+    {
+        if (bytes > RemainingBytes())
+        {
+            throw std::runtime_error("VLEDecoder: Unexpected end of data at offset " + std::to_string(m_offset));
+        }
+        m_offset += bytes;
+    }
+
     /**
      * @brief Reads a single VLE-encoded unsigned value.
      *
@@ -77,39 +109,31 @@ public:
      */
     uint32_t ReadVLEValue(bool* outSign = nullptr)
     {
-        uint8_t b = ReadByte();
-        uint32_t value = b & 0x3F;
+        uint32_t value = 0;
+        bool sign = false;
+        if (!TryReadVLEValue(value, sign))
+        {
+            ThrowEndOfData();
+        }
 
         if (outSign)
         {
-            *outSign = (b & 0x40) != 0;
+            *outSign = sign;
         }
+        return value;
+    }
 
-        if (b & 0x80)
+    /**
+     * @brief Exception-free ReadVLEValue. Sets the error flag on truncated data.
+     */
+    bool TryReadVLEValue(uint32_t& outValue, bool& outSign) noexcept
+    {
+        if (RemainingBytes() >= 8)
         {
-            b = ReadByte();
-            value |= (b & 0x7F) << 6;
-
-            if (b & 0x80)
-            {
-                b = ReadByte();
-                value |= (b & 0x7F) << 13;
-
-                if (b & 0x80)
-                {
-                    b = ReadByte();
-                    value |= (b & 0x7F) << 20;
-
-                    if (b & 0x80)
-                    {
-                        b = ReadByte();
-                        value |= static_cast<uint32_t>(b) << 27;
-                    }
-                }
-            }
+            m_offset += DecodeVLEWord(LoadWord(m_offset), outValue, outSign);
+            return true;
         }
-
-        return value;
+        return ReadVLEValueChecked(outValue, outSign);
     }
 
     /**
@@ -125,27 +149,107 @@ public:
      */
     std::vector<uint32_t> ExpandUnsignedDeltaVLE(uint32_t count)
     {
-        std::vector<uint32_t> values;
-        values.reserve(count);
+        std::vector<uint32_t> values(count);
+        if (!TryExpandUnsignedDeltaVLE(count, values.data()))
+        {
+            ThrowEndOfData();
+        }
+        return values;
+    }
 
+    /**
+     * @brief Exception-free ExpandUnsignedDeltaVLE into a caller-provided buffer.
+     *
+     * The bounds are validated once for the whole block: if the block cannot run
+     * past the end of the data (5 bytes per value at most), every value is decoded
+     * from a 64-bit word load without per-byte checks.
+     *
+     * @param count Number of values to decode.
+     * @param out Receives count values (may be nullptr to only advance the reader).
+     * @return false (and sets the error flag) if the data is truncated.
+     */
+    bool TryExpandUnsignedDeltaVLE(uint32_t count, uint32_t* out) noexcept
+    {
         int32_t last1 = 0;
         int32_t last2 = 0;
 
-        for (uint32_t i = 0; i < count; i++)
+        auto emit = [&](uint32_t i, uint32_t rawValue, bool signPositive)
         {
-            bool signPositive;
-            uint32_t rawValue = ReadVLEValue(&signPositive);
-
             int32_t delta = signPositive ? static_cast<int32_t>(rawValue) : -static_cast<int32_t>(rawValue);
             int32_t newValue = (last1 * 2 - last2) + delta;
-
-            values.push_back(static_cast<uint32_t>(newValue));
-
+            if (out)
+            {
+                out[i] = static_cast<uint32_t>(newValue);
+            }
             last2 = last1;
             last1 = newValue;
+        };
+
+        uint32_t i = 0;
+        if (RemainingBytes() >= static_cast<size_t>(count) * 5 + 8)
+        {
+            for (; i < count; i++)
+            {
+                uint32_t rawValue;
+                bool signPositive;
+                m_offset += DecodeVLEWord(LoadWord(m_offset), rawValue, signPositive);
+                emit(i, rawValue, signPositive);
+            }
+            return true;
         }
 
-        return values;
+        for (; i < count; i++)
+        {
+            uint32_t rawValue;
+            bool signPositive;
+            if (!TryReadVLEValue(rawValue, signPositive))
+            {
+                return false;
+            }
+            emit(i, rawValue, signPositive);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Skips count unsigned VLE values without decoding them.
+     *
+     * Only the continuation bits are inspected, so this is much cheaper than
+     * ExpandUnsignedDeltaVLE when the values themselves are not needed.
+     */
+    void SkipVLEValues(uint32_t count)
+    {
+        if (!TrySkipVLEValues(count))
+        {
+            ThrowEndOfData();
+        }
+    }
+
+    /**
+     * @brief Exception-free SkipVLEValues.
+     */
+    bool TrySkipVLEValues(uint32_t count) noexcept
+    {
+        return SkipValues<5>(count);
+    }
+
+    /**
+     * @brief Skips count signed delta VLE values (see ExpandSignedDeltaVLE).
+     */
+    void SkipSignedDeltaVLEs(uint32_t count)
+    {
+        if (!TrySkipSignedDeltaVLEs(count))
+        {
+            ThrowEndOfData();
+        }
+    }
+
+    /**
+     * @brief Exception-free SkipSignedDeltaVLEs.
+     */
+    bool TrySkipSignedDeltaVLEs(uint32_t count) noexcept
+    {
+        return SkipValues<3>(count);
     }
 
     /**
@@ -156,30 +260,86 @@ public:
      */
     int16_t ExpandSignedDeltaVLE(int16_t previous)
     {
-        uint8_t b = ReadByte();
-        uint32_t value = b & 0x3F;
-        bool signSubtract = (b & 0x40) != 0;
-
-        if (b & 0x80)
+        int16_t value = previous;
+        if (!TryExpandSignedDeltaVLE(value))
         {
-            b = ReadByte();
-            value |= (b & 0x7F) << 6;
-
-            if (b & 0x80)
-            {
-                b = ReadByte();
-                value |= static_cast<uint32_t>(b) << 13;
-            }
+            ThrowEndOfData();
         }
+        return value;
+    }
 
-        if (signSubtract)
+    /**
+     * @brief Exception-free ExpandSignedDeltaVLE, applies the delta to value in place.
+     */
+    bool TryExpandSignedDeltaVLE(int16_t& value) noexcept
+    {
+        uint32_t delta;
+        bool signSubtract;
+        if (RemainingBytes() >= 8)
+        {
+            m_offset += DecodeSignedDeltaWord(LoadWord(m_offset), delta, signSubtract);
+        }
+        else if (!ReadSignedDeltaChecked(delta, signSubtract))
         {
-            return static_cast<int16_t>((previous - value) & 0xFFFF);
+            return false;
         }
-        else
+
+        value = ApplySignedDelta(value, delta, signSubtract);
+        return true;
+    }
+
+    /**
+     * @brief Decodes one unsigned VLE value from the low bytes of a little-endian word.
+     *
+     * The length is found from the continuation bits with a single bit scan and the
+     * payload bits are gathered with fixed shifts and masks, there are no per-byte
+     * branches. The 5th byte always terminates the value.
+     *
+     * @return Number of bytes consumed (1-5).
+     */
+    static uint32_t DecodeVLEWord(uint64_t word, uint32_t& outValue, bool& outSign) noexcept
+    {
+        // A clear continuation bit ends the value, byte 4 ends it unconditionally
+        uint64_t stopBits = (~word & 0x0000000080808080ull) | 0x0000008000000000ull;
+        uint32_t length = (static_cast<uint32_t>(std::countr_zero(stopBits)) >> 3) + 1;
+        uint64_t w = word & (~0ull >> (64 - length * 8));
+
+        outSign = (word & 0x40) != 0;
+        outValue = static_cast<uint32_t>(
+            (w & 0x3F) |
+            ((w >> 2) & 0x00001FC0ull) |   // byte 1 bits [0,7) -> [6,13)
+            ((w >> 3) & 0x000FE000ull) |   // byte 2 bits [0,7) -> [13,20)
+            ((w >> 4) & 0x07F00000ull) |   // byte 3 bits [0,7) -> [20,27)
+            ((w >> 5) & 0xF8000000ull));   // byte 4 bits [0,5) -> [27,32)
+        return length;
+    }
+
+    /**
+     * @brief Decodes one signed delta VLE value (max 3 bytes) from a little-endian word.
+     *
+     * @return Number of bytes consumed (1-3).
+     */
+    static uint32_t DecodeSignedDeltaWord(uint64_t word, uint32_t& outDelta, bool& outSubtract) noexcept
+    {
+        uint64_t stopBits = (~word & 0x0000000000008080ull) | 0x0000000000800000ull;
+        uint32_t length = (static_cast<uint32_t>(std::countr_zero(stopBits)) >> 3) + 1;
+        uint64_t w = word & (~0ull >> (64 - length * 8));
+
+        outSubtract = (word & 0x40) != 0;
+        outDelta = static_cast<uint32_t>(
+            (w & 0x3F) |
+            ((w >> 2) & 0x00001FC0ull) |   // byte 1 bits [0,7) -> [6,13)
+            ((w >> 3) & 0x001FE000ull));   // byte 2 bits [0,8) -> [13,21)
+        return length;
+    }
+
+    static int16_t ApplySignedDelta(int16_t previous, uint32_t delta, bool signSubtract) noexcept
+    {
+        if (signSubtract)
         {
-            return static_cast<int16_t>((previous + value) & 0xFFFF);
+            return static_cast<int16_t>((previous - delta) & 0xFFFF);
         }
+        return static_cast<int16_t>((previous + delta) & 0xFFFF);
     }
 
     /**
@@ -216,6 +376,57 @@ public:
         return result;
     }
 
+    /**
+     * @brief Reads the float3 entries [first, last) of an array of count float3s.
+     *
+     * The reader is left positioned after the whole array.
+     */
+    std::vector<XMFLOAT3> ReadFloat3Range(uint32_t count, uint32_t first, uint32_t last)
+    {
+        last = std::min(last, count);
+        first = std::min(first, last);
+
+        size_t arrayStart = m_offset;
+        SkipFloat3s(count);
+
+        size_t rangeOffset = m_offset;
+        m_offset = arrayStart + static_cast<size_t>(first) * 12;
+        std::vector<XMFLOAT3> result = ReadFloat3s(last - first);
+        m_offset = rangeOffset;
+
+        return result;
+    }
+
+    /**
+     * @brief Skips count float3 values.
+     *
+     * Like ReadFloat3s, the offset is left after the last complete float3 if the
+     * data is truncated.
+     */
+    void SkipFloat3s(uint32_t count)
+    {
+        if (!TrySkipFloat3s(count))
+        {
+            throw std::runtime_error("VLEDecoder: Not enough data for float3 at offset " + std::to_string(m_offset));
+        }
+    }
+
+    /**
+     * @brief Exception-free SkipFloat3s.
+     */
+    bool TrySkipFloat3s(uint32_t count) noexcept
+    {
+        size_t available = RemainingBytes() / 12;
+        if (available < count)
+        {
+            m_offset += available * 12;
+            m_error = true;
+            return false;
+        }
+        m_offset += static_cast<size_t>(count) * 12;
+        return true;
+    }
+
     /**
      * @brief Decompresses rotation keyframes from Euler angles to quaternions.
      *
@@ -235,43 +446,45 @@ public:
      */
     std::vector<XMFLOAT4> DecompressQuaternionKeys(uint32_t count)
     {
-        std::vector<XMFLOAT4> quaternions;
-        quaternions.reserve(count);
+        return DecompressQuaternionKeyRange(count, 0, count);
+    }
 
-        constexpr float ANGLE_SCALE = (2.0f * 3.14159265358979323846f) / 65536.0f;
-        constexpr float ANGLE_OFFSET = 3.14159265358979323846f;
+    /**
+     * @brief Decompresses the rotation keyframes [first, last) of a stream of count keys.
+     *
+     * The Euler deltas of keys before first still have to be accumulated, but the
+     * (comparatively expensive) quaternion conversion is only done for the requested
+     * range. The reader is left positioned after the whole stream of count keys.
+     *
+     * Hemisphere continuity is enforced relative to the first key in the range, so
+     * the returned quaternions may differ in sign from a full decode (same rotation).
+     *
+     * @param count Total number of rotation keyframes in the stream.
+     * @param first Index of the first key to convert.
+     * @param last One past the index of the last key to convert.
+     * @return Vector of last - first quaternions.
+     */
+    std::vector<XMFLOAT4> DecompressQuaternionKeyRange(uint32_t count, uint32_t first, uint32_t last)
+    {
+        last = std::min(last, count);
+        first = std::min(first, last);
+
+        // Decode delta-encoded Euler angles (in GW coordinate space)
+        std::vector<int16_t> angles(static_cast<size_t>(last) * 3);
+        if (!TryDecodeEulerKeys(last, angles.data()))
+        {
+            ThrowEndOfData();
+        }
 
-        int16_t prevX = 0, prevY = 0, prevZ = 0;
+        std::vector<XMFLOAT4> quaternions;
+        quaternions.reserve(last - first);
 
-        for (uint32_t i = 0; i < count; i++)
+        for (uint32_t i = first; i < last; i++)
         {
-            // Decode delta-encoded Euler angles (in GW coordinate space)
-            prevX = ExpandSignedDeltaVLE(prevX);
-            prevY = ExpandSignedDeltaVLE(prevY);
-            prevZ = ExpandSignedDeltaVLE(prevZ);
-
-            // Convert from 16-bit encoded values to radians (still in GW space)
-            // GW uses TRANSPOSED rotation matrices (Ghidra: Model_DecompressQuaternionKeys @ 0x00770e60)
-            // Transposed matrices = inverse rotation = rotation by negative angle
-            // Therefore we negate ALL three Euler angles to match GW's convention
-            float rx_gw = -(prevX * ANGLE_SCALE - ANGLE_OFFSET);
-            float ry_gw = -(prevY * ANGLE_SCALE - ANGLE_OFFSET);
-            float rz_gw = -(prevZ * ANGLE_SCALE - ANGLE_OFFSET);
-
-            // Convert Euler angles to quaternion in GW coordinate space
-            XMFLOAT4 quat_gw = EulerToQuaternion(rx_gw, ry_gw, rz_gw);
-
-            // Transform quaternion from GW space to GWMB space
-            // Position transform: (x, y, z) -> (x, -z, y)
-            // Quaternion axis transform: (qx, qy, qz) -> (qx, -qz, qy)
-            XMFLOAT4 quat;
-            quat.x = quat_gw.x;
-            quat.y = -quat_gw.z;
-            quat.z = quat_gw.y;
-            quat.w = quat_gw.w;
+            XMFLOAT4 quat = EncodedEulerToQuaternion(angles[i * 3], angles[i * 3 + 1], angles[i * 3 + 2]);
 
             // Ensure quaternion continuity (flip if dot product is negative)
-            if (i > 0)
+            if (!quaternions.empty())
             {
                 const XMFLOAT4& prev = quaternions.back();
                 float dot = quat.w * prev.w + quat.x * prev.x + quat.y * prev.y + quat.z * prev.z;
@@ -287,9 +500,80 @@ public:
             quaternions.push_back(quat);
         }
 
+        // Skip the remaining keys of the stream
+        SkipSignedDeltaVLEs((count - last) * 3);
+
         return quaternions;
     }
 
+    /**
+     * @brief Decodes count delta-encoded Euler angle triples (exception-free).
+     *
+     * Like TryExpandUnsignedDeltaVLE, bounds are validated once for the block.
+     *
+     * @param count Number of keys (3 signed delta values each).
+     * @param outXYZ Receives count * 3 accumulated 16-bit encoded angles.
+     * @return false (and sets the error flag) if the data is truncated.
+     */
+    bool TryDecodeEulerKeys(uint32_t count, int16_t* outXYZ) noexcept
+    {
+        int16_t prev[3] = {0, 0, 0};
+        const size_t valueCount = static_cast<size_t>(count) * 3;
+
+        if (RemainingBytes() >= valueCount * 3 + 8)
+        {
+            for (size_t i = 0; i < valueCount; i++)
+            {
+                uint32_t delta;
+                bool signSubtract;
+                m_offset += DecodeSignedDeltaWord(LoadWord(m_offset), delta, signSubtract);
+                prev[i % 3] = ApplySignedDelta(prev[i % 3], delta, signSubtract);
+                outXYZ[i] = prev[i % 3];
+            }
+            return true;
+        }
+
+        for (size_t i = 0; i < valueCount; i++)
+        {
+            if (!TryExpandSignedDeltaVLE(prev[i % 3]))
+            {
+                return false;
+            }
+            outXYZ[i] = prev[i % 3];
+        }
+        return true;
+    }
+
+    /**
+     * @brief Converts 16-bit encoded Euler angles (GW space) to a GWMB space quaternion.
+     */
+    static XMFLOAT4 EncodedEulerToQuaternion(int16_t encodedX, int16_t encodedY, int16_t encodedZ)
+    {
+        constexpr float ANGLE_SCALE = (2.0f * 3.14159265358979323846f) / 65536.0f;
+        constexpr float ANGLE_OFFSET = 3.14159265358979323846f;
+
+        // Convert from 16-bit encoded values to radians (still in GW space)
+        // GW uses TRANSPOSED rotation matrices (Ghidra: Model_DecompressQuaternionKeys @ 0x00770e60)
+        // Transposed matrices = inverse rotation = rotation by negative angle
+        // Therefore we negate ALL three Euler angles to match GW's convention
+        float rx_gw = -(encodedX * ANGLE_SCALE - ANGLE_OFFSET);
+        float ry_gw = -(encodedY * ANGLE_SCALE - ANGLE_OFFSET);
+        float rz_gw = -(encodedZ * ANGLE_SCALE - ANGLE_OFFSET);
+
+        // Convert Euler angles to quaternion in GW coordinate space
+        XMFLOAT4 quat_gw = EulerToQuaternion(rx_gw, ry_gw, rz_gw);
+
+        // Transform quaternion from GW space to GWMB space
+        // Position transform: (x, y, z) -> (x, -z, y)
+        // Quaternion axis transform: (qx, qy, qz) -> (qx, -qz, qy)
+        XMFLOAT4 quat;
+        quat.x = quat_gw.x;
+        quat.y = -quat_gw.z;
+        quat.z = quat_gw.y;
+        quat.w = quat_gw.w;
+        return quat;
+    }
+
     /**
      * @brief Converts Euler angles (ZYX order) to quaternion.
      *
@@ -441,10 +725,115 @@ public:
         return {-q.x, -q.y, -q.z, q.w};
     }
 
+private:
+    [[noreturn]] void ThrowEndOfData() const
+    {
+        throw std::runtime_error("VLEDecoder: Unexpected end of data at offset " + std::to_string(m_offset));
+    }
+
+    uint64_t LoadWord(size_t offset) const noexcept
+    {
+        uint64_t word;
+        std::memcpy(&word, &m_data[offset], sizeof(word));
+        return word;
+    }
+
+    /**
+     * @brief Byte-at-a-time VLE read for the last few bytes of the buffer.
+     *
+     * On truncation the offset is left at the end of the data, like ReadByte().
+     */
+    bool ReadVLEValueChecked(uint32_t& outValue, bool& outSign) noexcept
+    {
+        uint8_t bytes[8] = {};
+        size_t available = RemainingBytes();
+        for (size_t i = 0; i < 5; i++)
+        {
+            if (i >= available)
+            {
+                m_offset = m_dataSize;
+                m_error = true;
+                return false;
+            }
+            bytes[i] = m_data[m_offset + i];
+            if (!(bytes[i] & 0x80))
+            {
+                break;
+            }
+        }
+
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        m_offset += DecodeVLEWord(word, outValue, outSign);
+        return true;
+    }
+
+    bool ReadSignedDeltaChecked(uint32_t& outDelta, bool& outSubtract) noexcept
+    {
+        uint8_t bytes[8] = {};
+        size_t available = RemainingBytes();
+        for (size_t i = 0; i < 3; i++)
+        {
+            if (i >= available)
+            {
+                m_offset = m_dataSize;
+                m_error = true;
+                return false;
+            }
+            bytes[i] = m_data[m_offset + i];
+            if (!(bytes[i] & 0x80))
+            {
+                break;
+            }
+        }
+
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        m_offset += DecodeSignedDeltaWord(word, outDelta, outSubtract);
+        return true;
+    }
+
+    /**
+     * @brief Skips count VLE values of at most MaxBytes bytes each.
+     */
+    template<uint32_t MaxBytes>
+    bool SkipValues(uint32_t count) noexcept
+    {
+        // Continuation bits of bytes that can continue the value, the last byte always ends it
+        constexpr uint64_t continueMask = (MaxBytes == 5) ? 0x0000000080808080ull : 0x0000000000008080ull;
+        constexpr uint64_t lastByteStop = 0x80ull << ((MaxBytes - 1) * 8);
+
+        uint32_t i = 0;
+        while (i < count && RemainingBytes() >= 8)
+        {
+            uint64_t stopBits = (~LoadWord(m_offset) & continueMask) | lastByteStop;
+            m_offset += (static_cast<uint32_t>(std::countr_zero(stopBits)) >> 3) + 1;
+            i++;
+        }
+
+        for (; i < count; i++)
+        {
+            for (uint32_t byteIdx = 0; byteIdx < MaxBytes; byteIdx++)
+            {
+                if (m_offset >= m_dataSize)
+                {
+                    m_error = true;
+                    return false;
+                }
+                if (!(m_data[m_offset++] & 0x80))
+                {
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
 private:
     const uint8_t* m_data;
     size_t m_dataSize;
     size_t m_offset;
+    bool m_error = false;
 };
 
 } // namespace GW::Parsers
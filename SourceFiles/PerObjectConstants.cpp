@@ -0,0 +1,27 @@
+#include "pch.h"
+#include "PerObjectConstants.h"
+#include <cstring>
+
+using namespace DirectX;
+
+const PerObjectCB& GpuPerObjectData::Get(const PerObjectCB& source)
+{
+    if (m_dirty) {
+        m_data = source;
+        XMStoreFloat4x4(&m_data.world, XMMatrixTranspose(XMLoadFloat4x4(&source.world)));
+        m_dirty = false;
+        m_update_count++;
+    }
+    return m_data;
+}
+
+uint32_t PerObjectConstantPacker::Append(const PerObjectCB& data)
+{
+    const size_t offset = GetSize();
+    if (m_data.size() < offset + SLOT_SIZE) {
+        m_data.resize(std::max(offset + SLOT_SIZE, m_data.size() * 2));
+    }
+
+    std::memcpy(m_data.data() + offset, &data, sizeof(PerObjectCB));
+    return m_slot_count++ * SLOT_CONSTANTS;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "PerObjectCB.h"
+
+/**
+ * @brief PerObjectCB in the layout the shaders read, with the world matrix transposed.
+ *
+ * The transposed copy is rebuilt lazily on the first read after the source data
+ * changed, so static meshes pay for the transpose once instead of once per draw.
+ */
+class GpuPerObjectData
+{
+public:
+    void MarkDirty() { m_dirty = true; }
+    bool IsDirty() const { return m_dirty; }
+
+    const PerObjectCB& Get(const PerObjectCB& source);
+
+    // Number of times the transposed copy was rebuilt.
+    uint32_t GetUpdateCount() const { return m_update_count; }
+
+private:
+    PerObjectCB m_data;
+    bool m_dirty = true;
+    uint32_t m_update_count = 0;
+};
+
+/**
+ * @brief Packs the per object constants of a pass into one buffer.
+ *
+ * Every object gets a 256 byte slot, the alignment *SetConstantBuffers1 needs for
+ * constant offsets, so the whole pass is uploaded with a single Map and each draw
+ * only binds its slot.
+ */
+class PerObjectConstantPacker
+{
+public:
+    static constexpr uint32_t SLOT_SIZE = 256;
+    static constexpr uint32_t SLOT_CONSTANTS = SLOT_SIZE / 16;
+    static_assert(sizeof(PerObjectCB) <= SLOT_SIZE, "PerObjectCB must fit into one constant buffer slot");
+
+    void Reset() { m_slot_count = 0; }
+
+    // Copies data into the next slot and returns the slot's first 16 byte constant.
+    uint32_t Append(const PerObjectCB& data);
+
+    const std::byte* GetData() const { return m_data.data(); }
+    size_t GetSize() const { return static_cast<size_t>(m_slot_count) * SLOT_SIZE; }
+    uint32_t GetSlotCount() const { return m_slot_count; }
+
+private:
+    std::vector<std::byte> m_data;
+    uint32_t m_slot_count = 0;
+};
@@ -69,14 +69,16 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
 float4 main(PixelInputType input) : SV_TARGET
 {
     float4 colorId = float4(0, 0, 0, 1);
-    colorId.r = (float) ((object_id & 0x00FF0000) >> 16) / 255.0f;
-    colorId.g = (float) ((object_id & 0x0000FF00) >> 8) / 255.0f;
-    colorId.b = (float) ((object_id & 0x000000FF)) / 255.0f;
+    colorId.r = (float) ((input.object_id & 0x00FF0000) >> 16) / 255.0f;
+    colorId.g = (float) ((input.object_id & 0x0000FF00) >> 8) / 255.0f;
+    colorId.b = (float) ((input.object_id & 0x000000FF)) / 255.0f;
 
     return colorId;
 }
@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "PickingReadback.h"
+
+namespace
+{
+    // The picking shader writes the object id to RGB, see PickingPixelShader.
+    uint32_t decode_object_id(const uint8_t* pixel)
+    {
+        return (static_cast<uint32_t>(pixel[0]) << 16) | (static_cast<uint32_t>(pixel[1]) << 8) | static_cast<uint32_t>(pixel[2]);
+    }
+}
+
+bool PickingReadback::Request(ID3D11DeviceContext* context, ID3D11Texture2D* picking_texture, int x, int y)
+{
+    D3D11_TEXTURE2D_DESC desc;
+    picking_texture->GetDesc(&desc);
+    m_target_width = static_cast<int>(desc.Width);
+    m_target_height = static_cast<int>(desc.Height);
+    if (x < 0 || x >= m_target_width || y < 0 || y >= m_target_height) return false;
+
+    if (desc.Format != m_format && !CreateStagingTextures(context, desc.Format)) return false;
+
+    // Make room for the copy if the oldest one is done.
+    ReadFinishedCopies(context);
+    auto& slot = m_slots[m_next_slot];
+    if (slot.pending) return false;
+
+    auto& region = slot.region;
+    region.width = std::min(REGION_SIZE, m_target_width);
+    region.height = std::min(REGION_SIZE, m_target_height);
+    region.left = std::clamp(x - region.width / 2, 0, m_target_width - region.width);
+    region.top = std::clamp(y - region.height / 2, 0, m_target_height - region.height);
+    region.cursor_x = x;
+    region.cursor_y = y;
+    slot.request_frame = m_frame;
+    slot.pending = true;
+
+    const D3D11_BOX box{ static_cast<UINT>(region.left), static_cast<UINT>(region.top), 0,
+        static_cast<UINT>(region.left + region.width), static_cast<UINT>(region.top + region.height), 1 };
+    context->CopySubresourceRegion(slot.staging_texture.Get(), 0, 0, 0, 0, picking_texture, 0, &box);
+
+    m_next_slot = (m_next_slot + 1) % RING_SIZE;
+    return true;
+}
+
+int PickingReadback::GetObjectId(ID3D11DeviceContext* context, int x, int y)
+{
+    ReadFinishedCopies(context);
+    m_frame++;
+
+    if (!m_has_result || x < 0 || x >= m_target_width || y < 0 || y >= m_target_height) return -1;
+
+    const auto& region = m_result_region;
+    if (x < region.left || x >= region.left + region.width || y < region.top || y >= region.top + region.height) {
+        x = region.cursor_x;
+        y = region.cursor_y;
+    }
+    return static_cast<int>(m_result_ids[(y - region.top) * region.width + (x - region.left)]);
+}
+
+void PickingReadback::Reset()
+{
+    for (auto& slot : m_slots) {
+        slot = Slot();
+    }
+    m_next_slot = 0;
+    m_format = DXGI_FORMAT_UNKNOWN;
+    m_has_result = false;
+}
+
+bool PickingReadback::CreateStagingTextures(ID3D11DeviceContext* context, DXGI_FORMAT format)
+{
+    Reset();
+
+    Microsoft::WRL::ComPtr<ID3D11Device> device;
+    context->GetDevice(device.GetAddressOf());
+
+    const CD3D11_TEXTURE2D_DESC desc(format, REGION_SIZE, REGION_SIZE, 1, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+    for (auto& slot : m_slots) {
+        if (FAILED(device->CreateTexture2D(&desc, nullptr, slot.staging_texture.ReleaseAndGetAddressOf()))) {
+            Reset();
+            return false;
+        }
+    }
+    m_format = format;
+    return true;
+}
+
+void PickingReadback::ReadFinishedCopies(ID3D11DeviceContext* context)
+{
+    // Copies finish in request order, starting at the oldest one.
+    for (size_t i = 0; i < RING_SIZE; i++) {
+        auto& slot = m_slots[(m_next_slot + i) % RING_SIZE];
+        if (!slot.pending) continue;
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        const HRESULT hr = context->Map(slot.staging_texture.Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+        if (hr == DXGI_ERROR_WAS_STILL_DRAWING) break;
+
+        slot.pending = false;
+        if (FAILED(hr)) continue;
+
+        const auto& region = slot.region;
+        m_result_region = region;
+        m_result_ids.resize(static_cast<size_t>(region.width) * region.height);
+        const auto* data = static_cast<const uint8_t*>(mapped.pData);
+        for (int row = 0; row < region.height; row++) {
+            for (int column = 0; column < region.width; column++) {
+                m_result_ids[row * region.width + column] = decode_object_id(data + row * mapped.RowPitch + column * 4);
+            }
+        }
+        context->Unmap(slot.staging_texture.Get(), 0);
+
+        m_has_result = true;
+        m_latency_frames = static_cast<uint32_t>(m_frame - slot.request_frame);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <d3d11.h>
+#include <wrl/client.h>
+
+/**
+ * @brief Reads object ids back from the picking render target without stalling on the GPU.
+ *
+ * Request copies a small region around the cursor into the next staging texture of a ring. GetObjectId maps the
+ * copies once the GPU finished them, a couple of frames later, with D3D11_MAP_FLAG_DO_NOT_WAIT and keeps the
+ * newest one. Ids are looked up in that region, so small cursor moves are answered without a new copy.
+ */
+class PickingReadback
+{
+public:
+    static constexpr int REGION_SIZE = 16;
+    static constexpr size_t RING_SIZE = 3;
+
+    // Queues a copy of the region around (x, y) of a non multisampled picking texture. Returns false if it was
+    // dropped because every staging texture is still waiting for the GPU or (x, y) is outside the texture.
+    bool Request(ID3D11DeviceContext* context, ID3D11Texture2D* picking_texture, int x, int y);
+
+    // Object id at (x, y) from the newest finished copy, -1 if there is none or (x, y) is outside the target.
+    // Outside of that copy's region the id under the cursor at the time of the request is returned.
+    // Call once per frame, after Request.
+    int GetObjectId(ID3D11DeviceContext* context, int x, int y);
+
+    // Releases the staging textures, e.g. when the device is lost.
+    void Reset();
+
+    // Frames between the newest finished copy's request and its readback.
+    uint32_t GetLatencyFrames() const { return m_latency_frames; }
+
+private:
+    struct Region
+    {
+        int left = 0;
+        int top = 0;
+        int width = 0;
+        int height = 0;
+        int cursor_x = 0;
+        int cursor_y = 0;
+    };
+
+    struct Slot
+    {
+        Microsoft::WRL::ComPtr<ID3D11Texture2D> staging_texture;
+        bool pending = false;
+        uint64_t request_frame = 0;
+        Region region;
+    };
+
+    bool CreateStagingTextures(ID3D11DeviceContext* context, DXGI_FORMAT format);
+    void ReadFinishedCopies(ID3D11DeviceContext* context);
+
+    std::array<Slot, RING_SIZE> m_slots;
+    size_t m_next_slot = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+    uint64_t m_frame = 0;
+
+    int m_target_width = 0;
+    int m_target_height = 0;
+
+    // The newest finished copy
+    bool m_has_result = false;
+    Region m_result_region;
+    std::vector<uint32_t> m_result_ids;
+    uint32_t m_latency_frames = 0;
+};
@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "PropInstancing.h"
+#include <cstring>
+
+namespace
+{
+    // Dense keys are grouped with a counting sort, larger ones fall back to a stable sort.
+    constexpr uint32_t MAX_COUNTING_SORT_KEY = 1 << 16;
+}
+
+bool HasSameMaterialConstants(const PerObjectCB& a, const PerObjectCB& b)
+{
+    // uv_indices up to num_uv_texture_pairs are contiguous uint32_t arrays without padding.
+    const size_t material_begin = offsetof(PerObjectCB, uv_indices);
+    const size_t material_end = offsetof(PerObjectCB, num_uv_texture_pairs) + sizeof(uint32_t);
+    if (std::memcmp(reinterpret_cast<const char*>(&a) + material_begin, reinterpret_cast<const char*>(&b) + material_begin,
+        material_end - material_begin) != 0)
+    {
+        return false;
+    }
+
+    return a.shore_max_alpha == b.shore_max_alpha && a.shore_wave_speed == b.shore_wave_speed &&
+        a.mesh_alpha == b.mesh_alpha && a.object_color.x == b.object_color.x && a.object_color.y == b.object_color.y &&
+        a.object_color.z == b.object_color.z && a.object_color.w == b.object_color.w;
+}
+
+void PropInstanceGroups::Build(std::span<const uint32_t> model_keys)
+{
+    m_group_keys.clear();
+    m_group_offsets.clear();
+    m_instances.resize(model_keys.size());
+    if (model_keys.empty()) {
+        m_group_offsets.push_back(0);
+        return;
+    }
+
+    const uint32_t max_key = *std::max_element(model_keys.begin(), model_keys.end());
+    if (max_key < MAX_COUNTING_SORT_KEY) {
+        std::vector<uint32_t> offsets(static_cast<size_t>(max_key) + 2, 0);
+        for (const uint32_t key : model_keys) {
+            offsets[key + 1]++;
+        }
+        for (uint32_t key = 0; key <= max_key; key++) {
+            if (offsets[key + 1] > 0) {
+                m_group_keys.push_back(key);
+                m_group_offsets.push_back(offsets[key]);
+            }
+            offsets[key + 1] += offsets[key];
+        }
+        for (uint32_t i = 0; i < model_keys.size(); i++) {
+            m_instances[offsets[model_keys[i]]++] = i;
+        }
+    }
+    else {
+        for (uint32_t i = 0; i < model_keys.size(); i++) {
+            m_instances[i] = i;
+        }
+        std::stable_sort(m_instances.begin(), m_instances.end(),
+            [&](uint32_t a, uint32_t b) { return model_keys[a] < model_keys[b]; });
+        for (uint32_t i = 0; i < m_instances.size(); i++) {
+            const uint32_t key = model_keys[m_instances[i]];
+            if (m_group_keys.empty() || m_group_keys.back() != key) {
+                m_group_keys.push_back(key);
+                m_group_offsets.push_back(i);
+            }
+        }
+    }
+    m_group_offsets.push_back(static_cast<uint32_t>(m_instances.size()));
+}
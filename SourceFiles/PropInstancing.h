@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <DirectXMath.h>
+#include "PerObjectCB.h"
+
+// Input slot of the per instance vertex buffer, slot 0 holds the mesh vertices.
+constexpr uint32_t PROP_INSTANCE_BUFFER_SLOT = 1;
+
+/**
+ * @brief Per instance vertex data of an instanced draw, read by the INSTANCED variant of VertexShader.hlsl.
+ *
+ * The world matrix is stored untransposed: the shader builds the matrix from its rows,
+ * which gives the same matrix as the transposed World in PerObjectCB.
+ */
+struct PropInstanceData
+{
+    DirectX::XMFLOAT4X4 world;
+    uint32_t object_id;
+    uint32_t highlight_state;
+};
+
+inline PropInstanceData MakePropInstanceData(const PerObjectCB& data)
+{
+    return { data.world, data.object_id, data.highlight_state };
+}
+
+// True if two draws only differ in the per instance fields of PerObjectCB (world, object_id and highlight_state).
+bool HasSameMaterialConstants(const PerObjectCB& a, const PerObjectCB& b);
+
+/**
+ * @brief Prop indices grouped by the model they place, so each model is decoded and uploaded once per map.
+ *
+ * Groups are ordered by model key and list their props in increasing prop index.
+ */
+class PropInstanceGroups
+{
+public:
+    // model_keys[i] is the model of prop i, e.g. PropInfo::filename_index.
+    void Build(std::span<const uint32_t> model_keys);
+
+    size_t GetGroupCount() const { return m_group_keys.size(); }
+    uint32_t GetModelKey(size_t group) const { return m_group_keys[group]; }
+    std::span<const uint32_t> GetInstances(size_t group) const
+    {
+        return std::span<const uint32_t>(m_instances).subspan(m_group_offsets[group],
+            m_group_offsets[group + 1] - m_group_offsets[group]);
+    }
+    size_t GetInstanceCount() const { return m_instances.size(); }
+
+private:
+    std::vector<uint32_t> m_group_keys;
+    std::vector<uint32_t> m_group_offsets;
+    std::vector<uint32_t> m_instances;
+};
+
+/**
+ * @brief A range of consecutive draws of a draw list that is submitted as one instanced draw.
+ *
+ * first_instance is the run's offset into the instance buffer, only set for runs of more than one draw.
+ */
+struct InstanceRun
+{
+    uint32_t first;
+    uint32_t count;
+    uint32_t first_instance;
+};
+
+/**
+ * @brief Splits draws [0, draw_count) into runs of consecutive draws that can be instanced together.
+ *
+ * can_merge(first, next) tells whether draw next can be drawn as an instance of the run starting at draw first.
+ * Draws that can't be merged with their predecessor start a new run, so the runs preserve the draw order.
+ */
+template <typename CanMerge>
+void FindInstanceRuns(size_t draw_count, CanMerge&& can_merge, std::vector<InstanceRun>& runs)
+{
+    runs.clear();
+    size_t first = 0;
+    while (first < draw_count) {
+        size_t last = first + 1;
+        while (last < draw_count && can_merge(first, last)) {
+            last++;
+        }
+        runs.push_back({ static_cast<uint32_t>(first), static_cast<uint32_t>(last - first), 0 });
+        first = last;
+    }
+}
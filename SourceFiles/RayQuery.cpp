@@ -0,0 +1,663 @@
+#include "pch.h"
+#include "RayQuery.h"
+#include "Terrain.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr uint32_t SAH_BIN_COUNT = 12;
+    constexpr uint32_t MAX_LEAF_ITEMS = 4;
+    // Deeper nodes are split at the median, which bounds the depth and so the traversal stacks below.
+    constexpr uint32_t MAX_SAH_DEPTH = 32;
+    constexpr uint32_t TRAVERSAL_STACK_SIZE = 64;
+    // Batched queries smaller than this run on the calling thread.
+    constexpr size_t PARALLEL_BATCH_SIZE = 1024;
+
+    XMFLOAT3 sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    float dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    float get_axis(const XMFLOAT3& v, int axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+    CullingAABB empty_box()
+    {
+        return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+    }
+
+    void grow(CullingAABB& box, const XMFLOAT3& point)
+    {
+        box.min = { std::min(box.min.x, point.x), std::min(box.min.y, point.y), std::min(box.min.z, point.z) };
+        box.max = { std::max(box.max.x, point.x), std::max(box.max.y, point.y), std::max(box.max.z, point.z) };
+    }
+
+    void grow(CullingAABB& box, const CullingAABB& other)
+    {
+        box.min = { std::min(box.min.x, other.min.x), std::min(box.min.y, other.min.y), std::min(box.min.z, other.min.z) };
+        box.max = { std::max(box.max.x, other.max.x), std::max(box.max.y, other.max.y), std::max(box.max.z, other.max.z) };
+    }
+
+    float surface_area(const CullingAABB& box)
+    {
+        const XMFLOAT3 extent = sub(box.max, box.min);
+        if (extent.x < 0) return 0;
+        return 2 * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    struct RayPrecomputed
+    {
+        XMFLOAT3 origin;
+        XMFLOAT3 inverse_direction;
+    };
+
+    RayPrecomputed precompute(const Ray& ray)
+    {
+        return { ray.origin, { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z } };
+    }
+
+    // Slab test. Returns the entry distance, or FLT_MAX if the box is missed or starts beyond max_distance.
+    float intersect_box(const CullingAABB& box, const RayPrecomputed& ray, float max_distance)
+    {
+        const float tx1 = (box.min.x - ray.origin.x) * ray.inverse_direction.x;
+        const float tx2 = (box.max.x - ray.origin.x) * ray.inverse_direction.x;
+        float t_enter = std::min(tx1, tx2);
+        float t_exit = std::max(tx1, tx2);
+        const float ty1 = (box.min.y - ray.origin.y) * ray.inverse_direction.y;
+        const float ty2 = (box.max.y - ray.origin.y) * ray.inverse_direction.y;
+        t_enter = std::max(t_enter, std::min(ty1, ty2));
+        t_exit = std::min(t_exit, std::max(ty1, ty2));
+        const float tz1 = (box.min.z - ray.origin.z) * ray.inverse_direction.z;
+        const float tz2 = (box.max.z - ray.origin.z) * ray.inverse_direction.z;
+        t_enter = std::max(t_enter, std::min(tz1, tz2));
+        t_exit = std::min(t_exit, std::max(tz1, tz2));
+
+        if (t_exit < t_enter || t_exit < 0 || t_enter > max_distance) return FLT_MAX;
+        return std::max(t_enter, 0.0f);
+    }
+
+    // Moller-Trumbore, both sides. On a hit closer than max_distance sets distance and the barycentrics.
+    bool intersect_triangle(const Ray& ray, const XMFLOAT3& v0, const XMFLOAT3& edge1, const XMFLOAT3& edge2,
+        float max_distance, float& distance, XMFLOAT2& barycentrics)
+    {
+        const XMFLOAT3 p = cross(ray.direction, edge2);
+        const float determinant = dot(edge1, p);
+        if (std::abs(determinant) < 1e-12f) return false;
+        const float inverse_determinant = 1.0f / determinant;
+
+        const XMFLOAT3 s = sub(ray.origin, v0);
+        const float u = dot(s, p) * inverse_determinant;
+        if (u < 0 || u > 1) return false;
+
+        const XMFLOAT3 q = cross(s, edge1);
+        const float v = dot(ray.direction, q) * inverse_determinant;
+        if (v < 0 || u + v > 1) return false;
+
+        const float t = dot(edge2, q) * inverse_determinant;
+        if (t < 0 || t >= max_distance) return false;
+
+        distance = t;
+        barycentrics = { u, v };
+        return true;
+    }
+
+    /**
+     * Builds the subtree over order[begin, end) and returns its node index. Nodes are stored depth first
+     * with the left child right after its parent, matching TriangleBVH::Node and RayScene::Node.
+     */
+    template <typename Node>
+    uint32_t build_node(std::vector<Node>& nodes, std::vector<uint32_t>& order, std::span<const CullingAABB> boxes,
+        std::span<const XMFLOAT3> centers, uint32_t begin, uint32_t end, uint32_t depth)
+    {
+        const uint32_t node_index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({});
+
+        CullingAABB bounds = empty_box();
+        CullingAABB center_bounds = empty_box();
+        for (uint32_t i = begin; i < end; i++) {
+            grow(bounds, boxes[order[i]]);
+            grow(center_bounds, centers[order[i]]);
+        }
+        nodes[node_index].bounds = bounds;
+
+        const uint32_t count = end - begin;
+        const XMFLOAT3 center_extent = sub(center_bounds.max, center_bounds.min);
+        int longest_axis = 0;
+        if (center_extent.y > center_extent.x) longest_axis = 1;
+        if (center_extent.z > get_axis(center_extent, longest_axis)) longest_axis = 2;
+
+        auto make_leaf = [&] {
+            nodes[node_index].first = begin;
+            nodes[node_index].count = count;
+            return node_index;
+        };
+        if (count <= 1 || (count <= MAX_LEAF_ITEMS && get_axis(center_extent, longest_axis) <= 0)) {
+            return make_leaf();
+        }
+
+        uint32_t middle = begin;
+        if (depth < MAX_SAH_DEPTH) {
+            // Binned SAH: cost of a split is the item count times the surface area of each side.
+            float best_cost = FLT_MAX;
+            int best_axis = -1;
+            uint32_t best_bin = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                const float axis_min = get_axis(center_bounds.min, axis);
+                const float axis_extent = get_axis(center_extent, axis);
+                if (axis_extent <= 0) continue;
+                const float scale = SAH_BIN_COUNT / axis_extent;
+
+                uint32_t bin_counts[SAH_BIN_COUNT]{};
+                CullingAABB bin_bounds[SAH_BIN_COUNT];
+                std::fill(std::begin(bin_bounds), std::end(bin_bounds), empty_box());
+                for (uint32_t i = begin; i < end; i++) {
+                    const auto bin = std::min(SAH_BIN_COUNT - 1, static_cast<uint32_t>((get_axis(centers[order[i]], axis) - axis_min) * scale));
+                    bin_counts[bin]++;
+                    grow(bin_bounds[bin], boxes[order[i]]);
+                }
+
+                float right_costs[SAH_BIN_COUNT]{};
+                CullingAABB right_bounds = empty_box();
+                uint32_t right_count = 0;
+                for (uint32_t bin = SAH_BIN_COUNT - 1; bin > 0; bin--) {
+                    grow(right_bounds, bin_bounds[bin]);
+                    right_count += bin_counts[bin];
+                    right_costs[bin - 1] = right_count * surface_area(right_bounds);
+                }
+
+                CullingAABB left_bounds = empty_box();
+                uint32_t left_count = 0;
+                for (uint32_t bin = 0; bin + 1 < SAH_BIN_COUNT; bin++) {
+                    grow(left_bounds, bin_bounds[bin]);
+                    left_count += bin_counts[bin];
+                    const float cost = left_count * surface_area(left_bounds) + right_costs[bin];
+                    if (left_count > 0 && left_count < count && cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_bin = bin;
+                    }
+                }
+            }
+
+            // A leaf costs an intersection per item, a split one traversal step plus the children weighted by area.
+            const float area = surface_area(bounds);
+            if (count <= MAX_LEAF_ITEMS && (best_axis < 0 || area <= 0 || 1 + best_cost / area >= count)) {
+                return make_leaf();
+            }
+
+            if (best_axis >= 0) {
+                const float axis_min = get_axis(center_bounds.min, best_axis);
+                const float scale = SAH_BIN_COUNT / get_axis(center_extent, best_axis);
+                const auto split = std::partition(order.begin() + begin, order.begin() + end, [&](uint32_t item) {
+                    return std::min(SAH_BIN_COUNT - 1, static_cast<uint32_t>((get_axis(centers[item], best_axis) - axis_min) * scale)) <= best_bin;
+                });
+                middle = static_cast<uint32_t>(split - order.begin());
+            }
+        }
+
+        if (middle == begin || middle == end) {
+            middle = begin + count / 2;
+            std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                [&](uint32_t a, uint32_t b) { return get_axis(centers[a], longest_axis) < get_axis(centers[b], longest_axis); });
+        }
+
+        build_node(nodes, order, boxes, centers, begin, middle, depth + 1);
+        const uint32_t right = build_node(nodes, order, boxes, centers, middle, end, depth + 1);
+        nodes[node_index].first = right;
+        nodes[node_index].count = 0;
+        return node_index;
+    }
+
+    /**
+     * Front to back traversal shared by both BVHs. intersect_leaf(first, count) tests a leaf range, updates
+     * hit.distance and returns true on a hit. Stops at the first hit if any_hit.
+     */
+    template <typename Node, typename IntersectLeaf>
+    bool traverse(const std::vector<Node>& nodes, const Ray& ray, RayHit& hit, bool any_hit, IntersectLeaf&& intersect_leaf)
+    {
+        if (nodes.empty()) return false;
+        const RayPrecomputed precomputed = precompute(ray);
+        if (intersect_box(nodes[0].bounds, precomputed, hit.distance) == FLT_MAX) return false;
+
+        uint32_t stack[TRAVERSAL_STACK_SIZE];
+        int stack_size = 0;
+        uint32_t node_index = 0;
+        bool found = false;
+        while (true) {
+            const Node& node = nodes[node_index];
+            if (node.count > 0) {
+                if (intersect_leaf(node.first, node.count)) {
+                    found = true;
+                    if (any_hit) return true;
+                }
+            }
+            else {
+                uint32_t near_child = node_index + 1;
+                uint32_t far_child = node.first;
+                float near_distance = intersect_box(nodes[near_child].bounds, precomputed, hit.distance);
+                float far_distance = intersect_box(nodes[far_child].bounds, precomputed, hit.distance);
+                if (far_distance < near_distance) {
+                    std::swap(near_child, far_child);
+                    std::swap(near_distance, far_distance);
+                }
+                if (near_distance != FLT_MAX) {
+                    if (far_distance != FLT_MAX) stack[stack_size++] = far_child;
+                    node_index = near_child;
+                    continue;
+                }
+            }
+
+            if (stack_size == 0) break;
+            node_index = stack[--stack_size];
+        }
+        return found;
+    }
+
+    // Whether the ray's height between t_enter and t_exit overlaps [min_y, max_y].
+    bool overlaps_height(const Ray& ray, float t_enter, float t_exit, float min_y, float max_y)
+    {
+        const float y_enter = ray.origin.y + ray.direction.y * t_enter;
+        const float y_exit = ray.origin.y + ray.direction.y * t_exit;
+        return std::max(y_enter, y_exit) >= min_y && std::min(y_enter, y_exit) <= max_y;
+    }
+
+    /**
+     * Visits the cells of a 2D grid crossed by origin + t * direction for t in [t_begin, t_end], in order.
+     * Coordinates are in cells, the walk is clamped to [min_cell, max_cell]. visit(x, z, t_enter, t_exit)
+     * returns true to stop the walk. Returns what the last visit returned.
+     */
+    template <typename Visit>
+    bool walk_grid(const XMFLOAT2& origin, const XMFLOAT2& direction, float t_begin, float t_end,
+        const XMINT2& min_cell, const XMINT2& max_cell, Visit&& visit)
+    {
+        const float start_x = origin.x + direction.x * t_begin;
+        const float start_z = origin.y + direction.y * t_begin;
+        int x = std::clamp(static_cast<int>(std::floor(start_x)), min_cell.x, max_cell.x);
+        int z = std::clamp(static_cast<int>(std::floor(start_z)), min_cell.y, max_cell.y);
+
+        const int step_x = direction.x > 0 ? 1 : -1;
+        const int step_z = direction.y > 0 ? 1 : -1;
+        const float delta_x = direction.x != 0 ? std::abs(1.0f / direction.x) : FLT_MAX;
+        const float delta_z = direction.y != 0 ? std::abs(1.0f / direction.y) : FLT_MAX;
+        float next_x = direction.x != 0 ? (x + (step_x > 0 ? 1 : 0) - origin.x) / direction.x : FLT_MAX;
+        float next_z = direction.y != 0 ? (z + (step_z > 0 ? 1 : 0) - origin.y) / direction.y : FLT_MAX;
+
+        float t = t_begin;
+        while (true) {
+            const float t_exit = std::min({ next_x, next_z, t_end });
+            if (visit(x, z, t, t_exit)) return true;
+            if (t_exit >= t_end) return false;
+
+            t = t_exit;
+            if (next_x < next_z) {
+                x += step_x;
+                next_x += delta_x;
+                if (x < min_cell.x || x > max_cell.x) return false;
+            }
+            else {
+                z += step_z;
+                next_z += delta_z;
+                if (z < min_cell.y || z > max_cell.y) return false;
+            }
+        }
+    }
+}
+
+void TriangleBVH::Build(std::span<const XMFLOAT3> positions, std::span<const uint32_t> indices)
+{
+    m_nodes.clear();
+    m_triangles.clear();
+    m_bounds = {};
+
+    std::vector<CullingAABB> boxes;
+    std::vector<XMFLOAT3> centers;
+    std::vector<uint32_t> source_triangles;
+    const size_t triangle_count = indices.size() / 3;
+    boxes.reserve(triangle_count);
+    centers.reserve(triangle_count);
+    source_triangles.reserve(triangle_count);
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++) {
+        const uint32_t* corners = &indices[triangle * 3];
+        if (corners[0] >= positions.size() || corners[1] >= positions.size() || corners[2] >= positions.size()) continue;
+
+        CullingAABB box = empty_box();
+        for (int i = 0; i < 3; i++) {
+            grow(box, positions[corners[i]]);
+        }
+        boxes.push_back(box);
+        centers.push_back({ (box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f });
+        source_triangles.push_back(triangle);
+    }
+    if (boxes.empty()) return;
+
+    std::vector<uint32_t> order(boxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    m_nodes.reserve(boxes.size() * 2 / MAX_LEAF_ITEMS + 1);
+    build_node(m_nodes, order, boxes, centers, 0, static_cast<uint32_t>(order.size()), 0);
+    m_bounds = m_nodes[0].bounds;
+
+    m_triangles.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        const uint32_t triangle = source_triangles[order[i]];
+        const XMFLOAT3& v0 = positions[indices[triangle * 3]];
+        m_triangles[i] = { v0, sub(positions[indices[triangle * 3 + 1]], v0), sub(positions[indices[triangle * 3 + 2]], v0), triangle };
+    }
+}
+
+bool TriangleBVH::Intersect(const Ray& ray, RayHit& hit, bool any_hit) const
+{
+    hit.distance = std::min(hit.distance, ray.max_distance);
+    return traverse(m_nodes, ray, hit, any_hit, [&](uint32_t first, uint32_t count) {
+        bool found = false;
+        for (uint32_t i = first; i < first + count; i++) {
+            const Triangle& triangle = m_triangles[i];
+            if (intersect_triangle(ray, triangle.v0, triangle.edge1, triangle.edge2, hit.distance, hit.distance, hit.barycentrics)) {
+                hit.triangle = triangle.index;
+                found = true;
+                if (any_hit) break;
+            }
+        }
+        return found;
+    });
+}
+
+HeightfieldRayCaster::HeightfieldRayCaster(const Terrain& terrain)
+    : m_terrain(&terrain)
+{
+    // The terrain mesh has a quad for every grid cell except the last column, see Terrain::GenerateTerrainMesh.
+    const auto& grid = terrain.get_heightmap_grid();
+    if (terrain.m_grid_dim_x < 2 || terrain.m_grid_dim_z < 1 || grid.width() < terrain.m_grid_dim_x + 1 ||
+        grid.height() < terrain.m_grid_dim_z + 1) {
+        return;
+    }
+
+    m_cell_count_x = terrain.m_grid_dim_x - 1;
+    m_cell_count_z = terrain.m_grid_dim_z;
+    m_min_x = terrain.m_bounds.map_min_x;
+    m_min_z = terrain.m_bounds.map_min_z;
+    m_cell_size_x = (terrain.m_bounds.map_max_x - terrain.m_bounds.map_min_x) / terrain.m_grid_dim_x;
+    m_cell_size_z = (terrain.m_bounds.map_max_z - terrain.m_bounds.map_min_z) / terrain.m_grid_dim_z;
+
+    m_block_count_x = (m_cell_count_x + BLOCK_CELLS - 1) / BLOCK_CELLS;
+    m_block_count_z = (m_cell_count_z + BLOCK_CELLS - 1) / BLOCK_CELLS;
+    m_block_heights.assign(static_cast<size_t>(m_block_count_x) * m_block_count_z, { FLT_MAX, -FLT_MAX });
+    for (uint32_t z = 0; z <= m_cell_count_z; z++) {
+        const auto row = grid.row(z);
+        // Points on a block edge belong to the blocks on both sides.
+        const uint32_t block_z_begin = z > 0 ? (z - 1) / BLOCK_CELLS : 0;
+        const uint32_t block_z_end = std::min(z / BLOCK_CELLS, m_block_count_z - 1);
+        for (uint32_t x = 0; x <= m_cell_count_x; x++) {
+            const uint32_t block_x_begin = x > 0 ? (x - 1) / BLOCK_CELLS : 0;
+            const uint32_t block_x_end = std::min(x / BLOCK_CELLS, m_block_count_x - 1);
+            for (uint32_t block_z = block_z_begin; block_z <= block_z_end; block_z++) {
+                for (uint32_t block_x = block_x_begin; block_x <= block_x_end; block_x++) {
+                    auto& heights = m_block_heights[static_cast<size_t>(block_z) * m_block_count_x + block_x];
+                    heights.x = std::min(heights.x, row[x]);
+                    heights.y = std::max(heights.y, row[x]);
+                }
+            }
+            m_min_height = std::min(m_min_height, row[x]);
+            m_max_height = std::max(m_max_height, row[x]);
+        }
+    }
+}
+
+XMFLOAT3 HeightfieldRayCaster::GetGridPoint(uint32_t x, uint32_t z) const
+{
+    return { m_min_x + x * m_cell_size_x, m_terrain->get_heightmap_grid().at(z, x), m_min_z + z * m_cell_size_z };
+}
+
+bool HeightfieldRayCaster::IntersectCell(const Ray& ray, uint32_t cell_x, uint32_t cell_z, float t_enter, float t_exit,
+    RayHit& hit) const
+{
+    const XMFLOAT3 bl = GetGridPoint(cell_x, cell_z);
+    const XMFLOAT3 tl = GetGridPoint(cell_x, cell_z + 1);
+    const XMFLOAT3 tr = GetGridPoint(cell_x + 1, cell_z + 1);
+    const XMFLOAT3 br = GetGridPoint(cell_x + 1, cell_z);
+    if (!overlaps_height(ray, t_enter, t_exit, std::min({ bl.y, tl.y, tr.y, br.y }), std::max({ bl.y, tl.y, tr.y, br.y }))) {
+        return false;
+    }
+
+    // Same winding as the terrain mesh: (BL, TL, TR) and (BL, TR, BR).
+    const uint32_t first_triangle = 2 * (cell_z * m_cell_count_x + cell_x);
+    bool found = false;
+    if (intersect_triangle(ray, bl, sub(tl, bl), sub(tr, bl), hit.distance, hit.distance, hit.barycentrics)) {
+        hit.triangle = first_triangle;
+        found = true;
+    }
+    if (intersect_triangle(ray, bl, sub(tr, bl), sub(br, bl), hit.distance, hit.distance, hit.barycentrics)) {
+        hit.triangle = first_triangle + 1;
+        found = true;
+    }
+    return found;
+}
+
+bool HeightfieldRayCaster::Intersect(const Ray& ray, RayHit& hit) const
+{
+    if (IsEmpty()) return false;
+    hit.distance = std::min(hit.distance, ray.max_distance);
+
+    const CullingAABB bounds{ { m_min_x, m_min_height, m_min_z },
+        { m_min_x + m_cell_count_x * m_cell_size_x, m_max_height, m_min_z + m_cell_count_z * m_cell_size_z } };
+    const float t_begin = intersect_box(bounds, precompute(ray), hit.distance);
+    if (t_begin == FLT_MAX) return false;
+
+    // Exit distance of the terrain bounds, so the walk doesn't run to hit.distance outside of them.
+    float t_end = hit.distance;
+    for (int axis = 0; axis < 3; axis++) {
+        const float direction = get_axis(ray.direction, axis);
+        if (direction == 0) continue;
+        const float plane = direction > 0 ? get_axis(bounds.max, axis) : get_axis(bounds.min, axis);
+        t_end = std::min(t_end, (plane - get_axis(ray.origin, axis)) / direction);
+    }
+
+    // Walk the blocks, then the cells of blocks whose height range overlaps the ray's over the block.
+    const XMFLOAT2 cell_origin((ray.origin.x - m_min_x) / m_cell_size_x, (ray.origin.z - m_min_z) / m_cell_size_z);
+    const XMFLOAT2 cell_direction(ray.direction.x / m_cell_size_x, ray.direction.z / m_cell_size_z);
+    const XMFLOAT2 block_origin(cell_origin.x / BLOCK_CELLS, cell_origin.y / BLOCK_CELLS);
+    const XMFLOAT2 block_direction(cell_direction.x / BLOCK_CELLS, cell_direction.y / BLOCK_CELLS);
+
+    const bool found = walk_grid(block_origin, block_direction, t_begin, t_end, { 0, 0 },
+        { static_cast<int>(m_block_count_x) - 1, static_cast<int>(m_block_count_z) - 1 },
+        [&](int block_x, int block_z, float t_enter, float t_exit) {
+            const auto& heights = m_block_heights[static_cast<size_t>(block_z) * m_block_count_x + block_x];
+            if (!overlaps_height(ray, t_enter, t_exit, heights.x, heights.y)) return false;
+
+            const XMINT2 min_cell(block_x * BLOCK_CELLS, block_z * BLOCK_CELLS);
+            const XMINT2 max_cell(std::min((block_x + 1) * BLOCK_CELLS, m_cell_count_x) - 1,
+                std::min((block_z + 1) * BLOCK_CELLS, m_cell_count_z) - 1);
+            return walk_grid(cell_origin, cell_direction, t_enter, t_exit, min_cell, max_cell,
+                [&](int cell_x, int cell_z, float cell_enter, float cell_exit) {
+                    // A cell's triangles don't reach past its walls, so the first hit along the walk is the closest.
+                    return IntersectCell(ray, cell_x, cell_z, cell_enter, cell_exit, hit);
+                });
+        });
+
+    if (found) {
+        hit.position = { ray.origin.x + ray.direction.x * hit.distance, ray.origin.y + ray.direction.y * hit.distance,
+            ray.origin.z + ray.direction.z * hit.distance };
+    }
+    return found;
+}
+
+void RayScene::Clear()
+{
+    m_models.clear();
+    m_pending_positions.clear();
+    m_pending_indices.clear();
+    m_built_model_count = 0;
+    m_instances.clear();
+    m_nodes.clear();
+    m_instance_order.clear();
+    m_instances_dirty = false;
+    m_terrain = HeightfieldRayCaster();
+}
+
+uint32_t RayScene::AddModel(std::span<const XMFLOAT3> positions, std::span<const uint32_t> indices)
+{
+    m_models.emplace_back();
+    m_pending_positions.emplace_back(positions.begin(), positions.end());
+    m_pending_indices.emplace_back(indices.begin(), indices.end());
+    return static_cast<uint32_t>(m_models.size() - 1);
+}
+
+uint32_t RayScene::AddInstance(uint32_t model, const XMFLOAT4X4& world, uint32_t prop_index, uint32_t submodel_index)
+{
+    m_instances.push_back({ {}, {}, {}, model, prop_index, submodel_index });
+    SetInstanceTransform(static_cast<uint32_t>(m_instances.size() - 1), world);
+    return static_cast<uint32_t>(m_instances.size() - 1);
+}
+
+void RayScene::SetInstanceTransform(uint32_t instance, const XMFLOAT4X4& world)
+{
+    auto& target = m_instances[instance];
+    target.world = world;
+    XMStoreFloat4x4(&target.inverse_world, XMMatrixInverse(nullptr, XMLoadFloat4x4(&world)));
+    m_instances_dirty = true;
+}
+
+void RayScene::SetTerrain(const Terrain* terrain)
+{
+    m_terrain = terrain ? HeightfieldRayCaster(*terrain) : HeightfieldRayCaster();
+}
+
+void RayScene::Build()
+{
+    if (m_built_model_count < m_models.size()) {
+        std::vector<uint32_t> models(m_models.size() - m_built_model_count);
+        std::iota(models.begin(), models.end(), m_built_model_count);
+        std::for_each(std::execution::par, models.begin(), models.end(), [&](uint32_t model) {
+            m_models[model].Build(m_pending_positions[model], m_pending_indices[model]);
+            m_pending_positions[model] = {};
+            m_pending_indices[model] = {};
+        });
+        m_built_model_count = static_cast<uint32_t>(m_models.size());
+        m_instances_dirty = true;
+    }
+
+    if (!m_instances_dirty) return;
+    m_instances_dirty = false;
+    m_nodes.clear();
+    m_instance_order.clear();
+    if (m_instances.empty()) return;
+
+    std::vector<CullingAABB> boxes(m_instances.size());
+    std::vector<XMFLOAT3> centers(m_instances.size());
+    for (size_t i = 0; i < m_instances.size(); i++) {
+        auto& instance = m_instances[i];
+        instance.bounds = TransformAABB(m_models[instance.model].GetBounds(), instance.world);
+        boxes[i] = instance.bounds;
+        XMStoreFloat3(&centers[i], XMVectorScale(XMVectorAdd(XMLoadFloat3(&boxes[i].min), XMLoadFloat3(&boxes[i].max)), 0.5f));
+    }
+
+    m_instance_order.resize(m_instances.size());
+    std::iota(m_instance_order.begin(), m_instance_order.end(), 0);
+    build_node(m_nodes, m_instance_order, boxes, centers, 0, static_cast<uint32_t>(m_instance_order.size()), 0);
+}
+
+bool RayScene::IntersectInstances(const Ray& ray, RayHit& hit, bool any_hit) const
+{
+    return traverse(m_nodes, ray, hit, any_hit, [&](uint32_t first, uint32_t count) {
+        bool found = false;
+        for (uint32_t i = first; i < first + count; i++) {
+            const Instance& instance = m_instances[m_instance_order[i]];
+            const TriangleBVH& model = m_models[instance.model];
+            if (model.IsEmpty()) continue;
+
+            // The direction isn't normalized in model space, so distances along both rays stay the same.
+            const XMMATRIX inverse_world = XMLoadFloat4x4(&instance.inverse_world);
+            Ray local_ray;
+            XMStoreFloat3(&local_ray.origin, XMVector3TransformCoord(XMLoadFloat3(&ray.origin), inverse_world));
+            XMStoreFloat3(&local_ray.direction, XMVector3TransformNormal(XMLoadFloat3(&ray.direction), inverse_world));
+            local_ray.max_distance = hit.distance;
+
+            if (model.Intersect(local_ray, hit, any_hit)) {
+                hit.type = RayHitType::Prop;
+                hit.prop_index = instance.prop_index;
+                hit.submodel_index = instance.submodel_index;
+                found = true;
+                if (any_hit) break;
+            }
+        }
+        return found;
+    });
+}
+
+bool RayScene::IntersectBuilt(const Ray& ray, RayHit& hit, bool any_hit) const
+{
+    hit = RayHit();
+    hit.distance = ray.max_distance;
+
+    bool found = IntersectInstances(ray, hit, any_hit);
+    if (!(found && any_hit) && m_terrain.Intersect(ray, hit)) {
+        hit.type = RayHitType::Terrain;
+        hit.prop_index = RAY_INVALID_ID;
+        hit.submodel_index = RAY_INVALID_ID;
+        found = true;
+    }
+
+    if (!found) {
+        hit = RayHit();
+        return false;
+    }
+    hit.position = { ray.origin.x + ray.direction.x * hit.distance, ray.origin.y + ray.direction.y * hit.distance,
+        ray.origin.z + ray.direction.z * hit.distance };
+    return true;
+}
+
+bool RayScene::Intersect(const Ray& ray, RayHit& hit)
+{
+    Build();
+    return IntersectBuilt(ray, hit, false);
+}
+
+bool RayScene::Occluded(const Ray& ray)
+{
+    Build();
+    RayHit hit;
+    return IntersectBuilt(ray, hit, true);
+}
+
+void RayScene::IntersectBatch(std::span<const Ray> rays, std::span<RayHit> hits)
+{
+    Build();
+    const size_t count = std::min(rays.size(), hits.size());
+    auto query = [&](size_t i) { IntersectBuilt(rays[i], hits[i], false); };
+
+    std::vector<size_t> indices(count);
+    std::iota(indices.begin(), indices.end(), 0);
+    if (count < PARALLEL_BATCH_SIZE) {
+        std::for_each(indices.begin(), indices.end(), query);
+    }
+    else {
+        std::for_each(std::execution::par, indices.begin(), indices.end(), query);
+    }
+}
+
+void RayScene::OccludedBatch(std::span<const Ray> rays, std::span<uint8_t> occluded)
+{
+    Build();
+    const size_t count = std::min(rays.size(), occluded.size());
+    auto query = [&](size_t i) {
+        RayHit hit;
+        occluded[i] = IntersectBuilt(rays[i], hit, true) ? 1 : 0;
+    };
+
+    std::vector<size_t> indices(count);
+    std::iota(indices.begin(), indices.end(), 0);
+    if (count < PARALLEL_BATCH_SIZE) {
+        std::for_each(indices.begin(), indices.end(), query);
+    }
+    else {
+        std::for_each(std::execution::par, indices.begin(), indices.end(), query);
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <cfloat>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <DirectXMath.h>
+#include "FrustumCulling.h"
+
+class Terrain;
+
+constexpr uint32_t RAY_INVALID_ID = 0xFFFFFFFF;
+
+struct Ray
+{
+    DirectX::XMFLOAT3 origin;
+    DirectX::XMFLOAT3 direction; // Hit distances are in units of its length
+    float max_distance = FLT_MAX;
+};
+
+enum class RayHitType
+{
+    None,
+    Prop,
+    Terrain
+};
+
+struct RayHit
+{
+    RayHitType type = RayHitType::None;
+    float distance = FLT_MAX;
+    DirectX::XMFLOAT3 position{};
+    // Weights of the triangle's second and third vertex, the first one gets 1 - x - y.
+    DirectX::XMFLOAT2 barycentrics{};
+
+    // Prop hits: the prop and submodel from RayScene::AddInstance, the triangle in the submodel's index list.
+    // Terrain hits: the triangle is 2 * (cell_z * cell_count_x + cell_x) + k, see HeightfieldRayCaster.
+    uint32_t prop_index = RAY_INVALID_ID;
+    uint32_t submodel_index = RAY_INVALID_ID;
+    uint32_t triangle = RAY_INVALID_ID;
+};
+
+/**
+ * @brief Bounding volume hierarchy over the triangles of one model, in model space.
+ *
+ * Built top-down with a binned surface area heuristic. Triangles are copied in leaf order as a vertex and
+ * two edges, which is what the Moller-Trumbore test needs, so the source mesh doesn't have to be kept.
+ * Both triangle sides are hit.
+ */
+class TriangleBVH
+{
+public:
+    void Build(std::span<const DirectX::XMFLOAT3> positions, std::span<const uint32_t> indices);
+
+    bool IsEmpty() const { return m_nodes.empty(); }
+    size_t GetTriangleCount() const { return m_triangles.size(); }
+    size_t GetNodeCount() const { return m_nodes.size(); }
+    const CullingAABB& GetBounds() const { return m_bounds; }
+
+    // Updates hit (distance, barycentrics, triangle) and returns true if a triangle is closer than hit.distance.
+    // With any_hit the first triangle found in range is taken, which is enough for occlusion tests.
+    bool Intersect(const Ray& ray, RayHit& hit, bool any_hit = false) const;
+
+private:
+    struct Node
+    {
+        CullingAABB bounds;
+        // Leaves: range in m_triangles. Inner nodes: first is the index of the right child, the left one follows the node.
+        uint32_t first;
+        uint32_t count; // 0 for inner nodes
+    };
+
+    struct Triangle
+    {
+        DirectX::XMFLOAT3 v0;
+        DirectX::XMFLOAT3 edge1;
+        DirectX::XMFLOAT3 edge2;
+        uint32_t index; // Triangle in the source index list
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<Triangle> m_triangles;
+    CullingAABB m_bounds{};
+};
+
+/**
+ * @brief Ray casts against the terrain height grid without building triangles.
+ *
+ * The grid is cut into square blocks that store their lowest and highest height. A ray walks the blocks
+ * with a 2D DDA and only descends into the cells of blocks whose height range it crosses. Each cell is
+ * tested as the two triangles the terrain mesh draws for it, split along the BL-TR diagonal.
+ */
+class HeightfieldRayCaster
+{
+public:
+    static constexpr uint32_t BLOCK_CELLS = 8;
+
+    HeightfieldRayCaster() = default;
+    explicit HeightfieldRayCaster(const Terrain& terrain);
+
+    bool IsEmpty() const { return m_cell_count_x == 0 || m_cell_count_z == 0; }
+    uint32_t GetCellCountX() const { return m_cell_count_x; }
+
+    // Same contract as TriangleBVH::Intersect, in world space. Also sets the hit position.
+    bool Intersect(const Ray& ray, RayHit& hit) const;
+
+private:
+    bool IntersectCell(const Ray& ray, uint32_t cell_x, uint32_t cell_z, float t_enter, float t_exit, RayHit& hit) const;
+    DirectX::XMFLOAT3 GetGridPoint(uint32_t x, uint32_t z) const;
+
+    const Terrain* m_terrain = nullptr;
+    uint32_t m_cell_count_x = 0;
+    uint32_t m_cell_count_z = 0;
+    float m_min_x = 0;
+    float m_min_z = 0;
+    float m_cell_size_x = 1;
+    float m_cell_size_z = 1;
+    float m_min_height = FLT_MAX;
+    float m_max_height = -FLT_MAX;
+
+    uint32_t m_block_count_x = 0;
+    uint32_t m_block_count_z = 0;
+    std::vector<DirectX::XMFLOAT2> m_block_heights; // (min, max) per block, row major
+};
+
+/**
+ * @brief Closest hit and occlusion queries against props and terrain on the CPU.
+ *
+ * Every unique model gets one TriangleBVH that all of its instances share. Instances keep their world
+ * matrix and its inverse and are organized in a BVH over their world bounds, built with the same heuristic.
+ * A ray is moved into model space per instance instead of transforming any geometry, so moving a prop
+ * only rebuilds the instance BVH. Builds happen lazily on the next query.
+ *
+ * Queries are const and can run from any number of threads once the scene is built, see Build.
+ */
+class RayScene
+{
+public:
+    void Clear();
+
+    // Returns the model id passed to AddInstance. positions and indices form a triangle list.
+    uint32_t AddModel(std::span<const DirectX::XMFLOAT3> positions, std::span<const uint32_t> indices);
+    uint32_t AddInstance(uint32_t model, const DirectX::XMFLOAT4X4& world, uint32_t prop_index, uint32_t submodel_index);
+    void SetInstanceTransform(uint32_t instance, const DirectX::XMFLOAT4X4& world);
+
+    // The terrain must outlive the scene or be unset with nullptr.
+    void SetTerrain(const Terrain* terrain);
+
+    uint32_t GetModelCount() const { return static_cast<uint32_t>(m_models.size()); }
+    uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_instances.size()); }
+
+    // Builds pending model and instance BVHs. Queries call it on their own, call it once up front before
+    // querying from several threads.
+    void Build();
+
+    bool Intersect(const Ray& ray, RayHit& hit);
+
+    // True if anything is hit within ray.max_distance, e.g. for line of sight between two points.
+    bool Occluded(const Ray& ray);
+
+    // Batched Intersect/Occluded, large batches are split across threads.
+    void IntersectBatch(std::span<const Ray> rays, std::span<RayHit> hits);
+    void OccludedBatch(std::span<const Ray> rays, std::span<uint8_t> occluded);
+
+private:
+    struct Instance
+    {
+        DirectX::XMFLOAT4X4 world;
+        DirectX::XMFLOAT4X4 inverse_world;
+        CullingAABB bounds;
+        uint32_t model;
+        uint32_t prop_index;
+        uint32_t submodel_index;
+    };
+
+    struct Node
+    {
+        CullingAABB bounds;
+        uint32_t first; // See TriangleBVH::Node
+        uint32_t count;
+    };
+
+    bool IntersectBuilt(const Ray& ray, RayHit& hit, bool any_hit) const;
+    bool IntersectInstances(const Ray& ray, RayHit& hit, bool any_hit) const;
+
+    std::vector<TriangleBVH> m_models;
+    std::vector<std::vector<DirectX::XMFLOAT3>> m_pending_positions; // Per model, until its BVH is built
+    std::vector<std::vector<uint32_t>> m_pending_indices;
+    uint32_t m_built_model_count = 0;
+
+    std::vector<Instance> m_instances;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_instance_order; // Leaf ranges of m_nodes index this
+    bool m_instances_dirty = false;
+
+    HeightfieldRayCaster m_terrain;
+};
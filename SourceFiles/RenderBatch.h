@@ -1,6 +1,7 @@
 #pragma once
 #include "RenderCommand.h"
 #include "DXMathHelpers.h"
+#include "RenderSortKey.h"
 
 class RenderBatch
 {
@@ -18,54 +19,61 @@ public:
 		m_needsSorting = true;
 	}
 
-	void SortCommands(XMFLOAT3& camera_pos)
+	// Builds the draw order for a camera position. The queue is kept until commands change or the camera moves,
+	// so passes that share a camera (e.g. the opaque and transparent main passes) only sort once.
+	void SortCommands(const XMFLOAT3& camera_pos)
 	{
-		if (!m_needsSorting) { return; }
-
-		m_sortedCommands.clear();
-		m_sortedCommands.reserve(m_commands.size());
+		if (!m_needsSorting && camera_pos.x == m_sortedCameraPos.x && camera_pos.y == m_sortedCameraPos.y &&
+			camera_pos.z == m_sortedCameraPos.z)
+		{
+			return;
+		}
 
-		for (const auto& entry : m_commands) { m_sortedCommands.push_back(entry.second); }
+		m_sortedCameraPos = camera_pos;
+		m_needsSorting = false;
+		m_sortCount++;
 
-		auto comparator = [&camera_pos](const RenderCommand& a, const RenderCommand& b) -> bool
+		// unordered_map nodes are stable, so the command pointers stay valid until a command is removed.
+		m_sortItems.clear();
+		m_commandPointers.clear();
+		const XMVECTOR camera = XMLoadFloat3(&camera_pos);
+		for (const auto& [mesh_id, command] : m_commands)
 		{
-			if (a.blend_state != BlendState::AlphaBlend && b.blend_state != BlendState::AlphaBlend)
-			{
-				return a.meshInstance->GetMeshID() > b.meshInstance->GetMeshID();
-			}
-
-			if (a.blend_state != BlendState::AlphaBlend) { return false; }
+			if (!command.should_render) { continue; }
+
+			const auto& mesh_instance = *command.meshInstance;
+			const XMFLOAT3 world_position = GetPositionFromMatrix(mesh_instance.GetPerObjectData().world);
+			const XMVECTOR position = XMVectorAdd(XMLoadFloat3(&mesh_instance.GetMesh().center), XMLoadFloat3(&world_position));
+			const XMVECTOR diff = XMVectorSubtract(position, camera);
+			const float distance_sq = XMVectorGetX(XMVector3LengthSq(diff));
+
+			const uint32_t shader = static_cast<uint32_t>(command.pixelShaderType);
+			const uint32_t state = (static_cast<uint32_t>(command.primitiveTopology) << 1) | (command.should_cull ? 1 : 0);
+			const uint64_t key = command.blend_state == BlendState::AlphaBlend
+				? MakeTransparentSortKey(shader, mesh_instance.GetTextureSetKey(), state, distance_sq)
+				: MakeOpaqueSortKey(shader, mesh_instance.GetTextureSetKey(), state, mesh_instance.GetGeometryKey(), distance_sq);
+
+			m_sortItems.push_back({ key, static_cast<uint32_t>(m_commandPointers.size()) });
+			m_commandPointers.push_back(&command);
+		}
 
-			if (b.blend_state != BlendState::AlphaBlend) { return true; }
+		RadixSortRenderItems(m_sortItems, m_sortScratch);
 
-			if (a.blend_state == BlendState::AlphaBlend && b.blend_state == BlendState::AlphaBlend)
+		m_sortedCommands.resize(m_sortItems.size());
+		m_firstTransparentCommand = m_sortItems.size();
+		for (size_t i = 0; i < m_sortItems.size(); i++)
+		{
+			m_sortedCommands[i] = m_commandPointers[m_sortItems[i].index];
+			if ((m_sortItems[i].key & RENDER_SORT_KEY_TRANSPARENT_BIT) && m_firstTransparentCommand == m_sortItems.size())
 			{
-				const auto a_local_pos = a.meshInstance->GetMesh().center;
-				const auto b_local_pos = b.meshInstance->GetMesh().center;
-
-				const auto a_world_pos = GetPositionFromMatrix(a.meshInstance->GetPerObjectData().world);
-				const auto b_world_pos = GetPositionFromMatrix(b.meshInstance->GetPerObjectData().world);
-
-				const auto a_pos = XMFLOAT3(a_local_pos.x + a_world_pos.x, a_local_pos.y + a_world_pos.y,
-				                            a_local_pos.z + a_world_pos.z);
-				const auto b_pos = XMFLOAT3(b_local_pos.x + b_world_pos.x, b_local_pos.y + b_world_pos.y,
-				                            b_local_pos.z + b_world_pos.z);
-
-				XMVECTOR a_diff = XMVectorSubtract(XMLoadFloat3(&a_pos), XMLoadFloat3(&camera_pos));
-				XMVECTOR b_diff = XMVectorSubtract(XMLoadFloat3(&b_pos), XMLoadFloat3(&camera_pos));
-
-				const auto a_distance_sq = XMVectorGetX(XMVector3Dot(a_diff, a_diff));
-				const auto b_distance_sq = XMVectorGetX(XMVector3Dot(b_diff, b_diff));
-
-				if (a_distance_sq == b_distance_sq) { return a.meshInstance->GetMeshID() < b.meshInstance->GetMeshID(); }
-
-				return a_distance_sq < b_distance_sq;
+				m_firstTransparentCommand = i;
 			}
-		};
-
-		std::sort(m_sortedCommands.rbegin(), m_sortedCommands.rend(), comparator);
+		}
 	}
 
+	// Forces the next SortCommands to rebuild, e.g. after a mesh moved.
+	void InvalidateOrder() { m_needsSorting = true; }
+
 	void SetShouldRender(int mesh_id, bool should_render)
 	{
 		auto it = m_commands.find(mesh_id);
@@ -89,9 +97,13 @@ public:
 	{
 		m_commands.clear();
 		m_sortedCommands.clear();
+		m_needsSorting = true;
 	}
 
-	std::vector<RenderCommand> GetCommands() { return m_sortedCommands; }
+	// Commands with should_render set, opaque ones first. Valid until the next SortCommands call.
+	const std::vector<const RenderCommand*>& GetCommands() const { return m_sortedCommands; }
+	size_t GetFirstTransparentCommand() const { return m_firstTransparentCommand; }
+	uint32_t GetSortCount() const { return m_sortCount; }
 
 	const std::optional<RenderCommand> const GetCommand(int mesh_id)
 	{
@@ -116,6 +128,13 @@ public:
 
 private:
 	std::unordered_map<int, RenderCommand> m_commands;
-	std::vector<RenderCommand> m_sortedCommands;
-	bool m_needsSorting = false;
+	std::vector<const RenderCommand*> m_sortedCommands;
+	size_t m_firstTransparentCommand = 0;
+	bool m_needsSorting = true;
+	XMFLOAT3 m_sortedCameraPos{ 0, 0, 0 };
+	uint32_t m_sortCount = 0;
+
+	std::vector<const RenderCommand*> m_commandPointers;
+	std::vector<RenderSortItem> m_sortItems;
+	std::vector<RenderSortItem> m_sortScratch;
 };
@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "RenderSortKey.h"
+#include <array>
+#include <bit>
+
+namespace
+{
+    uint32_t distance_bits(float distance_sq)
+    {
+        return std::bit_cast<uint32_t>(distance_sq > 0.0f ? distance_sq : 0.0f);
+    }
+}
+
+uint64_t MakeOpaqueSortKey(uint32_t shader, uint32_t texture_set, uint32_t state, uint32_t geometry, float distance_sq)
+{
+    return (static_cast<uint64_t>(shader & 0x7F) << 56) |
+        (static_cast<uint64_t>(texture_set & 0xFFFF) << 40) |
+        (static_cast<uint64_t>(state & 0xFF) << 32) |
+        (static_cast<uint64_t>(geometry & 0xFFFF) << 16) |
+        (distance_bits(distance_sq) >> 16);
+}
+
+uint64_t MakeTransparentSortKey(uint32_t shader, uint32_t texture_set, uint32_t state, float distance_sq)
+{
+    const uint32_t inverted_distance = ~distance_bits(distance_sq);
+    return RENDER_SORT_KEY_TRANSPARENT_BIT |
+        (static_cast<uint64_t>(inverted_distance) << 31) |
+        (static_cast<uint64_t>(shader & 0x7F) << 24) |
+        (static_cast<uint64_t>(texture_set & 0xFFFF) << 8) |
+        (state & 0xFF);
+}
+
+void RadixSortRenderItems(std::vector<RenderSortItem>& items, std::vector<RenderSortItem>& scratch)
+{
+    if (items.size() < 2) return;
+    scratch.resize(items.size());
+
+    // Histograms for all eight digits in a single pass over the keys.
+    std::array<std::array<uint32_t, 256>, 8> counts{};
+    for (const auto& item : items) {
+        for (int digit = 0; digit < 8; digit++) {
+            counts[digit][(item.key >> (digit * 8)) & 0xFF]++;
+        }
+    }
+
+    const uint32_t item_count = static_cast<uint32_t>(items.size());
+    for (int digit = 0; digit < 8; digit++) {
+        auto& digit_counts = counts[digit];
+        const uint32_t first_value = (items[0].key >> (digit * 8)) & 0xFF;
+        if (digit_counts[first_value] == item_count) continue;
+
+        uint32_t offset = 0;
+        for (auto& count : digit_counts) {
+            const uint32_t value_count = count;
+            count = offset;
+            offset += value_count;
+        }
+
+        for (const auto& item : items) {
+            scratch[digit_counts[(item.key >> (digit * 8)) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
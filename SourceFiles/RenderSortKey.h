@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 64-bit draw order keys for the render queue.
+ *
+ * Opaque draws come first, grouped by pixel shader, texture set and rasterizer/topology
+ * state so consecutive draws share as much state as possible, then by geometry so instances
+ * of a model can be merged, then front to back. Transparent draws follow back to front,
+ * with the state fields only breaking ties.
+ *
+ * Opaque:      [63] 0 | [62..56] shader | [55..40] texture set | [39..32] state | [31..16] geometry | [15..0] distance
+ * Transparent: [63] 1 | [62..31] inverted distance | [30..24] shader | [23..8] texture set | [7..0] state
+ */
+constexpr uint64_t RENDER_SORT_KEY_TRANSPARENT_BIT = 1ull << 63;
+
+struct RenderSortItem
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+// distance_sq is the squared camera distance, its float bits order like the value since it is never negative.
+// Opaque keys only keep the upper 16 bits of it, a coarse front to back order within a geometry.
+uint64_t MakeOpaqueSortKey(uint32_t shader, uint32_t texture_set, uint32_t state, uint32_t geometry, float distance_sq);
+uint64_t MakeTransparentSortKey(uint32_t shader, uint32_t texture_set, uint32_t state, float distance_sq);
+
+// Stable LSD radix sort by key, 8 bits per pass. Passes where all keys share the digit are skipped.
+void RadixSortRenderItems(std::vector<RenderSortItem>& items, std::vector<RenderSortItem>& scratch);
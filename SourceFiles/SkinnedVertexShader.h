@@ -125,6 +125,8 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
 float4 SkinPosition(float3 pos, uint4 indices, float4 weights)
@@ -243,6 +245,9 @@ PixelInputType main(SkinnedVertexInputType input)
         output.reflectionSpacePos = mul(reflectionViewPosition, reflection_proj);
     }
 
+    output.object_id = object_id;
+    output.highlight_state = highlight_state;
+
     return output;
 }
 )";
@@ -118,6 +118,8 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
 // Applies linear blend skinning to a position
@@ -270,5 +272,8 @@ PixelInputType main(SkinnedVertexInputType input)
         output.reflectionSpacePos = mul(reflectionViewPosition, reflection_proj);
     }
 
+    output.object_id = object_id;
+    output.highlight_state = highlight_state;
+
     return output;
 }
@@ -1,7 +1,8 @@
 #include "pch.h"
 #include "Terrain.h"
 #include <algorithm>
-#include <map>
+#include <execution>
+#include <numeric>
 
 static const float ATLAS_SIZE = 2048.0f;
 static const float TILE_SIZE = 256.0f;
@@ -82,31 +83,226 @@ static XMFLOAT2 make_neutral_uv() {
     return calculate_corner_uv(-1, 3, false, 0);
 }
 
-float Terrain::get_height_at(float world_x, float world_z) const
+// Atlas UV source for one blend layer of a terrain quad. Neutral layers ignore the corner.
+struct QuadLayer
 {
-    float grid_x = (world_x - m_bounds.map_min_x) / (m_bounds.map_max_x - m_bounds.map_min_x) * m_grid_dim_x;
-    float grid_z = (world_z - m_bounds.map_min_z) / (m_bounds.map_max_z - m_bounds.map_min_z) * m_grid_dim_z;
+    int tex_idx;
+    int quadrant;
+    bool rotated;
+    bool neutral;
+};
 
-    int cell_x = static_cast<int>(grid_x);
-    int cell_z = static_cast<int>(grid_z);
+// The three blend layers of a quad, resolved once per quad and evaluated per corner without allocating.
+struct QuadLayers
+{
+    QuadLayer layers[3];
 
-    if (cell_x >= m_grid_dim_x - 1) cell_x = m_grid_dim_x - 2;
-    if (cell_z >= m_grid_dim_z - 1) cell_z = m_grid_dim_z - 2;
+    XMFLOAT2 corner_uv(int layer, int corner) const
+    {
+        const QuadLayer& l = layers[layer];
+        return l.neutral ? make_neutral_uv() : calculate_corner_uv(l.tex_idx, l.quadrant, l.rotated, corner);
+    }
+};
 
-    float dx = grid_x - cell_x;
-    float dz = grid_z - cell_z;
+static QuadLayers resolve_quad_layers(int tex_tl, int tex_tr, int tex_bl, int tex_br, int prng_quadrant)
+{
+    const QuadLayer neutral{ -1, 3, false, true };
+    QuadLayers result{};
+
+    if (tex_tl == tex_tr && tex_tl == tex_bl && tex_tl == tex_br) {
+        result.layers[0] = { tex_tl, prng_quadrant, false, false };
+        result.layers[1] = neutral;
+        result.layers[2] = neutral;
+        return result;
+    }
 
-    float h00 = grid[cell_z][cell_x];     
-    float h10 = grid[cell_z][cell_x + 1]; 
-    float h01 = grid[cell_z + 1][cell_x]; 
-    float h11 = grid[cell_z + 1][cell_x + 1]; 
+    // Build per-texture corner masks sorted by texture index (matching Python's tex_corners)
+    int tex_list[4];
+    int mask_list[4];
+    int tex_count = 0;
+    auto add_corner = [&](int tex, int bit) {
+        int pos = 0;
+        while (pos < tex_count && tex_list[pos] < tex) pos++;
+        if (pos < tex_count && tex_list[pos] == tex) {
+            mask_list[pos] |= bit;
+            return;
+        }
+        for (int k = tex_count; k > pos; k--) {
+            tex_list[k] = tex_list[k - 1];
+            mask_list[k] = mask_list[k - 1];
+        }
+        tex_list[pos] = tex;
+        mask_list[pos] = bit;
+        tex_count++;
+    };
+    add_corner(tex_tl, 1);  // TL = bit 0
+    add_corner(tex_tr, 2);  // TR = bit 1
+    add_corner(tex_bl, 4);  // BL = bit 2
+    add_corner(tex_br, 8);  // BR = bit 3
+
+    // Primary variants (matching Python exactly). Only the first three layers reach the vertex.
+    int layer_count = 0;
+    for (int i = 0; i < tex_count && layer_count < 3; i++) {
+        if (i == 0) {
+            // First texture uses random quadrant
+            result.layers[layer_count++] = { tex_list[i], prng_quadrant, false, false };
+        } else {
+            // Other textures use LUT quadrant with rotation
+            uint16_t primary = VARIANT_LOOKUP[mask_list[i]].first;
+            result.layers[layer_count++] = { tex_list[i], primary & 0x3, (primary & 0x8000) != 0, false };
+        }
+    }
 
-    float height = h00 * (1 - dx) * (1 - dz) +
+    // Add secondary variant ONLY for 2-texture case (after loop, matching Python)
+    if (tex_count == 2) {
+        int secondary = VARIANT_LOOKUP[mask_list[1]].second;
+        if (secondary != -1) {
+            result.layers[layer_count++] = { tex_list[1], secondary & 0x3, (secondary & 0x8000) != 0, false };
+        } else {
+            result.layers[layer_count++] = neutral;
+        }
+    }
+
+    // Pad to 3 variants
+    while (layer_count < 3) {
+        result.layers[layer_count++] = neutral;
+    }
+
+    return result;
+}
+
+static GWVertex make_quad_corner(const QuadLayers& layers, int corner, const XMFLOAT3& position, const XMFLOAT3& normal,
+    const XMFLOAT2& local_uv)
+{
+    GWVertex v;
+    v.position = position;
+    v.normal = normal;
+    v.tex_coord0 = layers.corner_uv(0, corner);
+    v.tex_coord1 = layers.corner_uv(1, corner);
+    v.tex_coord2 = layers.corner_uv(2, corner);
+    v.tex_coord3 = local_uv;
+    return v;
+}
+
+// Clamp a bilinear cell index into [0, dim - 2] so the 2x2 footprint stays inside the grid.
+static int clamp_cell(float grid_coord, uint32_t dim)
+{
+    int cell = static_cast<int>(grid_coord);
+    return std::clamp(cell, 0, static_cast<int>(dim) - 2);
+}
+
+static float bilinear(const TerrainGrid<float>& grid, int cell_x, int cell_z, float dx, float dz)
+{
+    const float* row0 = grid.data() + static_cast<size_t>(cell_z) * grid.width() + cell_x;
+    const float* row1 = row0 + grid.width();
+
+    float h00 = row0[0];
+    float h10 = row0[1];
+    float h01 = row1[0];
+    float h11 = row1[1];
+
+    return h00 * (1 - dx) * (1 - dz) +
         h10 * dx * (1 - dz) +
         h01 * (1 - dx) * dz +
         h11 * dx * dz;
+}
 
-    return height;
+float Terrain::get_height_at(float world_x, float world_z) const
+{
+    float grid_x = (world_x - m_bounds.map_min_x) / (m_bounds.map_max_x - m_bounds.map_min_x) * m_grid_dim_x;
+    float grid_z = (world_z - m_bounds.map_min_z) / (m_bounds.map_max_z - m_bounds.map_min_z) * m_grid_dim_z;
+
+    int cell_x = clamp_cell(grid_x, m_grid_dim_x);
+    int cell_z = clamp_cell(grid_z, m_grid_dim_z);
+
+    return bilinear(m_height_grid, cell_x, cell_z, grid_x - cell_x, grid_z - cell_z);
+}
+
+void Terrain::get_heights_at(std::span<const XMFLOAT2> xz, std::span<float> heights) const
+{
+    size_t count = std::min(xz.size(), heights.size());
+    size_t i = 0;
+
+#if defined(_XM_SSE_INTRINSICS_)
+    const __m128 min_x = _mm_set1_ps(m_bounds.map_min_x);
+    const __m128 min_z = _mm_set1_ps(m_bounds.map_min_z);
+    const __m128 range_x = _mm_set1_ps(m_bounds.map_max_x - m_bounds.map_min_x);
+    const __m128 range_z = _mm_set1_ps(m_bounds.map_max_z - m_bounds.map_min_z);
+    const __m128 dim_x = _mm_set1_ps(static_cast<float>(m_grid_dim_x));
+    const __m128 dim_z = _mm_set1_ps(static_cast<float>(m_grid_dim_z));
+    const __m128 max_cell_x = _mm_set1_ps(static_cast<float>(static_cast<int>(m_grid_dim_x) - 2));
+    const __m128 max_cell_z = _mm_set1_ps(static_cast<float>(static_cast<int>(m_grid_dim_z) - 2));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const float* heights_data = m_height_grid.data();
+    const size_t width = m_height_grid.width();
+
+    for (; i + 4 <= count; i += 4)
+    {
+        // Deinterleave four (x, z) pairs into separate x and z lanes.
+        __m128 p01 = _mm_loadu_ps(&xz[i].x);
+        __m128 p23 = _mm_loadu_ps(&xz[i + 2].x);
+        __m128 world_x = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 world_z = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 grid_x = _mm_mul_ps(_mm_div_ps(_mm_sub_ps(world_x, min_x), range_x), dim_x);
+        __m128 grid_z = _mm_mul_ps(_mm_div_ps(_mm_sub_ps(world_z, min_z), range_z), dim_z);
+
+        // Clamping before truncation gives the same cell as clamp_cell for every finite input.
+        __m128i cell_x = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(grid_x, zero), max_cell_x));
+        __m128i cell_z = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(grid_z, zero), max_cell_z));
+
+        __m128 dx = _mm_sub_ps(grid_x, _mm_cvtepi32_ps(cell_x));
+        __m128 dz = _mm_sub_ps(grid_z, _mm_cvtepi32_ps(cell_z));
+
+        // SSE2 has no gather, so fetch the 2x2 footprint per lane.
+        alignas(16) int32_t cells_x[4], cells_z[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(cells_x), cell_x);
+        _mm_store_si128(reinterpret_cast<__m128i*>(cells_z), cell_z);
+
+        alignas(16) float h00[4], h10[4], h01[4], h11[4];
+        for (int lane = 0; lane < 4; lane++)
+        {
+            const float* row0 = heights_data + static_cast<size_t>(cells_z[lane]) * width + cells_x[lane];
+            h00[lane] = row0[0];
+            h10[lane] = row0[1];
+            h01[lane] = row0[width];
+            h11[lane] = row0[width + 1];
+        }
+
+        __m128 inv_dx = _mm_sub_ps(one, dx);
+        __m128 inv_dz = _mm_sub_ps(one, dz);
+
+        __m128 height = _mm_mul_ps(_mm_mul_ps(_mm_load_ps(h00), inv_dx), inv_dz);
+        height = _mm_add_ps(height, _mm_mul_ps(_mm_mul_ps(_mm_load_ps(h10), dx), inv_dz));
+        height = _mm_add_ps(height, _mm_mul_ps(_mm_mul_ps(_mm_load_ps(h01), inv_dx), dz));
+        height = _mm_add_ps(height, _mm_mul_ps(_mm_mul_ps(_mm_load_ps(h11), dx), dz));
+
+        _mm_storeu_ps(&heights[i], height);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        heights[i] = get_height_at(xz[i].x, xz[i].y);
+    }
+}
+
+std::vector<float> Terrain::get_trapezoid_corner_heights(const std::vector<PathfindingTrapezoid>& trapezoids) const
+{
+    std::vector<XMFLOAT2> corners;
+    corners.reserve(trapezoids.size() * 4);
+    for (const auto& trap : trapezoids)
+    {
+        corners.emplace_back(trap.xtl, trap.yt);
+        corners.emplace_back(trap.xtr, trap.yt);
+        corners.emplace_back(trap.xbl, trap.yb);
+        corners.emplace_back(trap.xbr, trap.yb);
+    }
+
+    std::vector<float> heights(corners.size());
+    get_heights_at(corners, heights);
+    return heights;
 }
 
 Mesh Terrain::GenerateTerrainMesh()
@@ -116,8 +312,8 @@ Mesh Terrain::GenerateTerrainMesh()
     uint32_t sub_grid_rows = m_grid_dim_z / grid_dims;
     uint32_t sub_grid_cols = m_grid_dim_x / grid_dims;
 
-    m_texture_index_grid.resize(m_grid_dim_z + 1, std::vector<uint32_t>(m_grid_dim_x + 1, 0));
-    m_terrain_shadow_map_grid.resize(m_grid_dim_z + 1, std::vector<uint32_t>(m_grid_dim_x + 1, 0));
+    m_texture_index_grid.resize(m_grid_dim_x + 1, m_grid_dim_z + 1, 0);
+    m_terrain_shadow_map_grid.resize(m_grid_dim_x + 1, m_grid_dim_z + 1, 0);
 
     float min_h = FLT_MAX;
     float max_h = FLT_MIN;
@@ -139,11 +335,11 @@ Mesh Terrain::GenerateTerrainMesh()
                     // FLIP STORAGE: Map Top-Down File Data to Bottom-Up Grid Index
                     int grid_row_idx = m_grid_dim_z - k;
                     
-                    grid[grid_row_idx][l] = -m_height_map[count];
-                    m_texture_index_grid[grid_row_idx][l] = m_terrain_texture_indices[count];
-                    m_terrain_shadow_map_grid[grid_row_idx][l] = m_terrain_shadow_map[count];
+                    m_height_grid.at(grid_row_idx, l) = -m_height_map[count];
+                    m_texture_index_grid.at(grid_row_idx, l) = m_terrain_texture_indices[count];
+                    m_terrain_shadow_map_grid.at(grid_row_idx, l) = m_terrain_shadow_map[count];
                     
-                    float h = grid[grid_row_idx][l];
+                    float h = m_height_grid.at(grid_row_idx, l);
                     if (h < min_h) min_h = h;
                     if (h > max_h) max_h = h;
                     
@@ -159,204 +355,378 @@ Mesh Terrain::GenerateTerrainMesh()
     float delta_x = (m_bounds.map_max_x - m_bounds.map_min_x) / m_grid_dim_x;
     float delta_z = (m_bounds.map_max_z - m_bounds.map_min_z) / m_grid_dim_z;
 
+    const uint32_t stride = m_grid_dim_x + 1;
+    const uint32_t cells_x = m_grid_dim_x - 1;
+    const uint32_t cells_z = m_grid_dim_z - 1;
+
+    std::vector<uint32_t> rows(m_grid_dim_z + 1);
+    std::iota(rows.begin(), rows.end(), 0);
+
     // 2. Pre-calculate Normals
-    std::vector<XMFLOAT3> grid_normals((m_grid_dim_z + 1) * (m_grid_dim_x + 1), XMFLOAT3(0, 1, 0));
-    
-    for (uint32_t z = 0; z < m_grid_dim_z - 1; z++) {
-        for (uint32_t x = 0; x < m_grid_dim_x - 1; x++) {
-            float y00 = grid[z][x];
-            float y10 = grid[z][x + 1];
-            float y01 = grid[z + 1][x];
-            
+    // Face normals are computed per row in parallel, then each vertex gathers its (up to) four faces.
+    std::vector<XMFLOAT3> face_normals(static_cast<size_t>(cells_x) * cells_z);
+    std::for_each(std::execution::par, rows.begin(), rows.begin() + cells_z, [&](uint32_t z) {
+        for (uint32_t x = 0; x < cells_x; x++) {
+            float y00 = m_height_grid.at(z, x);
+            float y10 = m_height_grid.at(z, x + 1);
+            float y01 = m_height_grid.at(z + 1, x);
+
             XMFLOAT3 p00(m_bounds.map_min_x + x * delta_x, y00, m_bounds.map_min_z + z * delta_z);
             XMFLOAT3 p10(m_bounds.map_min_x + (x+1) * delta_x, y10, m_bounds.map_min_z + z * delta_z);
             XMFLOAT3 p01(m_bounds.map_min_x + x * delta_x, y01, m_bounds.map_min_z + (z+1) * delta_z);
-            
-            XMFLOAT3 n = compute_normal(p00, p10, p01); 
-            
-            int idx00 = z * (m_grid_dim_x + 1) + x;
-            int idx10 = z * (m_grid_dim_x + 1) + x + 1;
-            int idx01 = (z + 1) * (m_grid_dim_x + 1) + x;
-            int idx11 = (z + 1) * (m_grid_dim_x + 1) + x + 1;
-
-            grid_normals[idx00] = AddXMFLOAT3(grid_normals[idx00], n);
-            grid_normals[idx10] = AddXMFLOAT3(grid_normals[idx10], n);
-            grid_normals[idx01] = AddXMFLOAT3(grid_normals[idx01], n);
-            grid_normals[idx11] = AddXMFLOAT3(grid_normals[idx11], n); 
+
+            face_normals[static_cast<size_t>(z) * cells_x + x] = compute_normal(p00, p10, p01);
         }
-    }
-    for(auto& n : grid_normals) n = NormalizeXMFLOAT3(n);
+    });
+
+    std::vector<XMFLOAT3> grid_normals(static_cast<size_t>(m_grid_dim_z + 1) * stride);
+    std::for_each(std::execution::par, rows.begin(), rows.end(), [&](uint32_t z) {
+        for (uint32_t x = 0; x <= m_grid_dim_x; x++) {
+            // Sum faces in the order a row-major scatter would visit them so the result is deterministic
+            XMFLOAT3 n(0, 1, 0);
+            auto accumulate = [&](uint32_t face_z, uint32_t face_x) {
+                if (face_z >= cells_z || face_x >= cells_x) return;
+                const XMFLOAT3& f = face_normals[static_cast<size_t>(face_z) * cells_x + face_x];
+                n.x += f.x;
+                n.y += f.y;
+                n.z += f.z;
+            };
+            if (z > 0 && x > 0) accumulate(z - 1, x - 1);
+            if (z > 0) accumulate(z - 1, x);
+            if (x > 0) accumulate(z, x - 1);
+            accumulate(z, x);
+
+            grid_normals[static_cast<size_t>(z) * stride + x] = NormalizeXMFLOAT3(n);
+        }
+    });
 
     // 3. Generate Mesh (Quads)
-    std::vector<GWVertex> vertices;
-    std::vector<uint32_t> indices;
-    
-    vertices.reserve((m_grid_dim_x - 1) * (m_grid_dim_z - 1) * 4);
-    indices.reserve((m_grid_dim_x - 1) * (m_grid_dim_z - 1) * 6);
-
     int chunks_in_x = (m_grid_dim_x - 1 + 31) / 32;
     int chunks_in_z = (m_grid_dim_z - 1 + 31) / 32;
-    
-    // Process chunks Top-Down (PRNG Order)
-    for (int cz = 0; cz < chunks_in_z; cz++) {
-        for (int cx = 0; cx < chunks_in_x; cx++) {
-            
-            uint32_t seed_cx = cx;
-            uint32_t seed_cz = cz;
-            uint32_t seed = seed_cz ^ (seed_cx << 16);
-            uint32_t prng_state = seed;
-            
-            for (int lz = 0; lz < 32; lz++) {
-                for (int lx = 0; lx < 32; lx++) {
-                    uint32_t rnd = prng_next(prng_state);
-                    
-                    int grid_x = cx * 32 + lx;
-                    // Invert Z Index: Map Chunk (Top-Down) to Grid (Bottom-Up)
-                    // tex_tl is read from grid_z+1, which should map to file row (cz*32+lz)
-                    // File row F is stored at grid index (m_grid_dim_z - F)
-                    // So grid_z+1 = m_grid_dim_z - (cz*32+lz), thus grid_z = m_grid_dim_z - 1 - cz*32 - lz
-                    int grid_z = (m_grid_dim_z - 1) - (cz * 32 + lz);
-                    
-                    if (grid_x >= (int)m_grid_dim_x - 1 || grid_z < 0) {
-                        continue; 
-                    }
+    int num_chunks = chunks_in_x * chunks_in_z;
+
+    // Each chunk owns a fixed slice of the vertex and index buffers so chunks can be built in parallel
+    // while the output stays in the same order as a serial Top-Down walk.
+    std::vector<uint32_t> chunk_first_quad(num_chunks + 1, 0);
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        int cz = chunk / chunks_in_x;
+        int cx = chunk % chunks_in_x;
+        int quads_x = std::clamp(static_cast<int>(m_grid_dim_x) - 1 - cx * 32, 0, 32);
+        int quads_z = std::clamp(static_cast<int>(m_grid_dim_z) - cz * 32, 0, 32);
+        chunk_first_quad[chunk + 1] = chunk_first_quad[chunk] + quads_x * quads_z;
+    }
 
-                    int tex_bl = m_texture_index_grid[grid_z][grid_x];
-                    int tex_br = m_texture_index_grid[grid_z][grid_x + 1];
-                    int tex_tl = m_texture_index_grid[grid_z + 1][grid_x];
-                    int tex_tr = m_texture_index_grid[grid_z + 1][grid_x + 1];
-                    
-                    int prng_quadrant = rnd & 3;
-                    
-                    bool is_uniform = (tex_tl == tex_tr && tex_tl == tex_bl && tex_tl == tex_br);
-                    
-                    auto get_uvs_for_corner = [&](int corner) -> std::vector<XMFLOAT2> {
-                        std::vector<XMFLOAT2> layers;
-
-                        if (is_uniform) {
-                            layers.push_back(calculate_corner_uv(tex_tl, prng_quadrant, false, corner));
-                            layers.push_back(make_neutral_uv());
-                            layers.push_back(make_neutral_uv());
-                            return layers;
-                        }
+    std::vector<GWVertex> vertices(static_cast<size_t>(chunk_first_quad.back()) * 4);
+    std::vector<uint32_t> indices(static_cast<size_t>(chunk_first_quad.back()) * 6);
 
-                        // Build per-texture corner masks (matching Python's tex_corners)
-                        std::map<int, int> tex_to_corners;
-                        tex_to_corners[tex_tl] |= 1;  // TL = bit 0
-                        tex_to_corners[tex_tr] |= 2;  // TR = bit 1
-                        tex_to_corners[tex_bl] |= 4;  // BL = bit 2
-                        tex_to_corners[tex_br] |= 8;  // BR = bit 3
-
-                        // std::map iterates by key order (sorted texture indices)
-                        std::vector<std::pair<int, int>> tex_list;
-                        for (auto const& [tex, mask] : tex_to_corners) {
-                            tex_list.push_back({tex, mask});
-                        }
+    std::vector<uint32_t> chunk_ids(num_chunks);
+    std::iota(chunk_ids.begin(), chunk_ids.end(), 0);
 
-                        // Primary variants loop (matching Python exactly)
-                        for (size_t i = 0; i < tex_list.size(); i++) {
-                            int tex = tex_list[i].first;
-                            int mask = tex_list[i].second;
-
-                            auto entry = VARIANT_LOOKUP[mask];
-                            uint16_t primary = entry.first;
-
-                            if (i == 0) {
-                                // First texture uses random quadrant
-                                layers.push_back(calculate_corner_uv(tex, prng_quadrant, false, corner));
-                            } else {
-                                // Other textures use LUT quadrant with rotation
-                                int quad = primary & 0x3;
-                                bool rot = (primary & 0x8000) != 0;
-                                layers.push_back(calculate_corner_uv(tex, quad, rot, corner));
-                            }
-                        }
+    std::for_each(std::execution::par, chunk_ids.begin(), chunk_ids.end(), [&](uint32_t chunk) {
+        int cz = chunk / chunks_in_x;
+        int cx = chunk % chunks_in_x;
 
-                        // Add secondary variant ONLY for 2-texture case (after loop, matching Python)
-                        if (tex_list.size() == 2) {
-                            int tex2 = tex_list[1].first;
-                            int mask2 = tex_list[1].second;
-                            int secondary = VARIANT_LOOKUP[mask2].second;
-
-                            if (secondary != -1) {
-                                int quad2 = secondary & 0x3;
-                                bool rot2 = (secondary & 0x8000) != 0;
-                                layers.push_back(calculate_corner_uv(tex2, quad2, rot2, corner));
-                            } else {
-                                layers.push_back(make_neutral_uv());
-                            }
-                        }
+        uint32_t seed_cx = cx;
+        uint32_t seed_cz = cz;
+        uint32_t seed = seed_cz ^ (seed_cx << 16);
+        uint32_t prng_state = seed;
 
-                        // Pad to 3 variants
-                        while (layers.size() < 3) {
-                            layers.push_back(make_neutral_uv());
-                        }
+        uint32_t quad = chunk_first_quad[chunk];
 
-                        return layers;
-                    }; 
+        for (int lz = 0; lz < 32; lz++) {
+            for (int lx = 0; lx < 32; lx++) {
+                // The PRNG advances for every cell of the chunk, including skipped edge cells
+                uint32_t rnd = prng_next(prng_state);
 
-                    float xPos = m_bounds.map_min_x + grid_x * delta_x;
-                    float zPos = m_bounds.map_min_z + grid_z * delta_z;
-                    float xL = xPos;
-                    float xR = xPos + delta_x;
-                    float zB = zPos;
-                    float zT = zPos + delta_z;
-                    
-                    auto uvs_TL = get_uvs_for_corner(0);
-                    GWVertex vTL;
-                    vTL.position = { xL, grid[grid_z+1][grid_x], zT };
-                    vTL.normal = grid_normals[(grid_z+1)*(m_grid_dim_x+1) + grid_x];
-                    vTL.tex_coord0 = uvs_TL[0];
-                    vTL.tex_coord1 = uvs_TL[1];
-                    vTL.tex_coord2 = uvs_TL[2];
-                    vTL.tex_coord3 = {(float)lx/32.0f, (float)lz/32.0f}; 
-                    
-                    auto uvs_TR = get_uvs_for_corner(1);
-                    GWVertex vTR;
-                    vTR.position = { xR, grid[grid_z+1][grid_x+1], zT };
-                    vTR.normal = grid_normals[(grid_z+1)*(m_grid_dim_x+1) + grid_x+1];
-                    vTR.tex_coord0 = uvs_TR[0];
-                    vTR.tex_coord1 = uvs_TR[1];
-                    vTR.tex_coord2 = uvs_TR[2];
-                    vTR.tex_coord3 = {(float)(lx+1)/32.0f, (float)lz/32.0f};
-
-                    auto uvs_BL = get_uvs_for_corner(2);
-                    GWVertex vBL;
-                    vBL.position = { xL, grid[grid_z][grid_x], zB };
-                    vBL.normal = grid_normals[grid_z*(m_grid_dim_x+1) + grid_x];
-                    vBL.tex_coord0 = uvs_BL[0];
-                    vBL.tex_coord1 = uvs_BL[1];
-                    vBL.tex_coord2 = uvs_BL[2];
-                    vBL.tex_coord3 = {(float)lx/32.0f, (float)(lz+1)/32.0f};
-
-                    auto uvs_BR = get_uvs_for_corner(3);
-                    GWVertex vBR;
-                    vBR.position = { xR, grid[grid_z][grid_x+1], zB };
-                    vBR.normal = grid_normals[grid_z*(m_grid_dim_x+1) + grid_x+1];
-                    vBR.tex_coord0 = uvs_BR[0];
-                    vBR.tex_coord1 = uvs_BR[1];
-                    vBR.tex_coord2 = uvs_BR[2];
-                    vBR.tex_coord3 = {(float)(lx+1)/32.0f, (float)(lz+1)/32.0f};
-                    
-                    uint32_t base_idx = (uint32_t)vertices.size();
-                    vertices.push_back(vTL);
-                    vertices.push_back(vTR);
-                    vertices.push_back(vBL);
-                    vertices.push_back(vBR);
-                    
-                    indices.push_back(base_idx + 2);
-                    indices.push_back(base_idx + 0);
-                    indices.push_back(base_idx + 1);
-                    
-                    indices.push_back(base_idx + 2);
-                    indices.push_back(base_idx + 1);
-                    indices.push_back(base_idx + 3);
+                int grid_x = cx * 32 + lx;
+                // Invert Z Index: Map Chunk (Top-Down) to Grid (Bottom-Up)
+                // tex_tl is read from grid_z+1, which should map to file row (cz*32+lz)
+                // File row F is stored at grid index (m_grid_dim_z - F)
+                // So grid_z+1 = m_grid_dim_z - (cz*32+lz), thus grid_z = m_grid_dim_z - 1 - cz*32 - lz
+                int grid_z = (m_grid_dim_z - 1) - (cz * 32 + lz);
+
+                if (grid_x >= (int)m_grid_dim_x - 1 || grid_z < 0) {
+                    continue;
                 }
+
+                int tex_bl = m_texture_index_grid.at(grid_z, grid_x);
+                int tex_br = m_texture_index_grid.at(grid_z, grid_x + 1);
+                int tex_tl = m_texture_index_grid.at(grid_z + 1, grid_x);
+                int tex_tr = m_texture_index_grid.at(grid_z + 1, grid_x + 1);
+
+                const QuadLayers layers = resolve_quad_layers(tex_tl, tex_tr, tex_bl, tex_br, rnd & 3);
+
+                float xPos = m_bounds.map_min_x + grid_x * delta_x;
+                float zPos = m_bounds.map_min_z + grid_z * delta_z;
+                float xL = xPos;
+                float xR = xPos + delta_x;
+                float zB = zPos;
+                float zT = zPos + delta_z;
+
+                auto write_corner = [&](GWVertex& v, int corner, float x, float z, int row, int col, XMFLOAT2 local_uv) {
+                    v = make_quad_corner(layers, corner, { x, m_height_grid.at(row, col), z },
+                        grid_normals[static_cast<size_t>(row) * stride + col], local_uv);
+                };
+
+                GWVertex* quad_vertices = &vertices[static_cast<size_t>(quad) * 4];
+                write_corner(quad_vertices[0], 0, xL, zT, grid_z + 1, grid_x, { (float)lx / 32.0f, (float)lz / 32.0f });
+                write_corner(quad_vertices[1], 1, xR, zT, grid_z + 1, grid_x + 1, { (float)(lx + 1) / 32.0f, (float)lz / 32.0f });
+                write_corner(quad_vertices[2], 2, xL, zB, grid_z, grid_x, { (float)lx / 32.0f, (float)(lz + 1) / 32.0f });
+                write_corner(quad_vertices[3], 3, xR, zB, grid_z, grid_x + 1, { (float)(lx + 1) / 32.0f, (float)(lz + 1) / 32.0f });
+
+                uint32_t base_idx = quad * 4;
+                uint32_t* quad_indices = &indices[static_cast<size_t>(quad) * 6];
+                quad_indices[0] = base_idx + 2;
+                quad_indices[1] = base_idx + 0;
+                quad_indices[2] = base_idx + 1;
+
+                quad_indices[3] = base_idx + 2;
+                quad_indices[4] = base_idx + 1;
+                quad_indices[5] = base_idx + 3;
+
+                quad++;
             }
         }
-    }
+    });
+
+    GenerateChunkLODs(vertices, grid_normals, chunk_first_quad, chunks_in_x, chunks_in_z, delta_x, delta_z);
     
     m_per_terrain_cb = PerTerrainCB(m_grid_dim_x, m_grid_dim_z, m_bounds.map_min_x, m_bounds.map_max_x, m_bounds.map_min_y, m_bounds.map_max_y, m_bounds.map_min_z, m_bounds.map_max_z, 0, 0.03, 0.03, {0});
 
     return Mesh(vertices, indices, {}, {}, {0}, { 0 }, { 0 }, { 0 }, true, BlendState::Opaque, 1, { 10000000, 10000000, 10000000 });
 }
+
+void Terrain::GenerateChunkLODs(const std::vector<GWVertex>& full_res_vertices, const std::vector<XMFLOAT3>& grid_normals,
+    const std::vector<uint32_t>& chunk_first_quad, int chunks_in_x, int chunks_in_z, float delta_x, float delta_z)
+{
+    const int num_chunks = chunks_in_x * chunks_in_z;
+    const uint32_t stride = m_grid_dim_x + 1;
+    const int cells = TERRAIN_CHUNK_CELLS;
+
+    m_chunk_lods.assign(num_chunks, TerrainChunkLOD{});
+
+    std::vector<uint32_t> chunk_ids(num_chunks);
+    std::iota(chunk_ids.begin(), chunk_ids.end(), 0);
+
+    auto quads_in_chunk_x = [&](int cx) { return std::clamp(static_cast<int>(m_grid_dim_x) - 1 - cx * cells, 0, cells); };
+    auto quads_in_chunk_z = [&](int cz) { return std::clamp(static_cast<int>(m_grid_dim_z) - cz * cells, 0, cells); };
+
+    // Chunk-local vertex coordinates (lx right, lz down in file order) to grid indices
+    auto grid_col = [&](int cx, int lx) { return cx * cells + lx; };
+    auto grid_row = [&](int cz, int lz) { return static_cast<int>(m_grid_dim_z) - (cz * cells + lz); };
+
+    // Quad boundaries of a level: 0, step, 2*step, ... clamped to the chunk edge.
+    auto level_breaks = [](int quads, int level) {
+        std::vector<int> breaks;
+        const int step = 1 << level;
+        for (int b = 0; b < quads; b += step) breaks.push_back(b);
+        breaks.push_back(quads);
+        return breaks;
+    };
+
+    // 1. Bounds and geometric error of every level against the full resolution surface
+    std::for_each(std::execution::par, chunk_ids.begin(), chunk_ids.end(), [&](uint32_t chunk) {
+        const int cz = chunk / chunks_in_x;
+        const int cx = chunk % chunks_in_x;
+        const int quads_x = quads_in_chunk_x(cx);
+        const int quads_z = quads_in_chunk_z(cz);
+        auto& lod = m_chunk_lods[chunk];
+
+        lod.full_res_range = { chunk_first_quad[chunk] * 6, (chunk_first_quad[chunk + 1] - chunk_first_quad[chunk]) * 6 };
+        lod.neighbors = {
+            cx > 0 ? static_cast<int32_t>(chunk - 1) : -1,
+            cx + 1 < chunks_in_x ? static_cast<int32_t>(chunk + 1) : -1,
+            cz > 0 ? static_cast<int32_t>(chunk - chunks_in_x) : -1,
+            cz + 1 < chunks_in_z ? static_cast<int32_t>(chunk + chunks_in_x) : -1,
+        };
+        if (quads_x == 0 || quads_z == 0) return;
+
+        auto height = [&](int lz, int lx) { return m_height_grid.at(grid_row(cz, lz), grid_col(cx, lx)); };
+
+        float min_y = FLT_MAX;
+        float max_y = -FLT_MAX;
+        for (int lz = 0; lz <= quads_z; lz++) {
+            for (int lx = 0; lx <= quads_x; lx++) {
+                float h = height(lz, lx);
+                min_y = std::min(min_y, h);
+                max_y = std::max(max_y, h);
+            }
+        }
+        lod.bounds_min = { m_bounds.map_min_x + grid_col(cx, 0) * delta_x, min_y, m_bounds.map_min_z + grid_row(cz, quads_z) * delta_z };
+        lod.bounds_max = { m_bounds.map_min_x + grid_col(cx, quads_x) * delta_x, max_y, m_bounds.map_min_z + grid_row(cz, 0) * delta_z };
+
+        for (int level = 1; level < TERRAIN_LOD_LEVELS; level++) {
+            const auto xs = level_breaks(quads_x, level);
+            const auto zs = level_breaks(quads_z, level);
+            float error = lod.geometric_error[level - 1];
+
+            for (size_t qz = 0; qz + 1 < zs.size(); qz++) {
+                for (size_t qx = 0; qx + 1 < xs.size(); qx++) {
+                    const int x0 = xs[qx], x1 = xs[qx + 1];
+                    const int z0 = zs[qz], z1 = zs[qz + 1];
+                    const float h_tl = height(z0, x0);
+                    const float h_tr = height(z0, x1);
+                    const float h_bl = height(z1, x0);
+                    const float h_br = height(z1, x1);
+
+                    for (int lz = z0; lz <= z1; lz++) {
+                        for (int lx = x0; lx <= x1; lx++) {
+                            // Coarse quads are split along the BL-TR diagonal, like the full resolution quads
+                            const float u = static_cast<float>(lx - x0) / (x1 - x0);
+                            const float v = static_cast<float>(z1 - lz) / (z1 - z0);
+                            const float coarse = v >= u ? h_bl + v * (h_tl - h_bl) + u * (h_tr - h_tl)
+                                                        : h_bl + u * (h_br - h_bl) + v * (h_tr - h_br);
+                            error = std::max(error, std::abs(height(lz, lx) - coarse));
+                        }
+                    }
+                }
+            }
+            lod.geometric_error[level] = error;
+        }
+    });
+
+    // Skirts have to reach past the largest error on either side of a chunk edge to hide the crack.
+    std::vector<float> skirt_depths(num_chunks, 0.0f);
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        const int cz = chunk / chunks_in_x;
+        const int cx = chunk % chunks_in_x;
+        float depth = m_chunk_lods[chunk].geometric_error.back();
+        if (cx > 0) depth = std::max(depth, m_chunk_lods[chunk - 1].geometric_error.back());
+        if (cx + 1 < chunks_in_x) depth = std::max(depth, m_chunk_lods[chunk + 1].geometric_error.back());
+        if (cz > 0) depth = std::max(depth, m_chunk_lods[chunk - chunks_in_x].geometric_error.back());
+        if (cz + 1 < chunks_in_z) depth = std::max(depth, m_chunk_lods[chunk + chunks_in_x].geometric_error.back());
+        skirt_depths[chunk] = depth;
+    }
+
+    // 2. Geometry for every (level, chunk) pair, built in parallel into local buffers
+    struct LevelGeometry
+    {
+        std::vector<GWVertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+    std::vector<LevelGeometry> geometry(static_cast<size_t>(num_chunks) * TERRAIN_LOD_LEVELS);
+
+    std::for_each(std::execution::par, chunk_ids.begin(), chunk_ids.end(), [&](uint32_t chunk) {
+        const int cz = chunk / chunks_in_x;
+        const int cx = chunk % chunks_in_x;
+        const int quads_x = quads_in_chunk_x(cx);
+        const int quads_z = quads_in_chunk_z(cz);
+        if (quads_x == 0 || quads_z == 0) return;
+
+        // Same per-chunk PRNG stream as the full resolution mesh; coarse quads use the draw of their top-left cell
+        uint32_t rnd[TERRAIN_CHUNK_CELLS * TERRAIN_CHUNK_CELLS];
+        uint32_t prng_state = static_cast<uint32_t>(cz) ^ (static_cast<uint32_t>(cx) << 16);
+        for (auto& r : rnd) r = prng_next(prng_state);
+
+        const float skirt_depth = skirt_depths[chunk];
+
+        auto add_skirt = [&](LevelGeometry& out, const GWVertex& a, const GWVertex& b) {
+            GWVertex a_low = a;
+            GWVertex b_low = b;
+            a_low.position.y -= skirt_depth;
+            b_low.position.y -= skirt_depth;
+
+            uint32_t base = static_cast<uint32_t>(out.vertices.size());
+            out.vertices.push_back(a);
+            out.vertices.push_back(b);
+            out.vertices.push_back(a_low);
+            out.vertices.push_back(b_low);
+
+            // Skirts are double sided so the winding does not depend on which edge of the chunk they hang from
+            for (uint32_t idx : { 0u, 1u, 3u, 0u, 3u, 2u, 0u, 3u, 1u, 0u, 2u, 3u }) {
+                out.indices.push_back(base + idx);
+            }
+        };
+
+        // corners: TL, TR, BL, BR
+        auto add_edge_skirts = [&](LevelGeometry& out, const GWVertex* corners, bool top, bool bottom, bool left, bool right) {
+            if (skirt_depth <= 0) return;
+            if (top) add_skirt(out, corners[0], corners[1]);
+            if (bottom) add_skirt(out, corners[2], corners[3]);
+            if (left) add_skirt(out, corners[0], corners[2]);
+            if (right) add_skirt(out, corners[1], corners[3]);
+        };
+
+        // Level 0 surface is the full resolution mesh; only its skirts go into the LOD mesh
+        {
+            auto& out = geometry[chunk];
+            const GWVertex* chunk_vertices = &full_res_vertices[static_cast<size_t>(chunk_first_quad[chunk]) * 4];
+            for (int lz = 0; lz < quads_z; lz++) {
+                for (int lx = 0; lx < quads_x; lx++) {
+                    if (lz != 0 && lz != quads_z - 1 && lx != 0 && lx != quads_x - 1) continue;
+                    const GWVertex* corners = chunk_vertices + static_cast<size_t>(lz * quads_x + lx) * 4;
+                    add_edge_skirts(out, corners, lz == 0, lz == quads_z - 1, lx == 0, lx == quads_x - 1);
+                }
+            }
+        }
+
+        for (int level = 1; level < TERRAIN_LOD_LEVELS; level++) {
+            auto& out = geometry[static_cast<size_t>(level) * num_chunks + chunk];
+            const auto xs = level_breaks(quads_x, level);
+            const auto zs = level_breaks(quads_z, level);
+
+            for (size_t qz = 0; qz + 1 < zs.size(); qz++) {
+                for (size_t qx = 0; qx + 1 < xs.size(); qx++) {
+                    const int x0 = xs[qx], x1 = xs[qx + 1];
+                    const int z0 = zs[qz], z1 = zs[qz + 1];
+                    const int row_t = grid_row(cz, z0), row_b = grid_row(cz, z1);
+                    const int col_l = grid_col(cx, x0), col_r = grid_col(cx, x1);
+
+                    const QuadLayers layers = resolve_quad_layers(
+                        m_texture_index_grid.at(row_t, col_l), m_texture_index_grid.at(row_t, col_r),
+                        m_texture_index_grid.at(row_b, col_l), m_texture_index_grid.at(row_b, col_r),
+                        rnd[z0 * TERRAIN_CHUNK_CELLS + x0] & 3);
+
+                    auto corner = [&](int c, int row, int col, int lx, int lz) {
+                        XMFLOAT3 position(m_bounds.map_min_x + col * delta_x, m_height_grid.at(row, col),
+                            m_bounds.map_min_z + row * delta_z);
+                        return make_quad_corner(layers, c, position, grid_normals[static_cast<size_t>(row) * stride + col],
+                            { (float)lx / 32.0f, (float)lz / 32.0f });
+                    };
+
+                    const GWVertex corners[4] = {
+                        corner(0, row_t, col_l, x0, z0),
+                        corner(1, row_t, col_r, x1, z0),
+                        corner(2, row_b, col_l, x0, z1),
+                        corner(3, row_b, col_r, x1, z1),
+                    };
+
+                    uint32_t base_idx = static_cast<uint32_t>(out.vertices.size());
+                    out.vertices.insert(out.vertices.end(), std::begin(corners), std::end(corners));
+                    for (uint32_t idx : { 2u, 0u, 1u, 2u, 1u, 3u }) {
+                        out.indices.push_back(base_idx + idx);
+                    }
+
+                    add_edge_skirts(out, corners, z0 == 0, z1 == quads_z, x0 == 0, x1 == quads_x);
+                }
+            }
+        }
+    });
+
+    // 3. Concatenate level-major so neighbouring chunks at the same level merge into one draw
+    size_t total_vertices = 0;
+    size_t total_indices = 0;
+    for (const auto& g : geometry) {
+        total_vertices += g.vertices.size();
+        total_indices += g.indices.size();
+    }
+
+    lod_mesh = std::make_unique<Mesh>();
+    lod_mesh->vertices.reserve(total_vertices);
+    lod_mesh->indices.reserve(total_indices);
+
+    for (int level = 0; level < TERRAIN_LOD_LEVELS; level++) {
+        for (int chunk = 0; chunk < num_chunks; chunk++) {
+            const auto& g = geometry[static_cast<size_t>(level) * num_chunks + chunk];
+            const uint32_t base_vertex = static_cast<uint32_t>(lod_mesh->vertices.size());
+
+            m_chunk_lods[chunk].lod_ranges[level] = { static_cast<uint32_t>(lod_mesh->indices.size()),
+                static_cast<uint32_t>(g.indices.size()) };
+
+            lod_mesh->vertices.insert(lod_mesh->vertices.end(), g.vertices.begin(), g.vertices.end());
+            for (uint32_t index : g.indices) {
+                lod_mesh->indices.push_back(base_vertex + index);
+            }
+        }
+    }
+}
@@ -1,7 +1,10 @@
 #pragma once
 #include <vector>
+#include <span>
 #include <DirectXMath.h>
 #include "MeshInstance.h"
+#include "TerrainGrid.h"
+#include "TerrainLOD.h"
 #include "FFNA_MapFile.h"
 #include "DXMathHelpers.h"
 #include "PerTerrainCB.h"
@@ -17,8 +20,8 @@ public:
         , m_height_map(height_map)
         , m_terrain_texture_indices(terrain_texture_indices)
         , m_terrain_shadow_map(terrain_shadow_map)
-        , m_bounds(bounds),
-        grid(m_grid_dim_z + 1, std::vector<float>(m_grid_dim_x + 1, 0.0f))
+        , m_bounds(bounds)
+        , m_height_grid(m_grid_dim_x + 1, m_grid_dim_z + 1, 0.0f)
     {
         // Generate terrain mesh
         mesh = std::make_unique<Mesh>(GenerateTerrainMesh());
@@ -26,22 +29,33 @@ public:
 
     Mesh* get_mesh() { return mesh.get(); }
 
-    const std::vector<std::vector<float>>& get_heightmap_grid() const {
-        return grid;
+    // Coarser chunk levels and crack-hiding skirts. Drawn with the same textures as get_mesh().
+    Mesh* get_lod_mesh() { return lod_mesh.get(); }
+    const std::vector<TerrainChunkLOD>& get_chunk_lods() const { return m_chunk_lods; }
+
+    const TerrainGrid<float>& get_heightmap_grid() const {
+        return m_height_grid;
     }
 
     float get_height_at(float world_x, float world_z) const;
 
+    // Batched bilinear height lookup. xz[i] holds (world_x, world_z); heights must be at least as long as xz.
+    // Samples are processed four at a time with SSE2 and give the same results as get_height_at.
+    void get_heights_at(std::span<const XMFLOAT2> xz, std::span<float> heights) const;
+
+    // Terrain heights under each trapezoid corner, four per trapezoid in TL, TR, BL, BR order.
+    std::vector<float> get_trapezoid_corner_heights(const std::vector<PathfindingTrapezoid>& trapezoids) const;
+
     uint32_t m_grid_dim_x;
     uint32_t m_grid_dim_z;
     MapBounds m_bounds;
     PerTerrainCB m_per_terrain_cb;
-    std::vector<std::vector<uint32_t>> m_texture_index_grid;
-    std::vector<std::vector<uint32_t>> m_terrain_shadow_map_grid;
+    TerrainGrid<uint8_t> m_texture_index_grid;
+    TerrainGrid<uint8_t> m_terrain_shadow_map_grid;
 
     void update_per_terrain_CB(PerTerrainCB& new_cb) { m_per_terrain_cb = new_cb; }
-    const std::vector<std::vector<uint32_t>>& get_texture_index_grid() const { return m_texture_index_grid; }
-    const std::vector<std::vector<uint32_t>>& get_terrain_shadow_map_grid() const
+    const TerrainGrid<uint8_t>& get_texture_index_grid() const { return m_texture_index_grid; }
+    const TerrainGrid<uint8_t>& get_terrain_shadow_map_grid() const
     {
         return m_terrain_shadow_map_grid;
     }
@@ -50,9 +64,15 @@ private:
     // Generates a terrain mesh based on the height map data
     Mesh GenerateTerrainMesh();
 
+    // Builds per-chunk bounds, errors and the LOD mesh from the full resolution quads
+    void GenerateChunkLODs(const std::vector<GWVertex>& full_res_vertices, const std::vector<XMFLOAT3>& grid_normals,
+        const std::vector<uint32_t>& chunk_first_quad, int chunks_in_x, int chunks_in_z, float delta_x, float delta_z);
+
     std::vector<float> m_height_map;
-    std::vector<std::vector<float>> grid;
+    TerrainGrid<float> m_height_grid;
     std::vector<uint8_t> m_terrain_texture_indices;
     std::vector<uint8_t> m_terrain_shadow_map;
     std::unique_ptr<Mesh> mesh;
+    std::unique_ptr<Mesh> lod_mesh;
+    std::vector<TerrainChunkLOD> m_chunk_lods;
 };
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Contiguous row-major 2D grid used for terrain heights and per-vertex attributes.
+ *
+ * All rows live in a single allocation so bulk reads (texture uploads, exports,
+ * batched height sampling) walk memory linearly.
+ */
+template <typename T>
+class TerrainGrid
+{
+public:
+    TerrainGrid() = default;
+
+    TerrainGrid(uint32_t width, uint32_t height, T fill = T{})
+        : m_width(width)
+        , m_height(height)
+        , m_data(static_cast<size_t>(width) * height, fill)
+    {
+    }
+
+    void resize(uint32_t width, uint32_t height, T fill = T{})
+    {
+        m_width = width;
+        m_height = height;
+        m_data.assign(static_cast<size_t>(width) * height, fill);
+    }
+
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    bool empty() const { return m_data.empty(); }
+
+    T& at(uint32_t row, uint32_t col) { return m_data[static_cast<size_t>(row) * m_width + col]; }
+    const T& at(uint32_t row, uint32_t col) const { return m_data[static_cast<size_t>(row) * m_width + col]; }
+
+    std::span<T> row(uint32_t row) { return { m_data.data() + static_cast<size_t>(row) * m_width, m_width }; }
+    std::span<const T> row(uint32_t row) const
+    {
+        return { m_data.data() + static_cast<size_t>(row) * m_width, m_width };
+    }
+
+    T* data() { return m_data.data(); }
+    const T* data() const { return m_data.data(); }
+    size_t size() const { return m_data.size(); }
+
+private:
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    std::vector<T> m_data;
+};
@@ -0,0 +1,163 @@
+#pragma once
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <DirectXMath.h>
+#include "Mesh.h"
+
+// Terrain is split into square chunks of this many cells, matching the PRNG chunks used for texturing.
+constexpr uint32_t TERRAIN_CHUNK_CELLS = 32;
+
+// Level L draws one quad per 2^L x 2^L cells, so the coarsest level has 4x4 quads per full chunk.
+constexpr int TERRAIN_LOD_LEVELS = 4;
+
+/**
+ * @brief Per-chunk bounds, error metrics and index ranges for geomipmapped terrain.
+ *
+ * Level 0 surface indices live in the full resolution terrain mesh. Everything else
+ * (coarser surfaces and the skirts that hide cracks between levels) lives in the
+ * terrain's LOD mesh.
+ */
+struct TerrainChunkLOD
+{
+    DirectX::XMFLOAT3 bounds_min;
+    DirectX::XMFLOAT3 bounds_max;
+
+    // Largest world-space height deviation from the full resolution surface when drawing a level.
+    std::array<float, TERRAIN_LOD_LEVELS> geometric_error{};
+
+    // Level 0 surface range in the full resolution mesh.
+    IndexRange full_res_range;
+
+    // Per level range in the LOD mesh. Level 0 holds only skirts, coarser levels hold surface and skirts.
+    std::array<IndexRange, TERRAIN_LOD_LEVELS> lod_ranges{};
+
+    // Indices of the left, right, top and bottom neighbouring chunks, -1 at the map edge.
+    std::array<int32_t, 4> neighbors{ -1, -1, -1, -1 };
+};
+
+/**
+ * @brief Camera parameters needed to turn world-space error into on-screen pixels.
+ */
+struct TerrainLODView
+{
+    DirectX::XMFLOAT3 camera_position;
+
+    // Perspective: viewport_height / (2 * tan(fov_y / 2)). Pixels covered by one world unit at distance 1.
+    float perspective_scale = 0;
+
+    // Orthographic: viewport_height / view_height. Used instead of perspective_scale when > 0.
+    float orthographic_scale = 0;
+
+    // Largest allowed projected geometric error in pixels.
+    float max_screen_error = 2.0f;
+};
+
+struct TerrainLODStats
+{
+    uint32_t full_res_index_count = 0;
+    uint32_t selected_index_count = 0;
+};
+
+inline float DistanceToChunkBounds(const TerrainChunkLOD& chunk, const DirectX::XMFLOAT3& point)
+{
+    float dx = std::max({ chunk.bounds_min.x - point.x, 0.0f, point.x - chunk.bounds_max.x });
+    float dy = std::max({ chunk.bounds_min.y - point.y, 0.0f, point.y - chunk.bounds_max.y });
+    float dz = std::max({ chunk.bounds_min.z - point.z, 0.0f, point.z - chunk.bounds_max.z });
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/**
+ * @brief Picks the coarsest level whose projected error stays within view.max_screen_error.
+ */
+inline int SelectTerrainChunkLOD(const TerrainChunkLOD& chunk, const TerrainLODView& view)
+{
+    float pixels_per_unit;
+    if (view.orthographic_scale > 0) {
+        pixels_per_unit = view.orthographic_scale;
+    }
+    else {
+        // Clamp the distance so a camera inside the bounds always gets full resolution without dividing by zero.
+        float distance = std::max(DistanceToChunkBounds(chunk, view.camera_position), 1.0f);
+        pixels_per_unit = view.perspective_scale / distance;
+    }
+
+    for (int level = TERRAIN_LOD_LEVELS - 1; level > 0; level--) {
+        if (chunk.geometric_error[level] * pixels_per_unit <= view.max_screen_error) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+// Full resolution chunks only need their skirts where a neighbour is drawn coarser.
+inline bool TerrainChunkNeedsSkirts(std::span<const TerrainChunkLOD> chunks, std::span<const uint8_t> levels, size_t chunk)
+{
+    if (levels[chunk] > 0) return true;
+    for (int32_t neighbor : chunks[chunk].neighbors) {
+        if (neighbor >= 0 && levels[neighbor] > 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Selects a level for every chunk and returns how many indices the selection draws.
+ */
+inline TerrainLODStats SelectTerrainLODs(std::span<const TerrainChunkLOD> chunks, const TerrainLODView& view,
+    std::vector<uint8_t>& levels)
+{
+    TerrainLODStats stats;
+    levels.resize(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        levels[i] = static_cast<uint8_t>(SelectTerrainChunkLOD(chunks[i], view));
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const auto& chunk = chunks[i];
+        int level = levels[i];
+
+        stats.full_res_index_count += chunk.full_res_range.index_count;
+        if (level == 0) {
+            stats.selected_index_count += chunk.full_res_range.index_count;
+        }
+        if (TerrainChunkNeedsSkirts(chunks, levels, i)) {
+            stats.selected_index_count += chunk.lod_ranges[level].index_count;
+        }
+    }
+    return stats;
+}
+
+/**
+ * @brief Turns a level selection into draw ranges for the full resolution and LOD meshes.
+ *
+ * Adjacent ranges are merged so neighbouring chunks at the same level become a single draw.
+ */
+inline void BuildTerrainDrawRanges(std::span<const TerrainChunkLOD> chunks, std::span<const uint8_t> levels,
+    std::vector<IndexRange>& full_res_ranges, std::vector<IndexRange>& lod_ranges)
+{
+    full_res_ranges.clear();
+    lod_ranges.clear();
+
+    auto append = [](std::vector<IndexRange>& ranges, const IndexRange& range) {
+        if (range.index_count == 0) return;
+        if (!ranges.empty() && ranges.back().start_index + ranges.back().index_count == range.start_index) {
+            ranges.back().index_count += range.index_count;
+            return;
+        }
+        ranges.push_back(range);
+    };
+
+    for (size_t i = 0; i < chunks.size() && i < levels.size(); i++) {
+        const auto& chunk = chunks[i];
+        int level = levels[i];
+        if (level == 0) {
+            append(full_res_ranges, chunk.full_res_range);
+        }
+        if (TerrainChunkNeedsSkirts(chunks, levels, i)) {
+            append(lod_ranges, chunk.lod_ranges[level]);
+        }
+    }
+}
@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "TextureExport.h"
+#include "DATManager.h"
+#include "DirectXTex/DirectXTex.h"
+#include "stb_image_write.h"
+
+namespace
+{
+    void write_to_stream(void* context, void* data, int size)
+    {
+        static_cast<std::ofstream*>(context)->write(static_cast<const char*>(data), size);
+    }
+}
+
+bool DecodeDDSTexture(const uint8_t* data, size_t size, DatTexture& texture_out)
+{
+    if (!data || size == 0) return false;
+
+    DirectX::TexMetadata metadata;
+    DirectX::ScratchImage image;
+    if (FAILED(DirectX::LoadFromDDSMemory(data, size, DirectX::DDS_FLAGS_NONE, &metadata, image))) return false;
+    if (metadata.width == 0 || metadata.height == 0) return false;
+
+    constexpr DXGI_FORMAT target_format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    if (DirectX::IsCompressed(metadata.format)) {
+        DirectX::ScratchImage decompressed;
+        if (FAILED(DirectX::Decompress(*image.GetImage(0, 0, 0), target_format, decompressed))) return false;
+        image = std::move(decompressed);
+    }
+    else if (metadata.format != target_format) {
+        DirectX::ScratchImage converted;
+        if (FAILED(DirectX::Convert(*image.GetImage(0, 0, 0), target_format, DirectX::TEX_FILTER_DEFAULT,
+            DirectX::TEX_THRESHOLD_DEFAULT, converted))) {
+            return false;
+        }
+        image = std::move(converted);
+    }
+
+    const DirectX::Image* top_level = image.GetImage(0, 0, 0);
+    texture_out.width = static_cast<int>(top_level->width);
+    texture_out.height = static_cast<int>(top_level->height);
+    texture_out.texture_type = DDSt;
+    texture_out.rgba_data.resize(top_level->width * top_level->height);
+    for (size_t y = 0; y < top_level->height; y++) {
+        std::memcpy(&texture_out.rgba_data[y * top_level->width], top_level->pixels + y * top_level->rowPitch,
+            top_level->width * sizeof(RGBA));
+    }
+    return true;
+}
+
+DatTexture DecodeTextureFile(DATManager* dat_manager, int mft_index)
+{
+    const auto& mft = dat_manager->get_MFT();
+    if (mft_index < 0 || mft_index >= static_cast<int>(mft.size())) {
+        throw std::runtime_error(std::format("Invalid MFT index {}.", mft_index));
+    }
+
+    DatTexture texture{};
+    if (mft[mft_index].type == DDS) {
+        const auto dds_data = dat_manager->parse_dds_file(mft_index);
+        if (!DecodeDDSTexture(dds_data.data(), dds_data.size(), texture)) {
+            throw std::runtime_error(std::format("Failed to decode DDS file at index {}.", mft_index));
+        }
+    }
+    else {
+        texture = dat_manager->parse_ffna_texture_file(mft_index);
+    }
+
+    if (texture.width <= 0 || texture.height <= 0 ||
+        texture.rgba_data.size() < static_cast<size_t>(texture.width) * texture.height) {
+        throw std::runtime_error(std::format("Texture at index {} decoded to invalid dimensions.", mft_index));
+    }
+    return texture;
+}
+
+bool SaveDatTextureToPng(const DatTexture& texture, const std::filesystem::path& file_path)
+{
+    if (texture.width <= 0 || texture.height <= 0) return false;
+
+    const size_t pixel_count = static_cast<size_t>(texture.width) * texture.height;
+    if (texture.rgba_data.size() < pixel_count) return false;
+
+    // stb_image_write takes R8G8B8A8, decoded textures are B8G8R8A8.
+    std::vector<uint8_t> pixels(pixel_count * 4);
+    for (size_t i = 0; i < pixel_count; i++) {
+        const auto& pixel = texture.rgba_data[i].c;
+        pixels[i * 4 + 0] = pixel[2];
+        pixels[i * 4 + 1] = pixel[1];
+        pixels[i * 4 + 2] = pixel[0];
+        pixels[i * 4 + 3] = pixel[3];
+    }
+
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file) return false;
+
+    const int result = stbi_write_png_to_func(write_to_stream, &file, texture.width, texture.height, 4, pixels.data(), texture.width * 4);
+    return result != 0 && file.good();
+}
+
+void TextureExportJob::Start(DATManager* dat_manager, std::vector<int> mft_indices, const std::filesystem::path& save_directory,
+    ErrorCallback on_error, unsigned num_threads)
+{
+    Stop();
+
+    m_dat_manager = dat_manager;
+    m_mft_indices = std::move(mft_indices);
+    m_save_directory = save_directory;
+    m_on_error = std::move(on_error);
+    m_next_index = 0;
+    m_completed = 0;
+    m_stop_requested = false;
+
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, static_cast<unsigned>(std::max<size_t>(m_mft_indices.size(), 1)));
+
+    m_running_workers = static_cast<int>(num_threads);
+    for (unsigned i = 0; i < num_threads; i++) {
+        m_workers.emplace_back([this] { RunWorker(); });
+    }
+}
+
+void TextureExportJob::Stop()
+{
+    m_stop_requested = true;
+    m_workers.clear(); // jthread joins
+}
+
+void TextureExportJob::RunWorker()
+{
+    while (!m_stop_requested) {
+        const size_t i = m_next_index.fetch_add(1);
+        if (i >= m_mft_indices.size()) break;
+
+        ExportTexture(m_mft_indices[i]);
+        m_completed.fetch_add(1);
+    }
+    m_running_workers.fetch_sub(1);
+}
+
+void TextureExportJob::ExportTexture(int mft_index)
+{
+    const auto& entry = m_dat_manager->get_MFT()[mft_index];
+    std::wstring error;
+    try {
+        std::wstring type_subfolder = typeToWString(entry.type);
+        if (type_subfolder == L" ") {
+            type_subfolder = L"UnknownType";
+        }
+        const std::filesystem::path subfolder_path = m_save_directory / type_subfolder;
+        std::filesystem::create_directories(subfolder_path);
+
+        const std::filesystem::path file_path = subfolder_path / std::format(L"texture_0x{:X}.png", entry.Hash);
+        if (std::filesystem::exists(file_path)) return;
+
+        const DatTexture texture = DecodeTextureFile(m_dat_manager, mft_index);
+        if (!SaveDatTextureToPng(texture, file_path)) {
+            error = std::format(L"Failed to save texture to PNG for index {}.", mft_index);
+        }
+    }
+    catch (const std::exception& e) {
+        const std::string what = e.what();
+        error = std::wstring(what.begin(), what.end());
+    }
+    catch (...) {
+        error = L"Unknown error.";
+    }
+
+    if (!error.empty() && m_on_error) {
+        std::scoped_lock lock(m_error_mutex);
+        m_on_error(mft_index, entry.Hash, error);
+    }
+}
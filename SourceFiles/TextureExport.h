@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AtexReader.h"
+
+class DATManager;
+
+// Decodes a DDS file on the CPU into B8G8R8A8 pixels, the layout the ATEX decoder produces.
+// Block compressed formats are decompressed with DirectXTex.
+bool DecodeDDSTexture(const uint8_t* data, size_t size, DatTexture& texture_out);
+
+// Decodes the texture file (ATEX, ATTX, DDS, ...) at mft_index without touching the GPU.
+// Throws std::runtime_error if it can't be read or decoded.
+DatTexture DecodeTextureFile(DATManager* dat_manager, int mft_index);
+
+// Encodes decoded B8G8R8A8 pixels to PNG with stb_image_write. Safe to call from any thread.
+bool SaveDatTextureToPng(const DatTexture& texture, const std::filesystem::path& file_path);
+
+/**
+ * @brief Exports texture files from a DAT to PNG on a pool of worker threads, without D3D.
+ *
+ * Workers take the next MFT index from a shared counter, decode it and encode the PNG straight from the
+ * decoded pixels. A worker holds one decoded texture at a time, so memory stays bounded by the worker count.
+ * Files go to <save_directory>/<file type>/texture_0x<hash>.png, existing files are kept.
+ */
+class TextureExportJob
+{
+public:
+    using ErrorCallback = std::function<void(int mft_index, int file_hash, const std::wstring& error)>;
+
+    ~TextureExportJob() { Stop(); }
+
+    // on_error is called from the workers, one call at a time. num_threads 0 uses every hardware thread.
+    void Start(DATManager* dat_manager, std::vector<int> mft_indices, const std::filesystem::path& save_directory,
+        ErrorCallback on_error, unsigned num_threads = 0);
+
+    // Cancels the remaining files and joins the workers.
+    void Stop();
+
+    // Started and not stopped yet, also while the finished workers wait to be joined by Stop.
+    bool IsActive() const { return !m_workers.empty(); }
+    bool IsDone() const { return m_running_workers.load() == 0; }
+
+    int GetTotalCount() const { return static_cast<int>(m_mft_indices.size()); }
+    int GetCompletedCount() const { return m_completed.load(); }
+
+private:
+    void RunWorker();
+    void ExportTexture(int mft_index);
+
+    DATManager* m_dat_manager = nullptr;
+    std::vector<int> m_mft_indices;
+    std::filesystem::path m_save_directory;
+    ErrorCallback m_on_error;
+    std::mutex m_error_mutex;
+
+    std::vector<std::jthread> m_workers;
+    std::atomic<size_t> m_next_index{0};
+    std::atomic<int> m_completed{0};
+    std::atomic<int> m_running_workers{0};
+    std::atomic<bool> m_stop_requested{false};
+};
@@ -262,7 +262,7 @@ public:
 	                                     int file_hash);
 	HRESULT SaveTextureToFile(ID3D11ShaderResourceView* srv, const wchar_t* filename);
 
-	DatTexture BuildTextureAtlas(const std::vector<DatTexture>& terrain_dat_textures, int num_cols,
+	static DatTexture BuildTextureAtlas(const std::vector<DatTexture>& terrain_dat_textures, int num_cols,
 	                             int num_rows);
 
 	void Clear() { 
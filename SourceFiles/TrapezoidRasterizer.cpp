@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "TrapezoidRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    constexpr int BAND_HEIGHT = 32;
+
+    // Trapezoid corners in pixels, top is the smaller row.
+    struct PixelTrapezoid
+    {
+        int top;
+        int bottom;
+        int top_left;
+        int top_right;
+        int bottom_left;
+        int bottom_right;
+    };
+
+    PixelTrapezoid to_pixels(const PathfindingTrapezoid& trap, const TrapezoidRasterTransform& transform, int height)
+    {
+        auto px = [&](float x) { return static_cast<int>((x - transform.min_x) * transform.scale_x); };
+        auto py = [&](float y) { return height - 1 - static_cast<int>((y - transform.min_y) * transform.scale_y); };
+
+        PixelTrapezoid result{ py(trap.yt), py(trap.yb), px(trap.xtl), px(trap.xtr), px(trap.xbl), px(trap.xbr) };
+        if (result.top > result.bottom) {
+            std::swap(result.top, result.bottom);
+            std::swap(result.top_left, result.bottom_left);
+            std::swap(result.top_right, result.bottom_right);
+        }
+        return result;
+    }
+
+    int round_to_int(float value)
+    {
+        return static_cast<int>(std::floor(value + 0.5f));
+    }
+
+    void fill_clipped(RGBA* row, int x0, int x1, int width, RGBA color)
+    {
+        if (x0 > x1) std::swap(x0, x1);
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, width - 1);
+        if (x0 <= x1) {
+            FillSpan(row + x0, x1 - x0 + 1, color);
+        }
+    }
+
+    // Pixels of the side edge from (x_top, top) to (x_bottom, bottom) on row y. Steep edges cover one
+    // pixel per row, shallow edges a run as long as the slope.
+    void draw_edge_row(RGBA* row, int y, const PixelTrapezoid& trap, int x_top, int x_bottom, int width, RGBA color)
+    {
+        const float slope = static_cast<float>(x_bottom - x_top) / static_cast<float>(trap.bottom - trap.top);
+        const float center = x_top + slope * static_cast<float>(y - trap.top);
+        const float half_run = std::max(0.0f, (std::abs(slope) - 1.0f) * 0.5f);
+        const int lo = std::max(round_to_int(center - half_run), std::min(x_top, x_bottom));
+        const int hi = std::min(round_to_int(center + half_run), std::max(x_top, x_bottom));
+        fill_clipped(row, lo, std::max(lo, hi), width, color);
+    }
+
+    void draw_trapezoid_rows(RGBA* pixels, int width, const PixelTrapezoid& trap, int row_begin, int row_end,
+        const TrapezoidRasterStyle& style)
+    {
+        const int first = std::max(trap.top, row_begin);
+        const int last = std::min(trap.bottom, row_end - 1);
+        const int rows = trap.bottom - trap.top;
+
+        for (int y = first; y <= last; y++) {
+            RGBA* row = pixels + static_cast<size_t>(y) * width;
+
+            if (rows == 0) {
+                // Degenerate trapezoid on a single row
+                const int x0 = std::min({ trap.top_left, trap.top_right, trap.bottom_left, trap.bottom_right });
+                const int x1 = std::max({ trap.top_left, trap.top_right, trap.bottom_left, trap.bottom_right });
+                fill_clipped(row, x0, x1, width, style.outline);
+                continue;
+            }
+
+            const float t = static_cast<float>(y - trap.top) / static_cast<float>(rows);
+            const float left = trap.top_left + (trap.bottom_left - trap.top_left) * t;
+            const float right = trap.top_right + (trap.bottom_right - trap.top_right) * t;
+            fill_clipped(row, static_cast<int>(left), static_cast<int>(right), width, style.fill);
+
+            if (y == trap.top) {
+                fill_clipped(row, trap.top_left, trap.top_right, width, style.outline);
+            }
+            else if (y == trap.bottom) {
+                fill_clipped(row, trap.bottom_left, trap.bottom_right, width, style.outline);
+            }
+            else {
+                draw_edge_row(row, y, trap, trap.top_left, trap.bottom_left, width, style.outline);
+                draw_edge_row(row, y, trap, trap.top_right, trap.bottom_right, width, style.outline);
+            }
+        }
+    }
+}
+
+void FillSpan(RGBA* pixels, int count, RGBA color)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+    const __m128i value = _mm_set1_epi32(static_cast<int>(color.dw));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), value);
+    }
+    for (; i < count; i++) {
+        pixels[i] = color;
+    }
+#else
+    std::fill_n(pixels, count, color);
+#endif
+}
+
+void RasterizeTrapezoids(RGBA* pixels, int width, int height, std::span<const PathfindingTrapezoid> trapezoids,
+    const TrapezoidRasterTransform& transform, std::span<const TrapezoidRasterStyle> styles)
+{
+    if (!pixels || width <= 0 || height <= 0 || trapezoids.empty() || styles.empty()) return;
+    const bool shared_style = styles.size() < trapezoids.size();
+
+    std::vector<PixelTrapezoid> pixel_traps(trapezoids.size());
+    std::transform(trapezoids.begin(), trapezoids.end(), pixel_traps.begin(),
+        [&](const PathfindingTrapezoid& trap) { return to_pixels(trap, transform, height); });
+
+    // Bin trapezoids into row bands (CSR), keeping input order within each band.
+    const int band_count = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    std::vector<uint32_t> band_offsets(band_count + 1, 0);
+    auto band_range = [&](const PixelTrapezoid& trap, int& first_band, int& last_band) {
+        const int top = std::max(trap.top, 0);
+        const int bottom = std::min(trap.bottom, height - 1);
+        if (top > bottom) return false;
+        first_band = top / BAND_HEIGHT;
+        last_band = bottom / BAND_HEIGHT;
+        return true;
+    };
+
+    for (const auto& trap : pixel_traps) {
+        int first_band, last_band;
+        if (!band_range(trap, first_band, last_band)) continue;
+        for (int band = first_band; band <= last_band; band++) {
+            band_offsets[band + 1]++;
+        }
+    }
+    std::partial_sum(band_offsets.begin(), band_offsets.end(), band_offsets.begin());
+
+    std::vector<uint32_t> band_items(band_offsets.back());
+    std::vector<uint32_t> band_fill(band_offsets.begin(), band_offsets.end() - 1);
+    for (uint32_t i = 0; i < pixel_traps.size(); i++) {
+        int first_band, last_band;
+        if (!band_range(pixel_traps[i], first_band, last_band)) continue;
+        for (int band = first_band; band <= last_band; band++) {
+            band_items[band_fill[band]++] = i;
+        }
+    }
+
+    std::vector<int> bands(band_count);
+    std::iota(bands.begin(), bands.end(), 0);
+    std::for_each(std::execution::par, bands.begin(), bands.end(), [&](int band) {
+        const int row_begin = band * BAND_HEIGHT;
+        const int row_end = std::min(row_begin + BAND_HEIGHT, height);
+        for (uint32_t item = band_offsets[band]; item < band_offsets[band + 1]; item++) {
+            const uint32_t i = band_items[item];
+            draw_trapezoid_rows(pixels, width, pixel_traps[i], row_begin, row_end, shared_style ? styles[0] : styles[i]);
+        }
+    });
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <span>
+#include "AtexReader.h"
+#include "FFNA_MapFile.h"
+
+// Maps pathfinding (map XY) coordinates to pixels. Image rows grow downwards, so map Y is flipped.
+struct TrapezoidRasterTransform
+{
+    float min_x = 0;
+    float min_y = 0;
+    float scale_x = 1;
+    float scale_y = 1;
+};
+
+struct TrapezoidRasterStyle
+{
+    RGBA fill;
+    RGBA outline;
+};
+
+/**
+ * @brief Rasterizes pathfinding trapezoids with a one pixel outline into an image.
+ *
+ * Trapezoids have horizontal top and bottom edges, so every covered row is a
+ * single span between the interpolated left and right sides and no edge sorting
+ * is needed. The image is split into bands of rows that are rasterized in
+ * parallel. Each band draws the trapezoids overlapping it in input order, so
+ * later trapezoids overwrite earlier ones exactly like a sequential pass.
+ *
+ * @param styles One style per trapezoid, or a single style shared by all of them.
+ */
+void RasterizeTrapezoids(RGBA* pixels, int width, int height, std::span<const PathfindingTrapezoid> trapezoids,
+    const TrapezoidRasterTransform& transform, std::span<const TrapezoidRasterStyle> styles);
+
+// Writes count copies of color, four pixels per store where SSE is available.
+void FillSpan(RGBA* pixels, int count, RGBA color);
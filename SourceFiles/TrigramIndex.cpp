@@ -0,0 +1,113 @@
+#include "pch.h"
+#include "TrigramIndex.h"
+
+namespace
+{
+    constexpr size_t TRIGRAM_LENGTH = 3;
+
+    uint32_t trigram_at(std::string_view text, size_t i)
+    {
+        return static_cast<uint8_t>(text[i]) | (static_cast<uint8_t>(text[i + 1]) << 8) | (static_cast<uint32_t>(static_cast<uint8_t>(text[i + 2])) << 16);
+    }
+
+    void get_trigrams(std::string_view text, std::vector<uint32_t>& trigrams)
+    {
+        trigrams.clear();
+        for (size_t i = 0; i + TRIGRAM_LENGTH <= text.size(); i++) {
+            trigrams.push_back(trigram_at(text, i));
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+
+    bool matches(std::string_view text, std::string_view query, bool prefix_only)
+    {
+        return prefix_only ? text.starts_with(query) : text.find(query) != std::string_view::npos;
+    }
+}
+
+void TrigramIndex::Clear()
+{
+    m_text.clear();
+    m_offsets.assign(1, 0);
+    m_postings.clear();
+}
+
+uint32_t TrigramIndex::Add(std::string_view text)
+{
+    const auto document = static_cast<uint32_t>(Size());
+    m_text += ToLowerCase(text);
+    m_offsets.push_back(static_cast<uint32_t>(m_text.size()));
+
+    std::vector<uint32_t> trigrams;
+    get_trigrams(GetText(document), trigrams);
+    for (const auto trigram : trigrams) {
+        m_postings[trigram].push_back(document);
+    }
+    return document;
+}
+
+void TrigramIndex::Search(std::string_view query, bool prefix_only, std::vector<uint32_t>& documents) const
+{
+    documents.clear();
+    const std::string lower_query = ToLowerCase(query);
+
+    if (lower_query.size() < TRIGRAM_LENGTH) {
+        for (uint32_t document = 0; document < Size(); document++) {
+            if (matches(GetText(document), lower_query, prefix_only)) documents.push_back(document);
+        }
+        return;
+    }
+
+    std::vector<uint32_t> trigrams;
+    get_trigrams(lower_query, trigrams);
+
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (const auto trigram : trigrams) {
+        const auto it = m_postings.find(trigram);
+        if (it == m_postings.end()) return;
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    std::vector<uint32_t> candidates = *lists.front();
+    std::vector<uint32_t> intersection;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    // Having all trigrams doesn't mean they are adjacent and in order.
+    for (const auto document : candidates) {
+        if (matches(GetText(document), lower_query, prefix_only)) documents.push_back(document);
+    }
+}
+
+size_t TrigramIndex::GetMemoryUsage() const
+{
+    size_t size = m_text.capacity() + m_offsets.capacity() * sizeof(uint32_t);
+    for (const auto& [trigram, documents] : m_postings) {
+        size += sizeof(trigram) + sizeof(documents) + documents.capacity() * sizeof(uint32_t);
+    }
+    return size;
+}
+
+int TrigramIndex::GetMatchRank(std::string_view text, std::string_view query)
+{
+    const size_t position = text.find(query);
+    if (position == std::string_view::npos) return -1;
+    if (position == 0) return text.size() == query.size() ? 0 : 1;
+
+    for (size_t i = position; i != std::string_view::npos; i = text.find(query, i + 1)) {
+        if (!std::isalnum(static_cast<unsigned char>(text[i - 1]))) return 2;
+    }
+    return 3;
+}
+
+std::string TrigramIndex::ToLowerCase(std::string_view text)
+{
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
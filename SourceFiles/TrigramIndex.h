@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Case insensitive substring and prefix search over a growing set of strings.
+ *
+ * Every string (document) is stored lower case in one pool and each of its trigrams, three consecutive bytes,
+ * lists the documents containing it. A query intersects the lists of its trigrams, shortest first, and checks
+ * the remaining candidates with a plain find. Queries shorter than a trigram scan the pool.
+ * Documents are only appended, so the lists stay sorted and the index can be extended at any time.
+ */
+class TrigramIndex
+{
+public:
+    void Clear();
+
+    // Returns the id of the new document, ids are consecutive from 0.
+    uint32_t Add(std::string_view text);
+
+    size_t Size() const { return m_offsets.size() - 1; }
+
+    // Lower case text of a document.
+    std::string_view GetText(uint32_t document) const
+    {
+        return std::string_view(m_text).substr(m_offsets[document], m_offsets[document + 1] - m_offsets[document]);
+    }
+
+    // Ids of the documents containing query, or starting with it if prefix_only, in ascending order.
+    void Search(std::string_view query, bool prefix_only, std::vector<uint32_t>& documents) const;
+
+    size_t GetMemoryUsage() const;
+
+    // Lower is better: 0 exact, 1 prefix, 2 prefix of a word, 3 anywhere else. -1 if text doesn't contain query.
+    // Both are expected to be lower case.
+    static int GetMatchRank(std::string_view text, std::string_view query);
+
+    static std::string ToLowerCase(std::string_view text);
+
+private:
+    std::string m_text;
+    std::vector<uint32_t> m_offsets{ 0 };
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include "PropInstancing.h"
 
 using namespace DirectX;
 
@@ -153,6 +154,27 @@ inline extern D3D11_INPUT_ELEMENT_DESC inputLayoutDesc[] = {
   {"TANGENT", 1, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(GWVertex, bitangent), D3D11_INPUT_PER_VERTEX_DATA, 0}
 };
 
+// Input layout of the instanced vertex shader: the mesh vertices in slot 0 and PropInstanceData per instance.
+inline extern D3D11_INPUT_ELEMENT_DESC instancedInputLayoutDesc[] = {
+  {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(GWVertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(GWVertex, normal), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord0), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord1), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 2, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord2), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 3, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord3), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 4, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord4), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 5, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord5), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 6, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord6), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TEXCOORD", 7, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(GWVertex, tex_coord7), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(GWVertex, tangent), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"TANGENT", 1, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(GWVertex, bitangent), D3D11_INPUT_PER_VERTEX_DATA, 0},
+  {"INSTANCE_WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, PROP_INSTANCE_BUFFER_SLOT, offsetof(PropInstanceData, world) + 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+  {"INSTANCE_WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, PROP_INSTANCE_BUFFER_SLOT, offsetof(PropInstanceData, world) + 16, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+  {"INSTANCE_WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, PROP_INSTANCE_BUFFER_SLOT, offsetof(PropInstanceData, world) + 32, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+  {"INSTANCE_WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, PROP_INSTANCE_BUFFER_SLOT, offsetof(PropInstanceData, world) + 48, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+  {"INSTANCE_OBJECT_DATA", 0, DXGI_FORMAT_R32G32_UINT, PROP_INSTANCE_BUFFER_SLOT, offsetof(PropInstanceData, object_id), D3D11_INPUT_PER_INSTANCE_DATA, 1}
+};
+
 // Input layout for skinned meshes (includes bone indices and weights)
 inline extern D3D11_INPUT_ELEMENT_DESC skinnedInputLayoutDesc[] = {
   {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(SkinnedGWVertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0},
@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "VertexFormat.h"
+#include <DirectXPackedVector.h>
+#include <cstring>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+    constexpr uint32_t FULL_VERTEX_ELEMENT_COUNT = ARRAYSIZE(inputLayoutDesc);
+    constexpr const char* UV_SEMANTIC = "TEXCOORD";
+
+    bool is_zero(const XMFLOAT2& v) { return v.x == 0.0f && v.y == 0.0f; }
+    bool is_zero(const XMFLOAT3& v) { return v.x == 0.0f && v.y == 0.0f && v.z == 0.0f; }
+
+    const XMFLOAT2& get_uv(const GWVertex& vertex, uint32_t set)
+    {
+        const XMFLOAT2* uvs[] = { &vertex.tex_coord0, &vertex.tex_coord1, &vertex.tex_coord2, &vertex.tex_coord3,
+            &vertex.tex_coord4, &vertex.tex_coord5, &vertex.tex_coord6, &vertex.tex_coord7 };
+        return *uvs[set];
+    }
+
+    int16_t to_snorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    float from_snorm16(int16_t value)
+    {
+        return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+    }
+
+    // Normalized direction, zero vectors stay zero so the shaders still see them as missing.
+    void write_direction(std::byte* dst, const XMFLOAT3& direction)
+    {
+        int16_t packed[4] = {};
+        const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+        if (length > 0.0f) {
+            packed[0] = to_snorm16(direction.x / length);
+            packed[1] = to_snorm16(direction.y / length);
+            packed[2] = to_snorm16(direction.z / length);
+        }
+        std::memcpy(dst, packed, sizeof(packed));
+    }
+
+    D3D11_INPUT_ELEMENT_DESC vertex_element(const char* semantic, UINT index, DXGI_FORMAT format, UINT offset)
+    {
+        return { semantic, index, format, 0, offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+
+    D3D11_INPUT_ELEMENT_DESC default_element(const char* semantic, UINT index, DXGI_FORMAT format)
+    {
+        return { semantic, index, format, VERTEX_DEFAULTS_BUFFER_SLOT, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+}
+
+uint32_t VertexFormat::GetStride() const
+{
+    if (!packed) return sizeof(GWVertex);
+
+    return sizeof(XMFLOAT3) + (has_normal ? 4 : 0) + uv_count * (half_uvs ? 4 : 8) + (has_tangents ? 16 : 0);
+}
+
+uint32_t VertexFormat::GetKey() const
+{
+    if (!packed) return 0;
+    return 1 | (has_normal ? 2 : 0) | (has_tangents ? 4 : 0) | (half_uvs ? 8 : 0) | (static_cast<uint32_t>(uv_count) << 4);
+}
+
+VertexFormat ChooseVertexFormat(std::span<const GWVertex> vertices, const std::optional<VertexAttributes>& attributes)
+{
+    VertexFormat format;
+    format.packed = true;
+
+    uint32_t uv_set_mask = 0;
+    if (attributes) {
+        uv_set_mask = attributes->uv_set_mask;
+        format.has_normal = attributes->has_normal;
+        format.has_tangents = attributes->has_tangents;
+    }
+    else {
+        for (const auto& vertex : vertices) {
+            format.has_normal |= !is_zero(vertex.normal);
+            format.has_tangents |= !is_zero(vertex.tangent) || !is_zero(vertex.bitangent);
+            for (uint32_t set = 0; set < PACKED_VERTEX_MAX_UV_SETS; set++) {
+                if (!is_zero(get_uv(vertex, set))) uv_set_mask |= 1u << set;
+            }
+        }
+    }
+
+    for (uint32_t set = 0; set < PACKED_VERTEX_MAX_UV_SETS; set++) {
+        if (uv_set_mask & (1u << set)) format.uv_count = static_cast<uint8_t>(set + 1);
+    }
+
+    format.half_uvs = true;
+    for (const auto& vertex : vertices) {
+        // Octahedral normals can't represent zero length normals within a mesh that has normals.
+        if (format.has_normal && is_zero(vertex.normal)) return VertexFormat::Full();
+
+        for (uint32_t set = 0; set < format.uv_count && format.half_uvs; set++) {
+            const auto& uv = get_uv(vertex, set);
+            if (!(std::abs(uv.x) <= PACKED_VERTEX_MAX_HALF_UV && std::abs(uv.y) <= PACKED_VERTEX_MAX_HALF_UV)) {
+                format.half_uvs = false;
+            }
+        }
+    }
+    if (format.uv_count == 0) format.half_uvs = false;
+
+    return format;
+}
+
+VertexFormat MergeVertexFormats(const VertexFormat& a, const VertexFormat& b)
+{
+    if (!a.packed || !b.packed) return VertexFormat::Full();
+    // A mesh without normals can't share a packed layout with one that has them, its zero normals aren't encodable.
+    if (a.has_normal != b.has_normal) return VertexFormat::Full();
+
+    VertexFormat format;
+    format.packed = true;
+    format.has_normal = a.has_normal;
+    format.has_tangents = a.has_tangents || b.has_tangents;
+    format.uv_count = std::max(a.uv_count, b.uv_count);
+    format.half_uvs = (a.half_uvs || a.uv_count == 0) && (b.half_uvs || b.uv_count == 0) && format.uv_count > 0;
+    return format;
+}
+
+void PackVertices(std::span<const GWVertex> vertices, const VertexFormat& format, std::vector<std::byte>& packed)
+{
+    const uint32_t stride = format.GetStride();
+    packed.resize(vertices.size() * stride);
+    if (!format.packed) {
+        std::memcpy(packed.data(), vertices.data(), packed.size());
+        return;
+    }
+
+    std::byte* dst = packed.data();
+    for (const auto& vertex : vertices) {
+        std::memcpy(dst, &vertex.position, sizeof(XMFLOAT3));
+        dst += sizeof(XMFLOAT3);
+
+        if (format.has_normal) {
+            int16_t normal[2];
+            EncodeOctahedralNormal(vertex.normal, normal[0], normal[1]);
+            std::memcpy(dst, normal, sizeof(normal));
+            dst += sizeof(normal);
+        }
+
+        for (uint32_t set = 0; set < format.uv_count; set++) {
+            const auto& uv = get_uv(vertex, set);
+            if (format.half_uvs) {
+                const HALF half_uv[2] = { XMConvertFloatToHalf(uv.x), XMConvertFloatToHalf(uv.y) };
+                std::memcpy(dst, half_uv, sizeof(half_uv));
+                dst += sizeof(half_uv);
+            }
+            else {
+                std::memcpy(dst, &uv, sizeof(XMFLOAT2));
+                dst += sizeof(XMFLOAT2);
+            }
+        }
+
+        if (format.has_tangents) {
+            write_direction(dst, vertex.tangent);
+            write_direction(dst + 8, vertex.bitangent);
+            dst += 16;
+        }
+    }
+}
+
+void GetVertexInputElements(const VertexFormat& format, bool instanced, std::vector<D3D11_INPUT_ELEMENT_DESC>& elements)
+{
+    elements.clear();
+    if (!format.packed) {
+        elements.assign(std::begin(inputLayoutDesc), std::end(inputLayoutDesc));
+    }
+    else {
+        UINT offset = 0;
+        elements.push_back(vertex_element("POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, offset));
+        offset += sizeof(XMFLOAT3);
+
+        if (format.has_normal) {
+            elements.push_back(vertex_element("NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, offset));
+            offset += 4;
+        }
+        else {
+            // Read as a float4 of zeros, w = 0 tells the shader there is no normal.
+            elements.push_back(default_element("NORMAL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT));
+        }
+
+        for (UINT set = 0; set < PACKED_VERTEX_MAX_UV_SETS; set++) {
+            if (set < format.uv_count) {
+                elements.push_back(vertex_element(UV_SEMANTIC, set, format.half_uvs ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT, offset));
+                offset += format.half_uvs ? 4 : 8;
+            }
+            else {
+                elements.push_back(default_element(UV_SEMANTIC, set, DXGI_FORMAT_R32G32_FLOAT));
+            }
+        }
+
+        if (format.has_tangents) {
+            elements.push_back(vertex_element("TANGENT", 0, DXGI_FORMAT_R16G16B16A16_SNORM, offset));
+            elements.push_back(vertex_element("TANGENT", 1, DXGI_FORMAT_R16G16B16A16_SNORM, offset + 8));
+        }
+        else {
+            elements.push_back(default_element("TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT));
+            elements.push_back(default_element("TANGENT", 1, DXGI_FORMAT_R32G32B32_FLOAT));
+        }
+    }
+
+    if (instanced) {
+        elements.insert(elements.end(), std::begin(instancedInputLayoutDesc) + FULL_VERTEX_ELEMENT_COUNT, std::end(instancedInputLayoutDesc));
+    }
+}
+
+void EncodeOctahedralNormal(const XMFLOAT3& normal, int16_t& x, int16_t& y)
+{
+    const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 <= 0.0f) {
+        x = 0;
+        y = 0;
+        return;
+    }
+
+    float ox = normal.x / l1;
+    float oy = normal.y / l1;
+    if (normal.z < 0.0f) {
+        // Fold the lower hemisphere over the diagonals.
+        const float fx = (1.0f - std::abs(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+        const float fy = (1.0f - std::abs(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+        ox = fx;
+        oy = fy;
+    }
+    x = to_snorm16(ox);
+    y = to_snorm16(oy);
+}
+
+XMFLOAT3 DecodeOctahedralNormal(int16_t x, int16_t y)
+{
+    XMFLOAT3 n(from_snorm16(x), from_snorm16(y), 0.0f);
+    n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+
+    XMFLOAT3 result;
+    XMStoreFloat3(&result, XMVector3Normalize(XMLoadFloat3(&n)));
+    return result;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "Vertex.h"
+
+// Input slot of a small zero buffer bound with stride 0. Attributes a packed layout doesn't store are read from it,
+// so every layout feeds the same shader inputs. Slot 1 holds per instance data.
+constexpr uint32_t VERTEX_DEFAULTS_BUFFER_SLOT = 2;
+constexpr uint32_t VERTEX_DEFAULTS_BUFFER_SIZE = 16;
+
+// The vertex shader only reads TEXCOORD0-5, sets 6 and 7 are dropped from packed layouts.
+constexpr uint32_t PACKED_VERTEX_MAX_UV_SETS = 6;
+
+// UVs with a larger magnitude are stored as floats. Below it the half float rounding error stays under 1/2048.
+constexpr float PACKED_VERTEX_MAX_HALF_UV = 2.0f;
+
+// The vertex attributes a mesh carries, e.g. from the FVF of a model file.
+struct VertexAttributes
+{
+    uint8_t uv_set_mask = 0;
+    bool has_normal = false;
+    bool has_tangents = false;
+};
+
+/**
+ * @brief GPU layout of a mesh's vertices.
+ *
+ * GWVertex holds every attribute any mesh can have and is 112 bytes. Meshes are uploaded in the smallest packed
+ * layout that holds their data instead:
+ *   POSITION   R32G32B32_FLOAT
+ *   NORMAL     R16G16_SNORM octahedral normal, if the mesh has normals
+ *   TEXCOORDn  R16G16_FLOAT, or R32G32_FLOAT if the UVs are too large for half floats, for the used UV sets
+ *   TANGENT0/1 R16G16B16A16_SNORM normalized tangent and bitangent, if the mesh has tangents
+ * The packed layouts are drawn with the COMPACT_VERTEX variant of VertexShader.hlsl. A mesh that can't be
+ * packed losslessly enough keeps the full GWVertex layout.
+ */
+struct VertexFormat
+{
+    bool packed = false;
+    bool has_normal = false;
+    bool has_tangents = false;
+    bool half_uvs = false;
+    uint8_t uv_count = 0; // TEXCOORD0 up to uv_count - 1 are stored.
+
+    static VertexFormat Full() { return {}; }
+
+    uint32_t GetStride() const;
+
+    // Identifies the input layout, formats with equal keys share one.
+    uint32_t GetKey() const;
+
+    bool operator==(const VertexFormat& other) const { return GetKey() == other.GetKey(); }
+};
+
+// Picks the layout for vertices. attributes, when known, limits the scan to the attributes the mesh declares.
+VertexFormat ChooseVertexFormat(std::span<const GWVertex> vertices, const std::optional<VertexAttributes>& attributes);
+
+// The smallest format that holds the data of both a and b.
+VertexFormat MergeVertexFormats(const VertexFormat& a, const VertexFormat& b);
+
+// Writes vertices in the layout of format, format.GetStride() bytes per vertex.
+void PackVertices(std::span<const GWVertex> vertices, const VertexFormat& format, std::vector<std::byte>& packed);
+
+// Input layout elements of format, followed by the per instance elements when instanced.
+void GetVertexInputElements(const VertexFormat& format, bool instanced, std::vector<D3D11_INPUT_ELEMENT_DESC>& elements);
+
+// Octahedral encoding of a normal into two snorm16 values, see decode_octahedral_normal in VertexShader.hlsl.
+void EncodeOctahedralNormal(const XMFLOAT3& normal, int16_t& x, int16_t& y);
+XMFLOAT3 DecodeOctahedralNormal(int16_t x, int16_t y);
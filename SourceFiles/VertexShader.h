@@ -1,6 +1,8 @@
 #pragma once
 #include <d3dcompiler.h>
+#include <unordered_map>
 #include "Vertex.h"
+#include "VertexFormat.h"
 using Microsoft::WRL::ComPtr;
 
 const char shader_vs[] = R"(
@@ -34,7 +36,7 @@ cbuffer PerObjectCB : register(b1)
     uint4 texture_types[2];
     uint num_uv_texture_pairs;
     uint object_id;
-    float pad1[2];
+    uint highlight_state;
 };
 
 cbuffer PerCameraCB : register(b2)
@@ -53,17 +55,32 @@ cbuffer PerCameraCB : register(b2)
 struct VertexInputType
 {
     float3 position : POSITION;
+#ifdef COMPACT_VERTEX
+    // Packed layouts, see VertexFormat. Octahedral encoded normal in xy, w is 0 when the mesh has no normals.
+    float4 normal_oct : NORMAL;
+#else
     float3 normal : NORMAL;
+#endif
     float2 tex_coords0 : TEXCOORD0;
     float2 tex_coords1 : TEXCOORD1;
     float2 tex_coords2 : TEXCOORD2;
     float2 tex_coords3 : TEXCOORD3;
     float2 tex_coords4 : TEXCOORD4;
     float2 tex_coords5 : TEXCOORD5;
+#ifndef COMPACT_VERTEX
     float2 tex_coords6 : TEXCOORD6;
     float2 tex_coords7 : TEXCOORD7;
+#endif
     float3 tangent : TANGENT;
     float3 bitangent : TANGENT;
+#ifdef INSTANCED
+    // Per instance data, see PropInstanceData. The rows form the untransposed world matrix.
+    float4 instance_world0 : INSTANCE_WORLD0;
+    float4 instance_world1 : INSTANCE_WORLD1;
+    float4 instance_world2 : INSTANCE_WORLD2;
+    float4 instance_world3 : INSTANCE_WORLD3;
+    uint2 instance_object_data : INSTANCE_OBJECT_DATA; // object_id, highlight_state
+#endif
 };
 
 struct PixelInputType
@@ -81,20 +98,45 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
+float3 decode_octahedral_normal(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
 
 PixelInputType main(VertexInputType input)
 {
     PixelInputType output;
 
+#ifdef INSTANCED
+    float4x4 world = float4x4(input.instance_world0, input.instance_world1, input.instance_world2, input.instance_world3);
+    output.object_id = input.instance_object_data.x;
+    output.highlight_state = input.instance_object_data.y;
+#else
+    float4x4 world = World;
+    output.object_id = object_id;
+    output.highlight_state = highlight_state;
+#endif
+
+#ifdef COMPACT_VERTEX
+    float3 vertex_normal = decode_octahedral_normal(input.normal_oct.xy) * input.normal_oct.w;
+#else
+    float3 vertex_normal = input.normal;
+#endif
+
     // Transform the vertex position to clip space
-    float4 worldPosition = mul(float4(input.position, 1.0f), World);
+    float4 worldPosition = mul(float4(input.position, 1.0f), world);
     float4 viewPosition = mul(worldPosition, View);
     output.position = mul(viewPosition, Projection);
     output.world_position = worldPosition;
 
-    output.normal = mul(input.normal, (float3x3)World);
+    output.normal = mul(vertex_normal, (float3x3)world);
 
     // Pass the texture coordinates to the pixel shader
     output.tex_coords0 = input.tex_coords0;
@@ -135,9 +177,9 @@ PixelInputType main(VertexInputType input)
     else
     {
 		// Calculate the TBN matrix using direct tangent and bitangent
-        float3 T = normalize(mul(input.tangent, (float3x3) World)); // Transform tangent
-        float3 B = normalize(mul(input.bitangent, (float3x3) World)); // Transform bitangent
-        float3 N = normalize(mul(input.normal, (float3x3) World)); // Transform normal
+        float3 T = normalize(mul(input.tangent, (float3x3) world)); // Transform tangent
+        float3 B = normalize(mul(input.bitangent, (float3x3) world)); // Transform bitangent
+        float3 N = normalize(mul(vertex_normal, (float3x3) world)); // Transform normal
 
 		// Set the TBN matrix
         output.TBN = float3x3(T, B, N);
@@ -178,30 +220,14 @@ public:
     bool Initialize(const std::wstring& shader_path)
     {
         ComPtr<ID3DBlob> vertex_shader_blob;
-        ComPtr<ID3DBlob> error_blob;
-
-        UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-#if defined(DEBUG) || defined(_DEBUG)
-        flags |= D3DCOMPILE_DEBUG;
-        flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-        // Compile from memory (the string above). Make sure that the shader_vs string is the same as the one in the .hlsl file.
-        HRESULT hr = D3DCompile(shader_vs, strlen(shader_vs), NULL, NULL, NULL, "main", "vs_5_0", flags, 0,
-                                vertex_shader_blob.GetAddressOf(), error_blob.GetAddressOf());
-
-        if (FAILED(hr))
+        if (!Compile(nullptr, vertex_shader_blob))
         {
-            if (error_blob)
-            {
-                OutputDebugStringA((char*)error_blob->GetBufferPointer());
-            }
             return false;
         }
 
-        hr = m_device->CreateVertexShader(vertex_shader_blob->GetBufferPointer(),
-                                          vertex_shader_blob->GetBufferSize(), nullptr,
-                                          m_vertex_shader.GetAddressOf());
+        HRESULT hr = m_device->CreateVertexShader(vertex_shader_blob->GetBufferPointer(),
+                                                  vertex_shader_blob->GetBufferSize(), nullptr,
+                                                  m_vertex_shader.GetAddressOf());
 
         if (FAILED(hr))
         {
@@ -217,15 +243,139 @@ public:
             return false;
         }
 
+        // The instanced variant reads the world matrix and object data from a per instance buffer.
+        // Instancing is simply unavailable if it fails, so this doesn't fail the initialization.
+        const D3D_SHADER_MACRO instanced_defines[] = { { "INSTANCED", "1" }, { nullptr, nullptr } };
+        ComPtr<ID3DBlob> instanced_blob;
+        if (Compile(instanced_defines, instanced_blob))
+        {
+            if (FAILED(m_device->CreateVertexShader(instanced_blob->GetBufferPointer(), instanced_blob->GetBufferSize(),
+                                                    nullptr, m_instanced_vertex_shader.GetAddressOf())) ||
+                FAILED(m_device->CreateInputLayout(instancedInputLayoutDesc, ARRAYSIZE(instancedInputLayoutDesc),
+                                                   instanced_blob->GetBufferPointer(), instanced_blob->GetBufferSize(),
+                                                   m_instanced_input_layout.GetAddressOf())))
+            {
+                m_instanced_vertex_shader.Reset();
+                m_instanced_input_layout.Reset();
+            }
+        }
+
+        // The COMPACT_VERTEX variants draw meshes uploaded in a packed VertexFormat. Their input layouts depend on
+        // the format and are created on first use in GetVariant.
+        const D3D_SHADER_MACRO compact_defines[] = { { "COMPACT_VERTEX", "1" }, { nullptr, nullptr } };
+        if (!Compile(compact_defines, m_compact_blob) ||
+            FAILED(m_device->CreateVertexShader(m_compact_blob->GetBufferPointer(), m_compact_blob->GetBufferSize(),
+                                                nullptr, m_compact_vertex_shader.GetAddressOf())))
+        {
+            return false;
+        }
+
+        if (m_instanced_vertex_shader)
+        {
+            const D3D_SHADER_MACRO compact_instanced_defines[] = {
+                { "COMPACT_VERTEX", "1" }, { "INSTANCED", "1" }, { nullptr, nullptr } };
+            if (!Compile(compact_instanced_defines, m_compact_instanced_blob) ||
+                FAILED(m_device->CreateVertexShader(m_compact_instanced_blob->GetBufferPointer(),
+                                                    m_compact_instanced_blob->GetBufferSize(), nullptr,
+                                                    m_compact_instanced_vertex_shader.GetAddressOf())))
+            {
+                // Instancing needs both vertex layouts.
+                m_instanced_vertex_shader.Reset();
+                m_instanced_input_layout.Reset();
+                m_compact_instanced_blob.Reset();
+            }
+        }
+
         return true;
     }
 
     ID3D11VertexShader* GetShader() const { return m_vertex_shader.Get(); }
     ID3D11InputLayout* GetInputLayout() const { return m_input_layout.Get(); }
 
+    // Null if the instanced variant failed to compile.
+    ID3D11VertexShader* GetInstancedShader() const { return m_instanced_vertex_shader.Get(); }
+    ID3D11InputLayout* GetInstancedInputLayout() const { return m_instanced_input_layout.Get(); }
+
+    struct Variant
+    {
+        ID3D11VertexShader* shader = nullptr;
+        ID3D11InputLayout* input_layout = nullptr;
+    };
+
+    // The shader and input layout that draw vertices in format. Null members if the variant is unavailable.
+    Variant GetVariant(const VertexFormat& format, bool instanced)
+    {
+        if (!format.packed)
+        {
+            return instanced ? Variant{ GetInstancedShader(), GetInstancedInputLayout() } : Variant{ GetShader(), GetInputLayout() };
+        }
+
+        ID3DBlob* blob = instanced ? m_compact_instanced_blob.Get() : m_compact_blob.Get();
+        if (!blob)
+        {
+            return {};
+        }
+
+        const uint32_t layout_key = format.GetKey() << 1 | (instanced ? 1 : 0);
+        auto it = m_compact_input_layouts.find(layout_key);
+        if (it == m_compact_input_layouts.end())
+        {
+            std::vector<D3D11_INPUT_ELEMENT_DESC> elements;
+            GetVertexInputElements(format, instanced, elements);
+
+            ComPtr<ID3D11InputLayout> input_layout;
+            if (FAILED(m_device->CreateInputLayout(elements.data(), static_cast<UINT>(elements.size()),
+                                                   blob->GetBufferPointer(), blob->GetBufferSize(),
+                                                   input_layout.GetAddressOf())))
+            {
+                input_layout.Reset();
+            }
+            it = m_compact_input_layouts.emplace(layout_key, input_layout).first;
+        }
+
+        if (!it->second)
+        {
+            return {};
+        }
+        return { instanced ? m_compact_instanced_vertex_shader.Get() : m_compact_vertex_shader.Get(), it->second.Get() };
+    }
+
 private:
+    bool Compile(const D3D_SHADER_MACRO* defines, ComPtr<ID3DBlob>& vertex_shader_blob)
+    {
+        ComPtr<ID3DBlob> error_blob;
+
+        UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined(DEBUG) || defined(_DEBUG)
+        flags |= D3DCOMPILE_DEBUG;
+        flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+
+        // Compile from memory (the string above). Make sure that the shader_vs string is the same as the one in the .hlsl file.
+        HRESULT hr = D3DCompile(shader_vs, strlen(shader_vs), NULL, defines, NULL, "main", "vs_5_0", flags, 0,
+                                vertex_shader_blob.GetAddressOf(), error_blob.GetAddressOf());
+
+        if (FAILED(hr))
+        {
+            if (error_blob)
+            {
+                OutputDebugStringA((char*)error_blob->GetBufferPointer());
+            }
+            return false;
+        }
+
+        return true;
+    }
+
     ID3D11Device* m_device;
     ID3D11DeviceContext* m_deviceContext;
     ComPtr<ID3D11VertexShader> m_vertex_shader;
     ComPtr<ID3D11InputLayout> m_input_layout;
+    ComPtr<ID3D11VertexShader> m_instanced_vertex_shader;
+    ComPtr<ID3D11InputLayout> m_instanced_input_layout;
+    ComPtr<ID3DBlob> m_compact_blob;
+    ComPtr<ID3DBlob> m_compact_instanced_blob;
+    ComPtr<ID3D11VertexShader> m_compact_vertex_shader;
+    ComPtr<ID3D11VertexShader> m_compact_instanced_vertex_shader;
+    std::unordered_map<uint32_t, ComPtr<ID3D11InputLayout>> m_compact_input_layouts;
 };
@@ -28,7 +28,7 @@ cbuffer PerObjectCB : register(b1)
     uint4 texture_types[2];
     uint num_uv_texture_pairs;
     uint object_id;
-    float pad1[2];
+    uint highlight_state;
 };
 
 cbuffer PerCameraCB : register(b2)
@@ -47,17 +47,32 @@ cbuffer PerCameraCB : register(b2)
 struct VertexInputType
 {
     float3 position : POSITION;
+#ifdef COMPACT_VERTEX
+    // Packed layouts, see VertexFormat. Octahedral encoded normal in xy, w is 0 when the mesh has no normals.
+    float4 normal_oct : NORMAL;
+#else
     float3 normal : NORMAL;
+#endif
     float2 tex_coords0 : TEXCOORD0;
     float2 tex_coords1 : TEXCOORD1;
     float2 tex_coords2 : TEXCOORD2;
     float2 tex_coords3 : TEXCOORD3;
     float2 tex_coords4 : TEXCOORD4;
     float2 tex_coords5 : TEXCOORD5;
+#ifndef COMPACT_VERTEX
     float2 tex_coords6 : TEXCOORD6;
     float2 tex_coords7 : TEXCOORD7;
+#endif
     float3 tangent : TANGENT;
     float3 bitangent : TANGENT;
+#ifdef INSTANCED
+    // Per instance data, see PropInstanceData. The rows form the untransposed world matrix.
+    float4 instance_world0 : INSTANCE_WORLD0;
+    float4 instance_world1 : INSTANCE_WORLD1;
+    float4 instance_world2 : INSTANCE_WORLD2;
+    float4 instance_world3 : INSTANCE_WORLD3;
+    uint2 instance_object_data : INSTANCE_OBJECT_DATA; // object_id, highlight_state
+#endif
 };
 
 struct PixelInputType
@@ -75,20 +90,45 @@ struct PixelInputType
     float4 lightSpacePos : TEXCOORD7;
     float3 world_position : TEXCOORD8;
     float3x3 TBN : TEXCOORD9;
+    nointerpolation uint object_id : OBJECT_ID;
+    nointerpolation uint highlight_state : HIGHLIGHT_STATE;
 };
 
+float3 decode_octahedral_normal(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
 
 PixelInputType main(VertexInputType input)
 {
     PixelInputType output;
 
+#ifdef INSTANCED
+    float4x4 world = float4x4(input.instance_world0, input.instance_world1, input.instance_world2, input.instance_world3);
+    output.object_id = input.instance_object_data.x;
+    output.highlight_state = input.instance_object_data.y;
+#else
+    float4x4 world = World;
+    output.object_id = object_id;
+    output.highlight_state = highlight_state;
+#endif
+
+#ifdef COMPACT_VERTEX
+    float3 vertex_normal = decode_octahedral_normal(input.normal_oct.xy) * input.normal_oct.w;
+#else
+    float3 vertex_normal = input.normal;
+#endif
+
     // Transform the vertex position to clip space
-    float4 worldPosition = mul(float4(input.position, 1.0f), World);
+    float4 worldPosition = mul(float4(input.position, 1.0f), world);
     float4 viewPosition = mul(worldPosition, View);
     output.position = mul(viewPosition, Projection);
     output.world_position = worldPosition;
 
-    output.normal = mul(input.normal, (float3x3)World);
+    output.normal = mul(vertex_normal, (float3x3)world);
 
     // Pass the texture coordinates to the pixel shader
     output.tex_coords0 = input.tex_coords0;
@@ -129,9 +169,9 @@ PixelInputType main(VertexInputType input)
     else
     {
 		// Calculate the TBN matrix using direct tangent and bitangent
-        float3 T = normalize(mul(input.tangent, (float3x3) World)); // Transform tangent
-        float3 B = normalize(mul(input.bitangent, (float3x3) World)); // Transform bitangent
-        float3 N = normalize(mul(input.normal, (float3x3) World)); // Transform normal
+        float3 T = normalize(mul(input.tangent, (float3x3) world)); // Transform tangent
+        float3 B = normalize(mul(input.bitangent, (float3x3) world)); // Transform bitangent
+        float3 N = normalize(mul(vertex_normal, (float3x3) world)); // Transform normal
 
 		// Set the TBN matrix
         output.TBN = float3x3(T, B, N);
@@ -4,6 +4,7 @@
 #include <GuiGlobalConstants.h>
 #include <DATManager.h>
 #include "Parsers/BB9AnimationParser.h"
+#include "Parsers/BB9AnimationIndex.h"
 #include <format>
 #include <thread>
 #include <mutex>
@@ -63,13 +64,12 @@ static bool CheckFileForMatchingAnimation(
                 {
                     outResult.chunkType = (chunkId == GW::Parsers::CHUNK_ID_BB9) ? "BB9" : "FA1";
 
-                    // Try to parse for more info
-                    auto clipOpt = GW::Parsers::BB9AnimationParser::Parse(
-                        &data[chunkDataOffset], chunkSize);
-                    if (clipOpt)
+                    // Only the header/skeleton pass is needed for the counts
+                    auto index = GW::Parsers::BB9AnimationIndex::Build(data, dataSize);
+                    if (index)
                     {
-                        outResult.sequenceCount = static_cast<uint32_t>(clipOpt->sequences.size());
-                        outResult.boneCount = static_cast<uint32_t>(clipOpt->boneTracks.size());
+                        outResult.sequenceCount = static_cast<uint32_t>(index->GetSequenceCount());
+                        outResult.boneCount = static_cast<uint32_t>(index->GetBoneCount());
                     }
 
                     return true;
@@ -220,10 +220,10 @@ static void LoadAnimationFromResult(
         const auto& mft = manager->get_MFT();
         size_t fileSize = mft[result.mftIndex].uncompressedSize;
 
-        auto clipOpt = GW::Parsers::ParseAnimationFromFile(fileData, fileSize);
-        if (clipOpt)
+        auto index = GW::Parsers::BB9AnimationIndex::Build(fileData, fileSize);
+        if (index)
         {
-            auto clip = std::make_shared<GW::Animation::AnimationClip>(std::move(*clipOpt));
+            auto clip = index->CreateClip();
             auto skeleton = std::make_shared<GW::Animation::Skeleton>(
                 GW::Parsers::BB9AnimationParser::CreateSkeleton(*clip));
 
@@ -233,7 +233,7 @@ static void LoadAnimationFromResult(
             bool savedHasModel = g_animationState.hasModel;
 
             // Initialize applies persistent playback settings automatically
-            g_animationState.Initialize(clip, skeleton, result.fileId);
+            g_animationState.Initialize(clip, skeleton, result.fileId, index->CreateSequenceLoader());
 
             // Restore model info
             g_animationState.modelHash0 = savedHash0;
@@ -275,10 +275,10 @@ static bool TryLoadAnimationFromSameFile(
                     if (!fileData)
                         continue;
 
-                    auto clipOpt = GW::Parsers::ParseAnimationFromFile(fileData, mft[i].uncompressedSize);
-                    if (clipOpt && !clipOpt->boneTracks.empty())
+                    auto index = GW::Parsers::BB9AnimationIndex::Build(fileData, mft[i].uncompressedSize);
+                    if (index && index->GetBoneCount() > 0)
                     {
-                        auto clip = std::make_shared<GW::Animation::AnimationClip>(std::move(*clipOpt));
+                        auto clip = index->CreateClip();
                         auto skeleton = std::make_shared<GW::Animation::Skeleton>(
                             GW::Parsers::BB9AnimationParser::CreateSkeleton(*clip));
 
@@ -287,7 +287,7 @@ static bool TryLoadAnimationFromSameFile(
                         uint32_t savedHash1 = g_animationState.modelHash1;
                         bool savedHasModel = g_animationState.hasModel;
 
-                        g_animationState.Initialize(clip, skeleton, fileId);
+                        g_animationState.Initialize(clip, skeleton, fileId, index->CreateSequenceLoader());
 
                         // Restore model info
                         g_animationState.modelHash0 = savedHash0;
@@ -435,7 +435,8 @@ struct AnimationPanelState
 
     void Initialize(std::shared_ptr<GW::Animation::AnimationClip> animClip,
                     std::shared_ptr<GW::Animation::Skeleton> skel,
-                    uint32_t fileId)
+                    uint32_t fileId,
+                    GW::Animation::AnimationController::SequenceLoader sequenceLoader = nullptr)
     {
         clip = animClip;
         skeleton = skel;
@@ -448,7 +449,7 @@ struct AnimationPanelState
         if (clip && clip->IsValid())
         {
             controller = std::make_shared<GW::Animation::AnimationController>();
-            controller->Initialize(clip);
+            controller->Initialize(clip, std::move(sequenceLoader));
             hasAnimation = true;
 
             // Apply persistent playback settings to the new controller
@@ -1,14 +1,17 @@
 ﻿#include "pch.h"
 #include "draw_dat_browser.h"
+#include "DatBrowserIndex.h"
 #include "draw_texture_panel.h"
 #include "animation_state.h"
 #include "ModelViewer/ModelViewer.h"
 #include "Parsers/BB9AnimationParser.h"
+#include "Parsers/BB9AnimationIndex.h"
 
 #include <codecvt>
 
 #include "GuiGlobalConstants.h"
 #include "maps_constant_data.h"
+#include "PropInstancing.h"
 #include <numeric>
 #include <set>
 
@@ -40,6 +43,7 @@ extern float volume_level;
 extern std::string selected_text_file_str = "";
 
 inline extern int selected_map_file_index = -1;
+inline extern uint32_t selected_map_file_hash = 0;
 
 inline extern uint32_t selected_item_hash = -1;
 inline extern uint32_t selected_item_murmurhash3 = -1;
@@ -71,22 +75,16 @@ inline std::unordered_map<int, TextureType> model_texture_types;
 std::unique_ptr<Terrain> terrain;
 std::vector<Mesh> prop_meshes;
 
-const ImGuiTableSortSpecs* DatBrowserItem::s_current_sort_specs = nullptr;
-
 DirectX::XMFLOAT4 GetAverageColorOfBottomRow(const DatTexture& dat_texture);
 GWVertex get_shore_vertex_for_2_points(Vertex2 point1, Vertex2 point2, float height = 5);
 GWVertex get_shore_vertex_for_3_points(Vertex2 point1, Vertex2 point2, Vertex2 point3, float height = 5);
 void generate_shore_mesh(const XMFLOAT2& point1, const XMFLOAT2& point2, Terrain* terrain, std::vector<Mesh>& meshes, float height = 5);
 
-void apply_filter(const std::vector<int>& new_filter, std::unordered_set<int>& intersection)
+// The text of a TEXT file as shown in the text panel, up to the first null character.
+std::string get_text_file_contents(const std::vector<uint8_t>& data)
 {
-	if (intersection.empty()) { intersection.insert(new_filter.begin(), new_filter.end()); }
-	else
-	{
-		std::unordered_set<int> new_intersection;
-		for (int id : new_filter) { if (intersection.contains(id)) { new_intersection.insert(id); } }
-		intersection = std::move(new_intersection);
-	}
+	const auto* text = reinterpret_cast<const char*>(data.data());
+	return std::string(text, strnlen(text, data.size()));
 }
 
 bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
@@ -94,7 +92,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 {
 	bool success = false;
 
-	const auto MFT = dat_manager->get_MFT();
+	const auto& MFT = dat_manager->get_MFT();
 	if (index >= MFT.size())
 		return false;
 
@@ -110,9 +108,9 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 		lpfnBassStreamFree(selected_audio_stream_handle);
 	}
 
-	unsigned char* raw_data = dat_manager->read_file(index);
-	selected_raw_data = std::vector<uint8_t>(raw_data, raw_data + entry->uncompressedSize);
-	delete raw_data;
+	// The file is read and decompressed once, the parsers below work on this buffer.
+	selected_raw_data = dat_manager->read_file_data(index);
+	std::span<unsigned char> file_data(selected_raw_data.data(), selected_raw_data.size());
 
 	if (entry->type != FFNA_Type3)
 	{
@@ -124,8 +122,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 	{
 	case TEXT:
 	{
-		std::string text_str(reinterpret_cast<char*>(selected_raw_data.data()));
-		selected_text_file_str = text_str;
+		selected_text_file_str = get_text_file_contents(selected_raw_data);
 		success = true;
 	}
 	break;
@@ -195,7 +192,9 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 		//case ATTXDXTA: Cannot parse this
 	case ATTXDXTL:
 	{
-		selected_dat_texture.dat_texture = dat_manager->parse_ffna_texture_file(index);
+		selected_dat_texture.dat_texture = file_data.size() >= 12
+			? ProcessImageFile(file_data.data(), static_cast<int>(file_data.size()))
+			: DatTexture();
 		selected_dat_texture.file_id = entry->Hash;
 		if (selected_dat_texture.dat_texture.width > 0 && selected_dat_texture.dat_texture.height > 0)
 		{
@@ -213,10 +212,8 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 	case DDS:
 	{
 		selected_dat_texture.file_id = entry->Hash;
-		const std::vector<uint8_t> ddsData = dat_manager->parse_dds_file(index);
-		size_t ddsDataSize = ddsData.size();
 		HRESULT hr = map_renderer->GetTextureManager()->CreateTextureFromDDSInMemory(
-			ddsData.data(), ddsDataSize, &selected_dat_texture.texture_id,
+			selected_raw_data.data(), selected_raw_data.size(), &selected_dat_texture.texture_id,
 			&selected_dat_texture.dat_texture.width, &selected_dat_texture.dat_texture.height,
 			selected_dat_texture.dat_texture.rgba_data, entry->Hash); // Pass the RGBA vector
 		if (FAILED(hr))
@@ -234,16 +231,18 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 		map_renderer->GetTextureManager()->Clear();
 		map_renderer->ClearProps();
 
-		// Check if this is an "other" model format (uses 0xBB* chunks instead of 0xFA*)
-		using_other_model_format = dat_manager->is_other_model_format(index);
-
-		if (using_other_model_format)
-		{
-			selected_ffna_model_file_other = dat_manager->parse_ffna_model_file_other(index);
-		}
-		else
+		// The "other" model format uses 0xBB* chunks instead of 0xFA*, ParseModelFile detects it.
 		{
-			selected_ffna_model_file = dat_manager->parse_ffna_model_file(index);
+			auto model_file = ParseModelFile(file_data);
+			using_other_model_format = IsOtherModelFormat(model_file);
+			if (using_other_model_format)
+			{
+				selected_ffna_model_file_other = std::move(std::get<FFNA_ModelFile_Other>(model_file));
+			}
+			else
+			{
+				selected_ffna_model_file = std::move(std::get<FFNA_ModelFile>(model_file));
+			}
 		}
 
 		// Reset animation state
@@ -325,15 +324,16 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 			// Try to parse animation from the model file (if it has embedded animation)
 			if (!selected_raw_data.empty())
 			{
-				auto clipOpt = GW::Parsers::ParseAnimationFromFile(selected_raw_data.data(), selected_raw_data.size());
-				if (clipOpt)
+				// Only the header/skeleton pass runs here, keyframes are decoded per sequence on playback
+				auto animIndex = GW::Parsers::BB9AnimationIndex::Build(selected_raw_data.data(), selected_raw_data.size());
+				if (animIndex)
 				{
-					auto clip = std::make_shared<GW::Animation::AnimationClip>(std::move(*clipOpt));
+					auto clip = animIndex->CreateClip();
 					// NOTE: Parent indices are computed by POP_COUNT algorithm during parsing.
 					// DO NOT override with FA1 parentInfo - those are raw hierarchyBytes, not pre-computed parents.
 					auto skeleton = std::make_shared<GW::Animation::Skeleton>(
 						GW::Parsers::BB9AnimationParser::CreateSkeleton(*clip));
-					g_animationState.Initialize(clip, skeleton, entry->Hash);
+					g_animationState.Initialize(clip, skeleton, entry->Hash, animIndex->CreateSequenceLoader());
 				}
 			}
 
@@ -1060,11 +1060,12 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 
 
 		selected_map_file_index = index;
+		selected_map_file_hash = static_cast<uint32_t>(entry->Hash);
 
 		object_id_to_prop_index.clear();
 		object_id_to_submodel_index.clear();
 		selected_map_files.clear();
-		selected_ffna_map_file = dat_manager->parse_ffna_map_file(index);
+		selected_ffna_map_file = FFNA_MapFile(0, file_data);
 
 		if (selected_ffna_map_file.terrain_chunk.terrain_heightmap.size() > 0 &&
 			selected_ffna_map_file.terrain_chunk.terrain_heightmap.size() ==
@@ -1490,14 +1491,25 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 			}
 		}
 
-		for (int i = 0; i < selected_ffna_map_file.props_info_chunk.prop_array.props_info.size(); i++)
+		// Props placing the same model are grouped, so each model is decoded and uploaded once and every
+		// further prop of it only adds instances that draw from the first prop's buffers.
+		const auto& props_info = selected_ffna_map_file.props_info_chunk.prop_array.props_info;
+		std::vector<uint32_t> prop_model_keys(props_info.size());
+		for (size_t i = 0; i < props_info.size(); i++)
 		{
-			PropInfo prop_info = selected_ffna_map_file.props_info_chunk.prop_array.props_info[i];
+			prop_model_keys[i] = props_info[i].filename_index;
+		}
+		PropInstanceGroups prop_groups;
+		prop_groups.Build(prop_model_keys);
 
-			if (prop_info.filename_index < selected_map_files.size())
+		for (size_t group = 0; group < prop_groups.GetGroupCount(); group++)
+		{
+			const uint32_t filename_index = prop_groups.GetModelKey(group);
+
+			if (filename_index < selected_map_files.size())
 			{
 				if (auto ffna_model_file_ptr =
-					std::get_if<FFNA_ModelFile>(&selected_map_files[prop_info.filename_index]))
+					std::get_if<FFNA_ModelFile>(&selected_map_files[filename_index]))
 				{
 
 					std::vector<std::vector<int>> per_mesh_tex_ids;
@@ -1626,103 +1638,113 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 							}
 						}
 
-						std::vector<PerObjectCB> per_object_cbs;
-						per_object_cbs.resize(prop_meshes.size());
-						for (int j = 0; j < per_object_cbs.size(); j++)
+						std::vector<int> model_mesh_ids;
+						for (const uint32_t i : prop_groups.GetInstances(group))
 						{
-							XMFLOAT3 translation(prop_info.x, prop_info.y, prop_info.z);
-
-							XMFLOAT3 vec1{ prop_info.f4, -prop_info.f6, prop_info.f5 };
-							XMFLOAT3 vec2{ prop_info.sin_angle, -prop_info.f9, prop_info.cos_angle };
-
-							// Load vectors into XMVECTORs
-							XMVECTOR v2 = XMLoadFloat3(&vec1);
-							XMVECTOR v3 = XMLoadFloat3(&vec2);
-
-							// Compute the third orthogonal vector with cross product
-							// Note: This is for left-handed coordinate systems
-							XMVECTOR v1 = XMVector3Cross(v3, v2);
-
-							// Ensure all vectors are normalized
-							v1 = XMVector3Normalize(v1);
-							v2 = XMVector3Normalize(v2);
-							v3 = XMVector3Normalize(v3);
-
-							// Fill the rotation matrix
-							auto rotation_matrix = XMMATRIX(
-								-v1.m128_f32[0], -v1.m128_f32[1], v1.m128_f32[2], 0.0f,
-								v2.m128_f32[0], v2.m128_f32[1], v2.m128_f32[2], 0.0f,
-								-v3.m128_f32[0], -v3.m128_f32[1], v3.m128_f32[2], 0.0f,
-								0.0f, 0.0f, 0.0f, 1.0f
-							);
-
-							// Create the scaling and translation matrices
-							const auto scale = prop_info.scaling_factor;
-							XMMATRIX scaling_matrix = XMMatrixScaling(scale, scale, scale);
-							XMMATRIX translation_matrix = XMMatrixTranslationFromVector(XMLoadFloat3(&translation));
-
-							// Compute the final transformation matrix
-							XMMATRIX transform_matrix = scaling_matrix * XMMatrixTranspose(rotation_matrix) *
-								translation_matrix;
-
-							// Store the transform matrix into the constant buffer
-							XMStoreFloat4x4(&per_object_cbs[j].world, transform_matrix);
-
-							auto& prop_mesh = prop_meshes[j];
-							if (prop_mesh.uv_coord_indices.size() != prop_mesh.tex_indices.size() ||
-								prop_mesh.uv_coord_indices.size() >= MAX_NUM_TEX_INDICES)
+							PropInfo prop_info = props_info[i];
+
+							std::vector<PerObjectCB> per_object_cbs;
+							per_object_cbs.resize(prop_meshes.size());
+							for (int j = 0; j < per_object_cbs.size(); j++)
 							{
-								ffna_model_file_ptr->textures_parsed_correctly = false;
-								continue;
-							}
+								XMFLOAT3 translation(prop_info.x, prop_info.y, prop_info.z);
+
+								XMFLOAT3 vec1{ prop_info.f4, -prop_info.f6, prop_info.f5 };
+								XMFLOAT3 vec2{ prop_info.sin_angle, -prop_info.f9, prop_info.cos_angle };
+
+								// Load vectors into XMVECTORs
+								XMVECTOR v2 = XMLoadFloat3(&vec1);
+								XMVECTOR v3 = XMLoadFloat3(&vec2);
+
+								// Compute the third orthogonal vector with cross product
+								// Note: This is for left-handed coordinate systems
+								XMVECTOR v1 = XMVector3Cross(v3, v2);
+
+								// Ensure all vectors are normalized
+								v1 = XMVector3Normalize(v1);
+								v2 = XMVector3Normalize(v2);
+								v3 = XMVector3Normalize(v3);
+
+								// Fill the rotation matrix
+								auto rotation_matrix = XMMATRIX(
+									-v1.m128_f32[0], -v1.m128_f32[1], v1.m128_f32[2], 0.0f,
+									v2.m128_f32[0], v2.m128_f32[1], v2.m128_f32[2], 0.0f,
+									-v3.m128_f32[0], -v3.m128_f32[1], v3.m128_f32[2], 0.0f,
+									0.0f, 0.0f, 0.0f, 1.0f
+								);
+
+								// Create the scaling and translation matrices
+								const auto scale = prop_info.scaling_factor;
+								XMMATRIX scaling_matrix = XMMatrixScaling(scale, scale, scale);
+								XMMATRIX translation_matrix = XMMatrixTranslationFromVector(XMLoadFloat3(&translation));
+
+								// Compute the final transformation matrix
+								XMMATRIX transform_matrix = scaling_matrix * XMMatrixTranspose(rotation_matrix) *
+									translation_matrix;
+
+								// Store the transform matrix into the constant buffer
+								XMStoreFloat4x4(&per_object_cbs[j].world, transform_matrix);
+
+								auto& prop_mesh = prop_meshes[j];
+								if (prop_mesh.uv_coord_indices.size() != prop_mesh.tex_indices.size() ||
+									prop_mesh.uv_coord_indices.size() >= MAX_NUM_TEX_INDICES)
+								{
+									ffna_model_file_ptr->textures_parsed_correctly = false;
+									continue;
+								}
 
-							if (ffna_model_file_ptr->textures_parsed_correctly)
-								per_object_cbs[j].num_uv_texture_pairs = prop_mesh.uv_coord_indices.size();
+								if (ffna_model_file_ptr->textures_parsed_correctly)
+									per_object_cbs[j].num_uv_texture_pairs = prop_mesh.uv_coord_indices.size();
 
-							for (int k = 0; k < prop_mesh.uv_coord_indices.size(); k++)
-							{
-								int index0 = k / 4;
-								int index1 = k % 4;
-
-								per_object_cbs[j].uv_indices[index0][index1] =
-									static_cast<uint32_t>(prop_mesh.uv_coord_indices[k]);
-								per_object_cbs[j].texture_indices[index0][index1] =
-									static_cast<uint32_t>(prop_mesh.tex_indices[k]);
-								per_object_cbs[j].blend_flags[index0][index1] =
-									static_cast<uint32_t>(prop_mesh.blend_flags[k]);
-								per_object_cbs[j].texture_types[index0][index1] =
-									static_cast<uint32_t>(model_texture_types[per_mesh_tex_ids[j][k]]) | (prop_mesh.texture_types[k] << 8);
+								for (int k = 0; k < prop_mesh.uv_coord_indices.size(); k++)
+								{
+									int index0 = k / 4;
+									int index1 = k % 4;
+
+									per_object_cbs[j].uv_indices[index0][index1] =
+										static_cast<uint32_t>(prop_mesh.uv_coord_indices[k]);
+									per_object_cbs[j].texture_indices[index0][index1] =
+										static_cast<uint32_t>(prop_mesh.tex_indices[k]);
+									per_object_cbs[j].blend_flags[index0][index1] =
+										static_cast<uint32_t>(prop_mesh.blend_flags[k]);
+									per_object_cbs[j].texture_types[index0][index1] =
+										static_cast<uint32_t>(model_texture_types[per_mesh_tex_ids[j][k]]) | (prop_mesh.texture_types[k] << 8);
+								}
 							}
-						}
 
-						auto pixel_shader_type = PixelShaderType::OldModel;
-						if (ffna_model_file_ptr->geometry_chunk.unknown_tex_stuff1.size() > 0)
-						{
-							pixel_shader_type = PixelShaderType::NewModel;
-						}
+							auto pixel_shader_type = PixelShaderType::OldModel;
+							if (ffna_model_file_ptr->geometry_chunk.unknown_tex_stuff1.size() > 0)
+							{
+								pixel_shader_type = PixelShaderType::NewModel;
+							}
 
-						auto mesh_ids = map_renderer->AddProp(prop_meshes, per_object_cbs, i, pixel_shader_type);
-						if (ffna_model_file_ptr->textures_parsed_correctly)
-						{
-							for (int l = 0; l < mesh_ids.size(); l++)
+							auto mesh_ids = map_renderer->AddProp(prop_meshes, per_object_cbs, i, pixel_shader_type, model_mesh_ids);
+							if (model_mesh_ids.empty())
+							{
+								model_mesh_ids = mesh_ids;
+							}
+							if (ffna_model_file_ptr->textures_parsed_correctly)
 							{
-								int mesh_id = mesh_ids[l];
-								auto& mesh_texture_ids = per_mesh_tex_ids[l];
+								for (int l = 0; l < mesh_ids.size(); l++)
+								{
+									int mesh_id = mesh_ids[l];
+									auto& mesh_texture_ids = per_mesh_tex_ids[l];
 
-								map_renderer->GetMeshManager()->SetTexturesForMesh(
-									mesh_id, map_renderer->GetTextureManager()->GetTextures(mesh_texture_ids),
-									3);
+									map_renderer->GetMeshManager()->SetTexturesForMesh(
+										mesh_id, map_renderer->GetTextureManager()->GetTextures(mesh_texture_ids),
+										3);
+								}
 							}
-						}
 
-						// Add prop index to map for later picking
-						for (int l = 0; l < prop_meshes.size(); l++)
-						{
-							int object_id = per_object_cbs[l].object_id;
-							int prop_index = i;
+							// Add prop index to map for later picking
+							for (int l = 0; l < prop_meshes.size(); l++)
+							{
+								int object_id = per_object_cbs[l].object_id;
+								int prop_index = i;
 
-							object_id_to_prop_index.insert({ object_id, prop_index });
-							object_id_to_submodel_index.emplace(object_id, l);
+								object_id_to_prop_index.insert({ object_id, prop_index });
+								object_id_to_submodel_index.emplace(object_id, l);
+							}
 						}
 					}
 				}
@@ -1919,54 +1941,17 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 
 		map_renderer->SetShore(shore_meshes, shore_textures, shore_per_object_cbs, PixelShaderType::Shore);
 
-		// Create pathfinding meshes from trapezoids
+		// Pathfinding overlay, drawn from the trapezoids through the debug draw buffer
 		if (selected_ffna_map_file.pathfinding_chunk.valid && selected_ffna_map_file.pathfinding_chunk.all_trapezoids.size() > 0) {
-			std::vector<Mesh> pathfinding_meshes;
 			std::vector<uint32_t> plane_sizes;
-			const float pathfinding_height_offset = 50.0f;  // Height above terrain
-
-			// Build plane sizes from planes data
 			for (const auto& plane : selected_ffna_map_file.pathfinding_chunk.planes) {
 				plane_sizes.push_back(plane.traps_count);
 			}
 
-			for (size_t i = 0; i < selected_ffna_map_file.pathfinding_chunk.all_trapezoids.size(); i++) {
-				const auto& trap = selected_ffna_map_file.pathfinding_chunk.all_trapezoids[i];
-
-				// Create quad mesh from trapezoid coordinates
-				// trap.yt = top Y, trap.yb = bottom Y (world Z)
-				// trap.xtl/xtr = top X coords, trap.xbl/xbr = bottom X coords (world X)
-				float height_tl = terrain->get_height_at(trap.xtl, trap.yt) + pathfinding_height_offset;
-				float height_tr = terrain->get_height_at(trap.xtr, trap.yt) + pathfinding_height_offset;
-				float height_bl = terrain->get_height_at(trap.xbl, trap.yb) + pathfinding_height_offset;
-				float height_br = terrain->get_height_at(trap.xbr, trap.yb) + pathfinding_height_offset;
-
-				XMFLOAT3 pos_tl(trap.xtl, height_tl, trap.yt);
-				XMFLOAT3 pos_tr(trap.xtr, height_tr, trap.yt);
-				XMFLOAT3 pos_bl(trap.xbl, height_bl, trap.yb);
-				XMFLOAT3 pos_br(trap.xbr, height_br, trap.yb);
-
-				// Calculate normal (facing up)
-				XMFLOAT3 normal(0.0f, 1.0f, 0.0f);
-
-				// Texture coordinates
-				XMFLOAT2 tex00(0.0f, 0.0f);
-				XMFLOAT2 tex10(1.0f, 0.0f);
-				XMFLOAT2 tex01(0.0f, 1.0f);
-				XMFLOAT2 tex11(1.0f, 1.0f);
-
-				Mesh mesh;
-				mesh.vertices.push_back(GWVertex(pos_tl, normal, tex00));
-				mesh.vertices.push_back(GWVertex(pos_tr, normal, tex10));
-				mesh.vertices.push_back(GWVertex(pos_br, normal, tex11));
-				mesh.vertices.push_back(GWVertex(pos_bl, normal, tex01));
-				mesh.indices = { 0, 1, 2, 0, 2, 3 };
-				mesh.blend_flags = { 8 };  // Alpha blend
-
-				pathfinding_meshes.push_back(mesh);
-			}
-
-			map_renderer->SetPathfinding(pathfinding_meshes, plane_sizes, PixelShaderType::OldModel);
+			map_renderer->SetPathfinding(selected_ffna_map_file.pathfinding_chunk.all_trapezoids, plane_sizes, terrain.get());
+		}
+		else {
+			map_renderer->ClearPathfinding();
 		}
 
 		//for (int i = 0; i < selected_ffna_map_file.big_chunk.vertices0.size(); i++) {
@@ -2030,24 +2015,60 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 
 std::string truncate_text_with_ellipsis(const std::string& text, float maxWidth);
 int custom_stoi(const std::string& input);
-std::string to_lower(const std::string& input);
+bool compare_with_sort_specs(const DatBrowserIndex& index, uint32_t lhs_row, uint32_t rhs_row, const ImGuiTableSortSpecs* sort_specs);
+
+// Sets the names, map ids and pvp flags of an item from the custom file info, or for maps from maps_constant_data.h.
+void apply_file_info(DatBrowserItem& item, const std::unordered_map<int, CustomFileInfoEntry>& custom_file_info_map)
+{
+	item.names.clear();
+	item.map_ids.clear();
+	item.is_pvp.clear();
+
+	auto custom_file_info_it = custom_file_info_map.find(item.hash);
+	if (custom_file_info_it == custom_file_info_map.end()) {
+		// Files with file_id == 0 uses murmurhash3 instead when saved to custom file
+		custom_file_info_it = custom_file_info_map.find(item.murmurhash3);
+	}
+
+	if (item.type == FFNA_Type3)
+	{
+		if (custom_file_info_it != custom_file_info_map.end()) {
+			item.names = custom_file_info_it->second.names;
+			item.map_ids = custom_file_info_it->second.map_ids;
+			item.is_pvp = { custom_file_info_it->second.is_pvp };
+		}
+		else {
+			auto it = constant_maps_info.find(item.hash);
+			if (it != constant_maps_info.end())
+			{
+				for (const auto& map : it->second)
+				{
+					item.map_ids.push_back(map.map_id);
+					item.names.push_back(map.map_name);
+					item.is_pvp.push_back(map.is_pvp);
+				}
+			}
+		}
+	}
+	else {
+		if (custom_file_info_it != custom_file_info_map.end()) {
+			item.names = custom_file_info_it->second.names;
+		}
+	}
+}
 
 void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const bool dat_manager_changed, const std::unordered_set<uint32_t>& dat_compare_filter_result, const bool dat_compare_filter_result_changed,
 	std::vector<std::vector<std::string>>& csv_data, bool custom_file_info_changed)
 {
-	static std::vector<DatBrowserItem> items;
-	static std::vector<DatBrowserItem> filtered_items;
+	static DatBrowserIndex dat_browser_index;
+	// Rows of dat_browser_index shown in the table, in display order.
+	static std::vector<uint32_t> filtered_rows;
 
-	static std::unordered_map<int, std::vector<int>> id_index;
+	// MFT indices by file hash, used by parse_file and the exporters to find referenced files.
 	static std::unordered_map<int, std::vector<int>> hash_index;
-	static std::unordered_map<int, std::vector<int>> file_id_0_index;
-	static std::unordered_map<int, std::vector<int>> file_id_1_index;
-	static std::unordered_map<FileType, std::vector<int>> type_index;
 
-	static std::unordered_map<int, std::vector<int>> map_id_index;
-	static std::unordered_map<std::string, std::vector<int>> name_index;
-	static std::unordered_map<bool, std::vector<int>> pvp_index;
-	static std::unordered_map<int, std::vector<int>> murmurhash3_index;
+	// Text files are read into the name search a few per frame, this is the next row to look at.
+	static uint32_t next_text_index_row = 0;
 
 	static std::unordered_map<int, CustomFileInfoEntry> custom_file_info_map;
 
@@ -2082,17 +2103,24 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 		}
 	}
 
-	if (dat_manager_changed || custom_file_info_changed) {
-		items.clear();
-		filtered_items.clear();
-		id_index.clear();
+	if (dat_manager_changed) {
+		dat_browser_index.Clear();
+		filtered_rows.clear();
 		hash_index.clear();
-		file_id_0_index.clear();
-		file_id_1_index.clear();
-		type_index.clear();
-		map_id_index.clear();
-		name_index.clear();
-		pvp_index.clear();
+		next_text_index_row = 0;
+	}
+	else if (custom_file_info_changed && dat_browser_index.Size() > 0) {
+		// Only the rows the custom file info applies to change.
+		std::vector<DatBrowserItem> updated_items;
+		for (uint32_t row = 0; row < dat_browser_index.Size(); row++) {
+			if (custom_file_info_map.contains(dat_browser_index.GetHash(row)) ||
+				custom_file_info_map.contains(dat_browser_index.GetMurmurhash3(row))) {
+				auto item = dat_browser_index.GetItem(row);
+				apply_file_info(item, custom_file_info_map);
+				updated_items.push_back(std::move(item));
+			}
+		}
+		dat_browser_index.UpdateRows(updated_items);
 	}
 
 	if (!GuiGlobalConstants::is_dat_browser_resizeable)
@@ -2116,7 +2144,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 	if (GuiGlobalConstants::is_dat_browser_open) {
 		if (ImGui::Begin("Browse .dat file contents", &GuiGlobalConstants::is_dat_browser_open, ImGuiWindowFlags_NoFocusOnAppearing)) {
 			// Create item list
-			if (items.size() == 0)
+			if (dat_browser_index.Size() == 0)
 			{
 				const auto& entries = dat_manager->get_MFT();
 				for (int i = 0; i < entries.size(); i++)
@@ -2131,63 +2159,13 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 					DatBrowserItem new_item{
 						i, entry.Hash, static_cast<FileType>(entry.type), entry.Size, entry.uncompressedSize, filename_id_0, filename_id_1, {}, {}, {}, entry.murmurhash3
 					};
-					auto custom_file_info_it = custom_file_info_map.find(entry.Hash);
-					if (custom_file_info_it == custom_file_info_map.end()) {
-						// Files with file_id == 0 uses murmurhash3 instead when saved to custom file
-						custom_file_info_it = custom_file_info_map.find(entry.murmurhash3);
-					}
+					apply_file_info(new_item, custom_file_info_map);
 
-					if (entry.type == FFNA_Type3)
-					{
-						if (custom_file_info_it != custom_file_info_map.end()) {
-							new_item.names = custom_file_info_it->second.names;
-							new_item.map_ids = custom_file_info_it->second.map_ids;
-							new_item.is_pvp = { custom_file_info_it->second.is_pvp };
-						}
-						else {
-							auto it = constant_maps_info.find(entry.Hash);
-							if (it != constant_maps_info.end())
-							{
-								for (const auto& map : it->second)
-								{
-									new_item.map_ids.push_back(map.map_id);
-									new_item.names.push_back(map.map_name);
-									new_item.is_pvp.push_back(map.is_pvp);
-								}
-							}
-						}
-					}
-					else {
-						if (custom_file_info_it != custom_file_info_map.end()) {
-							new_item.names = custom_file_info_it->second.names;
-						}
-					}
-
-					items.push_back(new_item);
-				}
-				filtered_items = items;
-			}
-
-			if (items.size() != 0 && id_index.empty())
-			{
-				for (int i = 0; i < items.size(); i++)
-				{
-					const auto& item = items[i];
-					id_index[item.id].push_back(i);
-					hash_index[item.hash].push_back(i);
-					type_index[item.type].push_back(i);
-					file_id_0_index[item.file_id_0].push_back(i);
-					file_id_1_index[item.file_id_1].push_back(i);
-					murmurhash3_index[item.murmurhash3].push_back(i);
-
-					for (const auto map_id : item.map_ids) { map_id_index[map_id].push_back(i); }
-					for (const auto& name : item.names)
-					{
-						if (name != "" && name != "-")
-							name_index[name].push_back(i);
-					}
-					for (const auto is_pvp : item.is_pvp) { pvp_index[is_pvp].push_back(i); }
+					dat_browser_index.Add(new_item);
+					hash_index[new_item.hash].push_back(i);
 				}
+				dat_browser_index.Finalize();
+				dat_browser_index.Filter(DatBrowserFilter(), filtered_rows);
 			}
 
 			// Set after filtering is complete.
@@ -2216,6 +2194,23 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 				filter_update_required = true;
 			}
 
+			const auto text_indexing_start = std::chrono::steady_clock::now();
+			bool text_index_updated = false;
+			while (next_text_index_row < dat_browser_index.Size() &&
+				std::chrono::steady_clock::now() - text_indexing_start < std::chrono::milliseconds(4))
+			{
+				const uint32_t row = next_text_index_row++;
+				if (dat_browser_index.GetType(row) == TEXT)
+				{
+					dat_browser_index.AddText(row, get_text_file_contents(dat_manager->read_file_data(row)));
+					text_index_updated = true;
+				}
+			}
+
+			if (text_index_updated && !name_filter_text.empty()) {
+				filter_update_required = true;
+			}
+
 			if (curr_id_filter != id_filter_text)
 			{
 				curr_id_filter = id_filter_text;
@@ -2275,165 +2270,27 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 
 				filter_update_required = false;
 
-				filtered_items.clear();
+				DatBrowserFilter filter;
+				if (!id_filter_text.empty()) { filter.id = custom_stoi(id_filter_text); }
+				if (!hash_filter_text.empty()) { filter.hash = custom_stoi(hash_filter_text); }
+				if (!filename_filter_text.empty()) { filter.filename = custom_stoi(filename_filter_text); }
+				if (!map_id_filter_text.empty()) { filter.map_id = custom_stoi(map_id_filter_text); }
+				if (!murmurhash3_filter_text.empty()) { filter.murmurhash3 = custom_stoi(murmurhash3_filter_text); }
+				filter.type = type_filter_value;
+				filter.pvp = pvp_filter_value;
+				filter.name = name_filter_text;
 
-				std::unordered_set<int> intersection;
+				dat_browser_index.Filter(filter, filtered_rows);
 
-				if (!id_filter_text.empty())
+				if (!dat_compare_filter_result.empty())
 				{
-					int id_filter_value = custom_stoi(id_filter_text);
-					if (id_index.contains(id_filter_value))
-					{
-						intersection.insert(id_index[id_filter_value].begin(), id_index[id_filter_value].end());
-					}
-				}
-
-				if (!hash_filter_text.empty())
-				{
-					int hash_filter_value = custom_stoi(hash_filter_text);
-					if (hash_index.contains(hash_filter_value))
-					{
-						if (id_filter_text.empty())
+					std::erase_if(filtered_rows, [&](uint32_t row)
 						{
-							intersection.insert(hash_index[hash_filter_value].begin(),
-								hash_index[hash_filter_value].end());
-						}
-						else
-						{
-							std::unordered_set<int> new_intersection;
-							for (int id : hash_index[hash_filter_value])
-							{
-								if (intersection.contains(id)) { new_intersection.insert(id); }
-							}
-							intersection = std::move(new_intersection);
-						}
-					}
-				}
-
-				if (!filename_filter_text.empty())
-				{
-					int filename_filter_value = custom_stoi(filename_filter_text);
-					uint16_t id0 = filename_filter_value & 0xFFFF;
-					uint16_t id1 = (filename_filter_value >> 16) & 0xFFFF;
-
-					bool is_full_filename_hash = id0 > 0xFF && id1 > 0xFF;
-
-					if (!is_full_filename_hash) {
-						if (file_id_0_index.contains(id0))
-						{
-							apply_filter(file_id_0_index[id0], intersection);
-						}
-
-						if (file_id_1_index.contains(id1))
-						{
-							apply_filter(file_id_1_index[id1], intersection);
-						}
-					}
-					else {
-						if (file_id_0_index.contains(id0) && file_id_1_index.contains(id1))
-						{
-							apply_filter(file_id_0_index[id0], intersection);
-							apply_filter(file_id_1_index[id1], intersection);
-						}
-						else if (file_id_0_index.contains(id1) && file_id_1_index.contains(id0)) {
-							apply_filter(file_id_0_index[id1], intersection);
-							apply_filter(file_id_1_index[id0], intersection);
-						}
-					}
-				}
-
-				if (type_filter_value != NONE)
-				{
-					if (id_filter_text.empty() && hash_filter_text.empty())
-					{
-						intersection.insert(type_index[type_filter_value].begin(),
-							type_index[type_filter_value].end());
-					}
-					else
-					{
-						std::unordered_set<int> new_intersection;
-						for (int id : type_index[type_filter_value])
-						{
-							if (intersection.contains(id)) { new_intersection.insert(id); }
-						}
-						intersection = std::move(new_intersection);
-					}
-				}
-
-				if (!map_id_filter_text.empty())
-				{
-					int map_id_filter_value = custom_stoi(map_id_filter_text);
-					if (map_id_index.contains(map_id_filter_value))
-					{
-						apply_filter(map_id_index[map_id_filter_value], intersection);
-					}
-				}
-
-				if (!name_filter_text.empty())
-				{
-					std::vector<int> matching_indices;
-					std::string name_filter_text_lower = to_lower(name_filter_text);
-
-					for (const auto& name_entry : name_index)
-					{
-						std::string name_entry_lower = to_lower(name_entry.first);
-						if (name_entry_lower.find(name_filter_text_lower) != std::string::npos)
-						{
-							matching_indices.insert(matching_indices.end(), name_entry.second.begin(),
-								name_entry.second.end());
-						}
-					}
-					if (!matching_indices.empty()) { apply_filter(matching_indices, intersection); }
-				}
-
-				if (pvp_filter_value != -1)
-				{
-					bool pvp_filter_bool = pvp_filter_value == 1;
-					apply_filter(pvp_index[pvp_filter_bool], intersection);
-				}
-
-				if (!murmurhash3_filter_text.empty())
-				{
-					int murmurhash3_filter_value = custom_stoi(murmurhash3_filter_text);
-					if (murmurhash3_index.contains(murmurhash3_filter_value))
-					{
-						if (intersection.empty())
-						{
-							intersection.insert(murmurhash3_index[murmurhash3_filter_value].begin(),
-								murmurhash3_index[murmurhash3_filter_value].end());
-						}
-						else
-						{
-							std::unordered_set<int> new_intersection;
-							for (int id : murmurhash3_index[murmurhash3_filter_value])
-							{
-								if (intersection.contains(id)) { new_intersection.insert(id); }
-							}
-							intersection = std::move(new_intersection);
-						}
-					}
+							return !dat_compare_filter_result.contains(dat_browser_index.GetMurmurhash3(row));
+						});
 				}
 
-				if (id_filter_text.empty() && hash_filter_text.empty() && type_filter_value == NONE &&
-					map_id_filter_text.empty() && name_filter_text.empty() && pvp_filter_value == -1 && filename_filter_text.empty() &&
-					murmurhash3_filter_text.empty()) {
-					for (const auto& item : items) {
-						if (dat_compare_filter_result.contains(item.murmurhash3) || dat_compare_filter_result.empty())
-						{
-							filtered_items.push_back(item);
-						}
-					}
-				}
-
-				else {
-					for (const auto& id : intersection)
-					{
-						const auto& item = items[id];
-						if (dat_compare_filter_result.contains(item.murmurhash3) || dat_compare_filter_result.empty()) {
-							filtered_items.push_back(item);
-						}
-					}
-				}
+				if (!name_filter_text.empty()) { dat_browser_index.SortByRelevance(name_filter_text, filtered_rows); }
 
 				// Set them equal so that the filter won't run again until the filter changes.
 				curr_id_filter = id_filter_text;
@@ -2467,6 +2324,9 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 			ImGui::Text("Name:");
 			ImGui::SameLine();
 			ImGui::InputText("##NameFilter", &name_filter_text);
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Searches names and the contents of text files, best matches first.\nStart with ^ to only match the beginning of a name.");
+			}
 			ImGui::NextColumn();
 
 			ImGui::Text("Map ID:");
@@ -2486,9 +2346,13 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 
 			ImGui::Separator();
 
-			ImGui::Text("Filtered items: %d", filtered_items.size());
+			ImGui::Text("Filtered items: %d", filtered_rows.size());
 			ImGui::SameLine();
-			ImGui::Text("Total items: %d", items.size());
+			ImGui::Text("Total items: %d", dat_browser_index.Size());
+			if (next_text_index_row < dat_browser_index.Size()) {
+				ImGui::SameLine();
+				ImGui::Text("Indexing text files: %d%%", static_cast<int>(100 * next_text_index_row / dat_browser_index.Size()));
+			}
 
 			// Options
 			static ImGuiTableFlags flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable |
@@ -2522,24 +2386,23 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 				// Sort our data if sort specs have been changed!
 				ImGuiTableSortSpecs* sorts_specs = ImGui::TableGetSortSpecs();
 				if (sorts_specs)
-					if (dat_manager_changed || custom_file_info_changed || filter_updated) {
+					// Name filter results stay ordered by relevance until a column header is clicked.
+					if (dat_manager_changed || custom_file_info_changed || (filter_updated && name_filter_text.empty())) {
 						sorts_specs->SpecsDirty = true;
 					}
 
 				if (sorts_specs->SpecsDirty)
 				{
-					DatBrowserItem::s_current_sort_specs =
-						sorts_specs; // Store in variable accessible by the sort function.
-					if (filtered_items.size() > 1)
-						qsort(&filtered_items[0], filtered_items.size(), sizeof(filtered_items[0]),
-							DatBrowserItem::CompareWithSortSpecs);
-					DatBrowserItem::s_current_sort_specs = nullptr;
+					std::sort(filtered_rows.begin(), filtered_rows.end(), [sorts_specs](uint32_t lhs, uint32_t rhs)
+						{
+							return compare_with_sort_specs(dat_browser_index, lhs, rhs, sorts_specs);
+						});
 					sorts_specs->SpecsDirty = false;
 				}
 
 				// Demonstrate using clipper for large vertical lists
 				ImGuiListClipper clipper;
-				clipper.Begin(filtered_items.size());
+				clipper.Begin(filtered_rows.size());
 
 				static int selected_item_id = -1;
 				ImGuiSelectableFlags selectable_flags =
@@ -2548,7 +2411,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 				while (clipper.Step())
 					for (int row_n = clipper.DisplayStart; row_n < clipper.DisplayEnd; row_n++)
 					{
-						DatBrowserItem& item = filtered_items[row_n];
+						DatBrowserItem item = dat_browser_index.GetItem(filtered_rows[row_n]);
 
 						const bool item_is_selected = selected_item_id == item.id;
 
@@ -2605,16 +2468,16 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 						if (dat_manager_changed || custom_file_info_changed) {
 							// Find the index of the item with item.hash == selected_item_hash or item.murmurhash3 == selected_item_hash
 							int item_index = -1;
-							for (int i = 0; i < filtered_items.size(); ++i) {
-								if (filtered_items[i].hash == selected_item_hash) {
+							for (int i = 0; i < filtered_rows.size(); ++i) {
+								if (dat_browser_index.GetHash(filtered_rows[i]) == selected_item_hash) {
 									item_index = i;
 									break;
 								}
 							}
 
 							if (item_index == -1) {
-								for (int i = 0; i < filtered_items.size(); ++i) {
-									if (filtered_items[i].murmurhash3 == selected_item_hash) { // note multiple files can share the same murmurhash3
+								for (int i = 0; i < filtered_rows.size(); ++i) {
+									if (dat_browser_index.GetMurmurhash3(filtered_rows[i]) == selected_item_hash) { // note multiple files can share the same murmurhash3
 										item_index = i;
 										break;
 									}
@@ -2670,7 +2533,16 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 
 
 										// Export the model to the chosen path
-										model_exporter::export_model(saveDir, filename, item.id, dat_manager, hash_index, map_renderer->GetTextureManager());
+										model_exporter::export_model(saveDir, filename, item.id, dat_manager, hash_index);
+									}
+								}
+								if (ImGui::MenuItem("Export model as binary (.gwmb)"))
+								{
+									std::wstring saveDir = OpenDirectoryDialog();
+									if (!saveDir.empty())
+									{
+										std::wstring filename = std::format(L"model_0x{:X}.gwmb", item.hash);
+										model_exporter::export_model_binary(saveDir, filename, item.id, dat_manager, hash_index);
 									}
 								}
 								if (ImGui::MenuItem("Export Mesh"))
@@ -2806,7 +2678,21 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 											create_directory(newDirPath);
 										}
 
-										map_exporter::export_map(newDirPath, item.hash, item.id, dat_manager, hash_index, map_renderer->GetTextureManager());
+										map_exporter::export_map(newDirPath, item.hash, item.id, dat_manager, hash_index);
+									}
+								}
+								else if (ImGui::MenuItem("Export full map as binary (.gwmb)"))
+								{
+									std::wstring savePath = OpenDirectoryDialog();
+									if (!savePath.empty())
+									{
+										std::filesystem::path newDirPath = std::filesystem::path(savePath) / (L"gwmb_map_" + std::to_wstring(item.hash));
+										if (!exists(newDirPath))
+										{
+											create_directory(newDirPath);
+										}
+
+										map_exporter::export_map_binary(newDirPath, item.hash, item.id, dat_manager, hash_index);
 									}
 								}
 								else if (ImGui::MenuItem("Export Terrain Mesh as .obj"))
@@ -3184,80 +3070,67 @@ void ExportDDS(DATManager* dat_manager, int mft_file_index, int file_id, MapRend
 	}
 }
 
-inline int IMGUI_CDECL DatBrowserItem::CompareWithSortSpecs(const void* lhs, const void* rhs)
+// Strict weak ordering of two rows by the table's sort columns, ties are ordered by id.
+bool compare_with_sort_specs(const DatBrowserIndex& index, uint32_t lhs_row, uint32_t rhs_row, const ImGuiTableSortSpecs* sort_specs)
 {
-	auto a = static_cast<const DatBrowserItem*>(lhs);
-	auto b = static_cast<const DatBrowserItem*>(rhs);
-	for (int n = 0; n < s_current_sort_specs->SpecsCount; n++)
+	for (int n = 0; n < sort_specs->SpecsCount; n++)
 	{
-		const ImGuiTableColumnSortSpecs* sort_spec = &s_current_sort_specs->Specs[n];
-		int delta = 0;
+		const ImGuiTableColumnSortSpecs* sort_spec = &sort_specs->Specs[n];
+		std::strong_ordering order = std::strong_ordering::equal;
 		switch (sort_spec->ColumnUserID)
 		{
 		case DatBrowserItemColumnID_id:
-			delta = (a->id - b->id);
+			order = index.GetId(lhs_row) <=> index.GetId(rhs_row);
 			break;
 		case DatBrowserItemColumnID_hash:
-			delta = (a->hash - b->hash);
+			order = index.GetHash(lhs_row) <=> index.GetHash(rhs_row);
 			break;
 		case DatBrowserItemColumnID_murmurhash3:
-			delta = (a->murmurhash3 - b->murmurhash3);
+			order = index.GetMurmurhash3(lhs_row) <=> index.GetMurmurhash3(rhs_row);
 			break;
 		case DatBrowserItemColumnID_type:
-			delta = (a->type - b->type);
+			order = index.GetType(lhs_row) <=> index.GetType(rhs_row);
 			break;
 		case DatBrowserItemColumnID_size:
-			delta = (a->size - b->size);
+			order = index.GetSize(lhs_row) <=> index.GetSize(rhs_row);
 			break;
 		case DatBrowserItemColumnID_decompressed_size:
-			delta = (a->decompressed_size - b->decompressed_size);
+			order = index.GetDecompressedSize(lhs_row) <=> index.GetDecompressedSize(rhs_row);
 			break;
 		case DatBrowserItemColumnID_filename:
-			delta = (a->file_id_0 + (a->file_id_1 << 16)) - (b->file_id_0 + (b->file_id_1 << 16));
+			order = (index.GetFileId0(lhs_row) + (index.GetFileId1(lhs_row) << 16)) <=> (index.GetFileId0(rhs_row) + (index.GetFileId1(rhs_row) << 16));
 			break;
-		case DatBrowserItemColumnID_map_id: // Modified map_id case
-			for (size_t i = 0; i < std::min(a->map_ids.size(), b->map_ids.size()); ++i)
-			{
-				delta = (a->map_ids[i] - b->map_ids[i]);
-				if (delta != 0)
-					break;
-			}
-			if (delta == 0)
-				delta = (a->map_ids.size() - b->map_ids.size());
+		case DatBrowserItemColumnID_map_id:
+		{
+			const auto a = index.GetMapIds(lhs_row);
+			const auto b = index.GetMapIds(rhs_row);
+			order = std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
 			break;
-
-		case DatBrowserItemColumnID_name: // Modified name case
-			for (size_t i = 0; i < std::min(a->names.size(), b->names.size()); ++i)
-			{
-				delta = a->names[i].compare(b->names[i]);
-				if (delta != 0)
-					break;
-			}
-			if (delta == 0)
-				delta = (a->names.size() - b->names.size());
+		}
+		case DatBrowserItemColumnID_name:
+		{
+			const auto a = index.GetNameIds(lhs_row);
+			const auto b = index.GetNameIds(rhs_row);
+			order = std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end(),
+				[&index](uint32_t lhs_name, uint32_t rhs_name) { return index.GetName(lhs_name) <=> index.GetName(rhs_name); });
 			break;
-
-		case DatBrowserItemColumnID_is_pvp: // Modified is_pvp case
-			for (size_t i = 0; i < std::min(a->is_pvp.size(), b->is_pvp.size()); ++i)
-			{
-				delta = (a->is_pvp[i] - b->is_pvp[i]);
-				if (delta != 0)
-					break;
-			}
-			if (delta == 0)
-				delta = (a->is_pvp.size() - b->is_pvp.size());
+		}
+		case DatBrowserItemColumnID_is_pvp:
+		{
+			const auto a = index.GetIsPvp(lhs_row);
+			const auto b = index.GetIsPvp(rhs_row);
+			order = std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
 			break;
+		}
 		default:
 			IM_ASSERT(0);
 			break;
 		}
-		if (delta > 0)
-			return (sort_spec->SortDirection == ImGuiSortDirection_Ascending) ? +1 : -1;
-		if (delta < 0)
-			return (sort_spec->SortDirection == ImGuiSortDirection_Ascending) ? -1 : +1;
+		if (order != 0)
+			return (sort_spec->SortDirection == ImGuiSortDirection_Ascending) ? order < 0 : order > 0;
 	}
 
-	return (a->id - b->id);
+	return index.GetId(lhs_row) < index.GetId(rhs_row);
 }
 
 std::string truncate_text_with_ellipsis(const std::string& text, float maxWidth)
@@ -3333,14 +3206,6 @@ int custom_stoi(const std::string& input)
 	return negative ? -value : value;
 }
 
-std::string to_lower(const std::string& input)
-{
-	std::string result = input;
-	std::transform(result.begin(), result.end(), result.begin(),
-		[](unsigned char c) { return std::tolower(c); });
-	return result;
-}
-
 DirectX::XMFLOAT4 GetAverageColorOfBottomRow(const DatTexture& dat_texture) {
 	int total_pixels = dat_texture.width;
 
@@ -41,10 +41,6 @@ struct DatBrowserItem
 	std::vector<int> is_pvp;
 
 	uint32_t murmurhash3;
-
-	static const ImGuiTableSortSpecs* s_current_sort_specs;
-
-	static int IMGUI_CDECL CompareWithSortSpecs(const void* lhs, const void* rhs);
 };
 
 struct CustomFileInfoEntry
@@ -3,7 +3,7 @@
 #include "GuiGlobalConstants.h"
 #include "GWUnpacker.h"
 #include "FFNA_ModelFile_Other.h"
-#include "DirectXTex/DirectXTex.h"
+#include "TextureExport.h"
 #include <thread>
 #include <atomic>
 
@@ -65,8 +65,58 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 				}
 			}
 
+			if (ImGui::CollapsingHeader("Export all maps to gwmb", ImGuiTreeNodeFlags_DefaultOpen)) {
+				static bool export_maps_binary = true;
+				static int memory_budget_mb = static_cast<int>(MapExportJob::default_memory_budget_bytes >> 20);
+
+				auto& map_export_job = extract_panel_info.map_export_job;
+				if (map_export_job.IsActive() && map_export_job.IsDone()) {
+					map_export_job.Stop(); // Joins the finished workers, the counters stay readable
+				}
+
+				if (map_export_job.IsActive()) {
+					const int total = map_export_job.GetTotalCount();
+					const int completed = map_export_job.GetCompletedCount();
+					ImGui::ProgressBar(total > 0 ? static_cast<float>(completed) / total : 0.0f, ImVec2(-1, 0),
+						std::format("{} / {} maps", completed, total).c_str());
+					ImGui::Text("Maps in flight: %.0f MB (estimated), texture cache: %.0f MB",
+						map_export_job.GetMemoryInUse() / (1024.0 * 1024.0), map_export_job.GetTextureCacheBytes() / (1024.0 * 1024.0));
+					if (ImGui::Button("Stop map export")) {
+						map_export_job.Stop();
+					}
+				}
+				else {
+					ImGui::Checkbox("Binary (.gwmb)", &export_maps_binary);
+					ImGui::InputInt("Memory budget (MB)", &memory_budget_mb, 256, 1024);
+					memory_budget_mb = std::max(memory_budget_mb, 256);
+
+					ImGui::BeginDisabled(dat_manager->m_initialization_state != InitializationState::Completed);
+					if (ImGui::Button("Export all maps")) {
+						std::wstring saveDir = OpenDirectoryDialog();
+						if (!saveDir.empty()) {
+							map_export_job.Start(dat_manager, saveDir, export_maps_binary, static_cast<uint64_t>(memory_budget_mb) << 20);
+						}
+					}
+					ImGui::EndDisabled();
+					if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+						ImGui::SetTooltip("Exports every map into its own gwmb_map_<hash> folder, ready for the Blender add-on.\n"
+							"Models and textures shared by several maps are written once and hard linked into the other folders.\n"
+							"Also available without the UI: GuildWarsMapBrowser.exe --export-all-maps <Gw.dat> <folder> [--json]");
+					}
+				}
+
+				if (map_export_job.GetTotalCount() > 0) {
+					ImGui::Text("Exported: %d, failed: %d, %.1f s", map_export_job.GetExportedCount(), map_export_job.GetFailedCount(),
+						map_export_job.GetElapsedSeconds());
+					const std::wstring last_error = map_export_job.GetLastError();
+					if (!last_error.empty()) {
+						ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Last error: %s (see map_export_errors.txt)",
+							std::filesystem::path(last_error).string().c_str());
+					}
+				}
+			}
+
 			if (ImGui::CollapsingHeader("Extract decompressed files", ImGuiTreeNodeFlags_DefaultOpen)) {
-				const auto& mft = dat_manager->get_MFT();
 				static std::map<int, bool> fileTypeSelections;
 				static bool initialized = false;
 				static int num_files_to_extract = 0;
@@ -74,6 +124,8 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 				static bool useMP3Extension = false;
 				static bool useTxtExtension = false;
 				static bool useDdsExtension = false;
+				static bool hardLinkDuplicates = true;
+				static bool writeTarArchive = false;
 
 				if (!initialized) {
 					for (FileType type : GetAllFileTypes()) {
@@ -110,46 +162,153 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 				ImGui::Checkbox("Use .mp3 extension for AMP and SOUND files", &useMP3Extension);
 				ImGui::Checkbox("Use .txt extension for Text files", &useTxtExtension);
 				ImGui::Checkbox("Use .dds extension for DDS files", &useDdsExtension);
+				ImGui::Checkbox("Hard link files with identical content", &hardLinkDuplicates);
+				if (ImGui::IsItemHovered()) {
+					ImGui::SetTooltip("Each distinct file content is written once. Copies become hard links to it, or are only listed in the manifest when this is off.");
+				}
+				ImGui::Checkbox("Write a single .tar archive instead of loose files", &writeTarArchive);
 
 				ImGui::Text(num_files_to_extract_ui_str.c_str());
 
-				if (ImGui::Button("Extract selected file types")) {
-					std::wstring saveDir = OpenDirectoryDialog();
-					if (!saveDir.empty()) {
-						const auto num_threads = std::thread::hardware_concurrency();
-						std::vector<std::jthread> threads(num_threads);
-
-						for (std::size_t t = 0; t < num_threads; ++t) {
-							threads[t] = std::jthread([&, t]() {
-								for (std::size_t i = t; i < mft.size(); i += num_threads) {
-									const auto& entry = mft[i];
-									if (fileTypeSelections[entry.type]) {
-										std::wstring subfolder = L"";
-										if (saveToSubfolders) {
-											subfolder = typeToWString(entry.type);
-											std::filesystem::create_directories(std::filesystem::path(saveDir) / subfolder);
-										}
+				auto& extraction_job = extract_panel_info.extraction_job;
+				const auto make_extraction_options = [&](const std::filesystem::path& save_directory) {
+					ExtractionOptions options;
+					options.save_directory = save_directory;
+					for (const auto& [type, selected] : fileTypeSelections) {
+						if (selected) options.file_types.insert(type);
+					}
+					options.save_to_subfolders = saveToSubfolders;
+					options.use_mp3_extension = useMP3Extension;
+					options.use_txt_extension = useTxtExtension;
+					options.use_dds_extension = useDdsExtension;
+					options.hard_link_duplicates = hardLinkDuplicates;
+					options.write_tar_archive = writeTarArchive;
+					return options;
+				};
+
+				if (extraction_job.IsActive() && extraction_job.GetPhase() == ExtractionJob::Phase::Done) {
+					extraction_job.Stop(); // Joins the finished job, its counters stay readable
+				}
 
-										std::wstring extension = L".gwraw";
-										if (useMP3Extension && (entry.type == AMP || entry.type == SOUND)) {
-											extension = L".mp3";
-										}
-										else if (useTxtExtension && (entry.type == TEXT)) {
-											extension = L".txt";
-										}
-										else if (useDdsExtension && (entry.type == DDS)) {
-											extension = L".dds";
-										}
+				if (extraction_job.IsActive()) {
+					if (extraction_job.GetPhase() == ExtractionJob::Phase::Planning) {
+						ImGui::Text("Reading manifest and planning extraction...");
+					}
+					else {
+						const int total = extraction_job.GetTotalCount();
+						const int completed = extraction_job.GetCompletedCount();
+						ImGui::ProgressBar(total > 0 ? static_cast<float>(completed) / total : 0.0f, ImVec2(-1, 0),
+							std::format("{} / {}", completed, total).c_str());
+					}
+					if (ImGui::Button("Stop extraction")) {
+						extraction_job.Stop();
+					}
+				}
+				else if (dat_manager->m_initialization_state != InitializationState::Completed) {
+					ImGui::BeginDisabled();
+					ImGui::Button("Extract selected file types");
+					ImGui::EndDisabled();
+					ImGui::SameLine();
+					ImGui::Text("Waiting for all files to be read...");
+				}
+				else {
+					if (ImGui::Button("Extract selected file types")) {
+						std::wstring saveDir = OpenDirectoryDialog();
+						if (!saveDir.empty()) {
+							extraction_job.Start(dat_manager, make_extraction_options(saveDir));
+						}
+					}
+					if (ImGui::IsItemHovered()) {
+						ImGui::SetTooltip("Extracting into a folder with an extraction_manifest.tsv only writes files that are new or changed since the last run.");
+					}
+				}
 
-										const auto filename = std::format(L"{}_{}_{}_{}{}", i, entry.Hash, entry.murmurhash3, typeToWString(entry.type), extension);
-										if (!std::filesystem::exists(std::filesystem::path(saveDir) / subfolder / filename)) {
-											dat_manager->save_raw_decompressed_data_to_file(i, std::filesystem::path(saveDir) / subfolder / filename);
-										}
-									}
-								}
-								});
+				if (extraction_job.GetTotalCount() > 0 && extraction_job.GetPhase() != ExtractionJob::Phase::Planning) {
+					ImGui::Text("Written: %d (%.1f MB), deduplicated: %d (%.1f MB), already extracted: %d, failed: %d",
+						extraction_job.GetWrittenCount(), extraction_job.GetBytesWritten() / (1024.0 * 1024.0),
+						extraction_job.GetDeduplicatedCount(), extraction_job.GetBytesDeduplicated() / (1024.0 * 1024.0),
+						extraction_job.GetSkippedCount(), extraction_job.GetFailedCount());
+					ImGui::Text("%.1f MB/s, %.0f files/s, %.1f s", extraction_job.GetBytesPerSecond() / (1024.0 * 1024.0),
+						extraction_job.GetFilesPerSecond(), extraction_job.GetElapsedSeconds());
+					const std::wstring last_error = extraction_job.GetLastError();
+					if (!last_error.empty()) {
+						ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Last error: %s", std::filesystem::path(last_error).string().c_str());
+					}
+				}
+
+				ImGui::Separator();
+				ImGui::Text("Extract changes since an older DAT:");
+
+				auto& dat_diff_job = extract_panel_info.dat_diff_job;
+				static bool dat_diff_stopped = false;
+				if (dat_diff_job.IsActive() && dat_diff_job.IsDone()) {
+					dat_diff_job.Stop();
+					if (dat_diff_job.GetError().empty()) {
+						// Only the added and modified files, with the extension and folder options above.
+						auto options = make_extraction_options(dat_diff_job.GetChangelogPath().parent_path());
+						options.mft_indices = dat_diff_job.GetResult().GetIndicesToExtract();
+						if (!options.mft_indices->empty()) {
+							extraction_job.Start(dat_manager, std::move(options));
+						}
+					}
+				}
+
+				if (dat_diff_job.IsActive()) {
+					const int files_to_read = dat_diff_job.GetFilesToRead();
+					const int files_read = dat_diff_job.GetFilesRead();
+					ImGui::ProgressBar(files_to_read > 0 ? static_cast<float>(files_read) / files_to_read : 0.0f, ImVec2(-1, 0),
+						std::format("Reading changed files: {} / {}", files_read, files_to_read).c_str());
+					if (ImGui::Button("Stop comparing")) {
+						dat_diff_job.Stop();
+						dat_diff_stopped = true;
+					}
+				}
+				else {
+					const bool can_compare = dat_manager->m_initialization_state == InitializationState::Completed && !extraction_job.IsActive();
+					ImGui::BeginDisabled(!can_compare);
+					if (ImGui::Button("Select older DAT and extract what changed")) {
+						std::string initial_filepath = ".";
+						const auto filepath_existing = load_last_filepath("dat_browser_last_filepath.txt");
+						if (filepath_existing.has_value()) {
+							initial_filepath = filepath_existing.value().parent_path().string();
+						}
+						ImGuiFileDialog::Instance()->OpenDialog("ChooseOlderDatDlgKey", "Choose older DAT file", ".dat", initial_filepath + "\\.");
+					}
+					ImGui::EndDisabled();
+					if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+						ImGui::SetTooltip("Compares the MFTs of both DATs and only decompresses files whose CRC or size changed.\n"
+							"Writes dat_changelog.json (added, removed, modified and moved files) to the selected folder\n"
+							"and extracts the added and modified files next to it.");
+					}
+
+					if (dat_diff_job.IsDone()) {
+						if (dat_diff_stopped) {
+							ImGui::Text("Comparison stopped.");
+						}
+						else if (!dat_diff_job.GetError().empty()) {
+							ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", std::filesystem::path(dat_diff_job.GetError()).string().c_str());
+						}
+						else {
+							const auto& diff = dat_diff_job.GetResult();
+							ImGui::Text("%d added, %d modified, %d moved, %d removed, %d unchanged (%d recompressed)",
+								diff.Count(DatChangeType::Added), diff.Count(DatChangeType::Modified), diff.Count(DatChangeType::Moved),
+								diff.Count(DatChangeType::Removed), diff.unchanged, diff.recompressed);
+							ImGui::Text("Compared in %.1f s, %d files decompressed", diff.seconds, diff.files_read);
+						}
+					}
+				}
+
+				if (ImGuiFileDialog::Instance()->Display("ChooseOlderDatDlgKey")) {
+					if (ImGuiFileDialog::Instance()->IsOk()) {
+						const std::string filePathName = ImGuiFileDialog::Instance()->GetFilePathName();
+						const std::wstring old_dat_filepath(filePathName.begin(), filePathName.end());
+						std::wstring saveDir = OpenDirectoryDialog();
+						if (!saveDir.empty()) {
+							dat_diff_stopped = false;
+							dat_diff_job.Start(dat_manager, old_dat_filepath, saveDir);
 						}
 					}
+					ImGuiFileDialog::Instance()->Close();
 				}
 				ImGui::Separator();
 				ImGui::Text("Extract All Textures:");
@@ -204,8 +363,10 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 									if (mft[i].type == FFNA_Type2) {
 										try {
 											// Check if this is an "other" format model with inline textures
-											if (dat_manager->is_other_model_format(static_cast<int>(i))) {
-												auto model = dat_manager->parse_ffna_model_file_other(static_cast<int>(i));
+											auto file_data = dat_manager->read_file_data(static_cast<int>(i));
+											std::span<unsigned char> model_data(file_data.data(), file_data.size());
+											if (IsOtherModelFormat(model_data)) {
+												FFNA_ModelFile_Other model(0, model_data);
 
 												if (model.has_inline_textures) {
 													auto inline_textures = model.GetAllInlineTextures();
@@ -228,18 +389,8 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 																continue;
 															}
 
-															// Create DirectX Image from BGRA data (GW textures are stored as BGRA)
-															DirectX::Image image;
-															image.width = tex.width;
-															image.height = tex.height;
-															image.format = DXGI_FORMAT_B8G8R8A8_UNORM;
-															image.rowPitch = tex.width * 4;
-															image.slicePitch = image.rowPitch * tex.height;
-															image.pixels = const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(tex.rgba_data.data()));
-
-															// Save to PNG
-															DirectX::SaveToWICFile(image, DirectX::WIC_FLAGS_FORCE_SRGB,
-																DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), filepath.c_str());
+															// Encoded on this thread from the BGRA data, no WIC or COM needed
+															SaveDatTextureToPng(tex, filepath);
 														}
 													}
 												}
@@ -1,5 +1,8 @@
 #pragma once
 #include "DATManager.h"
+#include "DatDiff.h"
+#include "ExtractionJob.h"
+#include "MapExportJob.h"
 
 namespace ExtractPanel {
     enum ExtractPanelMapFileType {
@@ -22,6 +25,9 @@ struct ExtractPanelInfo {
     std::wstring save_directory = L"";
     ExtractPanel::ExtractPanelMapFileType map_render_extract_file_type = ExtractPanel::DDS;
     ExtractPanel::ExtractMapType map_render_extract_map_type = ExtractPanel::CurrentMapNoViewChange;
+    ExtractionJob extraction_job; // "Extract selected file types", runs in the background
+    DatDiffJob dat_diff_job; // Compares with an older DAT, then extraction_job extracts what changed
+    MapExportJob map_export_job; // "Export all maps", also run headless by --export-all-maps
 };
 
 void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_manager);
\ No newline at end of file
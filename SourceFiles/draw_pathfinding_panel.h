@@ -76,16 +76,8 @@ private:
     // HSV to RGB conversion for coloring trapezoids
     RGBA HsvToRgb(float h, float s, float v, uint8_t a = 255);
 
-    // Draw a filled trapezoid on the image
-    void DrawTrapezoid(const PathfindingTrapezoid& trap,
-                       float min_x, float min_y, float scale_x, float scale_y,
-                       RGBA fill_color, RGBA outline_color);
-
-    // Draw a line on the image (Bresenham's algorithm)
-    void DrawLine(int x0, int y0, int x1, int y1, RGBA color);
-
-    // Fill a convex polygon (scanline fill)
-    void FillPolygon(const std::vector<std::pair<int, int>>& points, RGBA color);
+    // Computes the padded trapezoid bounds, the image size for image_size and the map to pixel scale.
+    bool ComputeImageLayout(const PathfindingChunk& pathfinding_chunk, int image_size, int& out_width, int& out_height);
 };
 
 // Draw the pathfinding visualization panel
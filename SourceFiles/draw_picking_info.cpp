@@ -5,12 +5,14 @@
 #include "draw_props_filenames_panel.h"
 #include "draw_props_info_panel.h"
 #include "FFNA_MapFile.h"
+#include "NavMesh.h"
 #include <algorithm>
 #include <GuiGlobalConstants.h>
 #include <model_exporter.h>
 
 
 extern FFNA_MapFile selected_ffna_map_file;
+extern int selected_map_file_index;
 extern std::vector<FileData> selected_map_files;
 
 void HightlightProp(MapRenderer* map_renderer, int selected_prop_index, int selected_prop_submodel_index);
@@ -87,6 +89,29 @@ void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATMa
 
             ImGui::Text("Mouse Coordinates: (%d, %d)", info.client_x, info.client_y);
 
+            const RayHit& world_hit = info.world_hit;
+            if (world_hit.type != RayHitType::None) {
+                ImGui::Text("World position: (%.1f, %.1f, %.1f)", world_hit.position.x, world_hit.position.y, world_hit.position.z);
+                if (world_hit.type == RayHitType::Prop) {
+                    ImGui::Text("Surface: prop %u, submodel %u, triangle %u", world_hit.prop_index, world_hit.submodel_index, world_hit.triangle);
+                }
+                else {
+                    ImGui::Text("Surface: terrain, triangle %u", world_hit.triangle);
+                }
+
+                static std::unique_ptr<NavMesh> nav_mesh;
+                static int nav_mesh_map_index = -1;
+                if (!nav_mesh || nav_mesh_map_index != selected_map_file_index) {
+                    nav_mesh = std::make_unique<NavMesh>(selected_ffna_map_file.pathfinding_chunk);
+                    nav_mesh_map_index = selected_map_file_index;
+                }
+                const uint32_t trapezoid = nav_mesh->FindTrapezoid({ world_hit.position.x, world_hit.position.z });
+                if (trapezoid != NAVMESH_INVALID_ID) {
+                    ImGui::Text("Pathfinding trapezoid: %u (plane %u)", trapezoid, nav_mesh->GetTrapezoidPlane(trapezoid));
+                }
+                else { ImGui::Text("Pathfinding trapezoid: None"); }
+            }
+
             if (prop_index >= 0) {
                 ImGui::Text("Picked Prop Index: %d", prop_index);
                 ImGui::Text("Submodel index: %d", submodel_index);
@@ -264,7 +289,16 @@ void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATMa
 
 
                                 // Export the model to the chosen path
-                                model_exporter::export_model(saveDir, filename, ffna_model_file_ptr, dat_manager, hash_index, map_renderer->GetTextureManager(), false);
+                                model_exporter::export_model(saveDir, filename, ffna_model_file_ptr, dat_manager, hash_index, false);
+                            }
+                        }
+                        if (ImGui::Button("Export model as binary (.gwmb)##picking_panel"))
+                        {
+                            std::wstring saveDir = OpenDirectoryDialog();
+                            if (!saveDir.empty())
+                            {
+                                std::wstring filename = std::format(L"model_0x{:X}.gwmb", file_id);
+                                model_exporter::export_model_binary(saveDir, filename, ffna_model_file_ptr, dat_manager, hash_index);
                             }
                         }
                         if (ImGui::Button("Save decompressed data to file##picking_panel"))
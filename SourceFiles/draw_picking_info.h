@@ -11,6 +11,7 @@ struct PickingInfo
     int prop_submodel_index;
     int mft_index;
     DirectX::XMFLOAT3 camera_pos;
+    RayHit world_hit; // CPU ray cast through the cursor, only while the picking panel is open
 };
 
 void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index);
\ No newline at end of file
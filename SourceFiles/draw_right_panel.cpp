@@ -97,6 +97,60 @@ void draw_right_panel(MapRenderer* map_renderer, int& FPS_target, DX::StepTimer&
                 map_renderer->UpdateTerrainTexturePadding(terrain_tex_pad_x, terrain_tex_pad_y);
             }
 
+            bool terrain_lod_enabled = map_renderer->GetTerrainLODEnabled();
+            if (ImGui::Checkbox("Terrain LOD", &terrain_lod_enabled)) {
+                map_renderer->SetTerrainLODEnabled(terrain_lod_enabled);
+            }
+
+            if (terrain_lod_enabled) {
+                float max_screen_error = map_renderer->GetTerrainLODMaxScreenError();
+                if (ImGui::SliderFloat("Terrain LOD error (px)", &max_screen_error, 0.5f, 16.0f, "%.1f", 0)) {
+                    map_renderer->SetTerrainLODMaxScreenError(max_screen_error);
+                }
+
+                const auto& lod_stats = map_renderer->GetTerrainLODStats();
+                ImGui::Text("Terrain triangles: %u / %u", lod_stats.selected_index_count / 3,
+                    lod_stats.full_res_index_count / 3);
+            }
+
+            bool prop_culling_enabled = map_renderer->GetPropCullingEnabled();
+            if (ImGui::Checkbox("Prop frustum culling", &prop_culling_enabled)) {
+                map_renderer->SetPropCullingEnabled(prop_culling_enabled);
+            }
+            ImGui::Text("Visible prop meshes: %u / %u", map_renderer->GetVisiblePropMeshCount(),
+                map_renderer->GetPropMeshCount());
+
+            if (map_renderer->GetMeshManager()->IsInstancingSupported()) {
+                bool instancing_enabled = map_renderer->GetMeshManager()->GetInstancingEnabled();
+                if (ImGui::Checkbox("Prop instancing", &instancing_enabled)) {
+                    map_renderer->GetMeshManager()->SetInstancingEnabled(instancing_enabled);
+                }
+            }
+
+            if (ImGui::TreeNode("Render queue stats")) {
+                const auto& render_stats = map_renderer->GetMeshManager()->GetRenderStats();
+                ImGui::Text("Draw calls: %u", render_stats.draw_calls);
+                ImGui::Text("Queue sorts: %u", render_stats.queue_sorts);
+                ImGui::Text("Pixel shader sets: %u", render_stats.pixel_shader_sets);
+                ImGui::Text("Sampler sets: %u", render_stats.sampler_sets);
+                ImGui::Text("Rasterizer sets: %u", render_stats.rasterizer_sets);
+                ImGui::Text("Topology sets: %u", render_stats.topology_sets);
+                ImGui::Text("Texture binds: %u", render_stats.texture_binds);
+                ImGui::Text("Skipped state sets: %u", render_stats.skipped_state_sets);
+                ImGui::Text("Constant buffer maps: %u", render_stats.constant_buffer_maps);
+                ImGui::Text("Instanced draws: %u (%u instances)", render_stats.instanced_draws, render_stats.instances);
+                ImGui::Text("Vertex shader sets: %u", render_stats.vertex_shader_sets);
+                ImGui::TreePop();
+            }
+
+            if (ImGui::TreeNode("Vertex memory")) {
+                const auto vertex_stats = map_renderer->GetMeshManager()->GetVertexMemoryStats();
+                ImGui::Text("Vertex buffers: %u (%u packed)", vertex_stats.vertex_buffers, vertex_stats.packed_vertex_buffers);
+                ImGui::Text("Size: %.2f MB", vertex_stats.vertex_buffer_bytes / (1024.0 * 1024.0));
+                ImGui::Text("Unpacked size: %.2f MB", vertex_stats.full_vertex_bytes / (1024.0 * 1024.0));
+                ImGui::TreePop();
+            }
+
             // Terrain pixel shader selection
             int terrain_shader_idx = (map_renderer->GetTerrainPixelShaderType() == PixelShaderType::TerrainTileChecker) ? 1 : 0;
             if (ImGui::Combo("Terrain shader", &terrain_shader_idx, "Textured\0Tile Checker\0"))
@@ -455,8 +509,6 @@ void draw_right_panel(MapRenderer* map_renderer, int& FPS_target, DX::StepTimer&
         ImGui::SetNextWindowSizeConstraints(ImVec2(0, 0), ImVec2(GuiGlobalConstants::right_panel_width, max_window_height));
         if (ImGui::Begin("Pathfinding Visibility", NULL, window_flags))
         {
-            auto& pathfindingMeshIds = map_renderer->GetPathfindingMeshIds();
-
             // Global toggle for showing pathfinding
             bool should_render_pathfinding = map_renderer->GetShouldRenderPathfinding();
             if (ImGui::Checkbox("Show Pathfinding", &should_render_pathfinding))
@@ -470,41 +522,37 @@ void draw_right_panel(MapRenderer* map_renderer, int& FPS_target, DX::StepTimer&
             {
                 if (selected_ffna_map_file.pathfinding_chunk.valid && map_renderer->GetTerrain())
                 {
-                    map_renderer->UpdatePathfindingMeshHeights(
+                    map_renderer->UpdatePathfindingHeights(
                         height_offset,
                         map_renderer->GetTerrain(),
                         selected_ffna_map_file.pathfinding_chunk.all_trapezoids);
                 }
             }
 
-            auto& planeMeshIds = map_renderer->GetPathfindingPlaneMeshIds();
+            const uint32_t plane_count = map_renderer->GetPathfindingPlaneCount();
+            const uint32_t trapezoid_count = map_renderer->GetPathfindingTrapezoidCount();
 
-            if (pathfindingMeshIds.size() > 0)
+            if (trapezoid_count > 0)
             {
-                ImGui::Text("Planes: %zu, Trapezoids: %zu", planeMeshIds.size(), pathfindingMeshIds.size());
+                ImGui::Text("Planes: %u, Trapezoids: %u", plane_count, trapezoid_count);
 
                 // Set all and Clear all buttons for all planes
                 if (ImGui::Button("Set all"))
                 {
-                    for (int mesh_id : pathfindingMeshIds)
-                    {
-                        map_renderer->SetPathfindingMeshIdShouldRender(mesh_id, true);
-                    }
+                    map_renderer->SetPathfindingTrapezoidsShouldRender(0, trapezoid_count, true);
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("Clear all"))
                 {
-                    for (int mesh_id : pathfindingMeshIds)
-                    {
-                        map_renderer->SetPathfindingMeshIdShouldRender(mesh_id, false);
-                    }
+                    map_renderer->SetPathfindingTrapezoidsShouldRender(0, trapezoid_count, false);
                 }
 
                 // Planes with individual trapezoids
-                for (size_t plane_idx = 0; plane_idx < planeMeshIds.size(); plane_idx++)
+                for (uint32_t plane_idx = 0; plane_idx < plane_count; plane_idx++)
                 {
-                    const auto& plane_mesh_ids = planeMeshIds[plane_idx];
-                    auto plane_label = std::format("Plane {} ({} traps)", plane_idx, plane_mesh_ids.size());
+                    const uint32_t first_trap = map_renderer->GetPathfindingPlaneFirstTrapezoid(plane_idx);
+                    const uint32_t plane_trap_count = map_renderer->GetPathfindingPlaneTrapezoidCount(plane_idx);
+                    auto plane_label = std::format("Plane {} ({} traps)", plane_idx, plane_trap_count);
 
                     if (ImGui::TreeNode(plane_label.c_str()))
                     {
@@ -514,30 +562,23 @@ void draw_right_panel(MapRenderer* map_renderer, int& FPS_target, DX::StepTimer&
 
                         if (ImGui::Button(set_label.c_str()))
                         {
-                            for (int mesh_id : plane_mesh_ids)
-                            {
-                                map_renderer->SetPathfindingMeshIdShouldRender(mesh_id, true);
-                            }
+                            map_renderer->SetPathfindingTrapezoidsShouldRender(first_trap, plane_trap_count, true);
                         }
                         ImGui::SameLine();
                         if (ImGui::Button(clear_label.c_str()))
                         {
-                            for (int mesh_id : plane_mesh_ids)
-                            {
-                                map_renderer->SetPathfindingMeshIdShouldRender(mesh_id, false);
-                            }
+                            map_renderer->SetPathfindingTrapezoidsShouldRender(first_trap, plane_trap_count, false);
                         }
 
                         // Individual trapezoid checkboxes
-                        for (size_t trap_idx = 0; trap_idx < plane_mesh_ids.size(); trap_idx++)
+                        for (uint32_t trap_idx = 0; trap_idx < plane_trap_count; trap_idx++)
                         {
-                            int mesh_id = plane_mesh_ids[trap_idx];
-                            bool should_render = map_renderer->GetPathfindingMeshIdShouldRender(mesh_id);
+                            bool should_render = map_renderer->GetPathfindingTrapezoidShouldRender(first_trap + trap_idx);
 
                             auto label = std::format("Trap {}##plane{}trap{}", trap_idx, plane_idx, trap_idx);
                             if (ImGui::Checkbox(label.c_str(), &should_render))
                             {
-                                map_renderer->SetPathfindingMeshIdShouldRender(mesh_id, should_render);
+                                map_renderer->SetPathfindingTrapezoidShouldRender(first_trap + trap_idx, should_render);
                             }
                         }
                         ImGui::TreePop();
@@ -5,16 +5,22 @@
 #include "GuiGlobalConstants.h"
 #include "draw_pathfinding_panel.h"
 #include "FFNA_MapFile.h"
+#include "NavDistanceMatrix.h"
+#include "NavMesh.h"
 #include <algorithm>
+#include <chrono>
 #include <commdlg.h>
 #include <cmath>
 #include <cstring>
 #include <filesystem>
+#include <future>
+#include <memory>
 #include <sstream>
 
 extern FFNA_MapFile selected_ffna_map_file;
 extern FileType selected_file_type;
 extern int selected_map_file_index;
+extern uint32_t selected_map_file_hash;
 
 namespace {
     constexpr float kSpellcastingRadius = 1085.0f;
@@ -213,7 +219,8 @@ namespace {
         return SUCCEEDED(hr) && route_map_texture_id >= 0;
     }
 
-    std::wstring OpenSaveFileDialog(const std::wstring& default_name, const std::wstring& extension) {
+    std::wstring OpenSaveFileDialog(const std::wstring& default_name, const std::wstring& extension,
+                                    const wchar_t* filter = L"CSV Files\0*.csv\0All Files\0*.*\0") {
         OPENFILENAMEW ofn;
         wchar_t szFile[260] = {0};
         wcscpy_s(szFile, default_name.c_str());
@@ -224,8 +231,7 @@ namespace {
         ofn.lpstrFile = szFile;
         ofn.nMaxFile = sizeof(szFile) / sizeof(wchar_t);
 
-        std::wstring filter = L"CSV Files\0*.csv\0All Files\0*.*\0";
-        ofn.lpstrFilter = filter.c_str();
+        ofn.lpstrFilter = filter;
         ofn.nFilterIndex = 1;
         ofn.lpstrDefExt = extension.c_str();
         ofn.Flags = OFN_PATHMUSTEXIST | OFN_OVERWRITEPROMPT;
@@ -339,7 +345,93 @@ namespace {
         return true;
     }
 
+    // Walkable path for every leg between consecutive waypoints. Legs without a path are left empty.
+    float BuildNavMeshLegs(NavMeshQuery& query,
+                           const std::vector<RouteWaypoint>& waypoints,
+                           std::vector<std::vector<DirectX::XMFLOAT2>>& out_leg_paths) {
+        out_leg_paths.clear();
+        if (waypoints.size() < 2) {
+            return 0.0f;
+        }
+
+        out_leg_paths.resize(waypoints.size() - 1);
+        float total_length = 0.0f;
+        NavPath path;
+        for (size_t i = 1; i < waypoints.size(); ++i) {
+            const DirectX::XMFLOAT2 start(waypoints[i - 1].x, waypoints[i - 1].y);
+            const DirectX::XMFLOAT2 goal(waypoints[i].x, waypoints[i].y);
+            if (query.FindPath(start, goal, path)) {
+                out_leg_paths[i - 1] = path.points;
+                total_length += path.length;
+            }
+        }
+        return total_length;
+    }
+
+    std::vector<DirectX::XMFLOAT2> WaypointsToPoints(const std::vector<RouteWaypoint>& waypoints) {
+        std::vector<DirectX::XMFLOAT2> points;
+        points.reserve(waypoints.size());
+        for (const auto& waypoint : waypoints) {
+            points.emplace_back(waypoint.x, waypoint.y);
+        }
+        return points;
+    }
+
+    bool SameWaypoints(const std::vector<RouteWaypoint>& a, const std::vector<RouteWaypoint>& b) {
+        return a.size() == b.size() &&
+               std::equal(a.begin(), a.end(), b.begin(), [](const RouteWaypoint& lhs, const RouteWaypoint& rhs) {
+                   return lhs.x == rhs.x && lhs.y == rhs.y;
+               });
+    }
+
+    enum class DistanceJobKind {
+        OptimizeOrder,
+        ExportCsv,
+        ExportJson,
+    };
+
+    // Distance matrix work behind the route buttons, run on a worker thread so large waypoint sets
+    // don't freeze the UI. One job runs at a time and uses the cache alone while it runs.
+    struct DistanceJob {
+        std::vector<RouteWaypoint> waypoints;   // As when started, the order refers to these
+        int map_index = -1;
+        std::future<std::vector<uint32_t>> order;   // Visiting order, empty for exports
+    };
+
+    std::future<std::vector<uint32_t>> StartDistanceJob(DistanceJobKind kind, NavDistanceCache& cache,
+                                                        std::shared_ptr<const NavMesh> nav_mesh, uint32_t map_file_hash,
+                                                        std::vector<DirectX::XMFLOAT2> points, std::wstring save_path) {
+        return std::async(std::launch::async,
+                          [kind, &cache, nav_mesh = std::move(nav_mesh), map_file_hash,
+                           points = std::move(points), save_path = std::move(save_path)]() {
+            const auto distances = cache.GetOrCompute(map_file_hash, *nav_mesh, points, points);
+            switch (kind) {
+            case DistanceJobKind::OptimizeOrder:
+                return OrderByNavDistance(*distances, 0);
+            case DistanceJobKind::ExportCsv:
+                WriteNavDistanceMatrixCsv(save_path, *distances);
+                break;
+            case DistanceJobKind::ExportJson:
+                WriteNavDistanceMatrixJson(save_path, *distances, map_file_hash, points, points);
+                break;
+            }
+            return std::vector<uint32_t>{};
+        });
+    }
+
+    // Trapezoid under every waypoint, NAVMESH_INVALID_ID where it is off the walkable area.
+    size_t ValidateWaypoints(const NavMesh& nav_mesh,
+                             const std::vector<RouteWaypoint>& waypoints,
+                             std::vector<uint32_t>& out_trapezoids) {
+        const auto points = WaypointsToPoints(waypoints);
+        out_trapezoids.resize(points.size());
+        nav_mesh.FindTrapezoids(points, out_trapezoids);
+        return std::count(out_trapezoids.begin(), out_trapezoids.end(), NAVMESH_INVALID_ID);
+    }
+
     void DrawWaypointOverlay(const std::vector<RouteWaypoint>& waypoints,
+                             const std::vector<uint32_t>& waypoint_trapezoids,
+                             const std::vector<std::vector<DirectX::XMFLOAT2>>& leg_paths,
                              const PathfindingVisualizer& visualizer,
                              const ImVec2& image_min,
                              const ImVec2& image_size,
@@ -372,7 +464,10 @@ namespace {
             }
 
             const bool is_selected = static_cast<int>(i) == selected_index;
-            const ImU32 marker_color = is_selected ? IM_COL32(255, 120, 0, 230) : IM_COL32(0, 200, 255, 200);
+            const bool is_off_mesh = i < waypoint_trapezoids.size() && waypoint_trapezoids[i] == NAVMESH_INVALID_ID;
+            const ImU32 marker_color = is_selected ? IM_COL32(255, 120, 0, 230)
+                                     : is_off_mesh ? IM_COL32(255, 40, 40, 230)
+                                                   : IM_COL32(0, 200, 255, 200);
             const float marker_radius = is_selected ? 7.0f : 5.0f;
             draw_list->AddCircleFilled(center, marker_radius, marker_color, 12);
             draw_list->AddText(ImVec2(center.x + 6.0f, center.y - 10.0f),
@@ -380,6 +475,17 @@ namespace {
                                std::to_string(i + 1).c_str());
 
             if (show_lines && i > 0) {
+                if (i - 1 < leg_paths.size() && leg_paths[i - 1].size() > 1) {
+                    const auto& leg = leg_paths[i - 1];
+                    for (size_t p = 1; p < leg.size(); ++p) {
+                        const ImVec2 from(image_min.x + (leg[p - 1].x - visualizer.GetMinX()) * px_per_world_x,
+                                          image_min.y + (visualizer.GetMaxY() - leg[p - 1].y) * px_per_world_y);
+                        const ImVec2 to(image_min.x + (leg[p].x - visualizer.GetMinX()) * px_per_world_x,
+                                        image_min.y + (visualizer.GetMaxY() - leg[p].y) * px_per_world_y);
+                        draw_list->AddLine(from, to, IM_COL32(0, 220, 255, 180), 2.0f);
+                    }
+                    continue;
+                }
                 const float prev_px = (waypoints[i - 1].x - visualizer.GetMinX()) * px_per_world_x;
                 const float prev_py = (visualizer.GetMaxY() - waypoints[i - 1].y) * px_per_world_y;
                 const ImVec2 prev_center = ImVec2(image_min.x + prev_px, image_min.y + prev_py);
@@ -423,80 +529,86 @@ namespace {
         return best_index;
     }
 
-    void RemoveMeshList(MapRenderer* map_renderer, std::vector<int>& mesh_ids) {
-        if (!map_renderer) {
-            return;
-        }
-        auto* mesh_manager = map_renderer->GetMeshManager();
-        if (!mesh_manager) {
+    // Route overlay in world space. Rebuilt when the route changes and resubmitted to the
+    // debug draw buffer every frame, also while the panel is closed.
+    const DirectX::XMFLOAT4 kRouteColor(0.0f, 0.85f, 1.0f, 0.95f);
+    const DirectX::XMFLOAT4 kCoverageColor(1.0f, 0.65f, 0.15f, 0.7f);
+    std::vector<DirectX::XMFLOAT3> route_overlay_points;      // Line strip
+    std::vector<DirectX::XMFLOAT3> coverage_overlay_segments; // Line list
+
+    void ClearRouteOverlay() {
+        route_overlay_points.clear();
+        coverage_overlay_segments.clear();
+    }
+
+    void SubmitRouteOverlay(MapRenderer* map_renderer) {
+        auto* debug_draw = map_renderer ? map_renderer->GetDebugDraw() : nullptr;
+        if (!debug_draw) {
             return;
         }
-        for (int mesh_id : mesh_ids) {
-            mesh_manager->RemoveMesh(mesh_id);
-        }
-        mesh_ids.clear();
+        debug_draw->AddLineStrip(route_overlay_points, kRouteColor);
+        debug_draw->AddLines(coverage_overlay_segments, kCoverageColor);
     }
 
-    void UpdateRouteOverlayMeshes(MapRenderer* map_renderer,
-                                  const std::vector<RouteWaypoint>& waypoints,
-                                  bool show_lines,
-                                  bool show_coverage,
-                                  std::vector<int>& route_line_mesh_ids,
-                                  std::vector<int>& coverage_mesh_ids) {
-        auto* mesh_manager = map_renderer ? map_renderer->GetMeshManager() : nullptr;
+    void UpdateRouteOverlay(MapRenderer* map_renderer,
+                            const std::vector<RouteWaypoint>& waypoints,
+                            const std::vector<std::vector<DirectX::XMFLOAT2>>& leg_paths,
+                            bool show_lines,
+                            bool show_coverage) {
+        ClearRouteOverlay();
+
         auto* terrain = map_renderer ? map_renderer->GetTerrain() : nullptr;
-        if (!mesh_manager || !terrain || waypoints.empty()) {
-            RemoveMeshList(map_renderer, route_line_mesh_ids);
-            RemoveMeshList(map_renderer, coverage_mesh_ids);
+        if (!terrain || waypoints.empty()) {
             return;
         }
 
-        RemoveMeshList(map_renderer, route_line_mesh_ids);
-        RemoveMeshList(map_renderer, coverage_mesh_ids);
-
-        const DirectX::XMFLOAT4 route_color(0.0f, 0.85f, 1.0f, 0.95f);
-        const DirectX::XMFLOAT4 coverage_color(1.0f, 0.65f, 0.15f, 0.7f);
-
         if (show_lines && waypoints.size() > 1) {
+            // Route polyline: navmesh legs where available, straight segments otherwise
+            std::vector<DirectX::XMFLOAT2> points;
+            points.reserve(waypoints.size());
+            points.emplace_back(waypoints[0].x, waypoints[0].y);
             for (size_t i = 1; i < waypoints.size(); ++i) {
-                const auto& start = waypoints[i - 1];
-                const auto& end = waypoints[i];
-                const float start_height = terrain->get_height_at(start.x, start.y) + kRouteHeightOffset;
-                const float end_height = terrain->get_height_at(end.x, end.y) + kRouteHeightOffset;
-                DirectX::XMFLOAT3 start_pos(start.x, start_height, start.y);
-                DirectX::XMFLOAT3 end_pos(end.x, end_height, end.y);
-
-                int line_id = mesh_manager->AddLine(start_pos, end_pos, PixelShaderType::OldModel);
-                if (line_id >= 0) {
-                    mesh_manager->SetMeshColor(line_id, route_color);
-                    route_line_mesh_ids.push_back(line_id);
+                if (i - 1 < leg_paths.size() && leg_paths[i - 1].size() > 1) {
+                    points.insert(points.end(), leg_paths[i - 1].begin() + 1, leg_paths[i - 1].end());
+                } else {
+                    points.emplace_back(waypoints[i].x, waypoints[i].y);
                 }
             }
+            std::vector<float> heights(points.size());
+            terrain->get_heights_at(points, heights);
+
+            route_overlay_points.reserve(points.size());
+            for (size_t i = 0; i < points.size(); ++i) {
+                route_overlay_points.emplace_back(points[i].x, heights[i] + kRouteHeightOffset, points[i].y);
+            }
         }
 
         if (show_coverage) {
             const float angle_step = (2.0f * kPi) / static_cast<float>(kCircleSegments);
+            const size_t points_per_circle = kCircleSegments + 1;
+
+            // Sample every circle point of every waypoint in a single batched height query
+            std::vector<DirectX::XMFLOAT2> points;
+            points.reserve(waypoints.size() * points_per_circle);
             for (const auto& waypoint : waypoints) {
-                float prev_x = waypoint.x + kSpellcastingRadius;
-                float prev_y = waypoint.y;
+                points.emplace_back(waypoint.x + kSpellcastingRadius, waypoint.y);
                 for (int seg = 1; seg <= kCircleSegments; ++seg) {
                     const float angle = angle_step * static_cast<float>(seg);
-                    const float next_x = waypoint.x + kSpellcastingRadius * std::cos(angle);
-                    const float next_y = waypoint.y + kSpellcastingRadius * std::sin(angle);
-
-                    const float prev_height = terrain->get_height_at(prev_x, prev_y) + kRouteHeightOffset;
-                    const float next_height = terrain->get_height_at(next_x, next_y) + kRouteHeightOffset;
-                    DirectX::XMFLOAT3 start_pos(prev_x, prev_height, prev_y);
-                    DirectX::XMFLOAT3 end_pos(next_x, next_height, next_y);
-
-                    int line_id = mesh_manager->AddLine(start_pos, end_pos, PixelShaderType::OldModel);
-                    if (line_id >= 0) {
-                        mesh_manager->SetMeshColor(line_id, coverage_color);
-                        coverage_mesh_ids.push_back(line_id);
-                    }
+                    points.emplace_back(waypoint.x + kSpellcastingRadius * std::cos(angle),
+                                        waypoint.y + kSpellcastingRadius * std::sin(angle));
+                }
+            }
+            std::vector<float> heights(points.size());
+            terrain->get_heights_at(points, heights);
 
-                    prev_x = next_x;
-                    prev_y = next_y;
+            coverage_overlay_segments.reserve(waypoints.size() * kCircleSegments * 2);
+            for (size_t w = 0; w < waypoints.size(); ++w) {
+                const size_t base = w * points_per_circle;
+                for (int seg = 1; seg <= kCircleSegments; ++seg) {
+                    const auto& prev = points[base + seg - 1];
+                    const auto& next = points[base + seg];
+                    coverage_overlay_segments.emplace_back(prev.x, heights[base + seg - 1] + kRouteHeightOffset, prev.y);
+                    coverage_overlay_segments.emplace_back(next.x, heights[base + seg] + kRouteHeightOffset, next.y);
                 }
             }
         }
@@ -504,6 +616,8 @@ namespace {
 }
 
 void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* device_resources) {
+    SubmitRouteOverlay(map_renderer);
+
     if (!GuiGlobalConstants::is_route_planner_panel_open) {
         return;
     }
@@ -525,12 +639,21 @@ void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* de
     static int route_map_texture_id = -1;
     static int route_map_map_index = -1;
     static int route_mask_map_index = -1;
-    static std::vector<int> route_line_mesh_ids;
-    static std::vector<int> coverage_mesh_ids;
     static std::vector<RouteWaypoint> last_overlay_waypoints;
     static bool last_overlay_show_lines = false;
     static bool last_overlay_show_coverage = false;
     static int last_overlay_map_index = -1;
+    static bool follow_navmesh = true;
+    static bool last_overlay_follow_navmesh = false;
+    static std::shared_ptr<NavMesh> nav_mesh;
+    static std::unique_ptr<NavMeshQuery> nav_query;
+    static int nav_mesh_map_index = -1;
+    static std::vector<std::vector<DirectX::XMFLOAT2>> leg_paths;
+    static float walk_distance = 0.0f;
+    static std::vector<uint32_t> waypoint_trapezoids;
+    static size_t off_mesh_waypoints = 0;
+    static NavDistanceCache distance_cache;
+    static DistanceJob distance_job;
 
     ImGuiIO& io = ImGui::GetIO();
     const bool prev_move_title_only = io.ConfigWindowsMoveFromTitleBarOnly;
@@ -543,8 +666,7 @@ void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* de
         if (selected_file_type != FFNA_Type3) {
             ImGui::TextWrapped("No pathfinding data loaded.");
             ImGui::TextWrapped("Load a map file (FFNA Type3) from the DAT browser to plan routes.");
-            RemoveMeshList(map_renderer, route_line_mesh_ids);
-            RemoveMeshList(map_renderer, coverage_mesh_ids);
+            ClearRouteOverlay();
             ImGui::End();
             return;
         }
@@ -557,6 +679,14 @@ void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* de
             }
         }
 
+        if (nav_mesh_map_index != selected_map_file_index) {
+            nav_query.reset();
+            nav_mesh = std::make_shared<NavMesh>(selected_ffna_map_file.pathfinding_chunk);
+            nav_query = std::make_unique<NavMeshQuery>(*nav_mesh);
+            nav_mesh_map_index = selected_map_file_index;
+            last_overlay_map_index = -1;
+        }
+
         ImGui::Text("Waypoints: %zu", waypoints.size());
         ImGui::SameLine();
         ImGui::Text("Spellcasting range: %.0f", kSpellcastingRadius);
@@ -566,6 +696,18 @@ void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* de
         ImGui::Checkbox("Click on map to add waypoint", &click_to_add);
         ImGui::Checkbox("Show route lines", &show_lines);
         ImGui::Checkbox("Show spellcasting coverage", &show_coverage);
+        ImGui::Checkbox("Follow walkable paths", &follow_navmesh);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Route legs follow the shortest path over the pathfinding trapezoids.\n"
+                              "Navmesh: %u trapezoids, %u links.",
+                              nav_mesh->GetTrapezoidCount(), nav_mesh->GetEdgeCount() / 2);
+        }
+        if (follow_navmesh && waypoints.size() > 1) {
+            ImGui::Text("Walk distance: %.0f", walk_distance);
+        }
+        if (off_mesh_waypoints > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%zu waypoint(s) outside the walkable area", off_mesh_waypoints);
+        }
         ImGui::SliderFloat("Map zoom", &map_zoom, 0.25f, 4.0f, "%.2fx");
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip("Use mouse wheel while hovering the map to zoom.");
@@ -605,7 +747,7 @@ void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* de
                 ImVec2 image_min = ImGui::GetCursorScreenPos();
                 ImGui::Image((ImTextureID)texture, scaled_size);
 
-                DrawWaypointOverlay(waypoints, *visualizer, image_min, scaled_size, show_lines, show_coverage, selected_waypoint);
+                DrawWaypointOverlay(waypoints, waypoint_trapezoids, leg_paths, *visualizer, image_min, scaled_size, show_lines, show_coverage, selected_waypoint);
 
                 if (ImGui::IsItemHovered()) {
                     if (io.MouseWheel != 0.0f) {
@@ -701,6 +843,67 @@ void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* de
             }
         }
 
+        if (distance_job.order.valid() &&
+            distance_job.order.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            std::vector<uint32_t> order;
+            try {
+                order = distance_job.order.get();
+            }
+            catch (const std::exception&) {
+                // Out of memory for the matrix, the waypoints stay as they are
+            }
+            // Waypoints edited while the job ran keep the order they were given
+            if (!order.empty() && distance_job.map_index == selected_map_file_index &&
+                SameWaypoints(waypoints, distance_job.waypoints)) {
+                std::vector<RouteWaypoint> ordered;
+                ordered.reserve(order.size());
+                for (uint32_t index : order) {
+                    ordered.push_back(waypoints[index]);
+                }
+                waypoints = std::move(ordered);
+                selected_waypoint = -1;
+            }
+        }
+
+        if (waypoints.size() > 1 && !nav_mesh->IsEmpty()) {
+            const bool job_running = distance_job.order.valid();
+            auto start_job = [&](DistanceJobKind kind, std::wstring save_path) {
+                distance_job.waypoints = waypoints;
+                distance_job.map_index = selected_map_file_index;
+                distance_job.order = StartDistanceJob(kind, distance_cache, nav_mesh, selected_map_file_hash,
+                                                      WaypointsToPoints(waypoints), std::move(save_path));
+            };
+
+            ImGui::BeginDisabled(job_running);
+            if (ImGui::Button("Optimize order")) {
+                start_job(DistanceJobKind::OptimizeOrder, {});
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Keeps the first waypoint and reorders the rest to shorten the walk.");
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Export distances CSV")) {
+                std::wstring default_name = std::format(L"route_distances_{}", selected_map_file_index);
+                std::wstring save_path = OpenSaveFileDialog(default_name, L"csv");
+                if (!save_path.empty()) {
+                    start_job(DistanceJobKind::ExportCsv, std::move(save_path));
+                }
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Export distances JSON")) {
+                std::wstring default_name = std::format(L"route_distances_{}", selected_map_file_index);
+                std::wstring save_path = OpenSaveFileDialog(default_name, L"json", L"JSON Files\0*.json\0All Files\0*.*\0");
+                if (!save_path.empty()) {
+                    start_job(DistanceJobKind::ExportJson, std::move(save_path));
+                }
+            }
+            ImGui::EndDisabled();
+            if (job_running) {
+                ImGui::SameLine();
+                ImGui::TextUnformatted("Computing walk distances...");
+            }
+        }
+
         if (!waypoints.empty()) {
             ImGui::Separator();
             if (ImGui::BeginChild("route_waypoint_list", ImVec2(0, 120), true)) {
@@ -728,16 +931,20 @@ void draw_route_planner_panel(MapRenderer* map_renderer, DX::DeviceResources* de
         if (selected_map_file_index != last_overlay_map_index ||
             show_lines != last_overlay_show_lines ||
             show_coverage != last_overlay_show_coverage ||
-            waypoints.size() != last_overlay_waypoints.size() ||
-            !std::equal(waypoints.begin(), waypoints.end(), last_overlay_waypoints.begin(),
-                        [](const RouteWaypoint& a, const RouteWaypoint& b) {
-                            return a.x == b.x && a.y == b.y;
-                        })) {
-            UpdateRouteOverlayMeshes(map_renderer, waypoints, show_lines, show_coverage,
-                                     route_line_mesh_ids, coverage_mesh_ids);
+            follow_navmesh != last_overlay_follow_navmesh ||
+            !SameWaypoints(waypoints, last_overlay_waypoints)) {
+            off_mesh_waypoints = ValidateWaypoints(*nav_mesh, waypoints, waypoint_trapezoids);
+            if (follow_navmesh) {
+                walk_distance = BuildNavMeshLegs(*nav_query, waypoints, leg_paths);
+            } else {
+                leg_paths.clear();
+                walk_distance = 0.0f;
+            }
+            UpdateRouteOverlay(map_renderer, waypoints, leg_paths, show_lines, show_coverage);
             last_overlay_waypoints = waypoints;
             last_overlay_show_lines = show_lines;
             last_overlay_show_coverage = show_coverage;
+            last_overlay_follow_navmesh = follow_navmesh;
             last_overlay_map_index = selected_map_file_index;
         }
     }
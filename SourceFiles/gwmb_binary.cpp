@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "gwmb_binary.h"
+
+namespace
+{
+    void write_u32(std::ofstream& file, uint32_t value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+
+nlohmann::json gwmb_binary_writer::add_view(const void* data, size_t size_bytes, size_t count, uint32_t components, const char* type)
+{
+    const size_t offset = m_buffer.size();
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size_bytes);
+    // All element types are 4 bytes wide, so views stay aligned without padding.
+
+    return nlohmann::json{ {"offset", offset}, {"count", count}, {"components", components}, {"type", type} };
+}
+
+bool gwmb_binary_writer::save(const std::filesystem::path& file_path, const nlohmann::json& metadata) const
+{
+    std::string json = metadata.dump();
+    json.resize((json.size() + 3) & ~size_t(3), ' ');
+
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    file.write(GWMB_BINARY_MAGIC, sizeof(GWMB_BINARY_MAGIC));
+    write_u32(file, GWMB_BINARY_VERSION);
+    write_u32(file, static_cast<uint32_t>(json.size()));
+    write_u32(file, static_cast<uint32_t>(m_buffer.size()));
+    file.write(json.data(), json.size());
+    file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+
+    return file.good();
+}
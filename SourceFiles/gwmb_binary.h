@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+// Binary gwmb container, written next to (or instead of) the JSON exports.
+//
+// Layout, all integers little-endian:
+//   char     magic[4]      "GWMB"
+//   uint32_t version       GWMB_BINARY_VERSION
+//   uint32_t json_length   Length of the metadata, padded with spaces to a multiple of 4
+//   uint32_t binary_length Length of the buffer that follows the metadata
+//   char     json[json_length]
+//   uint8_t  binary[binary_length]
+//
+// The metadata is the same document the JSON export writes, except that vertex, index and instance arrays
+// are replaced by views into the buffer:
+//   { "offset": <bytes from the buffer start>, "count": <elements>, "components": <per element>, "type": "f32" | "u32" }
+// Views are 4 byte aligned and tightly packed, so a reader can wrap them with array.array or numpy directly.
+// The Blender add-ons in blender_addons/ read both formats.
+
+constexpr char GWMB_BINARY_MAGIC[4] = { 'G', 'W', 'M', 'B' };
+constexpr uint32_t GWMB_BINARY_VERSION = 1;
+
+class gwmb_binary_writer
+{
+public:
+    nlohmann::json add_view(std::span<const float> values, uint32_t components)
+    {
+        return add_view(values.data(), values.size_bytes(), values.size() / components, components, "f32");
+    }
+
+    nlohmann::json add_view(std::span<const uint32_t> values, uint32_t components = 1)
+    {
+        return add_view(values.data(), values.size_bytes(), values.size() / components, components, "u32");
+    }
+
+    // Writes the container to file_path, metadata is the document that holds the views.
+    bool save(const std::filesystem::path& file_path, const nlohmann::json& metadata) const;
+
+private:
+    nlohmann::json add_view(const void* data, size_t size_bytes, size_t count, uint32_t components, const char* type);
+
+    std::vector<uint8_t> m_buffer;
+};
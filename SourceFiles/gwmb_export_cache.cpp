@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "gwmb_export_cache.h"
+
+std::shared_ptr<const DatTexture> gwmb_export_cache::get_texture(int file_hash, const std::function<DatTexture()>& decode)
+{
+    std::promise<std::shared_ptr<const DatTexture>> promise;
+    std::shared_future<std::shared_ptr<const DatTexture>> cached;
+    {
+        std::scoped_lock lock(m_mutex);
+        const auto it = m_textures.find(file_hash);
+        if (it != m_textures.end()) {
+            m_texture_lru.splice(m_texture_lru.begin(), m_texture_lru, it->second.lru);
+            cached = it->second.texture;
+        }
+        else {
+            m_texture_lru.push_front(file_hash);
+            m_textures.emplace(file_hash, texture_entry{ promise.get_future().share(), 0, m_texture_lru.begin() });
+        }
+    }
+    if (cached.valid()) {
+        return cached.get(); // Waits if another export is decoding it
+    }
+
+    std::shared_ptr<const DatTexture> texture;
+    try {
+        texture = std::make_shared<const DatTexture>(decode());
+    }
+    catch (...) {
+        {
+            std::scoped_lock lock(m_mutex);
+            const auto it = m_textures.find(file_hash);
+            m_texture_lru.erase(it->second.lru);
+            m_textures.erase(it);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    promise.set_value(texture);
+
+    std::scoped_lock lock(m_mutex);
+    auto& entry = m_textures.at(file_hash); // Entries being decoded aren't evicted
+    entry.bytes = std::max<size_t>(1, texture->rgba_data.size() * sizeof(RGBA));
+    m_texture_bytes += entry.bytes;
+    evict_textures(file_hash);
+    return texture;
+}
+
+bool gwmb_export_cache::write_file(const std::filesystem::path& file_path, const write_function& write)
+{
+    std::promise<bool> promise;
+    std::filesystem::path source_path;
+    std::shared_future<bool> written;
+    {
+        std::scoped_lock lock(m_mutex);
+        const auto [it, inserted] = m_files.try_emplace(file_path.filename().wstring());
+        if (inserted) {
+            it->second = file_entry{ file_path, promise.get_future().share() };
+        }
+        else {
+            source_path = it->second.path;
+            written = it->second.written;
+        }
+    }
+
+    if (!written.valid()) {
+        // Written even if it exists, an earlier run may have left it without the files it depends on.
+        bool success = false;
+        try {
+            success = write(file_path);
+        }
+        catch (...) {
+            promise.set_value(false);
+            throw;
+        }
+        promise.set_value(success);
+        return success;
+    }
+
+    if (!written.get() || source_path == file_path) {
+        return written.get();
+    }
+
+    std::vector<std::wstring> file_names{ file_path.filename().wstring() };
+    {
+        std::scoped_lock lock(m_mutex);
+        const auto& dependencies = m_files.at(file_names[0]).dependencies;
+        file_names.insert(file_names.end(), dependencies.begin(), dependencies.end());
+    }
+
+    bool success = true;
+    for (const auto& file_name : file_names) {
+        success &= link_file(source_path.parent_path() / file_name, file_path.parent_path() / file_name);
+    }
+    return success;
+}
+
+void gwmb_export_cache::set_dependencies(const std::filesystem::path& file_path, std::vector<std::wstring> file_names)
+{
+    std::scoped_lock lock(m_mutex);
+    const auto it = m_files.find(file_path.filename().wstring());
+    if (it != m_files.end() && it->second.path == file_path) {
+        it->second.dependencies = std::move(file_names);
+    }
+}
+
+bool gwmb_export_cache::link_file(const std::filesystem::path& source_path, const std::filesystem::path& file_path)
+{
+    if (std::filesystem::exists(file_path)) {
+        return true;
+    }
+
+    std::error_code error;
+    std::filesystem::create_hard_link(source_path, file_path, error);
+    if (error) {
+        error.clear();
+        std::filesystem::copy_file(source_path, file_path, std::filesystem::copy_options::overwrite_existing, error);
+    }
+    return !error;
+}
+
+size_t gwmb_export_cache::get_texture_bytes() const
+{
+    std::scoped_lock lock(m_mutex);
+    return m_texture_bytes;
+}
+
+void gwmb_export_cache::evict_textures(int keep_file_hash)
+{
+    for (auto lru_it = m_texture_lru.end(); m_texture_bytes > m_texture_budget_bytes && lru_it != m_texture_lru.begin();) {
+        --lru_it;
+        const auto it = m_textures.find(*lru_it);
+        if (*lru_it == keep_file_hash || it->second.bytes == 0) continue;
+
+        // Exports still holding the texture keep it alive through their shared_ptr.
+        m_texture_bytes -= it->second.bytes;
+        m_textures.erase(it);
+        lru_it = m_texture_lru.erase(lru_it);
+    }
+}
+
+bool write_file_once(gwmb_export_cache* cache, const std::filesystem::path& file_path, const gwmb_export_cache::write_function& write)
+{
+    if (cache) {
+        return cache->write_file(file_path, write);
+    }
+    return std::filesystem::exists(file_path) || write(file_path);
+}
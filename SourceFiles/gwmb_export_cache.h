@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AtexReader.h"
+
+/**
+ * @brief Shares decoded textures and written files between gwmb exports, also across threads.
+ *
+ * Exports of several maps have most models and textures in common. Decoded textures are kept, least recently
+ * used first out, while they fit the byte budget. Output files are identified by their file name, which holds
+ * the DAT file hash: the first export of a file name in a run writes it, later exports into other directories
+ * hard link to it (or copy it where links aren't possible), together with the files it depends on, such as a
+ * model's textures. Callers asking for a texture or file that is being produced wait for it instead of producing
+ * it again.
+ */
+class gwmb_export_cache
+{
+public:
+    using write_function = std::function<bool(const std::filesystem::path& file_path)>;
+
+    explicit gwmb_export_cache(size_t texture_budget_bytes) : m_texture_budget_bytes(texture_budget_bytes) {}
+
+    std::shared_ptr<const DatTexture> get_texture(int file_hash, const std::function<DatTexture()>& decode);
+
+    // Makes sure file_path exists, see the class comment. Returns false if the file couldn't be written.
+    bool write_file(const std::filesystem::path& file_path, const write_function& write);
+
+    // Called by a write function: file_names (in the same directory) are linked along wherever file_path is reused.
+    void set_dependencies(const std::filesystem::path& file_path, std::vector<std::wstring> file_names);
+
+    size_t get_texture_bytes() const;
+
+private:
+    struct texture_entry
+    {
+        std::shared_future<std::shared_ptr<const DatTexture>> texture;
+        size_t bytes = 0; // 0 while decoding
+        std::list<int>::iterator lru;
+    };
+
+    struct file_entry
+    {
+        std::filesystem::path path; // Where it was written first
+        std::shared_future<bool> written;
+        std::vector<std::wstring> dependencies; // Set before written is
+    };
+
+    void evict_textures(int keep_file_hash);
+    static bool link_file(const std::filesystem::path& source_path, const std::filesystem::path& file_path);
+
+    mutable std::mutex m_mutex;
+    size_t m_texture_budget_bytes;
+    size_t m_texture_bytes = 0;
+    std::unordered_map<int, texture_entry> m_textures;
+    std::list<int> m_texture_lru; // Most recently used first
+    std::unordered_map<std::wstring, file_entry> m_files;
+};
+
+// Writes file_path through the cache, or without one only if it doesn't exist yet, like single exports always did.
+bool write_file_once(gwmb_export_cache* cache, const std::filesystem::path& file_path, const gwmb_export_cache::write_function& write);
@@ -150,10 +150,11 @@ namespace nlohmann {
 class map_exporter
 {
 public:
-    static bool export_map(const std::wstring& save_directory, const int map_filehash, const int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print = false) {
+    // With a cache (see gwmb_export_cache.h) models and textures are shared with the other maps exported through it.
+    static bool export_map(const std::wstring& save_directory, const int map_filehash, const int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, const bool json_pretty_print = false, gwmb_export_cache* cache = nullptr) {
         // Build model
         gwmb_map map;
-        const bool success = generate_gwmb_map(save_directory, map, map_mft_index, dat_manager, hash_index, texture_manager, map_filehash);
+        const bool success = generate_gwmb_map(save_directory, map, map_mft_index, dat_manager, hash_index, map_filehash, false, cache);
         if (!success)
             return false;
 
@@ -172,8 +173,92 @@ public:
         return true; // Successfully exported the model
     }
 
+    // Writes map_<hash>.gwmb and its models as model_0x<hash>.gwmb, see gwmb_binary.h.
+    // Instead of one object per prop the map stores the unique model hashes once and packed instance arrays.
+    static bool export_map_binary(const std::wstring& save_directory, const int map_filehash, const int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, gwmb_export_cache* cache = nullptr) {
+        gwmb_map map;
+        const bool success = generate_gwmb_map(save_directory, map, map_mft_index, dat_manager, hash_index, map_filehash, true, cache);
+        if (!success)
+            return false;
+
+        gwmb_binary_writer writer;
+
+        const auto& terrain = map.terrain;
+        std::vector<float> positions, normals;
+        std::array<std::vector<float>, 4> uv_coords;
+        positions.reserve(terrain.vertices.size() * 3);
+        normals.reserve(terrain.vertices.size() * 3);
+        for (auto& uvs : uv_coords) {
+            uvs.reserve(terrain.vertices.size() * 2);
+        }
+        for (const auto& vertex : terrain.vertices) {
+            positions.insert(positions.end(), { vertex.pos.x, vertex.pos.y, vertex.pos.z });
+            normals.insert(normals.end(), { vertex.normal.x, vertex.normal.y, vertex.normal.z });
+            uv_coords[0].insert(uv_coords[0].end(), { vertex.uv_coord0.x, vertex.uv_coord0.y });
+            uv_coords[1].insert(uv_coords[1].end(), { vertex.uv_coord1.x, vertex.uv_coord1.y });
+            uv_coords[2].insert(uv_coords[2].end(), { vertex.uv_coord2.x, vertex.uv_coord2.y });
+            uv_coords[3].insert(uv_coords[3].end(), { vertex.uv_coord3.x, vertex.uv_coord3.y });
+        }
+
+        nlohmann::json terrain_json{
+            {"width", terrain.width},
+            {"height", terrain.height},
+            {"textures", terrain.textures},
+            {"vertex_count", terrain.vertices.size()},
+        };
+        terrain_json["positions"] = writer.add_view(positions, 3);
+        terrain_json["normals"] = writer.add_view(normals, 3);
+        for (int i = 0; i < 4; i++) {
+            terrain_json[std::format("uv_coord{}", i)] = writer.add_view(uv_coords[i], 2);
+        }
+        terrain_json["indices"] = writer.add_view(std::vector<uint32_t>(terrain.indices.begin(), terrain.indices.end()));
+
+        std::vector<int> model_hashes;
+        std::unordered_map<int, uint32_t> model_hash_to_index;
+        std::vector<uint32_t> model_indices;
+        std::vector<float> world_pos, model_right, model_up, model_look, scale;
+        for (const auto& model : map.models) {
+            const auto [it, inserted] = model_hash_to_index.try_emplace(model.model_hash, static_cast<uint32_t>(model_hashes.size()));
+            if (inserted) {
+                model_hashes.push_back(model.model_hash);
+            }
+            model_indices.push_back(it->second);
+            world_pos.insert(world_pos.end(), { model.world_pos.x, model.world_pos.y, model.world_pos.z });
+            model_right.insert(model_right.end(), { model.model_right.x, model.model_right.y, model.model_right.z });
+            model_up.insert(model_up.end(), { model.model_up.x, model.model_up.y, model.model_up.z });
+            model_look.insert(model_look.end(), { model.model_look.x, model.model_look.y, model.model_look.z });
+            scale.push_back(model.scale);
+        }
+
+        nlohmann::json instances{ {"count", map.models.size()} };
+        instances["model_index"] = writer.add_view(model_indices);
+        instances["world_pos"] = writer.add_view(world_pos, 3);
+        instances["model_right"] = writer.add_view(model_right, 3);
+        instances["model_up"] = writer.add_view(model_up, 3);
+        instances["model_look"] = writer.add_view(model_look, 3);
+        instances["scale"] = writer.add_view(scale, 1);
+
+        const nlohmann::json metadata{
+            {"format", "gwmb_map"},
+            {"filehash", map.filehash},
+            {"terrain", std::move(terrain_json)},
+            {"model_hashes", model_hashes},
+            {"instances", std::move(instances)},
+            {"min_x", map.min_x},
+            {"max_x", map.max_x},
+            {"min_y", map.min_y},
+            {"max_y", map.max_y},
+            {"min_z", map.min_z},
+            {"max_z", map.max_z},
+        };
+
+        const std::filesystem::path file_path = std::filesystem::path(save_directory) / ("map_" + std::to_string(map_filehash) + ".gwmb");
+        return writer.save(file_path, metadata);
+    }
+
 private:
-    static bool generate_gwmb_map(const std::wstring& save_directory, gwmb_map& map, int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, int map_filehash) {
+    // binary selects the format the map's models are exported in.
+    static bool generate_gwmb_map(const std::wstring& save_directory, gwmb_map& map, int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, int map_filehash, const bool binary, gwmb_export_cache* cache) {
         auto map_file = dat_manager->parse_ffna_map_file(map_mft_index);
 
         map.filehash = map_filehash;
@@ -202,31 +287,22 @@ private:
                 auto mft_entry_it = hash_index.find(decoded_filename);
                 if (mft_entry_it != hash_index.end())
                 {
-                    const DatTexture dat_texture =
-                        dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0));
-                    int texture_id = -1;
-                    auto HR = texture_manager->CreateTextureFromRGBA(dat_texture.width,
-                        dat_texture.height, dat_texture.rgba_data.data(), &texture_id,
-                        decoded_filename);
-
-                    if (dat_texture.width > 0 && dat_texture.height > 0) {
+                    const auto dat_texture =
+                        model_exporter::decode_texture(decoded_filename, mft_entry_it->second.at(0), dat_manager, cache);
+
+                    if (dat_texture->width > 0 && dat_texture->height > 0) {
                         gwmb_texture gwmb_texture_i;
                         gwmb_texture_i.file_hash = decoded_filename;
-                        gwmb_texture_i.height = dat_texture.height;
-                        gwmb_texture_i.width = dat_texture.width;
-                        gwmb_texture_i.texture_type = dat_texture.texture_type;
-
-                        ID3D11ShaderResourceView* texture = texture_manager->GetTexture(texture_id);
-
-                        std::wstring texture_save_path = save_directory + L"\\" + std::to_wstring(gwmb_texture_i.file_hash) + L".png";
-                        std::wstring texture_save_pathw = std::wstring(texture_save_path.begin(), texture_save_path.end());
+                        gwmb_texture_i.height = dat_texture->height;
+                        gwmb_texture_i.width = dat_texture->width;
+                        gwmb_texture_i.texture_type = dat_texture->texture_type;
 
-                        if (!SaveTextureToPng(texture, texture_save_pathw, texture_manager))
+                        if (!model_exporter::save_texture_png(save_directory, gwmb_texture_i.file_hash, *dat_texture, cache))
                         {
                             throw "Unable to save texture to png while creating terrain texture";
                         }
 
-                        terrain_dat_textures.push_back(dat_texture);
+                        terrain_dat_textures.push_back(*dat_texture);
                         new_terrain.textures.push_back(gwmb_texture_i);
                     }
                 }
@@ -242,29 +318,16 @@ private:
             terrain_dat_textures.insert(terrain_dat_textures.begin(), neutral_texture);
 
             // Save terrain textures in texture atlas
-            int terrain_tex_atlas_tex_id = -1;
-            const auto terrain_tex_atlas = texture_manager->BuildTextureAtlas(terrain_dat_textures, 8, 8);
+            const auto terrain_tex_atlas = TextureManager::BuildTextureAtlas(terrain_dat_textures, 8, 8);
 
-            if (terrain_tex_atlas.width > 0 && terrain_tex_atlas.height > 0)
+            if (terrain_tex_atlas.width <= 0 || terrain_tex_atlas.height <= 0)
             {
-                texture_manager->CreateTextureFromRGBA(
-                    terrain_tex_atlas.width,
-                    terrain_tex_atlas.height,
-                    terrain_tex_atlas.rgba_data.data(), 
-                    &terrain_tex_atlas_tex_id,
-                    -1);
-            }
-            else {
                 throw "terrain texture atlas could not be created";
             }
 
-            ID3D11ShaderResourceView* texture =
-                texture_manager->GetTexture(terrain_tex_atlas_tex_id);
-
             std::wstring texture_save_path = save_directory + L"\\" + L"atlas_" + std::to_wstring(map_filehash) + L".png";
-            std::wstring texture_save_pathw = std::wstring(texture_save_path.begin(), texture_save_path.end());
 
-            if (!SaveTextureToPng(texture, texture_save_pathw, texture_manager))
+            if (!SaveDatTextureToPng(terrain_tex_atlas, texture_save_path))
             {
                 throw "Unable to save texture to png while terrain texture atlas";
             }
@@ -328,7 +391,7 @@ private:
                     const auto entry = dat_manager->get_MFT()[mft_entry_it->second.at(0)];
                     if (entry.type == FFNA_Type2) {
                         // Export model to map folder
-                        model_exporter::export_model(save_directory, std::format(L"model_0x{:X}_gwmb.json", decoded_filename), mft_entry_it->second.at(0), dat_manager, hash_index, texture_manager);
+                        export_map_model(save_directory, decoded_filename, mft_entry_it->second.at(0), dat_manager, hash_index, binary, cache);
                         model_hashes.push_back(decoded_filename);
                     }
                 }
@@ -345,7 +408,7 @@ private:
                     const auto entry = dat_manager->get_MFT()[mft_entry_it->second.at(0)];
                     if (entry.type == FFNA_Type2) {
                         // Export model to map folder
-                        model_exporter::export_model(save_directory, std::format(L"model_0x{:X}_gwmb.json", decoded_filename), mft_entry_it->second.at(0), dat_manager, hash_index, texture_manager);
+                        export_map_model(save_directory, decoded_filename, mft_entry_it->second.at(0), dat_manager, hash_index, binary, cache);
                         model_hashes.push_back(decoded_filename);
                     }
                 }
@@ -400,5 +463,12 @@ private:
 
         return true;
     }
+
+    static bool export_map_model(const std::wstring& save_directory, int model_hash, int model_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, const bool binary, gwmb_export_cache* cache) {
+        if (binary) {
+            return model_exporter::export_model_binary(save_directory, std::format(L"model_0x{:X}.gwmb", model_hash), model_mft_index, dat_manager, hash_index, cache);
+        }
+        return model_exporter::export_model(save_directory, std::format(L"model_0x{:X}_gwmb.json", model_hash), model_mft_index, dat_manager, hash_index, false, cache);
+    }
 };
 
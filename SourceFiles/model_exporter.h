@@ -4,8 +4,11 @@
 #include <AMAT_file.h>
 #include <FFNA_ModelFile.h>
 #include <TextureManager.h>
+#include <TextureExport.h>
 #include <PixelShader.h>
 #include <json.hpp>
+#include <gwmb_binary.h>
+#include <gwmb_export_cache.h>
 
 struct gwmb_vec2f
 {
@@ -254,30 +257,89 @@ namespace nlohmann {
 // Step 2) Write the data to a .gwmb file. A custom data format to be used when importing into other programs like Blender.
 class model_exporter {
 public:
-    static bool export_model(const std::wstring& save_dir, const std::wstring& filename, const int model_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print = false) {
-        auto model_file = dat_manager->parse_ffna_model_file(model_mft_index);
-        return export_model_to_file(save_dir, filename, &model_file, dat_manager, hash_index, texture_manager, json_pretty_print);
+    // With a cache (see gwmb_export_cache.h) the model file and its textures are shared with other exports.
+    static bool export_model(const std::wstring& save_dir, const std::wstring& filename, const int model_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, const bool json_pretty_print = false, gwmb_export_cache* cache = nullptr) {
+        return export_model_to_file(save_dir, filename, model_mft_index, dat_manager, hash_index, json_pretty_print, false, cache);
     }
 
-    static bool export_model(const std::wstring& save_dir, const std::wstring& filename, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print = false) {
-        return export_model_to_file(save_dir, filename, model_file, dat_manager, hash_index, texture_manager, json_pretty_print);
+    static bool export_model(const std::wstring& save_dir, const std::wstring& filename, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, const bool json_pretty_print = false) {
+        return write_file_once(nullptr, save_dir + L"\\" + filename, [&](const std::filesystem::path& file_path) {
+            return write_model_file(file_path, model_file, dat_manager, hash_index, save_dir, json_pretty_print, false, nullptr);
+        });
+    }
+
+    // Same as export_model but writes the binary gwmb container (see gwmb_binary.h), usually named model_0x<hash>.gwmb.
+    static bool export_model_binary(const std::wstring& save_dir, const std::wstring& filename, const int model_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, gwmb_export_cache* cache = nullptr) {
+        return export_model_to_file(save_dir, filename, model_mft_index, dat_manager, hash_index, false, true, cache);
+    }
+
+    static bool export_model_binary(const std::wstring& save_dir, const std::wstring& filename, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index) {
+        return write_file_once(nullptr, save_dir + L"\\" + filename, [&](const std::filesystem::path& file_path) {
+            return write_model_file(file_path, model_file, dat_manager, hash_index, save_dir, false, true, nullptr);
+        });
+    }
+
+    // Decodes a DDS or ATEX texture on the CPU, see TextureExport.h. With a cache each texture is decoded once.
+    static std::shared_ptr<const DatTexture> decode_texture(const int file_hash, const int file_index, DATManager* dat_manager, gwmb_export_cache* cache) {
+        const auto decode = [&] {
+            DatTexture dat_texture{};
+            if (dat_manager->get_MFT()[file_index].type == DDS)
+            {
+                const auto ddsData = dat_manager->parse_dds_file(file_index);
+                DecodeDDSTexture(ddsData.data(), ddsData.size(), dat_texture);
+            }
+            else
+            {
+                dat_texture = dat_manager->parse_ffna_texture_file(file_index);
+            }
+            return dat_texture;
+        };
+        return cache ? cache->get_texture(file_hash, decode) : std::make_shared<const DatTexture>(decode());
+    }
+
+    // Saves <save_dir>\<file_hash>.png unless it exists already.
+    static bool save_texture_png(const std::wstring& save_dir, const int file_hash, const DatTexture& dat_texture, gwmb_export_cache* cache) {
+        const std::wstring texture_save_path = save_dir + L"\\" + std::to_wstring(file_hash) + L".png";
+        return write_file_once(cache, texture_save_path, [&](const std::filesystem::path& file_path) {
+            return SaveDatTextureToPng(dat_texture, file_path);
+        });
     }
 
 private:
-    static bool export_model_to_file(const std::wstring& save_dir, const std::wstring& filename, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print) {
-        std::wstring saveFilePath = save_dir + L"\\" + filename;
-        if (std::filesystem::exists(saveFilePath)) {
-            return true; // Return immediately if the file already exists
-        }
+    // The model is only opened if the file still has to be written.
+    static bool export_model_to_file(const std::wstring& save_dir, const std::wstring& filename, const int model_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, const bool json_pretty_print, const bool binary, gwmb_export_cache* cache) {
+        return write_file_once(cache, save_dir + L"\\" + filename, [&](const std::filesystem::path& file_path) {
+            auto opened_model_file = dat_manager->open_model_file(model_mft_index);
+            auto* model_file = std::get_if<FFNA_ModelFile>(&opened_model_file.model);
+            if (!model_file) {
+                return false; // The "other" model format can't be exported yet
+            }
+            return write_model_file(file_path, model_file, dat_manager, hash_index, save_dir, json_pretty_print, binary, cache);
+        });
+    }
 
+    static bool write_model_file(const std::filesystem::path& file_path, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, const std::wstring& save_dir, const bool json_pretty_print, const bool binary, gwmb_export_cache* cache) {
         gwmb_model model;
-        const bool success = generate_gwmb_model(model, model_file, dat_manager, hash_index, texture_manager, save_dir);
+        const bool success = generate_gwmb_model(model, model_file, dat_manager, hash_index, save_dir, cache);
         if (!success) {
             return false; // Failed to build the model
         }
 
+        if (cache) {
+            // Other maps reusing this file need its textures next to it.
+            std::vector<std::wstring> texture_file_names;
+            for (const auto& texture : model.textures) {
+                texture_file_names.push_back(std::to_wstring(texture.file_hash) + L".png");
+            }
+            cache->set_dependencies(file_path, std::move(texture_file_names));
+        }
+
+        if (binary) {
+            return write_binary_model(file_path, model);
+        }
+
         const nlohmann::json j = model;
-        std::ofstream file(saveFilePath);
+        std::ofstream file(file_path);
         if (!file) {
             return false; // Failed to open the file for writing
         }
@@ -293,7 +355,69 @@ private:
         return true; // Successfully exported the model
     }
 
-    static bool generate_gwmb_model(gwmb_model& model_out, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const std::wstring& save_dir) {
+    // Vertex attributes are split into one packed array each, instead of one JSON object per vertex.
+    static bool write_binary_model(const std::filesystem::path& file_path, const gwmb_model& model) {
+        gwmb_binary_writer writer;
+
+        nlohmann::json submodels = nlohmann::json::array();
+        for (const auto& submodel : model.submodels) {
+            const auto& vertices = submodel.vertices;
+
+            // All vertices of a submodel share its vertex format, so the first one tells which attributes exist.
+            const bool has_normal = !vertices.empty() && vertices[0].has_normal;
+            const bool has_tangent = !vertices.empty() && vertices[0].has_tangent;
+            const bool has_bitangent = !vertices.empty() && vertices[0].has_bitangent;
+            const size_t num_tex_coords = vertices.empty() ? 0 : vertices[0].texture_uv_coords.size();
+
+            std::vector<float> positions, normals, tangents, bitangents;
+            std::vector<std::vector<float>> texture_uv_coords(num_tex_coords);
+            positions.reserve(vertices.size() * 3);
+            for (const auto& vertex : vertices) {
+                positions.insert(positions.end(), { vertex.pos.x, vertex.pos.y, vertex.pos.z });
+                if (has_normal) normals.insert(normals.end(), { vertex.normal.x, vertex.normal.y, vertex.normal.z });
+                if (has_tangent) tangents.insert(tangents.end(), { vertex.tangent.x, vertex.tangent.y, vertex.tangent.z });
+                if (has_bitangent) bitangents.insert(bitangents.end(), { vertex.bitangent.x, vertex.bitangent.y, vertex.bitangent.z });
+                for (size_t k = 0; k < num_tex_coords; k++) {
+                    const auto uv = k < vertex.texture_uv_coords.size() ? vertex.texture_uv_coords[k] : gwmb_vec2f{ 0, 0 };
+                    texture_uv_coords[k].insert(texture_uv_coords[k].end(), { uv.x, uv.y });
+                }
+            }
+
+            nlohmann::json j{
+                {"vertex_count", vertices.size()},
+                {"has_med_lod", submodel.has_med_lod},
+                {"has_low_lod", submodel.has_low_lod},
+                {"texture_indices", submodel.texture_indices},
+                {"texture_uv_map_index", submodel.texture_uv_map_index},
+                {"texture_blend_flags", submodel.texture_blend_flags},
+                {"pixel_shader_type", submodel.pixel_shader_type},
+            };
+            j["positions"] = writer.add_view(positions, 3);
+            if (has_normal) j["normals"] = writer.add_view(normals, 3);
+            if (has_tangent) j["tangents"] = writer.add_view(tangents, 3);
+            if (has_bitangent) j["bitangents"] = writer.add_view(bitangents, 3);
+            j["texture_uv_coords"] = nlohmann::json::array();
+            for (const auto& uvs : texture_uv_coords) {
+                j["texture_uv_coords"].push_back(writer.add_view(uvs, 2));
+            }
+
+            j["indices"] = writer.add_view(std::vector<uint32_t>(submodel.indices.begin(), submodel.indices.end()));
+            if (submodel.has_med_lod) j["indices_med"] = writer.add_view(std::vector<uint32_t>(submodel.indices_med.begin(), submodel.indices_med.end()));
+            if (submodel.has_low_lod) j["indices_low"] = writer.add_view(std::vector<uint32_t>(submodel.indices_low.begin(), submodel.indices_low.end()));
+
+            submodels.push_back(std::move(j));
+        }
+
+        const nlohmann::json metadata{
+            {"format", "gwmb_model"},
+            {"textures", model.textures},
+            {"submodels", std::move(submodels)},
+            {"submodels_draw_order", model.submodels_draw_order},
+        };
+        return writer.save(file_path, metadata);
+    }
+
+    static bool generate_gwmb_model(gwmb_model& model_out, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, const std::wstring& save_dir, gwmb_export_cache* cache) {
 
         if (!model_file->parsed_correctly)
             return false;
@@ -316,37 +440,16 @@ private:
                 if (!entry)
                     return false;
 
-                int texture_id = -1;
-                DatTexture dat_texture;
-                if (entry->type == DDS)
-                {
-                    const auto ddsData = dat_manager->parse_dds_file(file_index);
-                    size_t ddsDataSize = ddsData.size();
-                    const auto hr = texture_manager->
-                        CreateTextureFromDDSInMemory(ddsData.data(), ddsDataSize, &texture_id, &dat_texture.width,
-                            &dat_texture.height, dat_texture.rgba_data, entry->Hash);
-                    dat_texture.texture_type = DDSt;
-                }
-                else
-                {
-                    dat_texture = dat_manager->parse_ffna_texture_file(file_index);
-                    auto HR = texture_manager->CreateTextureFromRGBA(dat_texture.width,
-                        dat_texture.height, dat_texture.rgba_data.data(), &texture_id,
-                        decoded_filename);
-                }
+                const auto dat_texture = decode_texture(decoded_filename, file_index, dat_manager, cache);
 
                 gwmb_texture gwmb_texture_i;
                 gwmb_texture_i.file_hash = decoded_filename;
-                gwmb_texture_i.height = dat_texture.height;
-                gwmb_texture_i.width = dat_texture.width;
-                gwmb_texture_i.texture_type = dat_texture.texture_type;
-
-                ID3D11ShaderResourceView* texture =
-                    texture_manager->GetTexture(texture_id);
-
-                std::wstring texture_save_path = save_dir + L"\\" + std::to_wstring(gwmb_texture_i.file_hash) + L".png";
+                gwmb_texture_i.height = dat_texture->height;
+                gwmb_texture_i.width = dat_texture->width;
+                gwmb_texture_i.texture_type = dat_texture->texture_type;
 
-                if (!SaveTextureToPng(texture, texture_save_path, texture_manager))
+                // Models of a map share many textures, they only need to be encoded once.
+                if (!save_texture_png(save_dir, gwmb_texture_i.file_hash, *dat_texture, cache))
                 {
                     throw "Unable to save texture to png while exporting model";
                 }
@@ -3,30 +3,29 @@
 #include "stb_image_write.h""
 #include "tinytiff/tinytiffwriter.h"
 
-bool write_heightmap_png(const std::vector<std::vector<float>>& heightmap, const char* filename)
+bool write_heightmap_png(const TerrainGrid<float>& heightmap, const char* filename)
 {
-	int width = heightmap[0].size();
-	int height = heightmap.size();
+	int width = heightmap.width();
+	int height = heightmap.height();
 	std::vector<unsigned char> pixels(width * height);
 
 	// Find min and max values in heightmap
 	float min = FLT_MAX;
 	float max = FLT_MIN;
-	for (const auto& row : heightmap)
+	for (size_t i = 0; i < heightmap.size(); i++)
 	{
-		for (float value : row)
-		{
-			if (value < min) min = value;
-			if (value > max) max = value;
-		}
+		float value = heightmap.data()[i];
+		if (value < min) min = value;
+		if (value > max) max = value;
 	}
 
 	// Scale float values to 8-bit
 	for (int y = 0; y < height; y++)
 	{
+		const auto row = heightmap.row(y);
 		for (int x = 0; x < width; x++)
 		{
-			float value = (heightmap[y][x] - min) / (max - min) * 255;
+			float value = (row[x] - min) / (max - min) * 255;
 			pixels[(height - y - 1) * width + x] = static_cast<unsigned char>(value); // Flipping the y-axis
 		}
 	}
@@ -40,9 +39,9 @@ bool write_heightmap_png(const std::vector<std::vector<float>>& heightmap, const
 	return true;
 }
 
-bool write_heightmap_tiff(const std::vector<std::vector<float>>& heightmap, const char* filename) {
-	int width = heightmap[0].size();
-	int height = heightmap.size();
+bool write_heightmap_tiff(const TerrainGrid<float>& heightmap, const char* filename) {
+	int width = heightmap.width();
+	int height = heightmap.height();
 
 	// Create a TIFF file with 32-bit depth, 1 sample per pixel (grayscale), and float format
 	TinyTIFFWriterFile* tif = TinyTIFFWriter_open(filename, 32, TinyTIFFWriter_Float, 1, width, height,
@@ -53,17 +52,17 @@ bool write_heightmap_tiff(const std::vector<std::vector<float>>& heightmap, cons
 
 	float min = FLT_MAX;
 	float max = FLT_MIN;
-	for (const auto& row : heightmap) {
-		for (float value : row) {
-			if (value < min) min = value;
-			if (value > max) max = value;
-		}
+	for (size_t i = 0; i < heightmap.size(); i++) {
+		float value = heightmap.data()[i];
+		if (value < min) min = value;
+		if (value > max) max = value;
 	}
 
 	std::vector<float> scaledData(width * height);
 	for (int y = 0; y < height; y++) {
+		const auto row = heightmap.row(y);
 		for (int x = 0; x < width; x++) {
-			scaledData[(height - y - 1) * width + x] = (heightmap[y][x] - min) / (max - min); // Scale the value to [0, 1] and flip y-axis
+			scaledData[(height - y - 1) * width + x] = (row[x] - min) / (max - min); // Scale the value to [0, 1] and flip y-axis
 		}
 	}
 
@@ -76,9 +75,9 @@ bool write_heightmap_tiff(const std::vector<std::vector<float>>& heightmap, cons
 	return true;
 }
 
-bool write_terrain_ints_tiff(const std::vector<std::vector<uint32_t>>& terrain_indices, const char* filename) {
-	int width = terrain_indices[0].size();
-	int height = terrain_indices.size();
+bool write_terrain_ints_tiff(const TerrainGrid<uint8_t>& terrain_indices, const char* filename) {
+	int width = terrain_indices.width();
+	int height = terrain_indices.height();
 
 	// Create a TIFF file with 8-bit depth, 1 sample per pixel (grayscale), and unsigned int format
 	TinyTIFFWriterFile* tif = TinyTIFFWriter_open(filename, 8, TinyTIFFWriter_UInt, 1, width, height,
@@ -87,15 +86,8 @@ bool write_terrain_ints_tiff(const std::vector<std::vector<uint32_t>>& terrain_i
 		return false; // Error opening TIFF file
 	}
 
-	std::vector<uint8_t> imageData(width * height);
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			imageData[y * width + x] = static_cast<uint8_t>(terrain_indices[y][x]); // Copy value as 8-bit and flip y-axis
-		}
-	}
-
-	// Write the entire image to TIFF
-	TinyTIFFWriter_writeImage(tif, imageData.data());
+	// The grid is already contiguous 8-bit rows, so it can be written as-is
+	TinyTIFFWriter_writeImage(tif, terrain_indices.data());
 
 	// Close the TIFF file
 	TinyTIFFWriter_close(tif);
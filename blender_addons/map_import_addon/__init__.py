@@ -4,7 +4,7 @@ bl_info = {
     "version": (2, 0, 0),
     "blender": (5, 0, 0),
     "location": "File > Import > GW Map Browser Map Folder",
-    "description": "Import a Guild Wars Map from a JSON file provided by Guild Wars Map Browser.",
+    "description": "Import a Guild Wars Map from the JSON or binary .gwmb files provided by Guild Wars Map Browser.",
     "warning": "This might take a long time.",
     "wiki_url": "github.com/Jonathan-Greve/GuildWarsMapBrowser",
     "category": "Import-Export",
@@ -1,3 +1,4 @@
+import array
 import bpy
 import json
 import time
@@ -5,6 +6,8 @@ import os
 import traceback
 from mathutils import Vector, Matrix
 
+from . import gwmb_binary
+
 # Blender 5.0 compatible version - V2 with new terrain format (4 UV layers)
 
 def get_blender_version():
@@ -487,12 +490,103 @@ def set_custom_normals(mesh, normals):
     mesh.normals_split_custom_set_from_vertices(normals)
 
 
+def swap_axes_flat(values):
+    """swap_axes for a flat x, y, z array"""
+    swapped = array.array('f', values)
+    swapped[1::3] = values[2::3]
+    swapped[2::3] = values[1::3]
+    return swapped
+
+
+def create_mesh_from_arrays(name, positions, indices, reverse_winding):
+    """
+    Builds a triangle mesh with foreach_set instead of from_pydata.
+    positions is a flat array in Blender space, indices a triangle list.
+    Returns the mesh and the vertex index of each loop, for per loop attributes.
+    """
+    indices = array.array('i', indices)
+    loops = array.array('i', indices)
+    if reverse_winding:
+        loops[0::3] = indices[2::3]
+        loops[2::3] = indices[0::3]
+
+    mesh = bpy.data.meshes.new(name=name)
+    mesh.vertices.add(len(positions) // 3)
+    mesh.vertices.foreach_set('co', positions)
+    mesh.loops.add(len(loops))
+    mesh.loops.foreach_set('vertex_index', loops)
+    mesh.polygons.add(len(loops) // 3)
+    mesh.polygons.foreach_set('loop_start', array.array('i', range(0, len(loops), 3)))
+    if get_blender_version() < (4, 0, 0):
+        mesh.polygons.foreach_set('loop_total', array.array('i', [3]) * (len(loops) // 3))
+    mesh.update(calc_edges=True)
+    return mesh, loops
+
+
+def loop_uvs(uvs, loops):
+    """Expands a flat per vertex u, v array to the per loop layout of a UV layer, flipping v"""
+    us = uvs[0::2]
+    vs = uvs[1::2]
+    flat = array.array('f', bytes(8 * len(loops)))
+    flat[0::2] = array.array('f', (us[i] for i in loops))
+    flat[1::2] = array.array('f', (1.0 - vs[i] for i in loops))
+    return flat
+
+
+def read_json_submodel(submodel):
+    """Flattens the per vertex objects of a JSON submodel into the arrays read_gwmb_submodel returns"""
+    vertices_data = submodel.get('vertices', [])
+    positions = array.array('f', [c for v in vertices_data for c in swap_axes(v['pos'])])
+    normals = [swap_axes(v['normal']) if v.get('has_normal', False) else (0, 0, 1) for v in vertices_data]
+
+    num_uv_sets = max((len(v.get('texture_uv_coords', [])) for v in vertices_data), default=0)
+    uv_sets = []
+    for k in range(num_uv_sets):
+        uv_sets.append(array.array('f', [c for v in vertices_data
+                                         for c in (v['texture_uv_coords'][k]['x'], v['texture_uv_coords'][k]['y'])]))
+
+    return positions, normals, uv_sets, submodel.get('indices', [])
+
+
+def read_gwmb_submodel(submodel, buffer):
+    """Reads the packed arrays of a binary submodel"""
+    positions = swap_axes_flat(gwmb_binary.read_view(buffer, submodel['positions']))
+    if 'normals' in submodel:
+        n = swap_axes_flat(gwmb_binary.read_view(buffer, submodel['normals']))
+        normals = list(zip(n[0::3], n[1::3], n[2::3]))
+    else:
+        normals = [(0, 0, 1)] * (len(positions) // 3)
+
+    uv_sets = [gwmb_binary.read_view(buffer, view) for view in submodel.get('texture_uv_coords', [])]
+    indices = gwmb_binary.read_view(buffer, submodel['indices'])
+    return positions, normals, uv_sets, indices
+
+
+def read_gwmb_instances(data, buffer):
+    """Expands the packed instance arrays of a binary map into the per model objects of the JSON map"""
+    instances = data['instances']
+    model_hashes = data['model_hashes']
+    model_index = gwmb_binary.read_view(buffer, instances['model_index'])
+    vectors = {key: gwmb_binary.read_view(buffer, instances[key])
+               for key in ('world_pos', 'model_right', 'model_up', 'model_look')}
+    scale = gwmb_binary.read_view(buffer, instances['scale'])
+
+    models = []
+    for i in range(instances['count']):
+        model = {'model_hash': model_hashes[model_index[i]], 'scale': scale[i]}
+        for key, values in vectors.items():
+            model[key] = {'x': values[3 * i], 'y': values[3 * i + 1], 'z': values[3 * i + 2]}
+        models.append(model)
+    return models
+
+
 def create_map_from_json(context, directory, filename):
     """
     Import map with new terrain format (V2):
     - Vertices already have 4 UV coordinates pre-computed
     - Indices are pre-computed
     - No need to calculate UVs from texture_index
+    Binary .gwmb maps always use this format.
     """
     log("=== create_map_from_json START (V2 format) ===")
     disable_render_preview_background()
@@ -511,8 +605,12 @@ def create_map_from_json(context, directory, filename):
         log(f"Object {obj_name} already exists. Skipping.")
         return {'FINISHED'}
 
-    with open(filepath, 'r') as f:
-        data = json.load(f)
+    buffer = None
+    if gwmb_binary.is_binary(filepath):
+        data, buffer = gwmb_binary.load(filepath)
+    else:
+        with open(filepath, 'r') as f:
+            data = json.load(f)
 
     if 'terrain' not in data:
         log(f"The key 'terrain' is not in the JSON data. Available keys: {list(data.keys())}")
@@ -541,47 +639,46 @@ def create_map_from_json(context, directory, filename):
     vertices_data = terrain_data.get('vertices', [])
     indices = terrain_data.get('indices', [])
 
-    log(f"Reading {len(vertices_data)} vertices and {len(indices)} indices")
+    if buffer is not None:
+        indices = gwmb_binary.read_view(buffer, terrain_data['indices'])
+        log(f"Reading {terrain_data['vertex_count']} vertices and {len(indices)} indices")
+    else:
+        log(f"Reading {len(vertices_data)} vertices and {len(indices)} indices")
 
     # Check if this is the new format (has uv_coord0) or old format (has texture_index)
-    is_new_format = len(vertices_data) > 0 and 'uv_coord0' in vertices_data[0]
+    is_new_format = buffer is not None or (len(vertices_data) > 0 and 'uv_coord0' in vertices_data[0])
     log(f"Detected format: {'NEW (pre-computed UVs)' if is_new_format else 'OLD (texture_index)'}")
 
     if is_new_format:
         # NEW FORMAT: Vertices already have 4 UV coords, indices are pre-computed
         # Convert vertices to Blender format (swap Y and Z)
-        blender_vertices = [swap_axes(v['pos']) for v in vertices_data]
-        blender_normals = [swap_axes_normal(v.get('normal')) for v in vertices_data]
-
-        # Extract all 4 UV layers
-        uv0_coords = [(v['uv_coord0']['x'], 1.0 - v['uv_coord0']['y']) for v in vertices_data]
-        uv1_coords = [(v['uv_coord1']['x'], 1.0 - v['uv_coord1']['y']) for v in vertices_data]
-        uv2_coords = [(v['uv_coord2']['x'], 1.0 - v['uv_coord2']['y']) for v in vertices_data]
-        uv3_coords = [(v['uv_coord3']['x'], 1.0 - v['uv_coord3']['y']) for v in vertices_data]
-
-        # Convert indices to faces (triangles)
-        faces = []
-        for i in range(0, len(indices), 3):
-            faces.append((indices[i], indices[i+1], indices[i+2]))
+        uv_keys = ['uv_coord0', 'uv_coord1', 'uv_coord2', 'uv_coord3']
+        if buffer is not None:
+            blender_vertices = swap_axes_flat(gwmb_binary.read_view(buffer, terrain_data['positions']))
+            n = swap_axes_flat(gwmb_binary.read_view(buffer, terrain_data['normals']))
+            blender_normals = list(zip(n[0::3], n[1::3], n[2::3]))
+            uv_data_lists = [gwmb_binary.read_view(buffer, terrain_data[key]) for key in uv_keys]
+        else:
+            blender_vertices = array.array('f', [c for v in vertices_data for c in swap_axes(v['pos'])])
+            blender_normals = [swap_axes_normal(v.get('normal')) for v in vertices_data]
+            uv_data_lists = [array.array('f', [c for v in vertices_data for c in (v[key]['x'], v[key]['y'])])
+                             for key in uv_keys]
 
-        log(f"Creating mesh with {len(blender_vertices)} vertices and {len(faces)} faces")
+        log(f"Creating mesh with {len(blender_vertices) // 3} vertices and {len(indices) // 3} faces")
 
         # Create mesh
         terrain_mesh_name = "{}_terrain".format(map_hash)
-        mesh = bpy.data.meshes.new(name=terrain_mesh_name)
-        mesh.from_pydata(blender_vertices, [], faces)
+        mesh, loops = create_mesh_from_arrays(terrain_mesh_name, blender_vertices, indices, reverse_winding=False)
 
         # Set custom normals
         set_custom_normals(mesh, blender_normals)
 
         # Create 4 UV layers
         uv_layer_names = ["UV_Atlas", "UV_Blend1", "UV_Blend2", "UV_Shadow"]
-        uv_data_lists = [uv0_coords, uv1_coords, uv2_coords, uv3_coords]
 
         for layer_idx, (layer_name, uv_data) in enumerate(zip(uv_layer_names, uv_data_lists)):
             uv_layer = mesh.uv_layers.new(name=layer_name)
-            for i, loop in enumerate(mesh.loops):
-                uv_layer.data[i].uv = uv_data[loop.vertex_index]
+            uv_layer.data.foreach_set('uv', loop_uvs(uv_data, loops))
             log(f"Created UV layer: {layer_name}")
 
         mesh.update()
@@ -808,7 +905,10 @@ def create_map_from_json(context, directory, filename):
     create_water_surface(0.0, top_left_point, bottom_right_point, map_collection)
 
     # Place models
-    map_models_data = data.get('models', [])
+    if buffer is not None:
+        map_models_data = read_gwmb_instances(data, buffer)
+    else:
+        map_models_data = data.get('models', [])
     parent_collection_name = "GWMB Models"
 
     if parent_collection_name in bpy.data.collections:
@@ -855,7 +955,7 @@ def create_map_from_json(context, directory, filename):
 
 
 def create_mesh_from_json(context, directory, filename):
-    """Import a model from JSON file"""
+    """Import a model from a JSON or binary .gwmb file"""
     log(f"Loading model: {filename}")
     filepath = os.path.join(directory, filename)
     base_name = os.path.basename(filepath).split('.')[0]
@@ -867,8 +967,12 @@ def create_mesh_from_json(context, directory, filename):
 
     gwmb_collection = ensure_collection(context, "GWMB Models")
 
-    with open(filepath, 'r') as f:
-        data = json.load(f)
+    buffer = None
+    if gwmb_binary.is_binary(filepath):
+        data, buffer = gwmb_binary.load(filepath)
+    else:
+        with open(filepath, 'r') as f:
+            data = json.load(f)
 
     all_texture_types = []
     all_images = []
@@ -892,16 +996,14 @@ def create_mesh_from_json(context, directory, filename):
 
     for idx, submodel in enumerate(data.get('submodels', [])):
         pixel_shader_type = submodel['pixel_shader_type']
-        vertices_data = submodel.get('vertices', [])
-        indices = submodel.get('indices', [])
-
-        vertices = [swap_axes(v['pos']) for v in vertices_data]
         texture_blend_flags = submodel.get('texture_blend_flags', [])
-        normals = [swap_axes(v['normal']) if v.get('has_normal', False) else (0, 0, 1) for v in vertices_data]
-        faces = [tuple(reversed(indices[i:i + 3])) for i in range(0, len(indices), 3)]
+        if buffer is not None:
+            positions, normals, uv_sets, indices = read_gwmb_submodel(submodel, buffer)
+        else:
+            positions, normals, uv_sets, indices = read_json_submodel(submodel)
 
-        mesh = bpy.data.meshes.new(name="{}_submodel_{}".format(model_hash, idx))
-        mesh.from_pydata(vertices, [], faces)
+        mesh, loops = create_mesh_from_arrays("{}_submodel_{}".format(model_hash, idx), positions, indices,
+                                              reverse_winding=True)
         set_custom_normals(mesh, normals)
 
         texture_indices = submodel.get('texture_indices', [])
@@ -915,13 +1017,7 @@ def create_mesh_from_json(context, directory, filename):
             uv_layer_name = f"UV_{uv_index}"
             uv_map_names.append(uv_layer_name)
             uv_layer = mesh.uv_layers.new(name=uv_layer_name)
-            uvs = []
-            for vertex in vertices_data:
-                uvs.append(
-                    (vertex['texture_uv_coords'][tex_index]['x'], 1 - vertex['texture_uv_coords'][tex_index]['y']))
-
-            for i, loop in enumerate(mesh.loops):
-                uv_layer.data[i].uv = uvs[loop.vertex_index]
+            uv_layer.data.foreach_set('uv', loop_uvs(uv_sets[tex_index], loops))
 
         # Create material based on pixel_shader_type
         # Type 4, 6: Old model shaders - complex multi-texture blending
@@ -1001,11 +1097,11 @@ class IMPORT_OT_GWMBMap(bpy.types.Operator):
             return {'CANCELLED'}
 
         try:
-            file_list = [f for f in os.listdir(self.directory) if f.lower().endswith('.json')]
-            log(f"Found {len(file_list)} JSON files in directory")
+            file_list = [f for f in os.listdir(self.directory) if f.lower().endswith(('.json', '.gwmb'))]
+            log(f"Found {len(file_list)} JSON/GWMB files in directory")
 
             if len(file_list) == 0:
-                self.report({'WARNING'}, "No JSON files found in directory")
+                self.report({'WARNING'}, "No JSON or GWMB files found in directory")
                 return {'CANCELLED'}
 
             map_filename = None
@@ -3,8 +3,8 @@ bl_info = {
     "author": "Jonathan Bjorn Greve",
     "version": (2, 0, 0),
     "blender": (5, 0, 0),
-    "location": "File > Import > GW Map Browser Model File (.json)",
-    "description": "Import a 3D model from a JSON file provided by Guild Wars Map Browser.",
+    "location": "File > Import > GW Map Browser Model File (.json/.gwmb)",
+    "description": "Import a 3D model from a JSON or binary .gwmb file provided by Guild Wars Map Browser.",
     "warning": "",
     "wiki_url": "github.com/Jonathan-Greve/GuildWarsMapBrowser",
     "category": "Import-Export",
@@ -16,7 +16,7 @@ from . import import_model
 
 
 def menu_func_import(self, context):
-    self.layout.operator(import_model.IMPORT_OT_JSONMesh.bl_idname, text="GW Map Browser Model File (.json)")
+    self.layout.operator(import_model.IMPORT_OT_JSONMesh.bl_idname, text="GW Map Browser Model File (.json/.gwmb)")
 
 
 def register():
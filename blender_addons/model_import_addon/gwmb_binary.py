@@ -0,0 +1,58 @@
+"""
+Reader for the binary .gwmb files written by Guild Wars Map Browser.
+
+Layout, all integers little-endian (see SourceFiles/gwmb_binary.h):
+    char[4]  magic          b'GWMB'
+    uint32   version
+    uint32   json_length    Length of the metadata, padded with spaces to a multiple of 4
+    uint32   binary_length  Length of the buffer that follows the metadata
+    json_length bytes       UTF-8 JSON metadata
+    binary_length bytes     Packed arrays
+
+The metadata matches the JSON export, except that vertex, index and instance arrays are views into the buffer:
+    {"offset": <bytes>, "count": <elements>, "components": <per element>, "type": "f32" | "u32"}
+"""
+
+import array
+import json
+import struct
+import sys
+
+GWMB_MAGIC = b'GWMB'
+GWMB_VERSION = 1
+
+HEADER_FORMAT = '<4sIII'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+TYPECODES = {'f32': 'f', 'u32': 'I'}
+
+
+def is_binary(filepath):
+    return filepath.lower().endswith('.gwmb')
+
+
+def load(filepath):
+    """Returns (metadata, buffer) of a .gwmb file, pass the buffer to read_view."""
+    with open(filepath, 'rb') as f:
+        data = f.read()
+
+    magic, version, json_length, binary_length = struct.unpack_from(HEADER_FORMAT, data, 0)
+    if magic != GWMB_MAGIC:
+        raise ValueError(f"{filepath} is not a binary GWMB file")
+    if version > GWMB_VERSION:
+        raise ValueError(f"{filepath} has version {version}, this add-on reads up to version {GWMB_VERSION}")
+
+    metadata = json.loads(data[HEADER_SIZE:HEADER_SIZE + json_length].decode('utf-8'))
+    binary_start = HEADER_SIZE + json_length
+    buffer = memoryview(data)[binary_start:binary_start + binary_length]
+    return metadata, buffer
+
+
+def read_view(buffer, view):
+    """Returns the elements of a view as a flat array.array, components of an element are consecutive."""
+    values = array.array(TYPECODES[view['type']])
+    size = view['count'] * view['components'] * values.itemsize
+    values.frombytes(buffer[view['offset']:view['offset'] + size])
+    if sys.byteorder == 'big':
+        values.byteswap()
+    return values
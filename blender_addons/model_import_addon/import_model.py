@@ -1,8 +1,11 @@
+import array
 import bpy
 import json
 import os
 import traceback
 
+from . import gwmb_binary
+
 # Blender 5.0 compatible version - matches map_import_addon exactly
 
 def get_blender_version():
@@ -389,8 +392,80 @@ def set_custom_normals(mesh, normals):
     mesh.normals_split_custom_set_from_vertices(normals)
 
 
+def swap_axes_flat(values):
+    """swap_axes for a flat x, y, z array"""
+    swapped = array.array('f', values)
+    swapped[1::3] = values[2::3]
+    swapped[2::3] = values[1::3]
+    return swapped
+
+
+def create_mesh_from_arrays(name, positions, indices, reverse_winding):
+    """
+    Builds a triangle mesh with foreach_set instead of from_pydata.
+    positions is a flat array in Blender space, indices a triangle list.
+    Returns the mesh and the vertex index of each loop, for per loop attributes.
+    """
+    indices = array.array('i', indices)
+    loops = array.array('i', indices)
+    if reverse_winding:
+        loops[0::3] = indices[2::3]
+        loops[2::3] = indices[0::3]
+
+    mesh = bpy.data.meshes.new(name=name)
+    mesh.vertices.add(len(positions) // 3)
+    mesh.vertices.foreach_set('co', positions)
+    mesh.loops.add(len(loops))
+    mesh.loops.foreach_set('vertex_index', loops)
+    mesh.polygons.add(len(loops) // 3)
+    mesh.polygons.foreach_set('loop_start', array.array('i', range(0, len(loops), 3)))
+    if get_blender_version() < (4, 0, 0):
+        mesh.polygons.foreach_set('loop_total', array.array('i', [3]) * (len(loops) // 3))
+    mesh.update(calc_edges=True)
+    return mesh, loops
+
+
+def loop_uvs(uvs, loops):
+    """Expands a flat per vertex u, v array to the per loop layout of a UV layer, flipping v"""
+    us = uvs[0::2]
+    vs = uvs[1::2]
+    flat = array.array('f', bytes(8 * len(loops)))
+    flat[0::2] = array.array('f', (us[i] for i in loops))
+    flat[1::2] = array.array('f', (1.0 - vs[i] for i in loops))
+    return flat
+
+
+def read_json_submodel(submodel):
+    """Flattens the per vertex objects of a JSON submodel into the arrays read_gwmb_submodel returns"""
+    vertices_data = submodel.get('vertices', [])
+    positions = array.array('f', [c for v in vertices_data for c in swap_axes(v['pos'])])
+    normals = [swap_axes(v['normal']) if v.get('has_normal', False) else (0, 0, 1) for v in vertices_data]
+
+    num_uv_sets = max((len(v.get('texture_uv_coords', [])) for v in vertices_data), default=0)
+    uv_sets = []
+    for k in range(num_uv_sets):
+        uv_sets.append(array.array('f', [c for v in vertices_data
+                                         for c in (v['texture_uv_coords'][k]['x'], v['texture_uv_coords'][k]['y'])]))
+
+    return positions, normals, uv_sets, submodel.get('indices', [])
+
+
+def read_gwmb_submodel(submodel, buffer):
+    """Reads the packed arrays of a binary submodel"""
+    positions = swap_axes_flat(gwmb_binary.read_view(buffer, submodel['positions']))
+    if 'normals' in submodel:
+        n = swap_axes_flat(gwmb_binary.read_view(buffer, submodel['normals']))
+        normals = list(zip(n[0::3], n[1::3], n[2::3]))
+    else:
+        normals = [(0, 0, 1)] * (len(positions) // 3)
+
+    uv_sets = [gwmb_binary.read_view(buffer, view) for view in submodel.get('texture_uv_coords', [])]
+    indices = gwmb_binary.read_view(buffer, submodel['indices'])
+    return positions, normals, uv_sets, indices
+
+
 def create_mesh_from_json(context, directory, filename):
-    """Import a model from JSON file - identical to map importer version"""
+    """Import a model from a JSON or binary .gwmb file - identical to map importer version"""
     log(f"Loading model: {filename}")
     filepath = os.path.join(directory, filename)
     base_name = os.path.basename(filepath).split('.')[0]
@@ -402,8 +477,12 @@ def create_mesh_from_json(context, directory, filename):
 
     gwmb_collection = ensure_collection(context, "GWMB Models")
 
-    with open(filepath, 'r') as f:
-        data = json.load(f)
+    buffer = None
+    if gwmb_binary.is_binary(filepath):
+        data, buffer = gwmb_binary.load(filepath)
+    else:
+        with open(filepath, 'r') as f:
+            data = json.load(f)
 
     all_texture_types = []
     all_images = []
@@ -427,16 +506,14 @@ def create_mesh_from_json(context, directory, filename):
 
     for idx, submodel in enumerate(data.get('submodels', [])):
         pixel_shader_type = submodel['pixel_shader_type']
-        vertices_data = submodel.get('vertices', [])
-        indices = submodel.get('indices', [])
-
-        vertices = [swap_axes(v['pos']) for v in vertices_data]
         texture_blend_flags = submodel.get('texture_blend_flags', [])
-        normals = [swap_axes(v['normal']) if v.get('has_normal', False) else (0, 0, 1) for v in vertices_data]
-        faces = [tuple(reversed(indices[i:i + 3])) for i in range(0, len(indices), 3)]
+        if buffer is not None:
+            positions, normals, uv_sets, indices = read_gwmb_submodel(submodel, buffer)
+        else:
+            positions, normals, uv_sets, indices = read_json_submodel(submodel)
 
-        mesh = bpy.data.meshes.new(name="{}_submodel_{}".format(model_hash, idx))
-        mesh.from_pydata(vertices, [], faces)
+        mesh, loops = create_mesh_from_arrays("{}_submodel_{}".format(model_hash, idx), positions, indices,
+                                              reverse_winding=True)
         set_custom_normals(mesh, normals)
 
         texture_indices = submodel.get('texture_indices', [])
@@ -450,13 +527,7 @@ def create_mesh_from_json(context, directory, filename):
             uv_layer_name = f"UV_{uv_index}"
             uv_map_names.append(uv_layer_name)
             uv_layer = mesh.uv_layers.new(name=uv_layer_name)
-            uvs = []
-            for vertex in vertices_data:
-                uvs.append(
-                    (vertex['texture_uv_coords'][tex_index]['x'], 1 - vertex['texture_uv_coords'][tex_index]['y']))
-
-            for i, loop in enumerate(mesh.loops):
-                uv_layer.data[i].uv = uvs[loop.vertex_index]
+            uv_layer.data.foreach_set('uv', loop_uvs(uv_sets[tex_index], loops))
 
         # Create material based on pixel_shader_type
         # Type 4, 6: Old model shaders - complex multi-texture blending
@@ -504,11 +575,12 @@ def create_mesh_from_json(context, directory, filename):
 class IMPORT_OT_JSONMesh(bpy.types.Operator):
     bl_idname = "import_mesh.json"
     bl_label = "Import JSON model file"
-    bl_description = "Import a Guild Wars Map Browser model file (.json)"
+    bl_description = "Import a Guild Wars Map Browser model file (.json or binary .gwmb)"
     bl_options = {'REGISTER', 'UNDO'}
 
     files: bpy.props.CollectionProperty(type=bpy.types.OperatorFileListElement)
     directory: bpy.props.StringProperty(subtype='DIR_PATH')
+    filter_glob: bpy.props.StringProperty(default="*.json;*.gwmb", options={'HIDDEN'})
 
     def invoke(self, context, event):
         context.window_manager.fileselect_add(self)
@@ -536,7 +608,7 @@ class IMPORT_OT_JSONMesh(bpy.types.Operator):
 
 
 def menu_func_import(self, context):
-    self.layout.operator(IMPORT_OT_JSONMesh.bl_idname, text="GW Map Browser Model File (.json)")
+    self.layout.operator(IMPORT_OT_JSONMesh.bl_idname, text="GW Map Browser Model File (.json/.gwmb)")
 
 
 def register():